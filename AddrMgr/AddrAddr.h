@@ -26,6 +26,8 @@ class TAddrAddr
 
     // return address in packed format (char[16])
     SPtr<TIPv6Addr> get();
+    // return address by value, used for lookups
+    TIPv6AddrValue getValue() const { return Addr->getValue(); }
 
     // lifetime related
     unsigned long getPref();
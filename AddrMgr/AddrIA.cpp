@@ -197,8 +197,9 @@ SPtr<TAddrAddr> TAddrIA::getAddr(SPtr<TIPv6Addr> addr)
     }
     AddrLst.first();
     SPtr <TAddrAddr> ptrAddr;
+    TIPv6AddrValue value = addr->getValue();
     while (ptrAddr = AddrLst.get() ) {
-        if ( (*addr)==(*(ptrAddr->get())) )
+        if (ptrAddr->getValue() == value)
             return ptrAddr;
     }
 
@@ -213,10 +214,11 @@ int TAddrIA::countAddr()
 int TAddrIA::delAddr(SPtr<TIPv6Addr> addr)
 {
     SPtr< TAddrAddr> ptr;
+    TIPv6AddrValue value = addr->getValue();
     AddrLst.first();
     while (ptr = AddrLst.get())
     {
-        if (*(ptr->get())==(*addr)) {
+        if (ptr->getValue() == value) {
             AddrLst.del();
             return 0;
         }
@@ -260,7 +262,7 @@ bool TAddrIA::delPrefix(SPtr<TAddrPrefix> x)
     while (ptr = PrefixLst.get())
     {
 	/// @todo: should we compare prefix length, too?
-        if (*(ptr->get())==(*x->get())) {
+        if (ptr->getValue() == x->getValue()) {
             PrefixLst.del();
             return true;
         }
@@ -271,12 +273,13 @@ bool TAddrIA::delPrefix(SPtr<TAddrPrefix> x)
 bool TAddrIA::delPrefix(SPtr<TIPv6Addr> x)
 {
     SPtr<TAddrPrefix> ptr;
+    TIPv6AddrValue value = x->getValue();
     PrefixLst.first();
 
     while (ptr = PrefixLst.get())
     {
 	/// @todo: should we compare prefix length, too?
-        if (*(ptr->get())==(*x)) {
+        if (ptr->getValue() == value) {
             PrefixLst.del();
             return true;
         }
@@ -58,11 +58,25 @@ TAddrMgr::TAddrMgr(const std::string& xmlFile, bool loadfile)
  *   quite dumb and may be confused quite easily. This is the only
  *   version that is available.
  *
+ * If there is a binary database (see dbLoadBinary()) that is not older
+ * than the XML file, it is loaded instead. XML file is used as a fallback
+ * if the binary database is missing or corrupted.
+ *
  * @param xmlFile filename of the database
  *
  */
 void TAddrMgr::dbLoad(const char * xmlFile)
 {
+    string binFile = binaryDbName(xmlFile);
+    if (binaryDbPreferred(xmlFile, binFile.c_str())) {
+        Log(Info) << "Loading old address database (" << binFile
+                  << "), using binary format." << LogEnd;
+        if (dbLoadBinary(binFile.c_str()))
+            return;
+        Log(Warning) << "Failed to load binary database " << binFile
+                     << ", trying " << xmlFile << " instead." << LogEnd;
+    }
+
     Log(Info) << "Loading old address database (" << xmlFile
               << "), using built-in routines." << LogEnd;
 
@@ -401,7 +415,7 @@ bool TAddrMgr::addPrefix(SPtr<TAddrClient> client, SPtr<TDUID> duid , SPtr<TIPv6
     SPtr <TAddrPrefix> ptrPrefix;
     ptrPD->firstPrefix();
     while ( ptrPrefix = ptrPD->getPrefix() ) {
-        if (*ptrPrefix->get()==*prefix)
+        if (ptrPrefix->getValue() == prefix->getValue())
             break;
     }
 
@@ -475,7 +489,7 @@ bool TAddrMgr::updatePrefix(SPtr<TAddrClient> client, SPtr<TDUID> duid , SPtr<TI
     SPtr <TAddrPrefix> ptrPrefix;
     pd->firstPrefix();
     while ( ptrPrefix = pd->getPrefix() ) {
-        if (*ptrPrefix->get()==*prefix)
+        if (ptrPrefix->getValue() == prefix->getValue())
             break;
     }
 
@@ -533,7 +547,7 @@ bool TAddrMgr::delPrefix(SPtr<TDUID> clntDuid,
     SPtr <TAddrPrefix> ptrPrefix;
     ptrPD->firstPrefix();
     while ( ptrPrefix = ptrPD->getPrefix() ) {
-        if (*ptrPrefix->get()==*prefix)
+        if (ptrPrefix->getValue() == prefix->getValue())
             break;
     }
 
@@ -578,6 +592,7 @@ bool TAddrMgr::prefixIsFree(SPtr<TIPv6Addr> x)
     SPtr<TAddrClient> client;
     SPtr<TAddrIA> pd;
     SPtr<TAddrPrefix> prefix;
+    TIPv6AddrValue value = x->getValue();
 
     firstClient();
     while (client = getClient()) {
@@ -585,7 +600,7 @@ bool TAddrMgr::prefixIsFree(SPtr<TIPv6Addr> x)
               while (pd = client->getPD()) {
                   pd->firstPrefix();
                   while (prefix = pd->getPrefix()) {
-                            if (*prefix->get()==*x)
+                            if (prefix->getValue() == value)
                                 return false;
                   }
               }
@@ -14,6 +14,7 @@ class TAddrMgr;
 
 #include <string>
 #include <map>
+#include <vector>
 #include "SmartPtr.h"
 #include "Container.h"
 #include "AddrClient.h"
@@ -57,14 +58,14 @@ class TAddrMgr
                                 const IndexToNameMapping& indexToName);
 
     //--- Client container ---
-    void addClient(SPtr<TAddrClient> x);
+    virtual void addClient(SPtr<TAddrClient> x);
     void firstClient();
     SPtr<TAddrClient> getClient();
     SPtr<TAddrClient> getClient(SPtr<TDUID> duid);
     SPtr<TAddrClient> getClient(uint32_t SPI);
     SPtr<TAddrClient> getClient(SPtr<TIPv6Addr> leasedAddr);
     int countClient();
-    bool delClient(SPtr<TDUID> duid);
+    virtual bool delClient(SPtr<TDUID> duid);
 
     // checks if address is conformant to current configuration (used in loadDB())
     virtual bool verifyAddr(SPtr<TIPv6Addr> addr) { return true; }
@@ -97,6 +98,13 @@ class TAddrMgr
     virtual void dump();
     bool isDone();
 
+    // binary database (see AddrMgrBinary.h for its layout)
+    static std::string binaryDbName(const std::string& xmlFile);
+    static bool binaryDbPreferred(const char * xmlFile, const char * binFile);
+    bool dbStoreBinary(const char * binFile);
+    bool dbLoadBinary(const char * binFile);
+    void dbSerializeBinary(List(TAddrClient)& clients, std::vector<char>& buf);
+
 #ifdef MOD_LIBXML2
     // database loading methods that use libxml2
     xmlDocPtr xmlLoad(const char * filename);
@@ -123,6 +131,8 @@ class TAddrMgr
 
 protected:
     virtual void print(std::ostream & out) = 0;
+    bool dbParseBinary(const char * binFile, const char * buf, size_t len,
+                       List(TAddrClient)& loaded);
     bool addPrefix(SPtr<TAddrClient> client, SPtr<TDUID> duid , SPtr<TIPv6Addr> clntAddr,
                    const std::string& ifname, int ifindex, unsigned long IAID,
                    unsigned long T1, unsigned long T2, SPtr<TIPv6Addr> prefix,
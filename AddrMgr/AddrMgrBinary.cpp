@@ -0,0 +1,579 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+#include <map>
+#include <vector>
+#include "Portable.h"
+#include "AddrMgr.h"
+#include "AddrMgrBinary.h"
+#include "AddrClient.h"
+#include "AddrIA.h"
+#include "AddrAddr.h"
+#include "AddrPrefix.h"
+#include "Logger.h"
+
+using namespace std;
+
+/// @brief Helper used to build string section of the binary database.
+///
+/// Identical strings (e.g. client DUID that is repeated in every IA) are
+/// stored only once.
+class TAddrDbStrings {
+public:
+    TAddrDbStrings() {}
+
+    /// stores data in string section and returns its offset
+    uint32_t add(const char* data, size_t len) {
+        if (!len)
+            return 0;
+        string key(data, len);
+        map<string, uint32_t>::const_iterator it = Offsets_.find(key);
+        if (it != Offsets_.end())
+            return it->second;
+        uint32_t offset = Data_.size();
+        Data_.insert(Data_.end(), data, data + len);
+        Offsets_[key] = offset;
+        return offset;
+    }
+
+    const vector<char>& data() const { return Data_; }
+
+private:
+    vector<char> Data_;
+    map<string, uint32_t> Offsets_;
+};
+
+/// @brief returns name of the binary database that accompanies XML file
+///
+/// server-AddrMgr.xml is accompanied by server-AddrMgr.bin.
+///
+/// @param xmlFile name of the XML database
+///
+/// @return name of the binary database
+std::string TAddrMgr::binaryDbName(const std::string& xmlFile)
+{
+    string::size_type pos = xmlFile.rfind(".xml");
+    if (pos != string::npos && pos + 4 == xmlFile.size())
+        return xmlFile.substr(0, pos) + ".bin";
+    return xmlFile + ".bin";
+}
+
+/// @brief checks if binary database should be loaded instead of the XML one
+///
+/// Binary database is used if it exists and is not older than the XML file.
+/// This way manual edits of the XML file still take precedence.
+///
+/// @param xmlFile name of the XML database
+/// @param binFile name of the binary database
+///
+/// @return true if binary database should be used
+bool TAddrMgr::binaryDbPreferred(const char * xmlFile, const char * binFile)
+{
+    struct stat binStat, xmlStat;
+    if (stat(binFile, &binStat))
+        return false;
+    if (stat(xmlFile, &xmlStat))
+        return true;
+    if (binStat.st_mtime != xmlStat.st_mtime)
+        return binStat.st_mtime > xmlStat.st_mtime;
+
+    // both written within the same second
+#if defined(LINUX) || defined(SUNOS)
+    return binStat.st_mtim.tv_nsec >= xmlStat.st_mtim.tv_nsec;
+#elif defined(BSD)
+    return binStat.st_mtimespec.tv_nsec >= xmlStat.st_mtimespec.tv_nsec;
+#else
+    return true;
+#endif
+}
+
+/**
+ * @brief stores content of the AddrMgr database in binary format
+ *
+ * Whole database is serialized in memory first, then written to a temporary
+ * file that is renamed over the destination, so readers never see a partially
+ * written database. See AddrMgrBinary.h for the file layout.
+ *
+ * @param binFile name of the file to be written
+ *
+ * @return true if database was stored successfully
+ */
+bool TAddrMgr::dbStoreBinary(const char * binFile)
+{
+    vector<char> buf;
+    dbSerializeBinary(ClntsLst, buf);
+
+    string tmpFile = string(binFile) + ".tmp";
+    FILE* f = fopen(tmpFile.c_str(), "wb");
+    if (!f) {
+        Log(Error) << "Unable to create binary database file " << tmpFile << "." << LogEnd;
+        return false;
+    }
+
+    bool ok = fwrite(&buf[0], 1, buf.size(), f) == buf.size();
+#ifndef WIN32
+    // the database must be on disk before it replaces the old one (and before
+    // the lease journal is truncated)
+    if (ok && (fflush(f) || fsync(fileno(f))))
+        ok = false;
+#endif
+    if (fclose(f))
+        ok = false;
+
+    if (!ok) {
+        Log(Error) << "Failed to write binary database file " << tmpFile << "." << LogEnd;
+        unlink(tmpFile.c_str());
+        return false;
+    }
+
+#ifdef WIN32
+    // rename() does not overwrite existing files on Windows
+    unlink(binFile);
+#endif
+    if (rename(tmpFile.c_str(), binFile)) {
+        Log(Error) << "Unable to rename " << tmpFile << " to " << binFile << "." << LogEnd;
+        unlink(tmpFile.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief serializes clients in the binary database format
+ *
+ * Used to write the whole database (see dbStoreBinary()), but also to store
+ * single clients (e.g. server's lease journal).
+ *
+ * @param clients clients to be stored
+ * @param buf the database will be stored here
+ */
+void TAddrMgr::dbSerializeBinary(List(TAddrClient)& clients, std::vector<char>& buf)
+{
+    TAddrDbStrings strings;
+    vector<char> clientRecs, ias, leases;
+
+    uint32_t clientCnt = 0, iaCnt = 0, leaseCnt = 0;
+
+    SPtr<TAddrClient> client;
+    clients.first();
+    while (client = clients.get()) {
+
+        // IAs and PDs are stored together, TAs are not persisted (the same
+        // as in the XML database)
+        vector<pair<SPtr<TAddrIA>, TIAType> > iaLst;
+        SPtr<TAddrIA> ia;
+        client->firstIA();
+        while (ia = client->getIA())
+            iaLst.push_back(make_pair(ia, IATYPE_IA));
+        client->firstPD();
+        while (ia = client->getPD())
+            iaLst.push_back(make_pair(ia, IATYPE_PD));
+
+        char clnt[ADDRDB_CLIENT_REC_LEN];
+        memset(clnt, 0, sizeof(clnt));
+        SPtr<TDUID> duid = client->getDUID();
+        if (duid) {
+            writeUint32(clnt + ADDRDB_CLNT_DUID_OFF, strings.add(duid->get(), duid->getLen()));
+            writeUint16(clnt + ADDRDB_CLNT_DUID_LEN, duid->getLen());
+        }
+        if (!client->ReconfKey_.empty()) {
+            writeUint32(clnt + ADDRDB_CLNT_KEY_OFF,
+                        strings.add((const char*)&client->ReconfKey_[0],
+                                    client->ReconfKey_.size()));
+            writeUint16(clnt + ADDRDB_CLNT_KEY_LEN, client->ReconfKey_.size());
+        }
+        writeUint32(clnt + ADDRDB_CLNT_FIRST_IA, iaCnt);
+        writeUint32(clnt + ADDRDB_CLNT_IA_CNT, iaLst.size());
+        clientRecs.insert(clientRecs.end(), clnt, clnt + sizeof(clnt));
+
+        for (vector<pair<SPtr<TAddrIA>, TIAType> >::const_iterator it = iaLst.begin();
+             it != iaLst.end(); ++it) {
+            ia = it->first;
+            TIAType type = it->second;
+
+            char rec[ADDRDB_IA_REC_LEN];
+            memset(rec, 0, sizeof(rec));
+            uint8_t flags = 0;
+
+            writeUint32(rec + ADDRDB_IA_CLIENT, clientCnt);
+            writeUint8(rec + ADDRDB_IA_TYPE, type);
+            writeUint32(rec + ADDRDB_IA_IAID, ia->getIAID());
+            writeUint32(rec + ADDRDB_IA_T1, ia->getT1());
+            writeUint32(rec + ADDRDB_IA_T2, ia->getT2());
+            writeUint32(rec + ADDRDB_IA_IFINDEX, ia->getIfindex());
+
+            const string& ifname = ia->getIfacename();
+            writeUint32(rec + ADDRDB_IA_IFNAME_OFF, strings.add(ifname.c_str(), ifname.size()));
+            writeUint16(rec + ADDRDB_IA_IFNAME_LEN, ifname.size());
+
+            if (ia->getDUID()) {
+                SPtr<TDUID> iaDuid = ia->getDUID();
+                writeUint32(rec + ADDRDB_IA_DUID_OFF, strings.add(iaDuid->get(), iaDuid->getLen()));
+                writeUint16(rec + ADDRDB_IA_DUID_LEN, iaDuid->getLen());
+            }
+
+            if (ia->getSrvAddr()) {
+                flags |= ADDRDB_IA_FLAG_UNICAST;
+                memcpy(rec + ADDRDB_IA_UNICAST, ia->getSrvAddr()->getAddr(), 16);
+            }
+
+            if (type != IATYPE_PD) {
+                if (ia->getFQDNDnsServer()) {
+                    flags |= ADDRDB_IA_FLAG_DNS_SERVER;
+                    memcpy(rec + ADDRDB_IA_DNS_SERVER, ia->getFQDNDnsServer()->getAddr(), 16);
+                }
+                SPtr<TFQDN> fqdn = ia->getFQDN();
+                if (fqdn) {
+                    flags |= ADDRDB_IA_FLAG_FQDN;
+                    if (fqdn->isUsed())
+                        flags |= ADDRDB_IA_FLAG_FQDN_USED;
+                    string name = fqdn->getName();
+                    writeUint32(rec + ADDRDB_IA_FQDN_OFF, strings.add(name.c_str(), name.size()));
+                    writeUint16(rec + ADDRDB_IA_FQDN_LEN, name.size());
+                    SPtr<TDUID> fqdnDuid = fqdn->getDuid();
+                    if (fqdnDuid) {
+                        writeUint32(rec + ADDRDB_IA_FQDN_DUID_OFF,
+                                    strings.add(fqdnDuid->get(), fqdnDuid->getLen()));
+                        writeUint16(rec + ADDRDB_IA_FQDN_DUID_LEN, fqdnDuid->getLen());
+                    }
+                }
+            }
+            writeUint8(rec + ADDRDB_IA_FLAGS, flags);
+
+            // leases: addresses for IA, prefixes for PD
+            uint32_t firstLease = leaseCnt;
+            char lease[ADDRDB_LEASE_REC_LEN];
+            if (type == IATYPE_PD) {
+                SPtr<TAddrPrefix> prefix;
+                ia->firstPrefix();
+                while (prefix = ia->getPrefix()) {
+                    memset(lease, 0, sizeof(lease));
+                    memcpy(lease + ADDRDB_LEASE_ADDR, prefix->get()->getAddr(), 16);
+                    writeUint32(lease + ADDRDB_LEASE_PREF, prefix->getPref());
+                    writeUint32(lease + ADDRDB_LEASE_VALID, prefix->getValid());
+                    writeUint32(lease + ADDRDB_LEASE_TIMESTAMP, prefix->getTimestamp());
+                    writeUint8(lease + ADDRDB_LEASE_LENGTH, prefix->getLength());
+                    leases.insert(leases.end(), lease, lease + sizeof(lease));
+                    leaseCnt++;
+                }
+            } else {
+                SPtr<TAddrAddr> addr;
+                ia->firstAddr();
+                while (addr = ia->getAddr()) {
+                    memset(lease, 0, sizeof(lease));
+                    memcpy(lease + ADDRDB_LEASE_ADDR, addr->get()->getAddr(), 16);
+                    writeUint32(lease + ADDRDB_LEASE_PREF, addr->getPref());
+                    writeUint32(lease + ADDRDB_LEASE_VALID, addr->getValid());
+                    writeUint32(lease + ADDRDB_LEASE_TIMESTAMP, addr->getTimestamp());
+                    writeUint8(lease + ADDRDB_LEASE_LENGTH, addr->getPrefix());
+                    leases.insert(leases.end(), lease, lease + sizeof(lease));
+                    leaseCnt++;
+                }
+            }
+            writeUint32(rec + ADDRDB_IA_FIRST_LEASE, firstLease);
+            writeUint32(rec + ADDRDB_IA_LEASE_CNT, leaseCnt - firstLease);
+
+            ias.insert(ias.end(), rec, rec + sizeof(rec));
+            iaCnt++;
+        }
+        clientCnt++;
+    }
+
+    const vector<char>& str = strings.data();
+    uint32_t total = ADDRDB_HEADER_LEN + clientRecs.size() + ias.size() + leases.size() + str.size();
+
+    char hdr[ADDRDB_HEADER_LEN];
+    memset(hdr, 0, sizeof(hdr));
+    memcpy(hdr + ADDRDB_HDR_MAGIC, ADDRDB_MAGIC, ADDRDB_MAGIC_LEN);
+    writeUint16(hdr + ADDRDB_HDR_VERSION, ADDRDB_VERSION);
+    writeUint16(hdr + ADDRDB_HDR_HEADER_LEN, ADDRDB_HEADER_LEN);
+    writeUint64(hdr + ADDRDB_HDR_TIMESTAMP, (uint64_t)time(NULL));
+    writeUint64(hdr + ADDRDB_HDR_REPLAY, ReplayDetectionValue_);
+    writeUint32(hdr + ADDRDB_HDR_CLIENT_CNT, clientCnt);
+    writeUint32(hdr + ADDRDB_HDR_IA_CNT, iaCnt);
+    writeUint32(hdr + ADDRDB_HDR_LEASE_CNT, leaseCnt);
+    writeUint32(hdr + ADDRDB_HDR_STRINGS_LEN, str.size());
+    writeUint16(hdr + ADDRDB_HDR_CLIENT_LEN, ADDRDB_CLIENT_REC_LEN);
+    writeUint16(hdr + ADDRDB_HDR_IA_LEN, ADDRDB_IA_REC_LEN);
+    writeUint16(hdr + ADDRDB_HDR_LEASE_LEN, ADDRDB_LEASE_REC_LEN);
+    writeUint32(hdr + ADDRDB_HDR_TOTAL_LEN, total);
+
+    buf.clear();
+    buf.reserve(total);
+    buf.insert(buf.end(), hdr, hdr + sizeof(hdr));
+    buf.insert(buf.end(), clientRecs.begin(), clientRecs.end());
+    buf.insert(buf.end(), ias.begin(), ias.end());
+    buf.insert(buf.end(), leases.begin(), leases.end());
+    buf.insert(buf.end(), str.begin(), str.end());
+}
+
+/**
+ * @brief loads AddrMgr database stored in binary format
+ *
+ * The file is mapped into memory and parsed in place. Loaded clients are
+ * appended to the database only if the whole file is valid.
+ *
+ * @param binFile name of the binary database
+ *
+ * @return true if database was loaded successfully
+ */
+bool TAddrMgr::dbLoadBinary(const char * binFile)
+{
+    int fd = open(binFile, O_RDONLY);
+    if (fd < 0) {
+        Log(Warning) << "Unable to open " << binFile << "." << LogEnd;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size < ADDRDB_HEADER_LEN) {
+        Log(Warning) << "Binary database " << binFile << " is truncated." << LogEnd;
+        close(fd);
+        return false;
+    }
+    size_t len = st.st_size;
+
+    List(TAddrClient) loaded;
+#ifndef WIN32
+    void* map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        Log(Error) << "Unable to map binary database " << binFile << " into memory." << LogEnd;
+        return false;
+    }
+    const char* data = (const char*)map;
+    bool status = dbParseBinary(binFile, data, len, loaded);
+#else
+    vector<char> buf(len);
+    bool status = read(fd, &buf[0], len) == (int)len;
+    close(fd);
+    const char* data = &buf[0];
+    if (status)
+        status = dbParseBinary(binFile, data, len, loaded);
+#endif
+
+    if (status) {
+        uint64_t ts = readUint64(data + ADDRDB_HDR_TIMESTAMP);
+        uint32_t now = (uint32_t)time(NULL);
+        Log(Info) << "DB timestamp:" << ts << ", now()=" << now << ", db is " << (now - ts)
+                  << " second(s) old." << LogEnd;
+
+        SPtr<TAddrClient> client;
+        loaded.first();
+        while (client = loaded.get())
+            ClntsLst.append(client);
+        Log(Debug) << loaded.count() << " client(s) loaded from " << binFile << "." << LogEnd;
+    }
+#ifndef WIN32
+    munmap(map, len);
+#endif
+
+    return status;
+}
+
+/**
+ * @brief parses binary database that is already loaded into memory
+ *
+ * Leases are verified in the same way as they are when loading XML database
+ * (see parseAddrIA() and parseAddrPD()).
+ *
+ * @param binFile name of the binary database (used for logging only)
+ * @param buf buffer that holds the database
+ * @param len length of the buffer
+ * @param loaded loaded clients will be appended here (only if the whole
+ *        buffer is valid)
+ *
+ * @return true if the buffer contains a valid database
+ */
+bool TAddrMgr::dbParseBinary(const char * binFile, const char * buf, size_t len,
+                             List(TAddrClient)& loaded)
+{
+    if (len < ADDRDB_HEADER_LEN || memcmp(buf + ADDRDB_HDR_MAGIC, ADDRDB_MAGIC, ADDRDB_MAGIC_LEN)) {
+        Log(Warning) << "File " << binFile << " is not a binary lease database." << LogEnd;
+        return false;
+    }
+    uint16_t version = readUint16(buf + ADDRDB_HDR_VERSION);
+    if (version != ADDRDB_VERSION) {
+        Log(Warning) << "Binary database " << binFile << " has unsupported version "
+                     << version << " (expected " << ADDRDB_VERSION << ")." << LogEnd;
+        return false;
+    }
+
+    size_t hdrLen    = readUint16(buf + ADDRDB_HDR_HEADER_LEN);
+    size_t clientCnt = readUint32(buf + ADDRDB_HDR_CLIENT_CNT);
+    size_t iaCnt     = readUint32(buf + ADDRDB_HDR_IA_CNT);
+    size_t leaseCnt  = readUint32(buf + ADDRDB_HDR_LEASE_CNT);
+    size_t strLen    = readUint32(buf + ADDRDB_HDR_STRINGS_LEN);
+    size_t clientLen = readUint16(buf + ADDRDB_HDR_CLIENT_LEN);
+    size_t iaLen     = readUint16(buf + ADDRDB_HDR_IA_LEN);
+    size_t leaseLen  = readUint16(buf + ADDRDB_HDR_LEASE_LEN);
+
+    const char* clients = buf + hdrLen;
+    const char* ias     = clients + clientCnt * clientLen;
+    const char* leases  = ias + iaCnt * iaLen;
+    const char* str     = leases + leaseCnt * leaseLen;
+
+    if (hdrLen < ADDRDB_HEADER_LEN || clientLen < ADDRDB_CLIENT_REC_LEN ||
+        iaLen < ADDRDB_IA_REC_LEN || leaseLen < ADDRDB_LEASE_REC_LEN ||
+        readUint32(buf + ADDRDB_HDR_TOTAL_LEN) != len ||
+        (uint64_t)hdrLen + (uint64_t)clientCnt * clientLen + (uint64_t)iaCnt * iaLen
+        + (uint64_t)leaseCnt * leaseLen + strLen != len) {
+        Log(Warning) << "Binary database " << binFile << " is truncated or corrupted." << LogEnd;
+        return false;
+    }
+
+    List(TAddrClient) parsed;
+    for (size_t c = 0; c < clientCnt; c++) {
+        const char* clnt = clients + c * clientLen;
+
+        uint32_t duidOff = readUint32(clnt + ADDRDB_CLNT_DUID_OFF);
+        uint16_t duidLen = readUint16(clnt + ADDRDB_CLNT_DUID_LEN);
+        uint32_t keyOff  = readUint32(clnt + ADDRDB_CLNT_KEY_OFF);
+        uint16_t keyLen  = readUint16(clnt + ADDRDB_CLNT_KEY_LEN);
+        size_t firstIA   = readUint32(clnt + ADDRDB_CLNT_FIRST_IA);
+        size_t clntIAs   = readUint32(clnt + ADDRDB_CLNT_IA_CNT);
+        if ((uint64_t)duidOff + duidLen > strLen || (uint64_t)keyOff + keyLen > strLen ||
+            (uint64_t)firstIA + clntIAs > iaCnt) {
+            Log(Warning) << "Binary database " << binFile << ": client record " << c
+                         << " is corrupted." << LogEnd;
+            return false;
+        }
+
+        SPtr<TAddrClient> client = new TAddrClient(new TDUID(str + duidOff, duidLen));
+        client->ReconfKey_.assign(str + keyOff, str + keyOff + keyLen);
+
+        for (size_t i = firstIA; i < firstIA + clntIAs; i++) {
+            const char* rec = ias + i * iaLen;
+
+            uint8_t type  = readUint8(rec + ADDRDB_IA_TYPE);
+            uint8_t flags = readUint8(rec + ADDRDB_IA_FLAGS);
+            uint32_t ifnameOff   = readUint32(rec + ADDRDB_IA_IFNAME_OFF);
+            uint16_t ifnameLen   = readUint16(rec + ADDRDB_IA_IFNAME_LEN);
+            uint32_t iaDuidOff   = readUint32(rec + ADDRDB_IA_DUID_OFF);
+            uint16_t iaDuidLen   = readUint16(rec + ADDRDB_IA_DUID_LEN);
+            uint32_t fqdnOff     = readUint32(rec + ADDRDB_IA_FQDN_OFF);
+            uint16_t fqdnLen     = readUint16(rec + ADDRDB_IA_FQDN_LEN);
+            uint32_t fqdnDuidOff = readUint32(rec + ADDRDB_IA_FQDN_DUID_OFF);
+            uint16_t fqdnDuidLen = readUint16(rec + ADDRDB_IA_FQDN_DUID_LEN);
+            size_t firstLease    = readUint32(rec + ADDRDB_IA_FIRST_LEASE);
+            size_t iaLeases      = readUint32(rec + ADDRDB_IA_LEASE_CNT);
+            if ((type != IATYPE_IA && type != IATYPE_PD) ||
+                (uint64_t)ifnameOff + ifnameLen > strLen ||
+                (uint64_t)iaDuidOff + iaDuidLen > strLen ||
+                (uint64_t)fqdnOff + fqdnLen > strLen ||
+                (uint64_t)fqdnDuidOff + fqdnDuidLen > strLen ||
+                (uint64_t)firstLease + iaLeases > leaseCnt) {
+                Log(Warning) << "Binary database " << binFile << ": IA record " << i
+                             << " is corrupted." << LogEnd;
+                return false;
+            }
+
+            SPtr<TDUID> iaDuid;
+            if (iaDuidLen)
+                iaDuid = new TDUID(str + iaDuidOff, iaDuidLen);
+
+            SPtr<TAddrIA> ia = new TAddrIA(string(str + ifnameOff, ifnameLen),
+                                           (int)readUint32(rec + ADDRDB_IA_IFINDEX),
+                                           (TIAType)type, SPtr<TIPv6Addr>(), iaDuid,
+                                           readUint32(rec + ADDRDB_IA_T1),
+                                           readUint32(rec + ADDRDB_IA_T2),
+                                           readUint32(rec + ADDRDB_IA_IAID));
+            if (type == IATYPE_PD)
+                ia->setState(STATE_CONFIRMME);
+
+            for (size_t l = firstLease; l < firstLease + iaLeases; l++) {
+                const char* lease = leases + l * leaseLen;
+                uint32_t pref      = readUint32(lease + ADDRDB_LEASE_PREF);
+                uint32_t valid     = readUint32(lease + ADDRDB_LEASE_VALID);
+                uint32_t timestamp = readUint32(lease + ADDRDB_LEASE_TIMESTAMP);
+                int length         = readUint8(lease + ADDRDB_LEASE_LENGTH);
+                if (!pref || !valid || !timestamp)
+                    continue; // the same leases are ignored by XML parser
+
+                SPtr<TIPv6Addr> addr = new TIPv6Addr(lease + ADDRDB_LEASE_ADDR);
+                if (type == IATYPE_PD) {
+                    if (!verifyPrefix(addr)) {
+                        Log(Debug) << "Prefix " << addr->getPlain()
+                                   << " does no longer match current configuration. Lease dropped."
+                                   << LogEnd;
+                        continue;
+                    }
+                    SPtr<TAddrPrefix> prefix = new TAddrPrefix(addr, pref, valid, length);
+                    prefix->setTimestamp(timestamp);
+                    ia->addPrefix(prefix);
+                    prefix->setTentative(ADDRSTATUS_NO);
+                } else {
+                    if (!verifyAddr(addr)) {
+                        Log(Debug) << "Address " << addr->getPlain()
+                                   << " is no longer supported. Lease dropped." << LogEnd;
+                        continue;
+                    }
+                    SPtr<TAddrAddr> addrAddr = new TAddrAddr(addr, pref, valid, length);
+                    addrAddr->setTimestamp(timestamp);
+                    ia->addAddr(addrAddr);
+                    addrAddr->setTentative(ADDRSTATUS_NO);
+                }
+            }
+            ia->setTentative();
+
+            if (flags & ADDRDB_IA_FLAG_UNICAST)
+                ia->setUnicast(new TIPv6Addr(rec + ADDRDB_IA_UNICAST));
+            if (flags & ADDRDB_IA_FLAG_DNS_SERVER)
+                ia->setFQDNDnsServer(new TIPv6Addr(rec + ADDRDB_IA_DNS_SERVER));
+            if (flags & ADDRDB_IA_FLAG_FQDN) {
+                SPtr<TDUID> fqdnDuid;
+                if (fqdnDuidLen)
+                    fqdnDuid = new TDUID(str + fqdnDuidOff, fqdnDuidLen);
+                ia->setFQDN(new TFQDN(fqdnDuid, string(str + fqdnOff, fqdnLen),
+                                      (flags & ADDRDB_IA_FLAG_FQDN_USED) != 0));
+            }
+
+            if (type == IATYPE_PD) {
+                if (ia->countPrefix())
+                    client->addPD(ia);
+                else
+                    Log(Debug) << "PD with iaid=" << ia->getIAID()
+                               << " has no valid prefixes." << LogEnd;
+            } else {
+                if (ia->countAddr())
+                    client->addIA(ia);
+                else
+                    Log(Debug) << "IA with iaid=" << ia->getIAID()
+                               << " has no valid addresses." << LogEnd;
+            }
+        }
+
+        if (client->countIA() + client->countPD() > 0) {
+            parsed.append(client);
+        } else {
+            Log(Info) << "All client's " << client->getDUID()->getPlain()
+                      << " leases are not valid." << LogEnd;
+        }
+    }
+
+    uint64_t replay = readUint64(buf + ADDRDB_HDR_REPLAY);
+    if (replay > ReplayDetectionValue_)
+        ReplayDetectionValue_ = replay;
+
+    SPtr<TAddrClient> client;
+    parsed.first();
+    while (client = parsed.get())
+        loaded.append(client);
+    return true;
+}
@@ -0,0 +1,101 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef ADDRMGRBINARY_H
+#define ADDRMGRBINARY_H
+
+/// @file AddrMgrBinary.h
+///
+/// @brief On-disk layout of the binary lease database.
+///
+/// The binary database holds exactly the same information as the XML dump
+/// produced by TAddrMgr::dump(), but in a form that can be mapped into memory
+/// and walked without any text parsing. All integers are stored in network
+/// byte order. The file consists of a fixed header followed by four sections,
+/// stored back to back in this order:
+///
+/// - client records (ADDRDB_CLIENT_REC_LEN bytes each)
+/// - IA records (ADDRDB_IA_REC_LEN bytes each), grouped by client
+/// - lease records (ADDRDB_LEASE_REC_LEN bytes each), grouped by IA. Whether
+///   a lease is an address or a prefix is determined by the type of its IA.
+/// - string section: variable length data (DUIDs, reconfigure keys, interface
+///   names and FQDNs), referenced by (offset, length) pairs. Identical strings
+///   are stored only once.
+///
+/// The header stores record lengths, so a newer writer may append fields to
+/// records without breaking older readers. Incompatible changes must bump
+/// ADDRDB_VERSION.
+
+#define ADDRDB_MAGIC          "DIBLEASE"
+#define ADDRDB_MAGIC_LEN      8
+#define ADDRDB_VERSION        1
+
+#define ADDRDB_HEADER_LEN     64
+#define ADDRDB_CLIENT_REC_LEN 24
+#define ADDRDB_IA_REC_LEN     96
+#define ADDRDB_LEASE_REC_LEN  32
+
+/// header: offsets of the fields
+#define ADDRDB_HDR_MAGIC       0  ///< 8 bytes: ADDRDB_MAGIC
+#define ADDRDB_HDR_VERSION     8  ///< uint16: format version
+#define ADDRDB_HDR_HEADER_LEN  10 ///< uint16: length of this header
+#define ADDRDB_HDR_FLAGS       12 ///< uint32: reserved, must be 0
+#define ADDRDB_HDR_TIMESTAMP   16 ///< uint64: time of the dump
+#define ADDRDB_HDR_REPLAY      24 ///< uint64: replay detection value
+#define ADDRDB_HDR_CLIENT_CNT  32 ///< uint32: number of client records
+#define ADDRDB_HDR_IA_CNT      36 ///< uint32: number of IA records
+#define ADDRDB_HDR_LEASE_CNT   40 ///< uint32: number of lease records
+#define ADDRDB_HDR_STRINGS_LEN 44 ///< uint32: length of the string section
+#define ADDRDB_HDR_CLIENT_LEN  48 ///< uint16: length of a client record
+#define ADDRDB_HDR_IA_LEN      50 ///< uint16: length of an IA record
+#define ADDRDB_HDR_LEASE_LEN   52 ///< uint16: length of a lease record
+#define ADDRDB_HDR_TOTAL_LEN   56 ///< uint32: length of the whole file
+
+/// client record
+#define ADDRDB_CLNT_DUID_OFF   0  ///< uint32: DUID (string section offset)
+#define ADDRDB_CLNT_DUID_LEN   4  ///< uint16: DUID length
+#define ADDRDB_CLNT_KEY_LEN    6  ///< uint16: reconfigure key length
+#define ADDRDB_CLNT_KEY_OFF    8  ///< uint32: reconfigure key
+#define ADDRDB_CLNT_FIRST_IA   12 ///< uint32: index of the first IA record
+#define ADDRDB_CLNT_IA_CNT     16 ///< uint32: number of IA records
+
+/// IA record
+#define ADDRDB_IA_CLIENT       0  ///< uint32: index of the owning client
+#define ADDRDB_IA_TYPE         4  ///< uint8: TIAType (IA or PD)
+#define ADDRDB_IA_FLAGS        5  ///< uint8: ADDRDB_IA_FLAG_* bits
+#define ADDRDB_IA_IAID         8  ///< uint32: IAID
+#define ADDRDB_IA_T1           12 ///< uint32: T1
+#define ADDRDB_IA_T2           16 ///< uint32: T2
+#define ADDRDB_IA_IFINDEX      20 ///< uint32: interface index
+#define ADDRDB_IA_IFNAME_OFF   24 ///< uint32: interface name
+#define ADDRDB_IA_IFNAME_LEN   28 ///< uint16: interface name length
+#define ADDRDB_IA_DUID_LEN     30 ///< uint16: IA DUID length
+#define ADDRDB_IA_DUID_OFF     32 ///< uint32: IA DUID
+#define ADDRDB_IA_FQDN_OFF     36 ///< uint32: FQDN name
+#define ADDRDB_IA_FQDN_LEN     40 ///< uint16: FQDN name length
+#define ADDRDB_IA_FQDN_DUID_LEN 42 ///< uint16: FQDN DUID length
+#define ADDRDB_IA_FQDN_DUID_OFF 44 ///< uint32: FQDN DUID
+#define ADDRDB_IA_FIRST_LEASE  48 ///< uint32: index of the first lease record
+#define ADDRDB_IA_LEASE_CNT    52 ///< uint32: number of lease records
+#define ADDRDB_IA_UNICAST      56 ///< 16 bytes: unicast address
+#define ADDRDB_IA_DNS_SERVER   72 ///< 16 bytes: DNS server used for the update
+
+#define ADDRDB_IA_FLAG_UNICAST    0x01 ///< unicast address is valid
+#define ADDRDB_IA_FLAG_DNS_SERVER 0x02 ///< DNS server address is valid
+#define ADDRDB_IA_FLAG_FQDN       0x04 ///< FQDN is present
+#define ADDRDB_IA_FLAG_FQDN_USED  0x08 ///< FQDN is marked as used
+
+/// lease record
+#define ADDRDB_LEASE_ADDR      0  ///< 16 bytes: address or prefix
+#define ADDRDB_LEASE_PREF      16 ///< uint32: preferred lifetime
+#define ADDRDB_LEASE_VALID     20 ///< uint32: valid lifetime
+#define ADDRDB_LEASE_TIMESTAMP 24 ///< uint32: timestamp
+#define ADDRDB_LEASE_LENGTH    28 ///< uint8: prefix length
+
+#endif
@@ -0,0 +1,244 @@
+#include <IPv6Addr.h>
+#include <AddrMgr.h>
+#include <gtest/gtest.h>
+#include <DUID.h>
+#include <sstream>
+#include <fstream>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace test {
+
+    class NakedAddrMgrBin : public TAddrMgr {
+    public:
+        NakedAddrMgrBin(const std::string& addrdb, bool loadfile):
+            TAddrMgr(addrdb, loadfile) {
+        }
+        virtual void print(std::ostream& s) {
+        }
+        uint64_t getReplayDetectionValue() {
+            return ReplayDetectionValue_;
+        }
+    };
+
+    // returns XML representation of the database without timestamp line
+    std::string dumpWithoutTimestamp(TAddrMgr& mgr) {
+        std::ostringstream xml;
+        xml << mgr;
+        std::istringstream in(xml.str());
+        std::string line, result;
+        while (getline(in, line)) {
+            if (line.find("<timestamp>") == std::string::npos)
+                result += line + "\n";
+        }
+        return result;
+    }
+
+TEST(AddrMgrBinaryTest, binaryDbName) {
+    EXPECT_EQ("server-AddrMgr.bin", TAddrMgr::binaryDbName("server-AddrMgr.xml"));
+    EXPECT_EQ("leases.bin", TAddrMgr::binaryDbName("leases"));
+    EXPECT_EQ("my.xml.db.bin", TAddrMgr::binaryDbName("my.xml.db"));
+}
+
+// checks that XML database converted to binary format and back is the same
+TEST(AddrMgrBinaryTest, xmlRoundTrip) {
+    NakedAddrMgrBin xml("server-AddrMgr-0.8.3.xml", true);
+    ASSERT_EQ(3, xml.countClient());
+
+    unlink("binary-roundtrip.bin");
+    ASSERT_TRUE(xml.dbStoreBinary("binary-roundtrip.bin"));
+
+    NakedAddrMgrBin bin("non-existing.xml", false);
+    ASSERT_TRUE(bin.dbLoadBinary("binary-roundtrip.bin"));
+    EXPECT_EQ(3, bin.countClient());
+
+    EXPECT_EQ(dumpWithoutTimestamp(xml), dumpWithoutTimestamp(bin));
+
+    unlink("binary-roundtrip.bin");
+}
+
+// checks that FQDN, DNS server, unicast and reconfigure key are stored
+TEST(AddrMgrBinaryTest, storeDetails) {
+    NakedAddrMgrBin mgr("non-existing.xml", false);
+
+    SPtr<TDUID> duid = new TDUID("00:01:00:0a:0b:0c:0d:0e:0f");
+    SPtr<TAddrClient> client = new TAddrClient(duid);
+    client->generateReconfKey();
+
+    SPtr<TIPv6Addr> unicast = new TIPv6Addr("fe80::1", true);
+    SPtr<TAddrIA> ia = new TAddrIA("eth0", 7, IATYPE_IA, unicast, duid, 100, 200, 5);
+    ia->addAddr(new TIPv6Addr("2001:db8::1", true), 300, 400);
+    ia->setFQDNDnsServer(new TIPv6Addr("2001:db8::53", true));
+    ia->setFQDN(new TFQDN(duid, "host.example.com", true));
+    client->addIA(ia);
+
+    SPtr<TAddrIA> pd = new TAddrIA("eth0", 7, IATYPE_PD, SPtr<TIPv6Addr>(), duid, 100, 200, 6);
+    pd->addPrefix(new TIPv6Addr("2001:db8:1::", true), 300, 400, 56);
+    client->addPD(pd);
+    mgr.addClient(client);
+
+    unlink("binary-details.bin");
+    ASSERT_TRUE(mgr.dbStoreBinary("binary-details.bin"));
+
+    NakedAddrMgrBin bin("non-existing.xml", false);
+    ASSERT_TRUE(bin.dbLoadBinary("binary-details.bin"));
+    ASSERT_EQ(1, bin.countClient());
+
+    bin.firstClient();
+    SPtr<TAddrClient> loaded = bin.getClient();
+    ASSERT_TRUE(loaded);
+    EXPECT_TRUE(*loaded->getDUID() == *duid);
+    EXPECT_TRUE(loaded->ReconfKey_ == client->ReconfKey_);
+    ASSERT_EQ(1, loaded->countIA());
+    ASSERT_EQ(1, loaded->countPD());
+
+    loaded->firstIA();
+    SPtr<TAddrIA> loadedIA = loaded->getIA();
+    ASSERT_TRUE(loadedIA);
+    EXPECT_EQ(5u, loadedIA->getIAID());
+    EXPECT_EQ(100u, loadedIA->getT1());
+    EXPECT_EQ(200u, loadedIA->getT2());
+    EXPECT_EQ("eth0", loadedIA->getIfacename());
+    EXPECT_EQ(7, loadedIA->getIfindex());
+    ASSERT_TRUE(loadedIA->getSrvAddr());
+    EXPECT_TRUE(*loadedIA->getSrvAddr() == *unicast);
+    ASSERT_TRUE(loadedIA->getFQDNDnsServer());
+    EXPECT_EQ("2001:db8::53", std::string(loadedIA->getFQDNDnsServer()->getPlain()));
+    ASSERT_TRUE(loadedIA->getFQDN());
+    EXPECT_EQ("host.example.com", loadedIA->getFQDN()->getName());
+    EXPECT_TRUE(loadedIA->getFQDN()->isUsed());
+    ASSERT_TRUE(loadedIA->getFQDN()->getDuid());
+    EXPECT_TRUE(*loadedIA->getFQDN()->getDuid() == *duid);
+
+    loadedIA->firstAddr();
+    SPtr<TAddrAddr> addr = loadedIA->getAddr();
+    ASSERT_TRUE(addr);
+    EXPECT_EQ("2001:db8::1", std::string(addr->get()->getPlain()));
+    EXPECT_EQ(300u, addr->getPref());
+    EXPECT_EQ(400u, addr->getValid());
+
+    loaded->firstPD();
+    SPtr<TAddrIA> loadedPD = loaded->getPD();
+    ASSERT_TRUE(loadedPD);
+    EXPECT_EQ(6u, loadedPD->getIAID());
+    EXPECT_FALSE(loadedPD->getSrvAddr());
+    loadedPD->firstPrefix();
+    SPtr<TAddrPrefix> prefix = loadedPD->getPrefix();
+    ASSERT_TRUE(prefix);
+    EXPECT_EQ("2001:db8:1::", std::string(prefix->get()->getPlain()));
+    EXPECT_EQ(56, prefix->getLength());
+
+    unlink("binary-details.bin");
+}
+
+// checks that FQDN stored without DUID is loaded without it
+TEST(AddrMgrBinaryTest, fqdnWithoutDuid) {
+    NakedAddrMgrBin mgr("non-existing.xml", false);
+
+    SPtr<TDUID> duid = new TDUID("00:01:00:0a:0b:0c:0d:0e:0f");
+    SPtr<TAddrClient> client = new TAddrClient(duid);
+    SPtr<TAddrIA> ia = new TAddrIA("eth0", 7, IATYPE_IA, SPtr<TIPv6Addr>(), duid, 100, 200, 5);
+    ia->addAddr(new TIPv6Addr("2001:db8::1", true), 300, 400);
+    ia->setFQDN(new TFQDN("host.example.com", false));
+    client->addIA(ia);
+    mgr.addClient(client);
+
+    unlink("binary-fqdn.bin");
+    ASSERT_TRUE(mgr.dbStoreBinary("binary-fqdn.bin"));
+
+    NakedAddrMgrBin bin("non-existing.xml", false);
+    ASSERT_TRUE(bin.dbLoadBinary("binary-fqdn.bin"));
+    bin.firstClient();
+    SPtr<TAddrClient> loaded = bin.getClient();
+    ASSERT_TRUE(loaded);
+    loaded->firstIA();
+    SPtr<TAddrIA> loadedIA = loaded->getIA();
+    ASSERT_TRUE(loadedIA);
+    ASSERT_TRUE(loadedIA->getFQDN());
+    EXPECT_EQ("host.example.com", loadedIA->getFQDN()->getName());
+    EXPECT_FALSE(loadedIA->getFQDN()->getDuid());
+
+    unlink("binary-fqdn.bin");
+}
+
+// checks that modification times are compared with sub-second precision
+TEST(AddrMgrBinaryTest, binaryDbPreferred) {
+    std::ofstream("binary-mtime.xml").close();
+    std::ofstream("binary-mtime.bin").close();
+
+    struct timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = 1000000;
+    times[0].tv_nsec = times[1].tv_nsec = 500000000;
+    ASSERT_EQ(0, utimensat(AT_FDCWD, "binary-mtime.xml", times, 0));
+
+    times[0].tv_nsec = times[1].tv_nsec = 400000000;
+    ASSERT_EQ(0, utimensat(AT_FDCWD, "binary-mtime.bin", times, 0));
+    EXPECT_FALSE(TAddrMgr::binaryDbPreferred("binary-mtime.xml", "binary-mtime.bin"));
+
+    times[0].tv_nsec = times[1].tv_nsec = 600000000;
+    ASSERT_EQ(0, utimensat(AT_FDCWD, "binary-mtime.bin", times, 0));
+    EXPECT_TRUE(TAddrMgr::binaryDbPreferred("binary-mtime.xml", "binary-mtime.bin"));
+
+    // binary database only
+    unlink("binary-mtime.xml");
+    EXPECT_TRUE(TAddrMgr::binaryDbPreferred("binary-mtime.xml", "binary-mtime.bin"));
+    unlink("binary-mtime.bin");
+    EXPECT_FALSE(TAddrMgr::binaryDbPreferred("binary-mtime.xml", "binary-mtime.bin"));
+}
+
+// checks that binary database is preferred by dbLoad() when it is present
+TEST(AddrMgrBinaryTest, dbLoadPrefersBinary) {
+    NakedAddrMgrBin xml("server-AddrMgr-0.8.3.xml", true);
+    for (int i = 0; i < 5; i++)
+        xml.getNextReplayDetectionValue();
+    unlink("binary-only.xml");
+    ASSERT_TRUE(xml.dbStoreBinary("binary-only.bin"));
+
+    // there is no binary-only.xml, so binary-only.bin must have been used
+    NakedAddrMgrBin bin("binary-only.xml", true);
+    EXPECT_EQ(3, bin.countClient());
+    EXPECT_EQ(xml.getReplayDetectionValue(), bin.getReplayDetectionValue());
+
+    unlink("binary-only.bin");
+}
+
+// checks that truncated or corrupted files are rejected
+TEST(AddrMgrBinaryTest, corrupted) {
+    NakedAddrMgrBin xml("server-AddrMgr-0.8.3.xml", true);
+    ASSERT_TRUE(xml.dbStoreBinary("binary-corrupted.bin"));
+
+    std::string content;
+    {
+        std::ifstream f("binary-corrupted.bin", std::ios::binary);
+        std::ostringstream tmp;
+        tmp << f.rdbuf();
+        content = tmp.str();
+    }
+    ASSERT_GT(content.size(), 64u);
+
+    // truncated file
+    {
+        std::ofstream f("binary-corrupted.bin", std::ios::binary | std::ios::trunc);
+        f.write(content.c_str(), content.size() - 1);
+    }
+    NakedAddrMgrBin mgr("non-existing.xml", false);
+    EXPECT_FALSE(mgr.dbLoadBinary("binary-corrupted.bin"));
+    EXPECT_EQ(0, mgr.countClient());
+
+    // bad magic
+    {
+        std::string bad = content;
+        bad[0] = 'X';
+        std::ofstream f("binary-corrupted.bin", std::ios::binary | std::ios::trunc);
+        f.write(bad.c_str(), bad.size());
+    }
+    EXPECT_FALSE(mgr.dbLoadBinary("binary-corrupted.bin"));
+    EXPECT_EQ(0, mgr.countClient());
+
+    // not existing file
+    unlink("binary-corrupted.bin");
+    EXPECT_FALSE(mgr.dbLoadBinary("binary-corrupted.bin"));
+}
+
+}
@@ -25,12 +25,7 @@ THostRange::THostRange( SPtr<TIPv6Addr> addrl, SPtr<TIPv6Addr> addrr)
 bool THostRange::in(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr) const
 {
     if (isAddrRange_)
-    {
-        if ((*addr<=*AddrL_)&&(*AddrL_<=*addr)) return true;
-        if ((*addr<=*AddrR_)&&(*AddrR_<=*addr)) return true;
-        if (*addr<=*AddrL_) return false;
-        if (*AddrR_<=*addr) return false;
-    }
+        return in(addr);
     else
     {
         if (!duid)
@@ -43,14 +38,16 @@ bool THostRange::in(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr) const
 }
 
 bool THostRange::in(SPtr<TIPv6Addr> addr) const
+{
+    return in(addr->getValue());
+}
+
+bool THostRange::in(const TIPv6AddrValue& addr) const
 {
     if (isAddrRange_)
     {
-        if ((*addr<=*AddrL_)&&(*AddrL_<=*addr)) return true;
-        if ((*addr<=*AddrR_)&&(*AddrR_<=*addr)) return true;
-        if (*addr<=*AddrL_) return false;
-        if (*AddrR_<=*addr) return false;
-        return true;
+        // compared as two 64-bit words, no temporary objects are created
+        return (AddrL_->getValue() <= addr) && (addr <= AddrR_->getValue());
     } else
         return false;
 }
@@ -97,14 +94,10 @@ SPtr<TIPv6Addr> THostRange::getRandomPrefix() const {
 
 unsigned long THostRange::rangeCount() const {
     if(isAddrRange_) {
-        SPtr<TIPv6Addr> diff(new TIPv6Addr());
-        *diff=(*AddrR_)-(*AddrL_);
-        char *addr=diff->getAddr();
-        for(int i=0;i<12;i++)
-        {
-            if (addr[i]>0) return DHCPV6_INFINITY;
-        }
-        unsigned long retVal = addr[12]*256*256*256 + addr[13]*256*256 + addr[14]*256 + addr[15];
+        TIPv6AddrValue diff = AddrR_->getValue() - AddrL_->getValue();
+        if (diff.getHi() || (diff.getLo() >> 32))
+            return DHCPV6_INFINITY;
+        unsigned long retVal = (unsigned long)diff.getLo();
         if (retVal!=DHCPV6_INFINITY)
             return retVal + 1;
         return retVal;
@@ -27,6 +27,7 @@ class THostRange
     ~THostRange(void);
     bool in(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr) const;
     bool in(SPtr<TIPv6Addr> addr) const;
+    bool in(const TIPv6AddrValue& addr) const;
     bool in(SPtr<TDUID> duid) const;
     SPtr<TIPv6Addr> getRandomAddr() const;
     SPtr<TIPv6Addr> getRandomPrefix() const;
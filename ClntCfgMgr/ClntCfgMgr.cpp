@@ -26,6 +26,7 @@ using namespace std;
 #include "ClntParsGlobalOpt.h"
 #include "ClntParser.h"
 #include "hex.h"
+#include "KeyStore.h"
 
 TClntCfgMgr * TClntCfgMgr::Instance = 0;
 
@@ -741,14 +742,14 @@ bool TClntCfgMgr::setGlobalOptions(ClntParser * parser)
         }
 
         // now let's try to load specified key
-        unsigned len = 0;
-        char * ptr = getAAAKey(SPI_, &len);
-        if (len == 0) {
+        // key stays cached, so it is not read again for every message
+        TKey key;
+        if (!TKeyStore::instance().get(SPI_, key)) {
             Log(Crit) << "Auth: Failed to load AAA key from file "
                       << getAAAKeyFilename(SPI_) << LogEnd;
             return false;
         }
-        free(ptr); // we don't really need the key yet.
+        TKeyStore::wipe(key); // we don't really need the key yet.
     }
 #endif
 
@@ -11,6 +11,8 @@
 
 #include <sstream>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include "Portable.h"
 #include "SmartPtr.h"
@@ -20,6 +22,7 @@
 #include "ClntMsgRenew.h"
 #include "ClntMsgAdvertise.h"
 #include "ClntMsgReconfigure.h"
+#include "DHCPDefaults.h"
 #include "Logger.h"
 
 
@@ -106,6 +109,13 @@ SPtr<TClntMsg> TClntIfaceMgr::select(unsigned int timeout)
 
     sockid = TIfaceMgr::select(timeout, buf, bufsize, peer, myaddr);
 
+    // read address and link notifications, they are processed in processEvents()
+    if (Monitor_.isActive()) {
+        if (!Monitor_.read())
+            LinksChanged_ = true;
+        setEventFD(Monitor_.getFD());
+    }
+
     if (sockid>0) {
         if (bufsize<4) {
             if (bufsize == 1 && buf[0] == CONTROL_MSG) {
@@ -174,7 +184,7 @@ SPtr<TClntMsg> TClntIfaceMgr::select(unsigned int timeout)
 }
 
 TClntIfaceMgr::TClntIfaceMgr(const std::string& xmlFile)
-    : TIfaceMgr(xmlFile, false)
+    : TIfaceMgr(xmlFile, false), LinksChanged_(false)
 {
     struct iface * ptr;
     struct iface * ifaceList;
@@ -216,6 +226,10 @@ TClntIfaceMgr::TClntIfaceMgr(const std::string& xmlFile)
     if_list_release(ifaceList); // allocated in pure C, and so release it there
 
     dump();
+
+    // DAD results and link changes are reported by the kernel (if supported)
+    if (Monitor_.open())
+        setEventFD(Monitor_.getFD());
 }
 
 TClntIfaceMgr::~TClntIfaceMgr() {
@@ -269,16 +283,24 @@ bool TClntIfaceMgr::doDuties() {
                             string fqdn = iface->getFQDN();
                             if (ClntAddrMgr().countIA() > 0 && DNSSrvLst.count() > 0 && fqdn.size() > 0) {
 
-                                Log(Warning) << "Sleeping 3 seconds before performing DNS Update." << LogEnd;
-                                /** @todo: sleep cannot be performed here. What if client has to perform other
-                                   action during those 3 seconds? */
-#ifdef WIN32
-                            Sleep(3);
-#else
-                            sleep(3);
-#endif
-                            this->fqdnAdd(iface, fqdn);
-                        }
+                                // The address must not be used before DAD is finished. Don't wait
+                                // here, DAD result (or its timeout) wakes up the main loop.
+                                SPtr<TAddrIA> ia;
+                                ClntAddrMgr().firstIA();
+                                while (ia = ClntAddrMgr().getIA()) {
+                                    if (ia->getIfindex() == iface->getID())
+                                        break;
+                                }
+                                if (!ia)
+                                    continue;
+                                if (ia->getTentative() != ADDRSTATUS_NO) {
+                                    Log(Debug) << "FQDN: DNS Update postponed, DAD is not finished for IA (IAID="
+                                               << ia->getIAID() << ")." << LogEnd;
+                                    continue;
+                                }
+                                this->fqdnAdd(iface, fqdn);
+                                cfgIface->setFQDNState(STATE_CONFIGURED);
+                            }
                   }
               }
     }
@@ -308,12 +330,15 @@ bool TClntIfaceMgr::fqdnAdd(SPtr<TClntIfaceIface> iface, const std::string& fqdn
     DNSSrvLst.first();
     DNSAddr = DNSSrvLst.get();
 
-    // And the first IP address
+    // And the first IP address of the IA bound to this interface
     SPtr<TAddrIA> ptrAddrIA;
     ClntAddrMgr().firstIA();
-    ptrAddrIA = ClntAddrMgr().getIA();
+    while (ptrAddrIA = ClntAddrMgr().getIA()) {
+        if (ptrAddrIA->getIfindex() == iface->getID())
+            break;
+    }
 
-    if (ptrAddrIA->countAddr() > 0) {
+    if (ptrAddrIA && ptrAddrIA->countAddr() > 0) {
         ptrAddrIA->firstAddr();
         addr = ptrAddrIA->getAddr()->get();
 
@@ -717,6 +742,12 @@ void TClntIfaceMgr::redetectIfaces() {
     struct iface  * ptr;
     struct iface  * ifaceList;
     SPtr<TIfaceIface> iface;
+
+    // if links are tracked, interfaces need to be read only after a change
+    if (Monitor_.isActive() && !LinksChanged_)
+        return;
+    LinksChanged_ = false;
+
     ifaceList = if_list_get(); // external (C coded) function
     ptr = ifaceList;
 
@@ -749,6 +780,152 @@ void TClntIfaceMgr::redetectIfaces() {
     if_list_release(ifaceList); // allocated in pure C, and so release it there
 }
 
+/// returns true if address and link changes are reported by the kernel
+bool TClntIfaceMgr::eventsActive() const {
+    return Monitor_.isActive();
+}
+
+/// @brief applies address and link changes reported since the last call
+///
+/// DAD results are stored in the address database, so checkDecline() can
+/// act on them without asking the kernel. Link changes trigger CONFIRM
+/// (if enabled) and interface redetection in inactive mode.
+void TClntIfaceMgr::processEvents() {
+    if (!Monitor_.isActive())
+        return;
+
+    std::vector<TIfaceMonitor::TEvent> events;
+    Monitor_.getEvents(events);
+    for (std::vector<TIfaceMonitor::TEvent>::const_iterator ev = events.begin();
+         ev != events.end(); ++ev)
+        handleEvent(*ev);
+
+    // addresses configured before their IA was stored, or changed while
+    // notifications were lost
+    syncAddrStates();
+}
+
+/// @brief applies single address or link event
+///
+/// @param event event reported by the monitor
+void TClntIfaceMgr::handleEvent(const TIfaceMonitor::TEvent& event) {
+    switch (event.type) {
+    case TIfaceMonitor::EVENT_DAD_DONE:
+        if (setAddrState(event.ifindex, event.addr, ADDRSTATUS_NO))
+            Log(Debug) << "DAD finished successfully. Address " << event.addr.getPlain()
+                       << " is not tentative." << LogEnd;
+        break;
+    case TIfaceMonitor::EVENT_DAD_FAILED:
+        if (setAddrState(event.ifindex, event.addr, ADDRSTATUS_YES))
+            Log(Warning) << "DAD failed. Address " << event.addr.getPlain()
+                         << " is duplicate." << LogEnd;
+        break;
+    case TIfaceMonitor::EVENT_ADDR_REMOVED:
+        break;
+    case TIfaceMonitor::EVENT_LINK_UP:
+    case TIfaceMonitor::EVENT_LINK_DOWN:
+    {
+        SPtr<TIfaceIface> iface = getIfaceByID(event.ifindex);
+        if (!iface)
+            break;
+        LinksChanged_ = true;
+        Log(Notice) << "Link " << iface->getFullName() << " is "
+                    << (event.type == TIfaceMonitor::EVENT_LINK_UP ? "up" : "down")
+                    << "." << LogEnd;
+#ifdef MOD_CLNT_CONFIRM
+        if (event.type == TIfaceMonitor::EVENT_LINK_UP && ClntCfgMgr().useConfirm()) {
+            link_state_notify_t links;
+            memset(&links, 0, sizeof(links));
+            links.ifindex[links.cnt++] = event.ifindex;
+            ClntAddrMgr().setIA2Confirm(&links);
+        }
+#endif
+        break;
+    }
+    }
+}
+
+/// @brief sets DAD status of an address stored in the address database
+///
+/// @param ifindex interface index
+/// @param addr address
+/// @param state new state
+///
+/// @return true if address was found and its state has changed
+bool TClntIfaceMgr::setAddrState(int ifindex, const TIPv6AddrValue& addr, EAddrStatus state) {
+    SPtr<TIPv6Addr> tmp = new TIPv6Addr(addr);
+    SPtr<TAddrIA> ia;
+    ClntAddrMgr().firstIA();
+    while (ia = ClntAddrMgr().getIA()) {
+        if (ia->getIfindex() != ifindex)
+            continue;
+        SPtr<TAddrAddr> ptrAddr = ia->getAddr(tmp);
+        if (!ptrAddr)
+            continue;
+        if (ptrAddr->getTentative() == state)
+            return false;
+        ptrAddr->setTentative(state);
+        ia->setTentative();
+        return true;
+    }
+    return false;
+}
+
+/// @brief resolves DAD status of addresses that are still unknown
+///
+/// Uses address table maintained by the monitor, so the kernel is not
+/// asked (see is_addr_tentative()). If DAD did not finish within
+/// DADTIMEOUT, the address is treated the same way as
+/// TAddrIA::getTentative() would: as duplicate if it is still tentative
+/// and as usable if it is not configured at all.
+void TClntIfaceMgr::syncAddrStates() {
+    unsigned long now = (unsigned long)time(NULL);
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC_RAW, &ts) == 0)
+        now = (unsigned long)ts.tv_sec; // the same clock as used for address timestamps
+
+    SPtr<TAddrIA> ia;
+    ClntAddrMgr().firstIA();
+    while (ia = ClntAddrMgr().getIA()) {
+        bool changed = false;
+        SPtr<TAddrAddr> ptrAddr;
+        ia->firstAddr();
+        while (ptrAddr = ia->getAddr()) {
+            if (ptrAddr->getTentative() != ADDRSTATUS_UNKNOWN)
+                continue;
+            bool timeout = ptrAddr->getTimestamp() + DADTIMEOUT < now;
+            switch (Monitor_.getDadState(ia->getIfindex(), ptrAddr->getValue())) {
+            case TIfaceMonitor::DAD_DONE:
+                ptrAddr->setTentative(ADDRSTATUS_NO);
+                changed = true;
+                break;
+            case TIfaceMonitor::DAD_FAILED:
+                ptrAddr->setTentative(ADDRSTATUS_YES);
+                changed = true;
+                break;
+            case TIfaceMonitor::DAD_IN_PROGRESS:
+                if (timeout) {
+                    Log(Warning) << "DAD failed. Address " << ptrAddr->get()->getPlain()
+                                 << " is still tentative." << LogEnd;
+                    ptrAddr->setTentative(ADDRSTATUS_YES);
+                    changed = true;
+                }
+                break;
+            case TIfaceMonitor::DAD_UNKNOWN:
+                if (timeout) {
+                    Log(Error) << "DAD inconclusive. Address " << ptrAddr->get()->getPlain()
+                               << " is not configured. Assuming NOT TENTATIVE." << LogEnd;
+                    ptrAddr->setTentative(ADDRSTATUS_NO);
+                    changed = true;
+                }
+                break;
+            }
+        }
+        if (changed)
+            ia->setTentative();
+    }
+}
+
 #ifdef MOD_REMOTE_AUTOCONF
 bool TClntIfaceMgr::notifyRemoteScripts(SPtr<TIPv6Addr> rcvdAddr, SPtr<TIPv6Addr> srvAddr, int ifindex) {
 
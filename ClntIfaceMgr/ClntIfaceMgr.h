@@ -23,6 +23,7 @@ class TClntIfaceIface;
 #include "ClntTransMgr.h"
 #include "ClntIfaceIface.h"
 #include "IPv6Addr.h"
+#include "IfaceMonitor.h"
 #include "ClntMsg.h"
 #include "ScriptParams.h"
 
@@ -79,6 +80,11 @@ public:
 
     void redetectIfaces();
 
+    // --- address and link events ---
+    bool eventsActive() const;
+    void processEvents();
+    void handleEvent(const TIfaceMonitor::TEvent& event);
+
     int numBits(int i);
 
     SPtr<TIPv6Addr> calculateSubprefix(const SPtr<TIPv6Addr>& prefix, int prefixLen,
@@ -90,8 +96,14 @@ public:
                       unsigned int pref, unsigned int valid, PrefixModifyMode mode,
                       TNotifyScriptParams* params /*= NULL*/);
 
+    bool setAddrState(int ifindex, const TIPv6AddrValue& addr, EAddrStatus state);
+    void syncAddrStates();
+
     std::string XmlFile;
 
+    TIfaceMonitor Monitor_; // tracks addresses and links (if supported)
+    bool LinksChanged_;     // link event received, interfaces need to be redetected
+
     static TClntIfaceMgr* Instance;
 };
 
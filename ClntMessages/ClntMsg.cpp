@@ -367,7 +367,11 @@ void TClntMsg::send()
 
     RC++;
 
-    storeSelf(pkt);
+    int len = storeSelf(pkt, size);
+    if (len < 0) {
+        delete [] pkt;
+        return;
+    }
 
     SPtr<TIfaceIface> ptrIface = ClntIfaceMgr().getIfaceByID(Iface);
     if (!ptrIface) {
@@ -385,7 +389,7 @@ void TClntMsg::send()
 	}
 	Log(Cont) << ") on " << ptrIface->getName()
 		   << "/" << Iface << " to unicast addr " << *PeerAddr_ << "." << LogEnd;
-	ClntIfaceMgr().sendUnicast(Iface,pkt,getSize(),PeerAddr_);
+	ClntIfaceMgr().sendUnicast(Iface,pkt,len,PeerAddr_);
     } else {
 	Log(Debug) << "Sending " << this->getName() << "(opts:";
 	SPtr<TOpt> opt;
@@ -395,7 +399,7 @@ void TClntMsg::send()
 	}
 	Log(Cont) << ") on " << ptrIface->getName()
 		   << "/" << Iface << " to multicast." << LogEnd;
-	ClntIfaceMgr().sendMulticast(Iface, pkt, getSize());
+	ClntIfaceMgr().sendMulticast(Iface, pkt, len);
     }
     LastTimeStamp = time(NULL);
     delete [] pkt;
@@ -469,6 +469,9 @@ void TClntTransMgr::doDuties()
 
     if (!this->Shutdown && !this->IsDone) {
 
+        // apply DAD results and link changes reported by the kernel
+        ClntIfaceMgr().processEvents();
+
         // did we switched links lately?
         // are there any IAs to confirm?
         checkConfirm();
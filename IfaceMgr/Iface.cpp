@@ -299,6 +299,58 @@ bool TIfaceIface::addSocket(SPtr<TIPv6Addr> addr,int port, bool ifaceonly, bool
     return true;
 }
 
+/// @brief binds several sockets to the same address and port
+///
+/// Received packets are spread among the sockets by the kernel, packets of
+/// one client (or relay) go to the same socket if the system supports it
+/// (see sock_steer()). Sockets are added in order, so the i-th of them is
+/// the i-th shard. If sockets can't share address and port on this system,
+/// just one (ordinary) socket is bound.
+///
+/// @param addr address to bind to
+/// @param port port to bind to
+/// @param ifaceonly should the sockets be bound to this interface only?
+/// @param shards number of sockets
+///
+/// @return number of sockets bound (0 if failed)
+unsigned int TIfaceIface::addSocketShards(SPtr<TIPv6Addr> addr, int port, bool ifaceonly,
+                                          unsigned int shards) {
+    if (shards <= 1)
+        return addSocket(addr, port, ifaceonly, false) ? 1 : 0;
+
+    SPtr<TIfaceSocket> first = new TIfaceSocket(this->Name, this->ID, port, addr, ifaceonly,
+                                                LOWLEVEL_REUSE_PORT);
+    if (first->getStatus() != STATE_CONFIGURED) {
+        Log(Warning) << "Unable to bind " << shards << " sockets to " << addr->getPlain()
+                     << " on " << getFullName() << ", one socket used." << LogEnd;
+        return addSocket(addr, port, ifaceonly, false) ? 1 : 0;
+    }
+    SocketsLst.append(first);
+
+    unsigned int cnt = 1;
+    while (cnt < shards) {
+        SPtr<TIfaceSocket> ptr = new TIfaceSocket(this->Name, this->ID, port, addr, ifaceonly,
+                                                  LOWLEVEL_REUSE_PORT);
+        if (ptr->getStatus() != STATE_CONFIGURED)
+            break;
+        SocketsLst.append(ptr);
+        cnt++;
+    }
+    if (cnt < shards) {
+        Log(Warning) << "Only " << cnt << " of " << shards << " sockets bound to "
+                     << addr->getPlain() << " on " << getFullName() << "." << LogEnd;
+    }
+
+    if (sock_steer(first->getFD(), cnt) < 0) {
+        Log(Info) << "Packets received on " << addr->getPlain() << " are spread among "
+                  << cnt << " sockets by the system (" << error_message() << ")." << LogEnd;
+    } else {
+        Log(Debug) << "Packets received on " << addr->getPlain() << " are spread among "
+                   << cnt << " sockets by client." << LogEnd;
+    }
+    return cnt;
+}
+
 #if 0
 /*
  * binds socket on whole interface
@@ -68,6 +68,8 @@ class TIfaceIface{
     
     // ---socket related---
     bool addSocket(SPtr<TIPv6Addr> addr,int port, bool ifaceonly, bool reuse);
+    unsigned int addSocketShards(SPtr<TIPv6Addr> addr, int port, bool ifaceonly,
+                                 unsigned int shards);
     // bool addSocket(int port, bool ifaceonly, bool reuse); 
     bool delSocket(int id);
     void firstSocket();
@@ -36,6 +36,8 @@ TIfaceMgr::TIfaceMgr(const std::string& xmlFile, bool getIfaces)
 {
     this->XmlFile = xmlFile;
     this->IsDone  = false;
+    this->EventFD_ = -1;
+    this->LastFD_ = -1;
     struct iface  * ptr;
     struct iface  * ifaceList;
 
@@ -149,7 +151,8 @@ SPtr<TIfaceIface> TIfaceMgr::getIfaceBySocket(int fd) {
 /// @param peer [out] sender address
 /// @param myaddr [out] local IPv6 address
 ///
-/// @return socket descriptor (or negative values for errors)
+/// @return socket descriptor (or negative values for errors), 0 if only
+///         event descriptor (see setEventFD()) is ready
 int TIfaceMgr::select(unsigned long time, char *buf,
                       int &bufsize, SPtr<TIPv6Addr> peer,
                       SPtr<TIPv6Addr> myaddr) {
@@ -174,9 +177,17 @@ int TIfaceMgr::select(unsigned long time, char *buf,
     int maxFD;
     maxFD = TIfaceSocket::getMaxFD() + 1;
 
+    if (EventFD_ >= 0) {
+        if (!TIfaceSocket::getCount())
+            FD_ZERO(&fds);
+        FD_SET(EventFD_, &fds);
+        if (maxFD <= EventFD_)
+            maxFD = EventFD_ + 1;
+    }
+
     // no sockets to listen  on... hopefully this is just inactive mode,
     // not an error
-    if (!TIfaceSocket::getCount()) {
+    if (!TIfaceSocket::getCount() && EventFD_ < 0) {
         Log(Debug) << "No sockets open. Sleeping for " << time << " seconds." << LogEnd;
 #ifdef WIN32
         Sleep(time*1000); // Windows sleep is specified in milliseconds
@@ -201,34 +212,50 @@ int TIfaceMgr::select(unsigned long time, char *buf,
         return -1;
     }
 
+    if (EventFD_ >= 0 && FD_ISSET(EventFD_, &fds)) {
+        if (result == 1) {
+            // nothing received, caller is expected to read events
+            bufsize = 0;
+            return 0;
+        }
+        FD_CLR(EventFD_, &fds);
+    }
+
+    // ready sockets are served in turns (the first one after the socket
+    // served last time), so busy socket (e.g. one of several sockets
+    // bound to the same address) doesn't starve the others
     SPtr<TIfaceIface> iface;
     SPtr<TIfaceSocket> sock;
-    bool found = 0;
+    SPtr<TIfaceIface> ptrIface;
+    SPtr<TIfaceSocket> ptrSock;
     IfaceLst.first();
-    while ( (!found) && (iface = IfaceLst.get()) ) {
-        iface->firstSocket();
-        while ( sock = iface->getSocket() ) {
-            if (FD_ISSET(sock->getFD(),&fds)) {
-                found = true;
-                break;
+    while (ptrIface = IfaceLst.get()) {
+        ptrIface->firstSocket();
+        while (ptrSock = ptrIface->getSocket()) {
+            int fd = ptrSock->getFD();
+            if (!FD_ISSET(fd, &fds))
+                continue;
+            bool next = fd > LastFD_;
+            if (!sock || (next && sock->getFD() <= LastFD_) ||
+                (next == (sock->getFD() > LastFD_) && fd < sock->getFD())) {
+                iface = ptrIface;
+                sock = ptrSock;
             }
         }
     }
 
-    if (!found) {
+    if (!sock) {
         Log(Error) << "Internal error. Can't find any socket with incoming data." << LogEnd;
         return -1;
     }
 
-    char myPlainAddr[48];   // my plain address
-    char peerPlainAddr[48]; // peer plain address
+    LastFD_ = sock->getFD();
 
-    // receive data (pure C function used)
-    result = sock_recv(sock->getFD(), myPlainAddr, peerPlainAddr, buf, bufsize);
     char peerAddrPacked[16];
     char myAddrPacked[16];
-    inet_pton6(peerPlainAddr,peerAddrPacked);
-    inet_pton6(myPlainAddr,myAddrPacked);
+
+    // receive data (pure C function used), addresses are already packed
+    result = sock_recv_packed(sock->getFD(), myAddrPacked, peerAddrPacked, buf, bufsize);
     peer->setAddr(peerAddrPacked);
     myaddr->setAddr(myAddrPacked);
 
@@ -246,7 +273,7 @@ int TIfaceMgr::select(unsigned long time, char *buf,
     if (!iface->flagLoopback()
         && memcmp(sock->getAddr()->getAddr(), myAddrPacked, 16)
         && memcmp(sock->getAddr()->getAddr(), anycast, 16) ) {
-            Log(Debug) << "Received data on address " << myPlainAddr << ", expected "
+            Log(Debug) << "Received data on address " << *myaddr << ", expected "
                    << *sock->getAddr() << ", message ignored." << LogEnd;
             bufsize = 0;
             return -1;
@@ -257,6 +284,15 @@ int TIfaceMgr::select(unsigned long time, char *buf,
     return sock->getFD();
 }
 
+/// @brief sets additional descriptor to be watched by select()
+///
+/// select() returns 0 when only this descriptor is ready.
+///
+/// @param fd descriptor (or -1 to disable)
+void TIfaceMgr::setEventFD(int fd) {
+    EventFD_ = fd;
+}
+
 /*
  * returns interface count
  */
@@ -38,6 +38,7 @@ class TIfaceMgr {
     // ---other---
     int select(unsigned long time, char *buf, int &bufsize, SPtr<TIPv6Addr> peer,
                SPtr<TIPv6Addr> myaddr);
+    void setEventFD(int fd);
     std::string printMac(char * mac, int macLen);
     void dump();
     bool isDone();
@@ -59,6 +60,8 @@ class TIfaceMgr {
     std::string XmlFile;
     List(TIfaceIface) IfaceLst; //Interface list
     bool IsDone;
+    int EventFD_; // additional descriptor watched by select() (e.g. address events)
+    int LastFD_;  // socket served by the last select()
 };
 
 #endif
@@ -0,0 +1,242 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "IfaceMonitor.h"
+#include "Logger.h"
+
+using namespace std;
+
+TIfaceMonitor::TIfaceMonitor()
+    :FD_(-1), Initial_(false) {
+}
+
+TIfaceMonitor::~TIfaceMonitor() {
+    close();
+}
+
+/// @brief opens notification socket and loads current state of links and addresses
+///
+/// @return true if notifications are supported, false otherwise
+bool TIfaceMonitor::open() {
+    if (FD_ >= 0)
+        return true;
+
+    // state loaded from the dump replaces whatever was known before and
+    // is not reported as events
+    Addrs_.clear();
+    Links_.clear();
+    Initial_ = true;
+    FD_ = addr_events_open(&TIfaceMonitor::handler, this);
+    Initial_ = false;
+
+    if (FD_ < 0) {
+        FD_ = -1;
+        return false;
+    }
+    Log(Debug) << "Tracking address and link changes (" << Addrs_.size()
+               << " IPv6 address(es), " << Links_.size() << " link(s) present)." << LogEnd;
+    return true;
+}
+
+void TIfaceMonitor::close() {
+    if (FD_ < 0)
+        return;
+    addr_events_close(FD_);
+    FD_ = -1;
+}
+
+bool TIfaceMonitor::isActive() const {
+    return FD_ >= 0;
+}
+
+/// returns descriptor to be added to select() (or -1)
+int TIfaceMonitor::getFD() const {
+    return FD_;
+}
+
+/// @brief reads pending notifications, does not block
+///
+/// If notifications were lost (e.g. receive buffer overflow), socket is
+/// reopened and current state is loaded again. Differences against the
+/// known state are reported as events.
+///
+/// @return false if notifications were lost
+bool TIfaceMonitor::read() {
+    if (FD_ < 0)
+        return true;
+
+    if (addr_events_read(FD_, &TIfaceMonitor::handler, this) >= 0)
+        return true;
+
+    Log(Warning) << "Address and link notifications lost: " << error_message()
+                 << ", reloading." << LogEnd;
+    map<TAddrKey, int> oldAddrs;
+    map<int, int> oldLinks;
+    oldAddrs.swap(Addrs_);
+    oldLinks.swap(Links_);
+    close();
+    open();
+    resync(oldAddrs, oldLinks);
+    return false;
+}
+
+/// @brief reports differences between state known before the reload and the fresh dump
+///
+/// @param oldAddrs addresses known before the notifications were lost
+/// @param oldLinks links known before the notifications were lost
+void TIfaceMonitor::resync(const std::map<TAddrKey, int>& oldAddrs,
+                           const std::map<int, int>& oldLinks) {
+    for (map<TAddrKey, int>::const_iterator old = oldAddrs.begin(); old != oldAddrs.end(); ++old) {
+        if (Addrs_.find(old->first) == Addrs_.end())
+            addEvent(EVENT_ADDR_REMOVED, old->first.first, old->first.second);
+    }
+    for (map<TAddrKey, int>::const_iterator it = Addrs_.begin(); it != Addrs_.end(); ++it) {
+        map<TAddrKey, int>::const_iterator old = oldAddrs.find(it->first);
+        EDadState was = (old == oldAddrs.end()) ? DAD_UNKNOWN : dadState(old->second);
+        EDadState state = dadState(it->second);
+        if (state == was)
+            continue;
+        if (state == DAD_DONE)
+            addEvent(EVENT_DAD_DONE, it->first.first, it->first.second);
+        else if (state == DAD_FAILED)
+            addEvent(EVENT_DAD_FAILED, it->first.first, it->first.second);
+    }
+
+    for (map<int, int>::const_iterator old = oldLinks.begin(); old != oldLinks.end(); ++old) {
+        map<int, int>::const_iterator it = Links_.find(old->first);
+        bool running = (it != Links_.end()) && (it->second & ADDR_EVENT_FLAG_RUNNING);
+        if ((old->second & ADDR_EVENT_FLAG_RUNNING) && !running)
+            addEvent(EVENT_LINK_DOWN, old->first, TIPv6AddrValue());
+    }
+    for (map<int, int>::const_iterator it = Links_.begin(); it != Links_.end(); ++it) {
+        map<int, int>::const_iterator old = oldLinks.find(it->first);
+        bool wasRunning = (old != oldLinks.end()) && (old->second & ADDR_EVENT_FLAG_RUNNING);
+        if ((it->second & ADDR_EVENT_FLAG_RUNNING) && !wasRunning)
+            addEvent(EVENT_LINK_UP, it->first, TIPv6AddrValue());
+    }
+}
+
+void TIfaceMonitor::handler(const addr_event_t* event, void* arg) {
+    static_cast<TIfaceMonitor*>(arg)->handle(*event);
+}
+
+TIfaceMonitor::EDadState TIfaceMonitor::dadState(int flags) {
+    if (flags & ADDR_EVENT_FLAG_DADFAILED)
+        return DAD_FAILED;
+    if (flags & ADDR_EVENT_FLAG_TENTATIVE)
+        return DAD_IN_PROGRESS;
+    return DAD_DONE;
+}
+
+void TIfaceMonitor::addEvent(EEventType type, int ifindex, const TIPv6AddrValue& addr) {
+    if (Initial_)
+        return;
+    TEvent event;
+    event.type = type;
+    event.ifindex = ifindex;
+    event.addr = addr;
+    Events_.push_back(event);
+}
+
+/// @brief updates state using single notification
+///
+/// @param event notification received from the kernel
+void TIfaceMonitor::handle(const addr_event_t& event) {
+    switch (event.type) {
+    case ADDR_EVENT_NEW_ADDR:
+    {
+        TAddrKey key(event.ifindex, TIPv6AddrValue(event.addr));
+        map<TAddrKey, int>::iterator it = Addrs_.find(key);
+        EDadState old = (it == Addrs_.end()) ? DAD_UNKNOWN : dadState(it->second);
+        EDadState state = dadState(event.flags);
+        Addrs_[key] = event.flags;
+
+        if (state == old)
+            break;
+        if (state == DAD_DONE)
+            addEvent(EVENT_DAD_DONE, key.first, key.second);
+        else if (state == DAD_FAILED)
+            addEvent(EVENT_DAD_FAILED, key.first, key.second);
+        break;
+    }
+    case ADDR_EVENT_DEL_ADDR:
+    {
+        TAddrKey key(event.ifindex, TIPv6AddrValue(event.addr));
+        if (Addrs_.erase(key))
+            addEvent(EVENT_ADDR_REMOVED, key.first, key.second);
+        break;
+    }
+    case ADDR_EVENT_NEW_LINK:
+    {
+        map<int, int>::iterator it = Links_.find(event.ifindex);
+        bool wasRunning = (it != Links_.end()) && (it->second & ADDR_EVENT_FLAG_RUNNING);
+        bool running = (event.flags & ADDR_EVENT_FLAG_RUNNING);
+        Links_[event.ifindex] = event.flags;
+
+        if (running && !wasRunning)
+            addEvent(EVENT_LINK_UP, event.ifindex, TIPv6AddrValue());
+        else if (!running && wasRunning)
+            addEvent(EVENT_LINK_DOWN, event.ifindex, TIPv6AddrValue());
+        break;
+    }
+    case ADDR_EVENT_DEL_LINK:
+    {
+        map<int, int>::iterator it = Links_.find(event.ifindex);
+        if (it == Links_.end())
+            break;
+        if (it->second & ADDR_EVENT_FLAG_RUNNING)
+            addEvent(EVENT_LINK_DOWN, event.ifindex, TIPv6AddrValue());
+        Links_.erase(it);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/// @brief returns events that happened since the last call
+///
+/// @param events events will be stored here (previous content is removed)
+///
+/// @return true if there are any events
+bool TIfaceMonitor::getEvents(std::vector<TEvent>& events) {
+    events.clear();
+    events.swap(Events_);
+    return !events.empty();
+}
+
+/// @brief returns DAD state of the address
+///
+/// @param ifindex interface index
+/// @param addr address
+///
+/// @return DAD state (DAD_UNKNOWN if address is not configured)
+TIfaceMonitor::EDadState TIfaceMonitor::getDadState(int ifindex,
+                                                    const TIPv6AddrValue& addr) const {
+    map<TAddrKey, int>::const_iterator it = Addrs_.find(TAddrKey(ifindex, addr));
+    if (it == Addrs_.end())
+        return DAD_UNKNOWN;
+    return dadState(it->second);
+}
+
+/// @brief returns link state
+///
+/// @param ifindex interface index
+///
+/// @return 1 if link is running, 0 if it is down, -1 if it is not known
+int TIfaceMonitor::getLinkState(int ifindex) const {
+    map<int, int>::const_iterator it = Links_.find(ifindex);
+    if (it == Links_.end())
+        return -1;
+    return (it->second & ADDR_EVENT_FLAG_RUNNING) ? 1 : 0;
+}
+
+size_t TIfaceMonitor::countAddrs() const {
+    return Addrs_.size();
+}
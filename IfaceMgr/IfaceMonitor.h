@@ -0,0 +1,86 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef IFACEMONITOR_H
+#define IFACEMONITOR_H
+
+#include <map>
+#include <vector>
+#include "IPv6Addr.h"
+#include "Portable.h"
+
+/// @brief Tracks addresses and links using notifications from the kernel.
+///
+/// A socket subscribed to address and link notifications (netlink on
+/// Linux) is kept open and its descriptor is added to the main select()
+/// loop. State of every IPv6 address (DAD in progress, finished or failed)
+/// and of every link is kept in memory, so checking a single address does
+/// not require dumping all addresses from the kernel. Changes that matter
+/// to the client (DAD finished or failed, link went up or down) are queued
+/// as events, see getEvents().
+///
+/// On systems without notification support open() fails and callers are
+/// expected to fall back to polling (is_addr_tentative(), if_list_get()).
+class TIfaceMonitor
+{
+  public:
+    typedef enum {
+        DAD_UNKNOWN,     // address not present
+        DAD_IN_PROGRESS, // address is tentative
+        DAD_DONE,        // address can be used
+        DAD_FAILED       // address is duplicate
+    } EDadState;
+
+    typedef enum {
+        EVENT_DAD_DONE,
+        EVENT_DAD_FAILED,
+        EVENT_ADDR_REMOVED,
+        EVENT_LINK_UP,
+        EVENT_LINK_DOWN
+    } EEventType;
+
+    struct TEvent {
+        EEventType type;
+        int ifindex;
+        TIPv6AddrValue addr; // not used for link events
+    };
+
+    TIfaceMonitor();
+    ~TIfaceMonitor();
+
+    bool open();
+    void close();
+    bool isActive() const;
+    int getFD() const;
+    bool read();
+
+    void handle(const addr_event_t& event);
+    bool getEvents(std::vector<TEvent>& events);
+
+    EDadState getDadState(int ifindex, const TIPv6AddrValue& addr) const;
+    int getLinkState(int ifindex) const;
+    size_t countAddrs() const;
+
+  private:
+    static void handler(const addr_event_t* event, void* arg);
+    static EDadState dadState(int flags);
+    void addEvent(EEventType type, int ifindex, const TIPv6AddrValue& addr);
+
+    typedef std::pair<int, TIPv6AddrValue> TAddrKey;
+
+    void resync(const std::map<TAddrKey, int>& oldAddrs, const std::map<int, int>& oldLinks);
+
+    std::map<TAddrKey, int> Addrs_; // address flags (ADDR_EVENT_FLAG_*)
+    std::map<int, int> Links_;      // link flags (ADDR_EVENT_FLAG_*)
+    std::vector<TEvent> Events_;    // events not retrieved yet
+    int FD_;
+    bool Initial_;                  // initial state is being loaded, don't report events
+};
+
+#endif
@@ -34,10 +34,10 @@ int TIfaceSocket::MaxFD=0;
  * @param port    UDP port, to which socket will be bound
  * @param addr    IPv6 address 
  * @param ifaceonly force interface-only flag in setsockopt()?
- * @param reuse   should socket be bound with reuse flag in setsockopt()?
+ * @param reuse   reuse flags (0, LOWLEVEL_REUSE_ADDR or LOWLEVEL_REUSE_PORT)
  */
 TIfaceSocket::TIfaceSocket(char * iface, int ifindex, int port,
-				   SPtr<TIPv6Addr> addr, bool ifaceonly, bool reuse) { 
+				   SPtr<TIPv6Addr> addr, bool ifaceonly, int reuse) { 
     if (this->Count==0) {
 	FD_ZERO(getFDS());
     }
@@ -56,9 +56,9 @@ enum EState TIfaceSocket::getStatus() {
  * @param ifaceid    interface index
  * @param port       UDP port, to which socket will be bound
  * @param ifaceonly  force interface-only flag in setsockopt()?
- * @param reuse      should socket be bound with reuse flag in setsockopt()?
+ * @param reuse      reuse flags (0, LOWLEVEL_REUSE_ADDR or LOWLEVEL_REUSE_PORT)
  */
-TIfaceSocket::TIfaceSocket(char * iface,int ifaceid, int port,bool ifaceonly, bool reuse) {
+TIfaceSocket::TIfaceSocket(char * iface,int ifaceid, int port,bool ifaceonly, int reuse) {
     if (this->Count==0) {
 	FD_ZERO(getFDS());
     }
@@ -77,12 +77,12 @@ TIfaceSocket::TIfaceSocket(char * iface,int ifaceid, int port,bool ifaceonly, bo
  * @param port - port, to which socket will be bound
  * @param addr - address 
  * @param ifaceonly - force interface-only flag in setsockopt()
- * @param reuse should socket be bound with reuse flag in setsockopt()?
+ * @param reuse reuse flags (0, LOWLEVEL_REUSE_ADDR or LOWLEVEL_REUSE_PORT)
  *
  * @return negative error code (or 0 if everything is ok)
  */
 int TIfaceSocket::createSocket(char * iface, int ifaceid, SPtr<TIPv6Addr> addr, 
-				   int port, bool ifaceonly, bool reuse) {
+				   int port, bool ifaceonly, int reuse) {
     int sock;
 
     // store info about this socket 
@@ -101,7 +101,7 @@ int TIfaceSocket::createSocket(char * iface, int ifaceid, SPtr<TIPv6Addr> addr,
 
     // create socket
     sock = sock_add(this->Iface, this->IfaceID, addr->getPlain(), 
-		    this->Port, ifaceonly?1:0, reuse?1:0);
+		    this->Port, ifaceonly?1:0, reuse);
 
     if (sock<0) {
 	printError(sock, iface, ifaceid, addr, port);
@@ -151,23 +151,20 @@ int TIfaceSocket::send(char * buf,int len, SPtr<TIPv6Addr> addr,int port) {
  * @param addr - will contain info about sender
  */
 int TIfaceSocket::recv(char * buf, SPtr<TIPv6Addr> addr) {
-    char myPlainAddr[48];
-    char peerPlainAddr[48];
+    char myAddr[16];
+    char peerAddr[16];
 
     // maximum DHCPv6 packet size
     int len=1500;
 
-    len = sock_recv(this->FD, myPlainAddr, peerPlainAddr, buf, len);
+    len = sock_recv_packed(this->FD, myAddr, peerAddr, buf, len);
 
     if ( len  < 0 ) {
 	printError(len, this->Iface, this->IfaceID, addr, this->Port);
         return -1;
     }
 
-    // convert to packed form (plain->16-byte)
-    char packedAddr[16];
-    inet_pton6(peerPlainAddr,packedAddr);
-    addr->setAddr(packedAddr);
+    addr->setAddr(peerAddr);
     return len;
 }
 
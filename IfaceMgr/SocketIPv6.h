@@ -31,9 +31,9 @@ class TIfaceSocket {
     friend std::ostream& operator<<(std::ostream& strum, TIfaceSocket &x);
  public:
     TIfaceSocket(char * iface,int ifaceid, int port, 
-		     SPtr<TIPv6Addr> addr, bool ifaceonly, bool reuse);
+		     SPtr<TIPv6Addr> addr, bool ifaceonly, int reuse);
     TIfaceSocket(char * iface,int ifaceid, int port,
-		     bool ifaceonly, bool reuse);
+		     bool ifaceonly, int reuse);
    
     // ---transmission---
     int send(char * buf,int len, SPtr<TIPv6Addr> addr,int port);
@@ -59,7 +59,7 @@ class TIfaceSocket {
  private:
     // adds socket to this interface
     int createSocket(char * iface, int ifaceid, SPtr<TIPv6Addr> addr, 
-		     int port, bool ifaceonly, bool reuse);
+		     int port, bool ifaceonly, int reuse);
     void printError(int error, char * iface, int ifaceid, SPtr<TIPv6Addr> addr, int port);
 
     // FileDescriptor
@@ -0,0 +1,139 @@
+#include "Iface.h"
+#include "SocketIPv6.h"
+#include "Portable.h"
+
+#include <vector>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+class SocketShardsTest : public ::testing::Test {
+public:
+    SocketShardsTest()
+        :Port_(20000 + getpid() % 20000), Client_(socket(AF_INET6, SOCK_DGRAM, 0)) {
+    }
+
+    ~SocketShardsTest() {
+        if (Client_ >= 0)
+            close(Client_);
+    }
+
+    /// sends packet to ::1 and returns index of a socket that received it (or -1)
+    int transmit(const vector<uint8_t>& pkt) {
+        struct sockaddr_in6 dst;
+        memset(&dst, 0, sizeof(dst));
+        dst.sin6_family = AF_INET6;
+        dst.sin6_port = htons(Port_);
+        dst.sin6_addr = in6addr_loopback;
+        if (sendto(Client_, &pkt[0], pkt.size(), 0, (struct sockaddr*)&dst, sizeof(dst)) < 0)
+            return -1;
+
+        vector<struct pollfd> fds(FDs_.size());
+        for (size_t i = 0; i < FDs_.size(); i++) {
+            fds[i].fd = FDs_[i];
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        if (poll(&fds[0], fds.size(), 1000) <= 0)
+            return -1;
+
+        int shard = -1;
+        char buf[1500];
+        for (size_t i = 0; i < FDs_.size(); i++) {
+            if (recv(FDs_[i], buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+                EXPECT_EQ(-1, shard) << "packet received on more than one socket";
+                shard = i;
+            }
+        }
+        return shard;
+    }
+
+    /// SOLICIT with client-id (DUID-LL, the last 4 bytes set to key)
+    static vector<uint8_t> solicit(uint32_t key) {
+        uint8_t pkt[] = { 1, 0x12, 0x34, 0x56,                  // SOLICIT, trans-id
+                          0, 1, 0, 10,                            // CLIENTID
+                          0, 3, 0, 1, 0x02, 0x00,                 // DUID-LL
+                          (uint8_t)(key >> 24), (uint8_t)(key >> 16), (uint8_t)(key >> 8), (uint8_t)key,
+                          0, 8, 0, 2, 0, 0 };                     // ELAPSED_TIME
+        return vector<uint8_t>(pkt, pkt + sizeof(pkt));
+    }
+
+    /// RELAY-FORW with link-address ending with key
+    static vector<uint8_t> relayForw(uint32_t key) {
+        vector<uint8_t> pkt(34, 0);
+        pkt[0] = 12;
+        pkt[2] = 0x20;
+        pkt[3] = 0x01;
+        pkt[14] = key >> 24;
+        pkt[15] = key >> 16;
+        pkt[16] = key >> 8;
+        pkt[17] = key;
+        pkt[18] = 0xfe;
+        pkt[19] = 0x80;
+        return pkt;
+    }
+
+    int Port_;
+    int Client_;
+    vector<int> FDs_;
+};
+
+// This test verifies that several sockets can be bound to the same
+// address and that packets of one client (or relay) are always received
+// on the same socket.
+TEST_F(SocketShardsTest, steering) {
+    int ifindex = if_nametoindex("lo");
+    ASSERT_NE(0, ifindex);
+    ASSERT_LE(0, Client_);
+
+    char mac[6] = { 0 };
+    TIfaceIface iface("lo", ifindex, 0, mac, 6, NULL, 0, NULL, 0, 772);
+    SPtr<TIPv6Addr> addr = new TIPv6Addr("::1", true);
+
+    unsigned int cnt = iface.addSocketShards(addr, Port_, false, 4);
+    ASSERT_NE(0u, cnt);
+    EXPECT_EQ((int)cnt, iface.countSocket());
+
+    SPtr<TIfaceSocket> sock;
+    iface.firstSocket();
+    while (sock = iface.getSocket())
+        FDs_.push_back(sock->getFD());
+    if (cnt < 4)
+        return; // sockets can't share address and port on this system
+
+    // program is attached again, to find out whether it is supported
+    bool steered = sock_steer(FDs_[0], 4) == LOWLEVEL_NO_ERROR;
+
+    for (uint32_t key = 0x1000; key < 0x1010; key++) {
+        int shard = transmit(solicit(key));
+        ASSERT_NE(-1, shard);
+        EXPECT_EQ(shard, transmit(solicit(key)));
+        if (steered) {
+            EXPECT_EQ((int)(key % 4), shard);
+        }
+
+        shard = transmit(relayForw(key));
+        ASSERT_NE(-1, shard);
+        if (steered) {
+            EXPECT_EQ((int)(key % 4), shard);
+        }
+    }
+
+    // client-id is not the first option, spread by transaction-id
+    if (steered) {
+        vector<uint8_t> pkt = solicit(0);
+        pkt.erase(pkt.begin() + 4, pkt.begin() + 18);
+        pkt[3] = 0x57; // msg-type and trans-id: 0x01123457
+        EXPECT_EQ(3, transmit(pkt));
+    }
+}
+
+}
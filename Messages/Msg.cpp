@@ -22,7 +22,8 @@
 #include "OptDUID.h"
 #include "OptStatusCode.h"
 #include "Logger.h"
-#include "hmac-sha-md5.h"
+#include "KeyStore.h"
+#include "HmacCache.h"
 
 class TNotifyScriptParams;
 
@@ -97,15 +98,38 @@ TOptList & TMsg::getOptLst()
 }
 
 /* prepares binary version of this message, returns number of bytes used
+ * (the buffer must be at least getSize() bytes long)
 **/
 int TMsg::storeSelf(char * buffer)
+{
+    return storeSelf(buffer, getSize());
+}
+
+/// @brief Stores message in a buffer of limited size.
+///
+/// Each option is checked against the space left in the buffer before it
+/// is stored (options with suboptions calculate their length while they
+/// are stored, see TOpt::storeLength()), so the whole message is encoded in
+/// linear time. An option that stores a different number of bytes than it
+/// reported is treated as an error and the message must not be sent.
+///
+/// @param buffer buffer to store the message in
+/// @param bufSize size of the buffer
+///
+/// @return number of bytes stored or -1 if the message can't be stored
+int TMsg::storeSelf(char * buffer, size_t bufSize)
 {
     char *start = buffer;
+    char *end = buffer + bufSize;
     int tmp = this->TransID;
-    
+
+    if (bufSize < 4) {
+        Log(Error) << "Unable to store " << getName() << " message: buffer is only "
+                   << bufSize << " bytes long." << LogEnd;
+        return -1;
+    }
+
     *(buffer++) = (char)MsgType;
-    
-    /* ugly 3-byte version of htons/htonl */
     buffer[2] = tmp%256;  tmp = tmp/256;
     buffer[1] = tmp%256;  tmp = tmp/256;
     buffer[0] = tmp%256;  tmp = tmp/256;
@@ -113,8 +137,21 @@ int TMsg::storeSelf(char * buffer)
 
     TOptList::iterator option;
     for (option=Options.begin(); option!=Options.end(); ++option) {
-        (*option)->storeSelf(buffer);
-	buffer += (*option)->getSize();
+        size_t len = (*option)->getSize();
+        if (len > static_cast<size_t>(end - buffer)) {
+            Log(Error) << "Unable to store " << getName() << " message: option "
+                       << (*option)->getOptType() << " (" << len << " bytes) does not fit in "
+                       << bufSize << " bytes long buffer." << LogEnd;
+            return -1;
+        }
+        char *next = (*option)->storeSelf(buffer);
+        if (next != buffer + len) {
+            Log(Error) << "Unable to store " << getName() << " message: option "
+                       << (*option)->getOptType() << " stored " << (next - buffer)
+                       << " bytes, but " << len << " bytes were expected." << LogEnd;
+            return -1;
+        }
+        buffer = next;
     }
 
 #ifndef MOD_DISABLE_AUTH
@@ -146,7 +183,8 @@ void TMsg::calculateDigests(char* buffer, size_t len) {
             return;
         }
         if (auth->getAuthDataPtr()) {
-            hmac_md5(buffer, len, (char*) &AuthKey_[0], AuthKey_.size() ,auth->getAuthDataPtr());
+            THmacCache::instance().digest(THmacCache::getType(DIGEST_HMAC_MD5), AuthKey_,
+                                          buffer, len, auth->getAuthDataPtr());
         }
         return;
     }
@@ -157,7 +195,8 @@ void TMsg::calculateDigests(char* buffer, size_t len) {
             return;
         }
         if (auth->getAuthDataPtr()) {
-            hmac_md5(buffer, len, (char*) &AuthKey_[0], AuthKey_.size() ,auth->getAuthDataPtr());
+            THmacCache::instance().digest(THmacCache::getType(DIGEST_HMAC_MD5), AuthKey_,
+                                          buffer, len, auth->getAuthDataPtr());
         }
         return;
     }
@@ -181,25 +220,10 @@ void TMsg::calculateDigests(char* buffer, size_t len) {
             case DIGEST_PLAIN:
                 memcpy(AuthDigestPtr_, "This is 32-byte plain testkey...", getDigestSize(UsedDigestType));
                 break;
-            case DIGEST_HMAC_MD5:
-                hmac_md5(buffer, len, (char*)&AuthKey_[0], AuthKey_.size(), (char *)AuthDigestPtr_);
-                break;
-            case DIGEST_HMAC_SHA1:
-                hmac_sha(buffer, len, (char*)&AuthKey_[0], AuthKey_.size(), (char *)AuthDigestPtr_, 1);
-                break;
-            case DIGEST_HMAC_SHA224:
-                hmac_sha(buffer, len, (char*)&AuthKey_[0], AuthKey_.size(), (char *)AuthDigestPtr_, 224);
-                break;
-            case DIGEST_HMAC_SHA256:
-                hmac_sha(buffer, len, (char*)&AuthKey_[0], AuthKey_.size(), (char *)AuthDigestPtr_, 256);
-                break;
-            case DIGEST_HMAC_SHA384:
-                hmac_sha(buffer, len, (char*)&AuthKey_[0], AuthKey_.size(), (char *)AuthDigestPtr_, 384);
-                break;
-            case DIGEST_HMAC_SHA512:
-                hmac_sha(buffer, len, (char*)&AuthKey_[0], AuthKey_.size(), (char *)AuthDigestPtr_, 512);
-                break;
             default:
+                // keyed state is prepared once per key, see THmacCache
+                THmacCache::instance().digest(THmacCache::getType(UsedDigestType), AuthKey_,
+                                              buffer, len, (char*)AuthDigestPtr_);
                 break;
             }
             PrintHex(std::string("Auth: Sending digest ") + getDigestName(UsedDigestType) +" : ",
@@ -239,6 +263,7 @@ TMsg::~TMsg() {
     if (NotifyScripts) {
         delete NotifyScripts;
     }
+    TKeyStore::wipe(AuthKey_);
 }
 
 SPtr<TIPv6Addr> TMsg::getRemoteAddr() {
@@ -270,13 +295,14 @@ void TMsg::setAuthKey(const TKey& key) {
 
 bool TMsg::loadAuthKey() {
 
-    unsigned len = 0;
-    char * ptr = getAAAKey(SPI_, &len);
-    AuthKey_.resize(len);
-    memcpy(&AuthKey_[0], ptr, len);
-    free(ptr);
+    // keys are cached, so no file is read here (unless the key has changed)
+    TKey key;
+    if (!TKeyStore::instance().get(SPI_, key))
+        return false;
 
-    return (len>0);
+    AuthKey_.swap(key);
+    TKeyStore::wipe(key);
+    return true;
 }
 
 TKey TMsg::getAuthKey() {
@@ -345,7 +371,8 @@ bool TMsg::validateAuthInfo(char *buf, int bufSize,
         memmove(rcvdAuthInfo, AuthDigestPtr_, DELAYED_AUTH_DIGEST_SIZE);
         memset(AuthDigestPtr_, 0, DELAYED_AUTH_DIGEST_SIZE);
 
-        hmac_md5(buf, bufSize, (char*)&AuthKey_[0], AuthKey_.size(), goodAuthInfo);
+        THmacCache::instance().digest(THmacCache::getType(DIGEST_HMAC_MD5), AuthKey_,
+                                      buf, bufSize, goodAuthInfo);
 
         Log(Debug) << "Auth: Checking delayed-auth (HMAC-MD5) digest:" << LogEnd;
         PrintHex("Auth:received digest: ", (uint8_t*)rcvdAuthInfo, DELAYED_AUTH_DIGEST_SIZE);
@@ -400,7 +427,8 @@ bool TMsg::validateAuthInfo(char *buf, int bufSize,
         memmove(rcvdAuthInfo, AuthDigestPtr_, RECONFIGURE_DIGEST_SIZE);
         memset(AuthDigestPtr_, 0, RECONFIGURE_DIGEST_SIZE);
 
-        hmac_md5(buf, bufSize, (char*)&AuthKey_[0], AuthKey_.size(), goodAuthInfo);
+        THmacCache::instance().digest(THmacCache::getType(DIGEST_HMAC_MD5), AuthKey_,
+                                      buf, bufSize, goodAuthInfo);
 
         Log(Debug) << "Auth: Checking reconfigure-key" << LogEnd;
         PrintHex("Auth:received digest: ", (uint8_t*)rcvdAuthInfo, RECONFIGURE_DIGEST_SIZE);
@@ -462,25 +490,9 @@ bool TMsg::validateAuthInfo(char *buf, int bufSize,
                     /// @todo: load plain text from a file
                     memcpy(goodAuthInfo, "This is 32-byte plain testkey...", 32);
                     break;
-                case DIGEST_HMAC_MD5:
-                    hmac_md5(buf, bufSize, (char*)&AuthKey_[0], AuthKey_.size(), goodAuthInfo);
-                    break;
-                case DIGEST_HMAC_SHA1:
-                    hmac_sha(buf, bufSize, (char*)&AuthKey_[0], AuthKey_.size(), goodAuthInfo, 1);
-                    break;
-                case DIGEST_HMAC_SHA224:
-                    hmac_sha(buf, bufSize, (char*)&AuthKey_[0], AuthKey_.size(), goodAuthInfo, 224);
-                    break;
-                case DIGEST_HMAC_SHA256:
-                    hmac_sha(buf, bufSize, (char*)&AuthKey_[0], AuthKey_.size(), goodAuthInfo, 256);
-                    break;
-                case DIGEST_HMAC_SHA384:
-                    hmac_sha(buf, bufSize, (char*)&AuthKey_[0], AuthKey_.size(), goodAuthInfo, 384);
-                    break;
-                case DIGEST_HMAC_SHA512:
-                    hmac_sha(buf, bufSize, (char*)&AuthKey_[0], AuthKey_.size(), goodAuthInfo, 512);
-                    break;
                 default:
+                    THmacCache::instance().digest(THmacCache::getType(DigestType_), AuthKey_,
+                                                  buf, bufSize, goodAuthInfo);
                     break;
         }
         if (0 == memcmp(goodAuthInfo, rcvdAuthInfo, AuthInfoLen))
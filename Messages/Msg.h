@@ -46,6 +46,7 @@ class TMsg
     virtual unsigned long getTimeout();
 
     virtual int storeSelf(char * buffer);
+    int storeSelf(char * buffer, size_t bufSize);
 
     virtual std::string getName() const = 0;
 
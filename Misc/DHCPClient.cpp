@@ -85,6 +85,11 @@ void TDHCPClient::initLinkStateChange()
 
     memset((void*)&this->linkstates, 0, sizeof(linkstates));
 
+    if (ClntIfaceMgr().eventsActive()) {
+        Log(Debug) << "Link-state changes are reported by the kernel, polling not needed." << LogEnd;
+        return;
+    }
+
     ClntCfgMgr().firstIface();
     SPtr<TClntCfgIface> iface;
     Log(Debug) << "Initialising link-state detection for interfaces: ";
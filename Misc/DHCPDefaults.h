@@ -47,6 +47,30 @@
 #define SERVER_DEFAULT_TA_PREF_LIFETIME 3600
 #define SERVER_DEFAULT_TA_VALID_LIFETIME 7200
 #define SERVER_DEFAULT_CACHE_SIZE 1048576   /* cache size, specified in bytes */
+#define SERVER_CACHE_DUID_LEN 14            /* DUID length assumed when cache size is converted to entries */
+#define SERVER_CACHE_JOURNAL_SLACK 1024     /* cache changes journaled before a snapshot is due */
+#define SERVER_LEASE_JOURNAL_SLACK 1024     /* lease journal records written before a snapshot is due */
+#define SERVER_LEASE_COMMIT_BATCH 64        /* performance mode: changed clients per commit */
+#define SERVER_LEASE_COMMIT_DELAY 2         /* performance mode: max. delay of a commit (in secs) */
+#define SERVER_LEASE_COMMIT_RETRY 1         /* delay before a failed commit is retried (in secs) */
+#define SERVER_REPLY_CACHE_SIZE 4096        /* answers kept for retransmitted client messages */
+#define SERVER_REPLY_CACHE_LIFETIME 10      /* how long answers are kept for (in secs) */
+#define SERVER_REPLY_TEMPLATES 256          /* pre-encoded INF-REQUEST answers (see TSrvReplyTemplates) */
+#define SERVER_ADMISSION_QUEUE 4096         /* received messages waiting to be processed */
+#define SERVER_ADMISSION_BATCH 64           /* messages received before the next one is processed */
+#define SERVER_ADMISSION_SOLICIT_DELAY 500  /* SOLICITs queued for longer are dropped (in msec) */
+#define SERVER_ADMISSION_OVERLOAD 256      /* rate limits apply only with this many messages queued */
+#define SERVER_ADMISSION_CLIENT_RATE 5      /* messages per second from a single client (0 - unlimited) */
+#define SERVER_ADMISSION_CLIENT_BURST 10
+#define SERVER_ADMISSION_RELAY_RATE 5000    /* messages per second from a single relay (0 - unlimited) */
+#define SERVER_ADMISSION_RELAY_BURST 10000
+#define SERVER_ADMISSION_BUCKETS 65536      /* clients and relays rate limits are tracked for */
+#define SERVER_ADMISSION_REPORT 10          /* dropped messages are reported at most every ... secs */
+#define SERVER_RECONFIGURE_RATE 100         /* RECONFIGUREs sent per second (0 - unlimited) */
+#define SERVER_RECONFIGURE_CHECKS 1000      /* clients checked for outdated leases per pass */
+#define SERVER_SOCKET_SHARDS 1              /* sockets bound to every unicast address */
+#define SERVER_FQDN_DYNAMIC_NAMES 65536     /* names accepted from clients kept per interface */
+#define SERVER_HOSTDB_CHECK_INTERVAL 5      /* how often host database is checked for changes (in secs) */
 
 #define SERVER_MAX_IA_RANDOM_TRIES 100
 #define SERVER_MAX_TA_RANDOM_TRIES 100
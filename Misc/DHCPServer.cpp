@@ -8,6 +8,7 @@
  *
  */
 
+#include <time.h>
 #include "DHCPServer.h"
 #include "AddrClient.h"
 #include "Logger.h"
@@ -55,7 +56,8 @@ TDHCPServer::TDHCPServer(const std::string& config)
         return;
     }
 
-    if ( !SrvTransMgr().sanitizeAddrDB() ) {
+    // interfaces, pool counters, reservations and reconfigure, in one pass
+    if ( !SrvTransMgr().reconcileLeases() ) {
         Log(Crit) << "Loaded address database failed sanitization checks."
                   << LogEnd;
         IsDone_ = true;
@@ -63,9 +65,6 @@ TDHCPServer::TDHCPServer(const std::string& config)
     }
 
     SrvAddrMgr().dump();
-
-    SrvCfgMgr().removeReservedFromCache();
-    SrvCfgMgr().setCounters();
     SrvCfgMgr().dump();
     SrvTransMgr().dump();
 }
@@ -74,6 +73,9 @@ void TDHCPServer::run()
 {
     Log(Notice) << "Server begins operation." << LogEnd;
 
+    // lease changes are committed once all queued messages are processed
+    SrvTransMgr().setGroupCommit(true);
+
     bool silent = false;
     while ( (!isDone()) && (!SrvTransMgr().isDone()) ) {
         if (serviceShutdown)
@@ -86,7 +88,16 @@ void TDHCPServer::run()
         if (serviceShutdown)
             timeout = 0;
 
-        if (!silent)
+        // replies are waiting for a commit, just pick up messages that are
+        // already queued, so they share the same commit (held replies imply
+        // pending changes, which are not due while a failed commit waits to
+        // be retried)
+        bool batch = SrvAddrMgr().commitDue((unsigned long)time(NULL)) ||
+            SrvTransMgr().getAdmission().count();
+        if (batch)
+            timeout = 0;
+
+        if (!silent && !batch)
             Log(Notice) << "Accepting connections. Next event in " << timeout
                         << " second(s)." << LogEnd;
 #ifdef WIN32
@@ -98,45 +109,32 @@ void TDHCPServer::run()
 #endif
 
         SPtr<TSrvMsg> msg=SrvIfaceMgr().select(timeout);
-        if (!msg)
-            continue;
-        silent = false;
-        SPtr<TIfaceIface>  physicalIface = SrvIfaceMgr().getIfaceByID(msg->getPhysicalIface());
-        SPtr<TSrvCfgIface> logicalIface = SrvCfgMgr().getIfaceByID(msg->getIface());
-        if (!physicalIface) {
-            Log(Error) << "Received data over unknown physical interface: ifindex="
-                       << msg->getPhysicalIface() << LogEnd;
-            continue;
-        }
-        if (!logicalIface) {
-            Log(Error) << "Received data over unknown logical interface: ifindex="
-                       << msg->getIface() << LogEnd;
-            continue;
-        }
-        Log(Notice) << "Received " << msg->getName() << " on " << physicalIface->getFullName()
-                    << hex << ", trans-id=0x" << msg->getTransID() << dec
-                    << ", " << msg->countOption() << " opts:";
-        SPtr<TOpt> ptrOpt;
-        msg->firstOption();
-        while (ptrOpt = msg->getOption() )
-            Log(Cont) << " " << ptrOpt->getOptType();
-        if (msg->RelayInfo_.size()) {
-            Log(Cont) << " (" << logicalIface->getFullName() << ", "
-                      << msg->RelayInfo_.size() << " relay(s)." << LogEnd;
-        } else {
-            Log(Cont) << " (non-relayed)" << LogEnd;
+
+        // messages already waiting are received as well, so the most
+        // important one can be processed first (see TSrvAdmission)
+        TSrvAdmission& admission = SrvTransMgr().getAdmission();
+        int received = 0;
+        while (msg) {
+            silent = false;
+            if (checkMsg(msg))
+                admission.enqueue(msg, TSrvAdmission::now());
+            if (++received == SERVER_ADMISSION_BATCH)
+                break;
+            msg = SrvIfaceMgr().select(0);
         }
 
-        if (SrvCfgMgr().stateless() && ( (msg->getType()!=INFORMATION_REQUEST_MSG) &&
-                                         (msg->getType()!=RELAY_FORW_MSG))) {
-            Log(Warning)
-                << "Stateful configuration message received while running in "
-                << "the stateless mode. Message ignored." << LogEnd;
+        uint64_t now = TSrvAdmission::now();
+        admission.report(now);
+        msg = admission.dequeue(now);
+        if (!msg) {
+            SrvTransMgr().commitLeases();
             continue;
         }
         SrvTransMgr().relayMsg(msg);
     }
 
+    SrvTransMgr().getAdmission().report(TSrvAdmission::now(), true);
+    SrvTransMgr().commitLeases(true);
     SrvCfgMgr().setPerformanceMode(false);
     SrvAddrMgr().dump();
 
@@ -144,6 +142,50 @@ void TDHCPServer::run()
     Log(Notice) << "Bye bye." << LogEnd;
 }
 
+/// @brief checks received message and logs it
+///
+/// @param msg message received
+///
+/// @return true if the message should be processed
+bool TDHCPServer::checkMsg(SPtr<TSrvMsg> msg)
+{
+    SPtr<TIfaceIface>  physicalIface = SrvIfaceMgr().getIfaceByID(msg->getPhysicalIface());
+    SPtr<TSrvCfgIface> logicalIface = SrvCfgMgr().getIfaceByID(msg->getIface());
+    if (!physicalIface) {
+        Log(Error) << "Received data over unknown physical interface: ifindex="
+                   << msg->getPhysicalIface() << LogEnd;
+        return false;
+    }
+    if (!logicalIface) {
+        Log(Error) << "Received data over unknown logical interface: ifindex="
+                   << msg->getIface() << LogEnd;
+        return false;
+    }
+    Log(Notice) << "Received " << msg->getName() << " on " << physicalIface->getFullName()
+                << hex << ", trans-id=0x" << msg->getTransID() << dec
+                << ", " << msg->countOption() << " opts:";
+    SPtr<TOpt> ptrOpt;
+    msg->firstOption();
+    while (ptrOpt = msg->getOption() )
+        Log(Cont) << " " << ptrOpt->getOptType();
+    if (msg->getRelayChain().size()) {
+        Log(Cont) << " (" << logicalIface->getFullName() << ", "
+                  << msg->getRelayChain().size() << " relay(s)." << LogEnd;
+    } else {
+        Log(Cont) << " (non-relayed)" << LogEnd;
+    }
+
+    if (SrvCfgMgr().stateless() && ( (msg->getType()!=INFORMATION_REQUEST_MSG) &&
+                                     (msg->getType()!=RELAY_FORW_MSG))) {
+        Log(Warning)
+            << "Stateful configuration message received while running in "
+            << "the stateless mode. Message ignored." << LogEnd;
+        return false;
+    }
+    return true;
+}
+
+
 bool TDHCPServer::isDone() {
     return IsDone_;
 }
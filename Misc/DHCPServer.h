@@ -14,6 +14,8 @@
 #include <string>
 #include "SmartPtr.h"
 
+class TSrvMsg;
+
 class TDHCPServer
 {
   public:
@@ -26,6 +28,8 @@ class TDHCPServer
     ~TDHCPServer();
 
   private:
+    bool checkMsg(SPtr<TSrvMsg> msg);
+
     bool IsDone_;
 };
 
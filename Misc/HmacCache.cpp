@@ -0,0 +1,134 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "HmacCache.h"
+#include "KeyStore.h"
+
+using namespace std;
+
+/// default maximum number of cached keys
+static const size_t HMAC_CACHE_SIZE = 256;
+
+/// returns cache used by messages
+THmacCache& THmacCache::instance() {
+    static THmacCache cache;
+    return cache;
+}
+
+THmacCache::THmacCache()
+    :Count_(0), MaxSize_(HMAC_CACHE_SIZE) {
+}
+
+THmacCache::~THmacCache() {
+    clear();
+}
+
+/// @brief calculates HMAC of a buffer
+///
+/// @param type HMAC type: 1, 224, 256, 384, 512 (SHA) or 5 (MD5), see getType()
+/// @param key HMAC key
+/// @param buf data to be signed
+/// @param len length of the data
+/// @param resbuf digest will be written here
+///
+/// @return false if type is not supported
+bool THmacCache::digest(int type, const TKey& key, const char* buf, size_t len, char* resbuf) {
+    TStates& states = States_[type];
+    TStates::iterator it = states.find(key);
+    if (it != states.end()) {
+        hmac_state_digest(&it->second, buf, len, resbuf);
+        return true;
+    }
+
+    pair<TKey, hmac_state> entry(key, hmac_state());
+    if (hmac_state_init(&entry.second, key.empty() ? "" : (const char*)&key[0], key.size(),
+                        type)) {
+        TKeyStore::wipe(entry.first);
+        return false;
+    }
+    hmac_state_digest(&entry.second, buf, len, resbuf);
+    if (Count_ >= MaxSize_)
+        clear();
+    if (MaxSize_) {
+        States_[type].insert(entry);
+        Count_++;
+    }
+    hmac_state_wipe(&entry.second);
+    TKeyStore::wipe(entry.first);
+    return true;
+}
+
+/// @brief sets maximum number of cached states
+///
+/// @param entries maximum number of entries (0 disables cache)
+void THmacCache::setMaxSize(size_t entries) {
+    MaxSize_ = entries;
+    if (Count_ > MaxSize_)
+        clear();
+}
+
+size_t THmacCache::count() const {
+    return Count_;
+}
+
+/// @brief removes (and wipes) states prepared for a key
+///
+/// Called when the key is dropped from the key store, so no copy of it is
+/// kept here.
+///
+/// @param key HMAC key
+void THmacCache::remove(const TKey& key) {
+    for (map<int, TStates>::iterator t = States_.begin(); t != States_.end(); ++t) {
+        TStates::iterator it = t->second.find(key);
+        if (it == t->second.end())
+            continue;
+        hmac_state_wipe(&it->second);
+        // entry is erased below, so changing the key here does not break the map
+        TKeyStore::wipe(const_cast<TKey&>(it->first));
+        t->second.erase(it);
+        Count_--;
+    }
+}
+
+/// removes (and wipes) all states
+void THmacCache::clear() {
+    for (map<int, TStates>::iterator t = States_.begin(); t != States_.end(); ++t) {
+        for (TStates::iterator it = t->second.begin(); it != t->second.end(); ++it) {
+            hmac_state_wipe(&it->second);
+            // map is cleared below, so changing the key here does not break it
+            TKeyStore::wipe(const_cast<TKey&>(it->first));
+        }
+    }
+    States_.clear();
+    Count_ = 0;
+}
+
+/// @brief converts digest type used by the dibbler auth protocol to HMAC type
+///
+/// @param digest digest type
+///
+/// @return HMAC type (or 0 if this is not a HMAC digest)
+int THmacCache::getType(DigestTypes digest) {
+    switch (digest) {
+    case DIGEST_HMAC_MD5:
+        return 5;
+    case DIGEST_HMAC_SHA1:
+        return 1;
+    case DIGEST_HMAC_SHA224:
+        return 224;
+    case DIGEST_HMAC_SHA256:
+        return 256;
+    case DIGEST_HMAC_SHA384:
+        return 384;
+    case DIGEST_HMAC_SHA512:
+        return 512;
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef HMACCACHE_H
+#define HMACCACHE_H
+
+#include <map>
+#include "Key.h"
+#include "hmac-state.h"
+
+/// @brief Keyed HMAC states, prepared once per key.
+///
+/// HMAC hashes key XOR ipad and key XOR opad blocks before the message
+/// itself. Those two blocks depend only on the key, so their hash state
+/// is kept here (indexed by HMAC type and key) and reused for every
+/// message signed or verified with the same key (AAA key, delayed-auth
+/// key or reconfigure-key). When the cache is full, all states are
+/// dropped. Keys dropped from TKeyStore are removed from here as well.
+/// Dropped states are wiped.
+class THmacCache
+{
+  public:
+    static THmacCache& instance();
+
+    THmacCache();
+    ~THmacCache();
+
+    bool digest(int type, const TKey& key, const char* buf, size_t len, char* resbuf);
+
+    void setMaxSize(size_t entries);
+    size_t count() const;
+    void remove(const TKey& key);
+    void clear();
+
+    static int getType(DigestTypes digest);
+
+  private:
+    typedef std::map<TKey, hmac_state> TStates;
+
+    std::map<int, TStates> States_; // HMAC type -> key -> state
+    size_t Count_;
+    size_t MaxSize_;
+};
+
+#endif
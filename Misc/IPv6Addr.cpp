@@ -19,35 +19,44 @@
 static unsigned char truncLeft[] = { 0xff, 0x7f, 0x3f, 0x1f, 0xf,  0x7,  0x3,  0x1, 0 };
 static unsigned char truncRight[]= { 0, 0x80, 0xc0, 0xe0, 0xf0, 0xf8, 0xfc, 0xfe, 0xff };
 
+// Text form of the address is not generated in constructors and setters.
+// Most addresses are never printed, so getPlain() formats it on first use
+// and keeps it until the address changes (empty Plain means not generated).
+
 TIPv6Addr::TIPv6Addr() {
     memset(Addr,0,16);
-    inet_ntop6(Addr,Plain);
+    Plain[0] = 0;
 }
 
 TIPv6Addr::TIPv6Addr(const char* addr, bool plain) {
     if (plain) {
         strncpy(Plain,addr, sizeof(Plain));
+        Plain[sizeof(Plain)-1] = 0;
         inet_pton6(Plain,Addr);
     } else {
         memcpy(Addr,addr,16);
-        inet_ntop6(Addr,Plain);
+        Plain[0] = 0;
     }
 }
 
+TIPv6Addr::TIPv6Addr(const TIPv6AddrValue& addr) {
+    addr.store(Addr);
+    Plain[0] = 0;
+}
+
 TIPv6Addr::TIPv6Addr(const char* prefix, const char* host, int prefixLength) {
 
     int offset = prefixLength/8;
+    Plain[0] = 0;
     if (prefixLength%8==0) {
         memmove(Addr, host, 16);
         memmove(Addr, prefix, offset);
-        inet_ntop6(Addr, Plain);
         return;
     }
 
     memmove(Addr, host, 16);  // copy whole host address, but...
     memmove(Addr, prefix, offset); // overwrite first bits with prefix...
     Addr[offset] = (prefix[offset] & truncRight[prefixLength%8]) | (host[offset] & truncLeft[prefixLength%8]);
-    inet_ntop6(Addr, Plain);
 }
 
 bool TIPv6Addr::linkLocal() {
@@ -67,13 +76,18 @@ char* TIPv6Addr::getAddr() {
 }
 
 char* TIPv6Addr::getPlain() {
-    inet_ntop6(Addr, Plain);
+    if (!Plain[0])
+        inet_ntop6(Addr, Plain);
     return Plain;
 }
 
+TIPv6AddrValue TIPv6Addr::getValue() const {
+    return TIPv6AddrValue(Addr);
+}
+
 void TIPv6Addr::setAddr(char* addr) {
     memcpy(Addr,addr,16);
-    inet_ntop6(Addr,Plain);
+    Plain[0] = 0;
 }
 
 char* TIPv6Addr::storeSelf(char *buf) {
@@ -97,6 +111,8 @@ void TIPv6Addr::truncate(int minPrefix, int maxPrefix) {
         return;
     }
 
+    Plain[0] = 0;
+
     // truncating from the left
     int x = minPrefix/8;
     memset(this->Addr, 0, x);
@@ -113,9 +129,6 @@ void TIPv6Addr::truncate(int minPrefix, int maxPrefix) {
         x = maxPrefix/8;
         this->Addr[x] = this->Addr[x] & truncRight[maxPrefix%8];
     }
-
-    // update plain form
-    inet_ntop6(Addr,Plain);
 }
 
 std::ostream& operator<<(std::ostream& out,TIPv6Addr& addr)
@@ -128,59 +141,17 @@ std::ostream& operator<<(std::ostream& out,TIPv6Addr& addr)
 
 bool TIPv6Addr::operator<=(const TIPv6Addr &other)
 {
-    for (int i=0;i<16;i++) {
-        if (Addr[i]<other.Addr[i])
-            return true;
-        if(Addr[i]>other.Addr[i])
-            return false;
-    }
-    return true; //hmm: are they equal
+    return getValue() <= other.getValue();
 }
 
 TIPv6Addr TIPv6Addr::operator-(const TIPv6Addr &other)
 {
-    char result[16];
-    memset(result,0,16);
-        char carry=0;
-    for (int i=15;i>=0;i--)
-    {
-        unsigned int left=Addr[i];
-        unsigned int right=other.Addr[i];
-        if(left>=(right+carry))
-        {
-            result[i]=left-other.Addr[i]-carry;
-            carry=0;
-        }
-        else
-        {
-            result[i]=Addr[i]+256-other.Addr[i]-carry;
-            carry=1;
-        }
-    }
-    return TIPv6Addr(result);
+    return TIPv6Addr(getValue() - other.getValue());
 }
 
 TIPv6Addr TIPv6Addr::operator+(const TIPv6Addr &other)
 {
-    char result[16];
-    memset(result,0,16);
-    unsigned int carry=0;
-    for (int i=15;i>=0;i--)
-    {
-        unsigned int left=Addr[i];
-        unsigned int right=other.Addr[i];
-        if(left+right+carry>255)
-        {
-            result[i]=char (left+right+carry-256);
-            carry=1;
-        }
-        else
-        {
-            result[i]=left+right+carry;
-            carry=0;
-        }
-    }
-    return TIPv6Addr(result);
+    return TIPv6Addr(getValue() + other.getValue());
 }
 
 /**
@@ -191,6 +162,7 @@ TIPv6Addr TIPv6Addr::operator+(const TIPv6Addr &other)
  */
 TIPv6Addr& TIPv6Addr::operator--()
 {
+    Plain[0] = 0;
 //#define ALGO_ANIA
 //#define OLD_CRAPPY_CODE
 //#define NEW_CRAPPY_CODE
@@ -338,6 +310,7 @@ TIPv6Addr& TIPv6Addr::operator--()
 ///
 TIPv6Addr& TIPv6Addr::operator++()
 {
+    Plain[0] = 0;
     int carry = 1;
     for (int i=15; i>=0; i--) {
         carry = (Addr[i] == 255);
@@ -348,3 +321,74 @@ TIPv6Addr& TIPv6Addr::operator++()
 
     return *this;
 }
+
+// --------------------------------------------------------------------
+// --- TIPv6AddrValue -------------------------------------------------
+// --------------------------------------------------------------------
+
+TIPv6AddrValue::TIPv6AddrValue(const char* packed)
+    :Hi_(readUint64(packed)), Lo_(readUint64(packed + 8)) {
+}
+
+/// stores address in packed (16 bytes, network order) form
+void TIPv6AddrValue::store(char* packed) const {
+    writeUint64(packed, Hi_);
+    writeUint64(packed + 8, Lo_);
+}
+
+std::string TIPv6AddrValue::getPlain() const {
+    char packed[16];
+    char plain[sizeof("0000:0000:0000:0000:0000:0000:0000.000.000.000.000")];
+    store(packed);
+    inet_ntop6(packed, plain);
+    return std::string(plain);
+}
+
+/// returns hash of the address, suitable for hash tables
+size_t TIPv6AddrValue::hash() const {
+    uint64_t x = Hi_ * 0x9e3779b97f4a7c15ULL ^ Lo_;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (size_t)x;
+}
+
+bool TIPv6AddrValue::linkLocal() const {
+    return (Hi_ >> 48) == 0xfe80;
+}
+
+bool TIPv6AddrValue::multicast() const {
+    return (Hi_ >> 56) == 0xff;
+}
+
+/// returns mask of bits [from, 128) within 64-bit word that starts at bit base
+static uint64_t maskFrom(int from, int base) {
+    from -= base;
+    if (from <= 0)
+        return ~(uint64_t)0;
+    if (from >= 64)
+        return 0;
+    return (~(uint64_t)0) >> from;
+}
+
+/// @brief clears bits before minPrefix and from maxPrefix onwards
+///
+/// Works the same way as TIPv6Addr::truncate().
+void TIPv6AddrValue::truncate(int minPrefix, int maxPrefix) {
+    if (minPrefix>128 || minPrefix<0 || maxPrefix>128 || maxPrefix<0)
+        return;
+    Hi_ &= maskFrom(minPrefix, 0) & ~maskFrom(maxPrefix, 0);
+    Lo_ &= maskFrom(minPrefix, 64) & ~maskFrom(maxPrefix, 64);
+}
+
+TIPv6AddrValue TIPv6AddrValue::operator+(const TIPv6AddrValue& other) const {
+    uint64_t lo = Lo_ + other.Lo_;
+    uint64_t hi = Hi_ + other.Hi_ + (lo < Lo_ ? 1 : 0);
+    return TIPv6AddrValue(hi, lo);
+}
+
+TIPv6AddrValue TIPv6AddrValue::operator-(const TIPv6AddrValue& other) const {
+    uint64_t lo = Lo_ - other.Lo_;
+    uint64_t hi = Hi_ - other.Hi_ - (Lo_ < other.Lo_ ? 1 : 0);
+    return TIPv6AddrValue(hi, lo);
+}
@@ -12,8 +12,54 @@
 #define IPV6ADDR_H
 
 #include <list>
+#include <string>
+#include <stdint.h>
 #include <SmartPtr.h>
 
+/// @brief IPv6 address stored by value
+///
+/// This is a compact, trivially copyable (16 bytes) representation, meant
+/// to be embedded in containers, indexes and other objects instead of
+/// SPtr<TIPv6Addr>. The address is kept as two 64-bit words in host byte
+/// order, so comparisons and arithmetic work on whole words and ordering
+/// follows the network order. Text form is generated only when requested.
+class TIPv6AddrValue
+{
+public:
+    TIPv6AddrValue() : Hi_(0), Lo_(0) {}
+    TIPv6AddrValue(uint64_t hi, uint64_t lo) : Hi_(hi), Lo_(lo) {}
+    explicit TIPv6AddrValue(const char* packed);
+
+    void store(char* packed) const;
+    uint64_t getHi() const { return Hi_; }
+    uint64_t getLo() const { return Lo_; }
+    std::string getPlain() const;
+    size_t hash() const;
+
+    bool linkLocal() const;
+    bool multicast() const;
+    void truncate(int minPrefix, int maxPrefix);
+
+    bool operator==(const TIPv6AddrValue& other) const {
+        return Hi_ == other.Hi_ && Lo_ == other.Lo_;
+    }
+    bool operator!=(const TIPv6AddrValue& other) const {
+        return Hi_ != other.Hi_ || Lo_ != other.Lo_;
+    }
+    bool operator<(const TIPv6AddrValue& other) const {
+        return Hi_ < other.Hi_ || (Hi_ == other.Hi_ && Lo_ < other.Lo_);
+    }
+    bool operator<=(const TIPv6AddrValue& other) const {
+        return !(other < *this);
+    }
+    TIPv6AddrValue operator+(const TIPv6AddrValue& other) const;
+    TIPv6AddrValue operator-(const TIPv6AddrValue& other) const;
+
+private:
+    uint64_t Hi_; // first 8 bytes of the address
+    uint64_t Lo_; // last 8 bytes of the address
+};
+
 class TIPv6Addr
 {
         friend std::ostream& operator<<(std::ostream& out,TIPv6Addr& group);
@@ -22,9 +68,11 @@ public:
     TIPv6Addr(const char* addr, bool plain=false);
     /* creates address from prefix+host, used in SrvCfgPD */
     TIPv6Addr(const char* prefix, const char* host, int prefixLength);
+    TIPv6Addr(const TIPv6AddrValue& addr);
     char* getAddr();
     void setAddr(char* addr);
     char* getPlain();
+    TIPv6AddrValue getValue() const;
     char* storeSelf(char *buf);
     bool linkLocal();
     bool multicast();
@@ -38,6 +86,7 @@ public:
     void truncate(int minPrefix, int maxPrefix);
 private:
     char Addr[16];
+    // text form, generated by the first getPlain() call (empty until then)
     char Plain[sizeof("0000:0000:0000:0000:0000:0000:0000.000.000.000.000")];
 };
 
@@ -0,0 +1,207 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <fstream>
+#include <stdlib.h>
+#include <string.h>
+#include "KeyStore.h"
+#include "HmacCache.h"
+#include "Logger.h"
+
+using namespace std;
+
+/// returns key store used by messages
+TKeyStore& TKeyStore::instance() {
+    static TKeyStore store;
+    return store;
+}
+
+/// @brief creates key store for the default AAA directory
+TKeyStore::TKeyStore()
+    :WatchFD_(-1) {
+    string file = getAAAKeyFilename(0);
+    size_t pos = file.find_last_of("/\\");
+    if (pos != string::npos)
+        Dir_ = file.substr(0, pos + 1);
+}
+
+/// @brief creates key store for specified directory
+///
+/// @param dir directory with AAA-key-* files
+TKeyStore::TKeyStore(const std::string& dir)
+    :Dir_(dir), WatchFD_(-1) {
+    if (!Dir_.empty() && Dir_[Dir_.size() - 1] != '/')
+        Dir_ += "/";
+}
+
+TKeyStore::~TKeyStore() {
+    // HMAC cache may be destroyed already, so it is not notified here
+    for (map<uint32_t, TKey>::iterator it = Keys_.begin(); it != Keys_.end(); ++it)
+        wipe(it->second);
+    dir_watch_close(WatchFD_);
+}
+
+/// @brief returns key for specified SPI
+///
+/// @param spi security parameter index
+/// @param key key will be stored here
+///
+/// @return true if key was found
+bool TKeyStore::get(uint32_t spi, TKey& key) {
+    if (!watch()) {
+        // changes would not be noticed, don't cache anything
+        return load(spi, key);
+    }
+    update();
+
+    map<uint32_t, TKey>::const_iterator it = Keys_.find(spi);
+    if (it != Keys_.end()) {
+        key = it->second;
+        return true;
+    }
+    if (Missing_.count(spi))
+        return false;
+
+    if (!load(spi, key)) {
+        Missing_.insert(spi);
+        return false;
+    }
+    Keys_[spi] = key;
+    Log(Debug) << "Auth: Key for SPI " << hex << spi << dec << " loaded from "
+               << getFilename(spi) << " (" << key.size() << " bytes)." << LogEnd;
+    return true;
+}
+
+/// @brief processes pending directory notifications, does not block
+///
+/// Entries for changed files are dropped. If notifications were lost,
+/// all entries are dropped.
+void TKeyStore::update() {
+    if (WatchFD_ < 0)
+        return;
+    if (dir_watch_read(WatchFD_, &TKeyStore::handler, this) >= 0)
+        return;
+
+    Log(Warning) << "Auth: " << error_message() << " Reloading all keys." << LogEnd;
+    clear();
+    dir_watch_close(WatchFD_);
+    WatchFD_ = -1;
+}
+
+/// removes (and wipes) all cached keys, along with their HMAC states
+void TKeyStore::clear() {
+    for (map<uint32_t, TKey>::iterator it = Keys_.begin(); it != Keys_.end(); ++it) {
+        THmacCache::instance().remove(it->second);
+        wipe(it->second);
+    }
+    Keys_.clear();
+    Missing_.clear();
+}
+
+size_t TKeyStore::count() const {
+    return Keys_.size();
+}
+
+/// returns true if directory is watched and keys are cached
+bool TKeyStore::isWatched() const {
+    return WatchFD_ >= 0;
+}
+
+void TKeyStore::handler(const char* name, void* arg) {
+    uint32_t spi;
+    if (parseName(name, spi))
+        static_cast<TKeyStore*>(arg)->evict(spi);
+}
+
+/// @brief extracts SPI from key file name (AAA-key or AAA-key-<hex SPI>)
+///
+/// @param name file name
+/// @param spi SPI will be stored here
+///
+/// @return true if this is a key file
+bool TKeyStore::parseName(const char* name, uint32_t& spi) {
+    static const char prefix[] = "AAA-key";
+    size_t len = sizeof(prefix) - 1;
+    if (strncmp(name, prefix, len))
+        return false;
+    if (!name[len]) {
+        spi = 0;
+        return true;
+    }
+    if (name[len] != '-' || !name[len + 1])
+        return false;
+
+    char* end = 0;
+    unsigned long val = strtoul(name + len + 1, &end, 16);
+    if (*end || val > 0xffffffffUL)
+        return false;
+    spi = (uint32_t)val;
+    return true;
+}
+
+std::string TKeyStore::getFilename(uint32_t spi) const {
+    string file = getAAAKeyFilename(spi);
+    size_t pos = file.find_last_of("/\\");
+    if (pos != string::npos)
+        file = file.substr(pos + 1);
+    return Dir_ + file;
+}
+
+/// @brief reads key from its file
+///
+/// @param spi security parameter index
+/// @param key key will be stored here
+///
+/// @return true if key was read (empty files are ignored)
+bool TKeyStore::load(uint32_t spi, TKey& key) const {
+    ifstream f(getFilename(spi).c_str(), ios::in | ios::binary);
+    if (!f.is_open())
+        return false;
+
+    f.seekg(0, ios::end);
+    streamoff len = f.tellg();
+    f.seekg(0, ios::beg);
+    if (len <= 0)
+        return false;
+
+    key.resize((size_t)len);
+    f.read((char*)&key[0], len);
+    if (f.gcount() != len) {
+        wipe(key);
+        return false;
+    }
+    return true;
+}
+
+/// drops (and wipes) cached key and its HMAC states, so it is read again
+/// when needed
+void TKeyStore::evict(uint32_t spi) {
+    map<uint32_t, TKey>::iterator it = Keys_.find(spi);
+    if (it != Keys_.end()) {
+        THmacCache::instance().remove(it->second);
+        wipe(it->second);
+        Keys_.erase(it);
+        Log(Debug) << "Auth: Key for SPI " << hex << spi << dec << " changed, dropped from cache."
+                   << LogEnd;
+    }
+    Missing_.erase(spi);
+}
+
+/// @brief starts watching key directory (if not watched yet)
+///
+/// @return true if directory is watched
+bool TKeyStore::watch() {
+    if (WatchFD_ >= 0)
+        return true;
+    int fd = dir_watch_open(Dir_.empty() ? "." : Dir_.c_str());
+    if (fd < 0)
+        return false;
+    WatchFD_ = fd;
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef KEYSTORE_H
+#define KEYSTORE_H
+
+#include <map>
+#include <set>
+#include <string>
+#include "Key.h"
+
+/// @brief Cache of AAA keys (used by delayed and dibbler authentication).
+///
+/// Keys are stored in files named AAA-key-<SPI> (see getAAAKeyFilename()).
+/// Every key is read from its file once and kept in memory, indexed by
+/// SPI. The key directory is watched (inotify on Linux), so added,
+/// rotated or removed keys are noticed and the affected entries are
+/// dropped; the next lookup reads the file again. Missing keys are
+/// remembered as well, so messages with an unknown SPI do not cause file
+/// access either. Dropped keys are wiped from memory and their HMAC
+/// states are removed from THmacCache.
+///
+/// If the directory can't be watched (missing directory, no support on
+/// this system), nothing is cached and every lookup reads the file.
+class TKeyStore
+{
+  public:
+    static TKeyStore& instance();
+
+    TKeyStore();
+    TKeyStore(const std::string& dir);
+    ~TKeyStore();
+
+    bool get(uint32_t spi, TKey& key);
+    void update();
+    void clear();
+    size_t count() const;
+    bool isWatched() const;
+
+    /// @brief overwrites key with zeros and clears it
+    ///
+    /// Writes through a volatile pointer, so they are not optimized away.
+    /// Defined here, so users of other key caches don't depend on the store.
+    static void wipe(TKey& key) {
+        volatile uint8_t* ptr = key.empty() ? 0 : &key[0];
+        for (size_t i = 0; i < key.size(); ++i)
+            ptr[i] = 0;
+        key.clear();
+    }
+
+  private:
+    static void handler(const char* name, void* arg);
+    static bool parseName(const char* name, uint32_t& spi);
+    std::string getFilename(uint32_t spi) const;
+    bool load(uint32_t spi, TKey& key) const;
+    void evict(uint32_t spi);
+    bool watch();
+
+    std::string Dir_;                // key directory, ends with a separator (or empty)
+    std::map<uint32_t, TKey> Keys_;  // cached keys
+    std::set<uint32_t> Missing_;     // SPIs without a key file
+    int WatchFD_;
+};
+
+#endif
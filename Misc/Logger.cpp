@@ -159,14 +159,14 @@ namespace logger {
     }
 
     ostream& logCont()    { return logger::buffer; }
-    ostream& logEmerg()   { return logger::logCommon(1); }
-    ostream& logAlert()   { return logger::logCommon(2); }
-    ostream& logCrit()    { return logger::logCommon(3); }
-    ostream& logError()   { return logger::logCommon(4); }
-    ostream& logWarning() { return logger::logCommon(5); }
-    ostream& logNotice()  { return logger::logCommon(6); }
-    ostream& logInfo()    { return logger::logCommon(7); }
-    ostream& logDebug()   { return logger::logCommon(8); }
+    ostream& logEmerg()   { return logger::logCommon(LEVEL_EMERG); }
+    ostream& logAlert()   { return logger::logCommon(LEVEL_ALERT); }
+    ostream& logCrit()    { return logger::logCommon(LEVEL_CRIT); }
+    ostream& logError()   { return logger::logCommon(LEVEL_ERROR); }
+    ostream& logWarning() { return logger::logCommon(LEVEL_WARNING); }
+    ostream& logNotice()  { return logger::logCommon(LEVEL_NOTICE); }
+    ostream& logInfo()    { return logger::logCommon(LEVEL_INFO); }
+    ostream& logDebug()   { return logger::logCommon(LEVEL_DEBUG); }
 
     /**
      * Prepare logging backend specified in logger::logmode for logging.
@@ -274,6 +274,17 @@ namespace logger {
         return logger::logLevel;
     }
 
+    /// @brief checks if messages of given priority are logged
+    ///
+    /// Used to skip preparing log-only data (e.g. formatting addresses).
+    ///
+    /// @param level message priority (LEVEL_*)
+    ///
+    /// @return true if messages of this priority are logged
+    bool enabled(int level) {
+        return level <= logger::logLevel;
+    }
+
     void setLogMode(string x) {
 	if (x=="short") {
 	    changeLogMode(LOGMODE_SHORT);
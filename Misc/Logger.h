@@ -31,6 +31,18 @@ namespace logger {
         LOGMODE_EVENTLOG /* windows only */
     };
 
+    /// message priorities, used by Log(X) and in the log-level setting
+    enum ELogLevel {
+        LEVEL_EMERG = 1,
+        LEVEL_ALERT,
+        LEVEL_CRIT,
+        LEVEL_ERROR,
+        LEVEL_WARNING,
+        LEVEL_NOTICE,
+        LEVEL_INFO,
+        LEVEL_DEBUG
+    };
+
     std::ostream& logCont();
     std::ostream& logEmerg();
     std::ostream& logAlert();
@@ -52,6 +64,7 @@ namespace logger {
     void setColors(bool colors);
     std::string getLogName();
     int getLogLevel();
+    bool enabled(int level);
 }
 
 std::string StateToString(EState state);
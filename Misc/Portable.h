@@ -113,6 +113,31 @@ struct link_state_notify_t
     int cnt;  /* number of iterface indexes filled */
 };
 
+/* address and link change events, see addr_events_open() */
+#define ADDR_EVENT_NEW_ADDR 1  /* address added or its flags changed */
+#define ADDR_EVENT_DEL_ADDR 2  /* address removed */
+#define ADDR_EVENT_NEW_LINK 3  /* link added or its state changed */
+#define ADDR_EVENT_DEL_LINK 4  /* link removed */
+
+#define ADDR_EVENT_FLAG_TENTATIVE 0x01 /* DAD in progress */
+#define ADDR_EVENT_FLAG_DADFAILED 0x02 /* DAD failed, address is duplicate */
+#define ADDR_EVENT_FLAG_RUNNING   0x04 /* link is up and running */
+
+struct addr_event_t
+{
+    int type;        /* ADDR_EVENT_* */
+    int ifindex;     /* interface index */
+    char addr[16];   /* address (packed), address events only */
+    int prefix_len;  /* prefix length, address events only */
+    int flags;       /* ADDR_EVENT_FLAG_* */
+};
+
+typedef void (*addr_event_handler_t)(const struct addr_event_t * event, void * arg);
+
+/* called with a name of a file that was created, changed or removed in a
+   watched directory, see dir_watch_open() */
+typedef void (*dir_watch_handler_t)(const char * name, void * arg);
+
 /**********************************************************************/
 /*** file setup/default paths *****************************************/
 /**********************************************************************/
@@ -129,6 +154,8 @@ struct link_state_notify_t
 #define SRVADDRMGR_FILE   "server-AddrMgr.xml"
 #define SRVTRANSMGR_FILE  "server-TransMgr.xml"
 #define SRVCACHE_FILE     "server-cache.xml"
+#define SRVCACHE_JOURNAL_FILE "server-cache.journal"
+#define SRVHOSTDB_FILE    "server-hosts"
 
 #define RELCFGMGR_FILE    "relay-CfgMgr.xml"
 #define RELIFACEMGR_FILE  "relay-IfaceMgr.xml"
@@ -257,6 +284,10 @@ struct link_state_notify_t
 #define LOWLEVEL_ERROR_SOCKET           -11
 #define LOWLEVEL_ERROR_NOT_IMPLEMENTED  -12
 
+/* reuse flags of sock_add() */
+#define LOWLEVEL_REUSE_ADDR 1 /* SO_REUSEADDR */
+#define LOWLEVEL_REUSE_PORT 2 /* several sockets share address and port, see sock_steer() */
+
 #define LOWLEVEL_TENTATIVE_YES 1
 #define LOWLEVEL_TENTATIVE_NO  0
 #define LOWLEVEL_TENTATIVE_DONT_KNOW -1
@@ -296,9 +327,13 @@ unsigned long pref, unsigned long valid, int prefixLength);
 
     /* add socket to interface */
     extern int sock_add(char* ifacename,int ifaceid, char* addr, int port, int thisifaceonly, int reuse);
+    /* selects socket (of those sharing address and port) for received packets */
+    extern int sock_steer(int fd, int shards);
     extern int sock_del(int fd);
     extern int sock_send(int fd, char* addr, char* buf, int buflen, int port, int iface);
     extern int sock_recv(int fd, char* myPlainAddr, char* peerPlainAddr, char* buf, int buflen);
+    /* the same as sock_recv(), but addresses are returned in packed (16 bytes) form */
+    extern int sock_recv_packed(int fd, char* myAddr, char* peerAddr, char* buf, int buflen);
 
     /** @brief gets MAC address from the specified IPv6 address
      *
@@ -330,6 +365,10 @@ unsigned long pref, unsigned long valid, int prefixLength);
     extern void link_state_change_init(volatile struct link_state_notify_t * changed_links,
                                        volatile int * notify);
     extern void link_state_change_cleanup();
+    /* address and link change events (not supported on all systems) */
+    extern int addr_events_open(addr_event_handler_t handler, void * arg);
+    extern int addr_events_read(int fd, addr_event_handler_t handler, void * arg);
+    extern void addr_events_close(int fd);
     extern void microsleep(int microsecs);
     extern char * error_message();
 
@@ -366,6 +405,11 @@ unsigned long pref, unsigned long valid, int prefixLength);
     char * getAAAKeyFilename(uint32_t SPI); /* which file? use this function to find out */
     uint32_t getAAASPIfromFile();
 
+    /* directory change notifications (used by the AAA key store) */
+    extern int dir_watch_open(const char * dir);
+    extern int dir_watch_read(int fd, dir_watch_handler_t handler, void * arg);
+    extern void dir_watch_close(int fd);
+
     int execute(const char *filename, const char * argv[], const char *env[]);
 
     /** @brief fills specified buffer with random data
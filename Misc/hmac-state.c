@@ -0,0 +1,129 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * Released under GNU GPL v2 licence
+ *
+ */
+
+#include <string.h>
+#include "Misc/hmac-state.h"
+
+/* hash functions used by a single HMAC type */
+struct hmac_hash {
+    int type;
+    int blocksize;
+    int digestsize;
+    void (*init_ctx)(void *);
+    void (*process_bytes)(const void *, size_t, void *);
+    void *(*finish_ctx)(void *, void *);
+};
+
+#define HMAC_HASH(x,y) \
+    { x, SHA##x##_BLOCKSIZE, SHA##x##_DIGESTSIZE,                \
+      (void(*)(void *))                     &sha##x##_init_ctx,  \
+      (void(*)(const void *, size_t, void *))&sha##y##_process_bytes, \
+      (void* (*)(void *, void *))           &sha##x##_finish_ctx }
+
+static const struct hmac_hash hmac_hashes[] = {
+    { 5, MD5_BLOCKSIZE, MD5_DIGESTSIZE,
+      (void(*)(void *))                      &md5_init_ctx,
+      (void(*)(const void *, size_t, void *))&md5_process_bytes,
+      (void* (*)(void *, void *))            &md5_finish_ctx },
+    HMAC_HASH(  1,   1),
+    HMAC_HASH(224, 256),
+    HMAC_HASH(256, 256),
+    HMAC_HASH(384, 512),
+    HMAC_HASH(512, 512)
+};
+
+static const struct hmac_hash *hmac_find(int type) {
+    size_t i;
+    for (i = 0; i < sizeof(hmac_hashes)/sizeof(hmac_hashes[0]); i++)
+        if (hmac_hashes[i].type == type)
+            return &hmac_hashes[i];
+    return NULL;
+}
+
+/* overwrite memory that held key material, so the writes are not optimized away */
+static void hmac_wipe(void *ptr, size_t len) {
+    volatile unsigned char *p = (volatile unsigned char *)ptr;
+    while (len--)
+        *p++ = 0;
+}
+
+/* Prepare keyed state for HMAC type (1, 224, 256, 384, 512 for SHA or 5 */
+/* for MD5). Returns 0 if successful, -1 if type is not supported.        */
+int hmac_state_init(struct hmac_state *state, const char *key, size_t key_len, int type) {
+  /* SHA512_BLOCKSIZE and SHA512_DIGESTSIZE are the biggest, so we can use it with other algorithms */
+  char Ki[SHA512_BLOCKSIZE];
+  char Ko[SHA512_BLOCKSIZE];
+  const struct hmac_hash *hash = hmac_find(type);
+  size_t i;
+
+  if (!hash)
+          return -1;
+
+  /* if given key is longer that algorithm's block, we must change it to
+     hash of the original key (of size of algorithm's digest) */
+  if (key_len > (size_t)hash->blocksize) {
+          hash->init_ctx (&state->inner);
+          hash->process_bytes (key, key_len, &state->inner);
+          hash->finish_ctx (&state->inner, Ki);
+          key_len = hash->digestsize;
+          memcpy(Ko, Ki, key_len);
+  } else {
+          memcpy(Ki, key, key_len);
+          memcpy(Ko, key, key_len);
+  }
+
+  /* prepare input and output key */
+  for (i = 0; i < key_len; i++) {
+          Ki[i] ^= 0x36;
+          Ko[i] ^= 0x5c;
+  }
+  for (; i < (size_t)hash->blocksize; i++) {
+          Ki[i] = 0x36;
+          Ko[i] = 0x5c;
+  }
+
+  state->type = type;
+  state->digest_size = hash->digestsize;
+  hash->init_ctx (&state->inner);
+  hash->process_bytes (Ki, hash->blocksize, &state->inner);
+  hash->init_ctx (&state->outer);
+  hash->process_bytes (Ko, hash->blocksize, &state->outer);
+
+  hmac_wipe(Ki, sizeof(Ki));
+  hmac_wipe(Ko, sizeof(Ko));
+  return 0;
+}
+
+/* Calculate HMAC of BUFFER using keyed STATE and write it to RESBUF. */
+/* STATE is not modified.                                             */
+void *hmac_state_digest(const struct hmac_state *state, const char *buffer, size_t len, char *resbuf) {
+  char tmpbuf[SHA512_DIGESTSIZE];
+  union hmac_hash_ctx ctx;
+  const struct hmac_hash *hash = hmac_find(state->type);
+  void *result;
+
+  if (!hash)
+          return NULL;
+
+  ctx = state->inner;
+  hash->process_bytes (buffer, len, &ctx);
+  hash->finish_ctx (&ctx, tmpbuf);
+
+  ctx = state->outer;
+  hash->process_bytes (tmpbuf, hash->digestsize, &ctx);
+  result = hash->finish_ctx (&ctx, resbuf);
+
+  hmac_wipe(&ctx, sizeof(ctx));
+  return result;
+}
+
+/* Remove key material from STATE. */
+void hmac_state_wipe(struct hmac_state *state) {
+  hmac_wipe(state, sizeof(*state));
+}
@@ -0,0 +1,49 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * Released under GNU GPL v2 licence
+ *
+ */
+
+#ifndef HMAC_STATE_H
+#define HMAC_STATE_H
+
+#include <stddef.h>
+#include "md5.h"
+#include "sha1.h"
+#include "sha256.h"
+#include "sha512.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+union hmac_hash_ctx {
+    struct md5_ctx md5;
+    struct sha1_ctx sha1;
+    struct sha256_ctx sha256;
+    struct sha512_ctx sha512;
+};
+
+/* Keyed HMAC state. Key XOR ipad and key XOR opad blocks are hashed once,
+   in hmac_state_init(), so every digest only needs to copy both states
+   and process the message itself. The same state can be used for any
+   number of messages. */
+struct hmac_state {
+    int type;                  /* 1, 224, 256, 384, 512 (SHA) or 5 (MD5) */
+    size_t digest_size;
+    union hmac_hash_ctx inner; /* after processing key XOR ipad */
+    union hmac_hash_ctx outer; /* after processing key XOR opad */
+};
+
+int hmac_state_init(struct hmac_state *state, const char *key, size_t key_len, int type);
+void *hmac_state_digest(const struct hmac_state *state, const char *buffer, size_t len, char *resbuf);
+void hmac_state_wipe(struct hmac_state *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
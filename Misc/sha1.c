@@ -27,6 +27,7 @@
 /* This file is taken from coreutils-6.2 (lib/sha1.c) and adapted for dibbler
  * by Michal Kowalczuk <michal@kowalczuk.eu> */
 
+#include "dibbler-config.h"
 #include "sha1.h"
 
 #include <stddef.h>
@@ -37,7 +38,7 @@
 # define SWAP(n) \
     (((n) << 24) | (((n) & 0xff00) << 8) | (((n) >> 8) & 0xff00) | ((n) >> 24))
 #else
-#if __BYTE_ORDER == __BIG_ENDIAN
+#if defined( WORDS_BIGENDIAN)
 # define SWAP(n) (n)
 #else
 # define SWAP(n) \
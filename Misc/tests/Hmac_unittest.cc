@@ -0,0 +1,157 @@
+#include "HmacCache.h"
+#include "hmac-sha-md5.h"
+
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <string.h>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+/// known answer: HMAC type, test case (see hmacKey()) and expected digest
+struct THmacKat {
+    int type;
+    int testCase;
+    const char* digest;
+};
+
+// RFC 2202 (HMAC-MD5, HMAC-SHA1) and RFC 4231 (HMAC-SHA2) test cases 1, 2
+// and 6 (key longer than the block)
+const THmacKat HmacKats[] = {
+    { 5, 0, "5ccec34ea9656392457fa1ac27f08fbc" },
+    { 5, 1, "750c783e6ab0b503eaa86e310a5db738" },
+    { 5, 2, "bfecaf4efff90a3a668f3922fec3762d" },
+    { 1, 0, "b617318655057264e28bc0b6fb378c8ef146be00" },
+    { 1, 1, "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79" },
+    { 1, 2, "90d0dace1c1bdc957339307803160335bde6df2b" },
+    { 224, 0, "896fb1128abbdf196832107cd49df33f47b4b1169912ba4f53684b22" },
+    { 224, 1, "a30e01098bc6dbbf45690f3a7e9e6d0f8bbea2a39e6148008fd05e44" },
+    { 224, 2, "95e9a0db962095adaebe9b2d6f0dbce2d499f112f2d2b7273fa6870e" },
+    { 256, 0, "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7" },
+    { 256, 1, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" },
+    { 256, 2, "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54" },
+    { 384, 0, "afd03944d84895626b0825f4ab46907f15f9dadbe4101ec682aa034c7cebc59cfaea9ea9076ede7f4af152e8b2fa9cb6" },
+    { 384, 1, "af45d2e376484031617f78d2b58a6b1b9c7ef464f5a01b47e42ec3736322445e8e2240ca5e69e2c78b3239ecfab21649" },
+    { 384, 2, "4ece084485813e9088d2c63a041bc5b44f9ef1012a2b588f3cd11f05033ac4c60c2ef6ab4030fe8296248df163f44952" },
+    { 512, 0, "87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cdedaa833b7d6b8a702038b274eaea3f4e4be9d914eeb61f1702e696c203a126854" },
+    { 512, 1, "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea2505549758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737" },
+    { 512, 2, "80b24263c7c1a3ebb71493c1dd7be8b49b46d1f41b4aeec1121b013783f8f3526b56d037e05f2598bd0fd2215d6a1e5295e64f73f63f0aec8b915a985d786598" },
+};
+
+string hex(const uint8_t* buf, size_t len) {
+    ostringstream tmp;
+    for (size_t i = 0; i < len; ++i)
+        tmp << setfill('0') << setw(2) << std::hex << (unsigned)buf[i];
+    return tmp.str();
+}
+
+TKey hmacKey(int testCase) {
+    switch (testCase) {
+    case 0:
+        return TKey(20, 0x0b);
+    case 1:
+        return TKey((const uint8_t*)"Jefe", (const uint8_t*)"Jefe" + 4);
+    default:
+        return TKey(131, 0xaa);
+    }
+}
+
+string hmacData(int testCase) {
+    switch (testCase) {
+    case 0:
+        return "Hi There";
+    case 1:
+        return "what do ya want for nothing?";
+    default:
+        return "Test Using Larger Than Block-Size Key - Hash Key First";
+    }
+}
+
+// This test verifies that one-shot HMAC functions return known answers.
+TEST(HmacTest, oneShot) {
+    for (size_t i = 0; i < sizeof(HmacKats)/sizeof(HmacKats[0]); ++i) {
+        const THmacKat& kat = HmacKats[i];
+        TKey key = hmacKey(kat.testCase);
+        string data = hmacData(kat.testCase);
+        uint8_t digest[64];
+        memset(digest, 0, sizeof(digest));
+
+        if (kat.type == 5)
+            hmac_md5(data.c_str(), data.size(), (char*)&key[0], key.size(), (char*)digest);
+        else
+            hmac_sha(data.c_str(), data.size(), (char*)&key[0], key.size(), (char*)digest, kat.type);
+        EXPECT_EQ(kat.digest, hex(digest, strlen(kat.digest) / 2))
+            << "type=" << kat.type << ", test case " << kat.testCase;
+    }
+}
+
+// This test verifies that keyed state can be used for many messages and
+// returns the same digests as the one-shot functions.
+TEST(HmacTest, state) {
+    for (size_t i = 0; i < sizeof(HmacKats)/sizeof(HmacKats[0]); ++i) {
+        const THmacKat& kat = HmacKats[i];
+        TKey key = hmacKey(kat.testCase);
+        string data = hmacData(kat.testCase);
+
+        hmac_state state;
+        ASSERT_EQ(0, hmac_state_init(&state, (const char*)&key[0], key.size(), kat.type));
+        EXPECT_EQ(strlen(kat.digest) / 2, state.digest_size);
+
+        for (int j = 0; j < 3; ++j) {
+            uint8_t digest[64];
+            hmac_state_digest(&state, data.c_str(), data.size(), (char*)digest);
+            EXPECT_EQ(kat.digest, hex(digest, state.digest_size))
+                << "type=" << kat.type << ", test case " << kat.testCase;
+        }
+        hmac_state_wipe(&state);
+    }
+
+    hmac_state state;
+    EXPECT_EQ(-1, hmac_state_init(&state, "key", 3, 2));
+}
+
+// This test verifies that cached states are reused and return known answers.
+TEST(HmacTest, cache) {
+    THmacCache cache;
+    for (int round = 0; round < 2; ++round) {
+        for (size_t i = 0; i < sizeof(HmacKats)/sizeof(HmacKats[0]); ++i) {
+            const THmacKat& kat = HmacKats[i];
+            string data = hmacData(kat.testCase);
+            uint8_t digest[64];
+            ASSERT_TRUE(cache.digest(kat.type, hmacKey(kat.testCase), data.c_str(), data.size(),
+                                     (char*)digest));
+            EXPECT_EQ(kat.digest, hex(digest, strlen(kat.digest) / 2));
+        }
+    }
+    EXPECT_EQ(sizeof(HmacKats)/sizeof(HmacKats[0]), cache.count());
+
+    uint8_t digest[64];
+    EXPECT_FALSE(cache.digest(0, hmacKey(0), "abc", 3, (char*)digest));
+
+    // cache is dropped when full
+    cache.setMaxSize(2);
+    EXPECT_EQ(0u, cache.count());
+    cache.digest(5, hmacKey(0), "abc", 3, (char*)digest);
+    cache.digest(5, hmacKey(1), "abc", 3, (char*)digest);
+    cache.digest(5, hmacKey(2), "abc", 3, (char*)digest);
+    EXPECT_EQ(1u, cache.count());
+
+    // states of a removed key are dropped, for all HMAC types
+    cache.setMaxSize(256);
+    cache.digest(256, hmacKey(2), "abc", 3, (char*)digest);
+    cache.digest(5, hmacKey(1), "abc", 3, (char*)digest);
+    EXPECT_EQ(3u, cache.count());
+    cache.remove(hmacKey(2));
+    EXPECT_EQ(1u, cache.count());
+    cache.remove(hmacKey(2));
+    EXPECT_EQ(1u, cache.count());
+
+    EXPECT_EQ(5, THmacCache::getType(DIGEST_HMAC_MD5));
+    EXPECT_EQ(256, THmacCache::getType(DIGEST_HMAC_SHA256));
+    EXPECT_EQ(0, THmacCache::getType(DIGEST_PLAIN));
+}
+
+}
@@ -1,6 +1,7 @@
 #include "IPv6Addr.h"
 
 #include <string>
+#include <string.h>
 #include <gtest/gtest.h>
 
 using namespace std;
@@ -29,6 +30,19 @@ TEST(IPv6AddrTest, subtraction) {
     EXPECT_EQ(string(result.getPlain()), "ffff:ffff:ffff:ffff::1");
 }
 
+// text form is cached, but must follow changes of the address
+TEST(IPv6AddrTest, plainFollowsChanges) {
+    TIPv6Addr addr("2001:db8::ff", true);
+    EXPECT_EQ("2001:db8::ff", string(addr.getPlain()));
+
+    ++addr;
+    EXPECT_EQ("2001:db8::100", string(addr.getPlain()));
+
+    TIPv6Addr other("2001:db8::1", true);
+    addr.setAddr(other.getAddr());
+    EXPECT_EQ("2001:db8::1", string(addr.getPlain()));
+}
+
 TEST(IPv6AddrTest, randomDecrease) {
     srandom(time(NULL));
 
@@ -76,4 +90,83 @@ TEST(IPv6AddrTest, truncate) {
     EXPECT_EQ("ff00::", string(x.getPlain()));
 }
 
+// Tests that value form of the address can be converted back and forth.
+TEST(IPv6AddrTest, value) {
+    TIPv6Addr addr("2001:db8:1:2:3:4:5:6", true);
+
+    TIPv6AddrValue value = addr.getValue();
+    EXPECT_EQ(0x20010db800010002ULL, value.getHi());
+    EXPECT_EQ(0x0003000400050006ULL, value.getLo());
+    EXPECT_EQ("2001:db8:1:2:3:4:5:6", value.getPlain());
+    EXPECT_EQ(16u, sizeof(TIPv6AddrValue));
+
+    TIPv6Addr copy(value);
+    EXPECT_TRUE(copy == addr);
+    EXPECT_EQ("2001:db8:1:2:3:4:5:6", string(copy.getPlain()));
+
+    char packed[16];
+    value.store(packed);
+    EXPECT_EQ(0, memcmp(packed, addr.getAddr(), 16));
+    EXPECT_TRUE(TIPv6AddrValue(packed) == value);
+
+    EXPECT_TRUE(TIPv6Addr("fe80::1", true).getValue().linkLocal());
+    EXPECT_FALSE(value.linkLocal());
+    EXPECT_TRUE(TIPv6Addr("ff02::1:2", true).getValue().multicast());
+    EXPECT_FALSE(value.multicast());
+}
+
+// Tests that value form is compared as a 128-bit number.
+TEST(IPv6AddrTest, valueCompare) {
+    TIPv6AddrValue a = TIPv6Addr("2001:db8::ffff", true).getValue();
+    TIPv6AddrValue b = TIPv6Addr("2001:db8:0:1::", true).getValue();
+    TIPv6AddrValue c = TIPv6Addr("2001:db8:0:1::", true).getValue();
+
+    EXPECT_TRUE(a < b);
+    EXPECT_FALSE(b < a);
+    EXPECT_TRUE(a <= b);
+    EXPECT_TRUE(b <= c);
+    EXPECT_FALSE(b < c);
+    EXPECT_TRUE(b == c);
+    EXPECT_TRUE(a != b);
+    EXPECT_EQ(b.hash(), c.hash());
+    EXPECT_NE(a.hash(), b.hash());
+
+    // ordering of TIPv6Addr follows the value
+    TIPv6Addr x("2001:db8::ffff", true);
+    TIPv6Addr y("2001:db8:0:1::", true);
+    EXPECT_TRUE(x <= y);
+    EXPECT_FALSE(y <= x);
+}
+
+// Tests that carry and borrow are passed between 64-bit words.
+TEST(IPv6AddrTest, valueArithmetic) {
+    TIPv6AddrValue a = TIPv6Addr("2001:db8:1:0:ffff:ffff:ffff:ffff", true).getValue();
+    TIPv6AddrValue one(0, 1);
+
+    EXPECT_EQ("2001:db8:1:1::", (a + one).getPlain());
+    EXPECT_TRUE((a + one) - one == a);
+    EXPECT_EQ("::ffff:ffff:ffff:ffff",
+              (a - TIPv6Addr("2001:db8:1::", true).getValue()).getPlain());
+
+    TIPv6Addr x("2001:db8:1:0:ffff:ffff:ffff:ffff", true);
+    TIPv6Addr y("::1", true);
+    EXPECT_EQ("2001:db8:1:1::", string((x + y).getPlain()));
+}
+
+// Tests that value form is truncated the same way as TIPv6Addr.
+TEST(IPv6AddrTest, valueTruncate) {
+    const int ranges[][2] = { {0, 128}, {0, 127}, {0, 120}, {0, 64}, {0, 63},
+                              {0, 8}, {0, 0}, {1, 128}, {48, 64}, {60, 68},
+                              {64, 128}, {100, 101} };
+    for (size_t i = 0; i < sizeof(ranges)/sizeof(ranges[0]); i++) {
+        TIPv6Addr x("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff", true);
+        TIPv6AddrValue value = x.getValue();
+
+        x.truncate(ranges[i][0], ranges[i][1]);
+        value.truncate(ranges[i][0], ranges[i][1]);
+        EXPECT_EQ(string(x.getPlain()), value.getPlain())
+            << "truncate(" << ranges[i][0] << "," << ranges[i][1] << ")";
+    }
+}
+
 }
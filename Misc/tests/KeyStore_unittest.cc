@@ -0,0 +1,135 @@
+#include "KeyStore.h"
+#include "HmacCache.h"
+
+#include <fstream>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+class KeyStoreTest : public ::testing::Test {
+public:
+    KeyStoreTest() {
+        char tmpl[] = "/tmp/dibbler-keys-XXXXXX";
+        Dir_ = mkdtemp(tmpl);
+    }
+
+    ~KeyStoreTest() {
+        remove(file(0x1234).c_str());
+        remove(file(0x5678).c_str());
+        rmdir(Dir_.c_str());
+    }
+
+    string file(uint32_t spi) {
+        string name = getAAAKeyFilename(spi);
+        return Dir_ + "/" + name.substr(name.find_last_of('/') + 1);
+    }
+
+    void write(uint32_t spi, const string& data) {
+        // written to a temporary file first, the same way keys should be rotated
+        string tmp = Dir_ + "/tmp";
+        ofstream f(tmp.c_str(), ios::out | ios::binary | ios::trunc);
+        f << data;
+        f.close();
+        rename(tmp.c_str(), file(spi).c_str());
+    }
+
+    static string str(const TKey& key) {
+        return string(key.begin(), key.end());
+    }
+
+    string Dir_;
+};
+
+// This test verifies that keys are read, cached and reloaded when their
+// files change.
+TEST_F(KeyStoreTest, reload) {
+    TKeyStore store(Dir_);
+    TKey key;
+
+    write(0x1234, "secret1");
+    ASSERT_TRUE(store.get(0x1234, key));
+    EXPECT_EQ("secret1", str(key));
+    if (!store.isWatched())
+        return; // no notifications on this system, nothing is cached
+
+    EXPECT_EQ(1u, store.count());
+    ASSERT_TRUE(store.get(0x1234, key));
+    EXPECT_EQ("secret1", str(key));
+    EXPECT_EQ(1u, store.count());
+
+    // rotated key
+    write(0x1234, "secret2");
+    ASSERT_TRUE(store.get(0x1234, key));
+    EXPECT_EQ("secret2", str(key));
+
+    // removed key
+    remove(file(0x1234).c_str());
+    EXPECT_FALSE(store.get(0x1234, key));
+    EXPECT_EQ(0u, store.count());
+}
+
+// This test verifies that missing keys are picked up once they are added.
+TEST_F(KeyStoreTest, missing) {
+    TKeyStore store(Dir_);
+    TKey key;
+
+    EXPECT_FALSE(store.get(0x5678, key));
+    EXPECT_FALSE(store.get(0x5678, key));
+
+    write(0x5678, "key");
+    ASSERT_TRUE(store.get(0x5678, key));
+    EXPECT_EQ("key", str(key));
+
+    // empty file is not a valid key
+    write(0x1234, "");
+    EXPECT_FALSE(store.get(0x1234, key));
+}
+
+TEST_F(KeyStoreTest, wipe) {
+    TKey key;
+    key.push_back(1);
+    key.push_back(2);
+    TKeyStore::wipe(key);
+    EXPECT_TRUE(key.empty());
+
+    TKeyStore store(Dir_);
+    write(0x1234, "secret");
+    ASSERT_TRUE(store.get(0x1234, key));
+    store.clear();
+    EXPECT_EQ(0u, store.count());
+}
+
+// This test verifies that HMAC states of a dropped key are removed.
+TEST_F(KeyStoreTest, hmacStates) {
+    TKeyStore store(Dir_);
+    TKey key;
+    THmacCache& cache = THmacCache::instance();
+    cache.clear();
+
+    write(0x1234, "secret1");
+    ASSERT_TRUE(store.get(0x1234, key));
+    if (!store.isWatched())
+        return; // no notifications on this system, nothing is cached
+
+    char digest[64];
+    ASSERT_TRUE(cache.digest(256, key, "abc", 3, digest));
+    ASSERT_TRUE(cache.digest(5, key, "abc", 3, digest));
+    EXPECT_EQ(2u, cache.count());
+
+    // rotated key
+    write(0x1234, "secret2");
+    ASSERT_TRUE(store.get(0x1234, key));
+    EXPECT_EQ(0u, cache.count());
+
+    ASSERT_TRUE(cache.digest(256, key, "abc", 3, digest));
+    store.clear();
+    EXPECT_EQ(0u, cache.count());
+}
+
+}
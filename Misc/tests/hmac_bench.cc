@@ -0,0 +1,86 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * author: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+/*
+ * HMAC benchmark. This is not a unit test and it is not run by 'make
+ * check'. For every HMAC type and a few message sizes it reports CPU time
+ * per message of the one-shot functions (hmac_md5(), hmac_sha()), which
+ * hash key pads for every message, and of the cached keyed state
+ * (THmacCache), which hashes them once per key.
+ *
+ * Usage: ./Misc_bench [--gtest_filter=...]
+ */
+
+#include <time.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "HmacCache.h"
+#include "hmac-sha-md5.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+/// number of messages signed for every type and size
+const int HMAC_BENCH_MSGS = 200000;
+
+unsigned long long cpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void bench(const char* name, int type) {
+    // typical message sizes: short REPLY, REPLY with a few options, large REPLY
+    const size_t sizes[] = { 100, 300, 1000 };
+    TKey key(32, 0x5a);
+    char digest[64];
+
+    for (size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++i) {
+        vector<char> msg(sizes[i], 0x21);
+
+        unsigned long long start = cpuNs();
+        for (int j = 0; j < HMAC_BENCH_MSGS; ++j) {
+            msg[0] = (char)j;
+            if (type == 5)
+                hmac_md5(&msg[0], msg.size(), (char*)&key[0], key.size(), digest);
+            else
+                hmac_sha(&msg[0], msg.size(), (char*)&key[0], key.size(), digest, type);
+        }
+        unsigned long long oneShot = cpuNs() - start;
+
+        THmacCache cache;
+        start = cpuNs();
+        for (int j = 0; j < HMAC_BENCH_MSGS; ++j) {
+            msg[0] = (char)j;
+            cache.digest(type, key, &msg[0], msg.size(), digest);
+        }
+        unsigned long long cached = cpuNs() - start;
+
+        cout << "BENCH " << setw(12) << left << name << right
+             << " size=" << setw(5) << sizes[i]
+             << " one-shot/msg=" << setw(8) << fixed << setprecision(0)
+             << (double)oneShot / HMAC_BENCH_MSGS << "ns"
+             << " cached/msg=" << setw(8) << (double)cached / HMAC_BENCH_MSGS << "ns"
+             << " speedup=" << setprecision(2) << (double)oneShot / (cached ? cached : 1)
+             << endl;
+    }
+}
+
+TEST(HmacBench, digests) {
+    bench("HMAC-MD5", 5);
+    bench("HMAC-SHA1", 1);
+    bench("HMAC-SHA256", 256);
+    bench("HMAC-SHA512", 512);
+}
+
+}
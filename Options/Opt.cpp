@@ -46,12 +46,36 @@ char* TOpt::storeHeader(char* buf) {
     return buf;
 }
 
+/// @brief Stores option type and skips option length.
+///
+/// Used by options with suboptions. Calculating their size would require
+/// calculating sizes of all suboptions (and their suboptions), so the length
+/// is written once the whole option is stored (see storeLength()).
+///
+/// @param buf buffer to store the option header in
+///
+/// @return pointer to the option data
+char* TOpt::storeHeaderType(char* buf) {
+    buf = writeUint16(buf, OptType);
+    return buf + 2;
+}
+
+/// @brief Back-patches option length of an option stored with storeHeaderType()
+///
+/// @param start beginning of the stored option
+/// @param end end of the stored option
+///
+/// @return end of the stored option
+char* TOpt::storeLength(char* start, char* end) {
+    writeUint16(start + 2, end - start - OPTION6_HDR_LEN);
+    return end;
+}
+
 char* TOpt::storeSubOpt(char* buf){
     TOptPtr ptr;
     SubOptions.first();
     while ( ptr = SubOptions.get() ) {
-        ptr->storeSelf(buf);
-        buf += ptr->getSize();
+        buf = ptr->storeSelf(buf);
     }
     return buf;
 }
@@ -101,6 +101,8 @@ class TOpt
 
  protected:
     char* storeHeader(char* buf);
+    char* storeHeaderType(char* buf);
+    static char* storeLength(char* start, char* end);
     char* storeSubOpt(char* buf);
     int getSubOptSize();
 
@@ -48,13 +48,15 @@ std::string TOptAddr::getPlain() {
 }
 
 char * TOptAddr::storeSelf(char* buf) {
-    // store generic header
-    buf = writeUint16( buf, OptType );
-    buf = writeUint16( buf, getSize() - 4 );
+    char* start = buf;
+
+    // store generic header (length is written at the end)
+    buf = storeHeaderType(buf);
 
     // store address
     buf = Addr->storeSelf(buf);
 
     // store sub-options (if three are any)
-    return storeSubOpt(buf);
+    buf = storeSubOpt(buf);
+    return storeLength(start, buf);
 }
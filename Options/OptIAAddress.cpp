@@ -62,9 +62,8 @@ void TOptIAAddress::setValid(unsigned long valid) {
 
  char * TOptIAAddress::storeSelf( char* buf)
 {
-    buf = writeUint16(buf, OptType);
-
-    buf = writeUint16(buf, getSize() - 4 );
+    char* start = buf;
+    buf = storeHeaderType(buf);
 
     memcpy(buf, Addr_->getAddr(), 16);
     buf += 16;
@@ -75,7 +74,7 @@ void TOptIAAddress::setValid(unsigned long valid) {
 
     buf = storeSubOpt(buf);
 
-    return buf;
+    return storeLength(start, buf);
 }
 
 SPtr<TIPv6Addr> TOptIAAddress::getAddr() const {
@@ -63,8 +63,8 @@ void TOptIAPrefix::setPrefixLenght(char prefix_length){
 
 char * TOptIAPrefix::storeSelf(char* buf)
 {
-    buf = writeUint16(buf, OptType);
-    buf = writeUint16(buf, getSize()-4);
+    char* start = buf;
+    buf = storeHeaderType(buf);
 
     buf = writeUint32(buf, PrefLifetime_);
     buf = writeUint32(buf, ValidLifetime_);
@@ -75,7 +75,7 @@ char * TOptIAPrefix::storeSelf(char* buf)
     buf+=16;
 
     buf=storeSubOpt(buf);
-    return buf;
+    return storeLength(start, buf);
 }
 
 SPtr<TIPv6Addr> TOptIAPrefix::getPrefix() const {
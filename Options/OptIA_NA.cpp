@@ -48,15 +48,15 @@ size_t TOptIA_NA::getSize() {
 }
 
 char * TOptIA_NA::storeSelf( char* buf) {
-    buf = writeUint16(buf, OptType);
-    buf = writeUint16(buf, getSize() - 4 );
+    char* start = buf;
+    buf = storeHeaderType(buf);
 
     buf = writeUint32(buf, IAID_);
     buf = writeUint32(buf, T1_);
     buf = writeUint32(buf, T2_);
 
     buf = storeSubOpt(buf);
-    return buf;
+    return storeLength(start, buf);
 }
 
 unsigned long TOptIA_NA::getMaxValid() {
@@ -49,8 +49,7 @@ char * TOptReconfigureMsg::storeSelf( char* buf)
     buf = writeUint16(buf, OptType);
     buf = writeUint16(buf, 1); // length
     buf = writeUint8(buf, MsgType_);
-    //*buf = (char)MsgType_;
-    return buf+1;
+    return buf;
 }
 
 bool TOptReconfigureMsg::isValid() const
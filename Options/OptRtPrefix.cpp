@@ -47,7 +47,8 @@ TOptRtPrefix::TOptRtPrefix(const char * buf, int bufsize, TMsg* parent)
 }
 
 char* TOptRtPrefix::storeSelf(char* buf) {
-    buf = storeHeader(buf);
+    char* start = buf;
+    buf = storeHeaderType(buf);
     buf = writeUint32(buf, Lifetime);
     buf[0] = PrefixLen;
     buf[1] = Metric;
@@ -55,7 +56,8 @@ char* TOptRtPrefix::storeSelf(char* buf) {
 
     buf = Prefix->storeSelf(buf);
 
-    return storeSubOpt(buf);
+    buf = storeSubOpt(buf);
+    return storeLength(start, buf);
 }
 
 uint32_t TOptRtPrefix::getLifetime()
@@ -36,7 +36,8 @@ char * TOptString::storeSelf(char* buf)
     buf = writeUint16(buf, getSize()-4);
     memcpy(buf,Str.c_str(),Str.length());
     buf[Str.length()]=0;  // null-terminated
-    return buf+this->Str.length()+1;
+    buf[Str.length()+1]=0; // getSize() counts one more byte, don't leave it uninitialized
+    return buf+this->Str.length()+2;
 
     *buf = (char)Str.length(); // length of a string (with first byte)
     buf++;
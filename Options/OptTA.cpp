@@ -59,11 +59,11 @@ size_t TOptTA::getSize() {
 }
 
 char * TOptTA::storeSelf( char* buf) {
-    buf = writeUint16(buf, OptType);
-    buf = writeUint16(buf, getSize()-4);
+    char* start = buf;
+    buf = storeHeaderType(buf);
     buf = writeUint32(buf, IAID_);
     buf = storeSubOpt(buf);
-    return buf;
+    return storeLength(start, buf);
 }
 
 unsigned long TOptTA::getMaxValid() {
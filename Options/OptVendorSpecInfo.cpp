@@ -106,11 +106,11 @@ size_t TOptVendorSpecInfo::getSize() {
 
 char * TOptVendorSpecInfo::storeSelf( char* buf)
 {
-    // option-code OPTION_VENDOR_OPTS (2 bytes long)
-    buf = writeUint16(buf, OptType);
+    char* start = buf;
 
-    // option-len size of total option-data
-    buf = writeUint16(buf, getSize()-4);
+    // option-code OPTION_VENDOR_OPTS (2 bytes long), option-len is written
+    // once all suboptions are stored
+    buf = storeHeaderType(buf);
 
     // enterprise-number (4 bytes long)
     buf = writeUint32(buf, Vendor_);
@@ -121,8 +121,8 @@ char * TOptVendorSpecInfo::storeSelf( char* buf)
     {
         buf = opt->storeSelf(buf);
     }
-    
-    return buf;
+
+    return storeLength(start, buf);
 }
 
 std::string TOptVendorSpecInfo::getPlain() {
@@ -5,6 +5,11 @@
 #include "Opt.h"
 #include "OptAddr.h"
 #include "OptGeneric.h"
+#include "OptIA_PD.h"
+#include "OptIAPrefix.h"
+#include "OptInteger.h"
+#include "OptStatusCode.h"
+#include "Portable.h"
 
 using namespace std;
 
@@ -63,4 +68,60 @@ TEST(OptTest, OptList) {
     EXPECT_FALSE(TOpt::getOption(list, 6));
 }
 
+class NakedOptIA_PD : public TOptIA_PD {
+public:
+    NakedOptIA_PD(uint32_t iaid, uint32_t t1, uint32_t t2)
+        :TOptIA_PD(iaid, t1, t2, NULL) {}
+    bool doDuties() { return true; }
+};
+
+// Checks that nested options (IA_PD with many IAPREFIXes, each with a status
+// code) are stored in one pass, with option lengths back-patched properly.
+TEST(OptTest, storeNested) {
+    const int prefixes = 100;
+    TOptIA_PD* pd = new NakedOptIA_PD(1234, 100, 200);
+    for (int i = 0; i < prefixes; i++) {
+        SPtr<TIPv6Addr> addr = new TIPv6Addr("2001:db8::", true);
+        SPtr<TOpt> prefix = new TOptIAPrefix(addr, 64, 300, 400, NULL);
+        prefix->addOption(new TOptStatusCode(STATUSCODE_SUCCESS, "ok", NULL));
+        pd->addOption(prefix);
+    }
+
+    // IA_PD: 4 + 12, IAPREFIX: 4 + 25, STATUS_CODE: 4 + 2 + 2
+    const size_t prefixLen = 29 + 8;
+    const size_t expectedLen = 16 + prefixes * prefixLen;
+    ASSERT_EQ(expectedLen, pd->getSize());
+
+    vector<char> buf(expectedLen + 16, 0x55);
+    char* end = pd->storeSelf(&buf[0]);
+    EXPECT_EQ(&buf[0] + expectedLen, end);
+
+    // guard bytes must not be touched
+    for (size_t i = expectedLen; i < buf.size(); i++)
+        EXPECT_EQ(0x55, buf[i]);
+
+    EXPECT_EQ(OPTION_IA_PD, readUint16(&buf[0]));
+    EXPECT_EQ(expectedLen - 4, readUint16(&buf[2]));
+    EXPECT_EQ(1234u, readUint32(&buf[4]));
+
+    for (int i = 0; i < prefixes; i++) {
+        const char* opt = &buf[16 + i * prefixLen];
+        EXPECT_EQ(OPTION_IAPREFIX, readUint16(opt));
+        EXPECT_EQ(prefixLen - 4, readUint16(opt + 2));
+        EXPECT_EQ(OPTION_STATUS_CODE, readUint16(opt + 29));
+        EXPECT_EQ(4, readUint16(opt + 31));
+    }
+
+    delete pd;
+}
+
+// Checks that integer options return proper end of stored data.
+TEST(OptTest, storeInteger) {
+    char buf[16];
+    for (unsigned int len = 1; len <= 4; len *= 2) {
+        TOptInteger opt(OPTION_PREFERENCE, len, 0x12345678 & (0xffffffff >> (32 - 8*len)), NULL);
+        EXPECT_EQ(buf + opt.getSize(), opt.storeSelf(buf));
+    }
+}
+
 }
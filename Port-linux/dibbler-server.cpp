@@ -12,7 +12,12 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <limits.h>
 #include "DHCPServer.h"
+#include "SrvCfgMgr.h"
+#include "SrvHostDB.h"
+#include "SrvAddrMgr.h"
 #include "Portable.h"
 #include "Logger.h"
 #include "daemon.h"
@@ -79,6 +84,26 @@ int run() {
     return 0;
 }
 
+/// compiles host reservations of an interface (see TSrvHostDB::compile())
+int compileHosts(const char* csvFile, const char* ifaceName) {
+    string binFile = WORKDIR + "/" + TSrvCfgMgr::hostDBName(ifaceName);
+    return TSrvHostDB::compile(csvFile, binFile)? 0 : -1;
+}
+
+/// writes lease database in XML format (see TSrvAddrMgr::exportXml())
+int exportLeases(const char* xmlFile) {
+    // database files are relative to the working directory
+    char cwd[PATH_MAX];
+    string file = xmlFile;
+    if (file[0] != '/' && getcwd(cwd, sizeof(cwd)))
+	file = string(cwd) + "/" + file;
+    if (chdir(WORKDIR.c_str())) {
+	cout << "Unable to change directory to " << WORKDIR << "." << endl;
+	return -1;
+    }
+    TSrvAddrMgr::instanceCreate(SRVADDRMGR_FILE, true);
+    return SrvAddrMgr().exportXml(file)? 0 : -1;
+}
 
 int help() {
     cout << "Usage:" << endl;
@@ -90,6 +115,9 @@ int help() {
 	 << " install   - Not available in Linux/Unix systems." << endl
 	 << " uninstall - Not available in Linux/Unix systems." << endl
 	 << " run       - run in the console" << endl
+	 << " compile-hosts FILE IFACE - compiles host reservations of interface IFACE" << endl
+	 << "             (a running server picks them up automatically)" << endl
+	 << " export-leases FILE - writes lease database in XML format to FILE" << endl
 	 << " help      - displays usage info." << endl;
     return 0;
 }
@@ -120,6 +148,12 @@ int main(int argc, char * argv[])
     if (!strncasecmp(command,"status",6)) {
 	result = status();
     } else
+    if (!strncasecmp(command,"compile-hosts",13) && argc==4) {
+	result = compileHosts(argv[2], argv[3]);
+    } else
+    if (!strncasecmp(command,"export-leases",13) && argc==3) {
+	result = exportLeases(argv[2]);
+    } else
     if (!strncasecmp(command,"help",4)) {
 	result = help();
     } else
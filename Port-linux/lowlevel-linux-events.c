@@ -0,0 +1,272 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ * Address and link change notifications (netlink). Instead of dumping all
+ * addresses every time state of a single address is needed, a socket
+ * subscribed to RTNLGRP_LINK and RTNLGRP_IPV6_IFADDR groups is kept open
+ * and changes are reported as they happen.
+ *
+ * Directory change notifications (inotify), so files (e.g. AAA keys) can
+ * be cached and reloaded only when they change.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/inotify.h>
+#include <net/if.h>
+#include <netinet/in.h>
+
+#include "libnetlink.h"
+#include "Portable.h"
+
+#ifndef IFA_F_DADFAILED
+#define IFA_F_DADFAILED 0x08
+#endif
+
+extern char Message[1024];
+
+/* kernel silently caps this at net.core.rmem_max */
+#define ADDR_EVENTS_RCVBUF (1024*1024)
+
+struct addr_events_ctx {
+    addr_event_handler_t handler;
+    void * arg;
+    int cnt;
+};
+
+/*
+ * converts single netlink message to an event and passes it to the handler
+ */
+static int addr_events_parse(const struct sockaddr_nl *who, struct nlmsghdr *n, void *arg)
+{
+    struct addr_events_ctx * ctx = (struct addr_events_ctx*)arg;
+    struct addr_event_t event;
+    memset(&event, 0, sizeof(event));
+
+    switch (n->nlmsg_type) {
+    case RTM_NEWADDR:
+    case RTM_DELADDR:
+    {
+	struct ifaddrmsg *ifa = NLMSG_DATA(n);
+	struct rtattr * tb[IFA_MAX+1];
+	int len = n->nlmsg_len - NLMSG_LENGTH(sizeof(*ifa));
+	unsigned int flags;
+	if (len < 0 || ifa->ifa_family != AF_INET6)
+	    return 0;
+
+	memset(tb, 0, sizeof(tb));
+	parse_rtattr(tb, IFA_MAX, IFA_RTA(ifa), len);
+	if (!tb[IFA_LOCAL])
+	    tb[IFA_LOCAL] = tb[IFA_ADDRESS];
+	if (!tb[IFA_LOCAL] || RTA_PAYLOAD(tb[IFA_LOCAL]) < 16)
+	    return 0;
+
+	flags = ifa->ifa_flags;
+#ifdef IFA_FLAGS
+	/* extended (32 bit) flags */
+	if (tb[IFA_FLAGS] && RTA_PAYLOAD(tb[IFA_FLAGS]) >= sizeof(__u32))
+	    flags = *(__u32*)RTA_DATA(tb[IFA_FLAGS]);
+#endif
+
+	event.type = (n->nlmsg_type == RTM_NEWADDR) ? ADDR_EVENT_NEW_ADDR : ADDR_EVENT_DEL_ADDR;
+	event.ifindex = ifa->ifa_index;
+	event.prefix_len = ifa->ifa_prefixlen;
+	memcpy(event.addr, RTA_DATA(tb[IFA_LOCAL]), 16);
+	if (flags & IFA_F_TENTATIVE)
+	    event.flags |= ADDR_EVENT_FLAG_TENTATIVE;
+	if (flags & IFA_F_DADFAILED)
+	    event.flags |= ADDR_EVENT_FLAG_DADFAILED;
+	break;
+    }
+    case RTM_NEWLINK:
+    case RTM_DELLINK:
+    {
+	struct ifinfomsg *ifi = NLMSG_DATA(n);
+	if (n->nlmsg_len < NLMSG_LENGTH(sizeof(*ifi)))
+	    return 0;
+	event.type = (n->nlmsg_type == RTM_NEWLINK) ? ADDR_EVENT_NEW_LINK : ADDR_EVENT_DEL_LINK;
+	event.ifindex = ifi->ifi_index;
+	if ((ifi->ifi_flags & IFF_UP) && (ifi->ifi_flags & IFF_RUNNING))
+	    event.flags |= ADDR_EVENT_FLAG_RUNNING;
+	break;
+    }
+    default:
+	return 0;
+    }
+
+    ctx->handler(&event, ctx->arg);
+    ctx->cnt++;
+    return 0;
+}
+
+/*
+ * opens event socket and reports current state of links and IPv6 addresses
+ *
+ * returns: socket descriptor or LOWLEVEL_ERROR_SOCKET
+ */
+int addr_events_open(addr_event_handler_t handler, void * arg)
+{
+    struct rtnl_handle events;
+    struct addr_events_ctx ctx;
+    int rcvbuf = ADDR_EVENTS_RCVBUF;
+
+    ctx.handler = handler;
+    ctx.arg = arg;
+    ctx.cnt = 0;
+
+    if (rtnl_open(&events, RTMGRP_LINK | RTMGRP_IPV6_IFADDR) < 0) {
+	sprintf(Message, "Unable to open netlink socket for address events.");
+	return LOWLEVEL_ERROR_SOCKET;
+    }
+    setsockopt(events.fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    /* notifications received during dumps are not lost, they are parsed as junk */
+    if (rtnl_wilddump_request(&events, AF_UNSPEC, RTM_GETLINK) < 0 ||
+	rtnl_dump_filter(&events, addr_events_parse, &ctx, addr_events_parse, &ctx) < 0 ||
+	rtnl_wilddump_request(&events, AF_INET6, RTM_GETADDR) < 0 ||
+	rtnl_dump_filter(&events, addr_events_parse, &ctx, addr_events_parse, &ctx) < 0) {
+	sprintf(Message, "Unable to dump links and addresses.");
+	rtnl_close(&events);
+	return LOWLEVEL_ERROR_SOCKET;
+    }
+
+    return events.fd;
+}
+
+/*
+ * reads all pending notifications, does not block
+ *
+ * returns: number of reported events, LOWLEVEL_ERROR_SOCKET if some
+ *          notifications were lost (socket should be reopened)
+ */
+int addr_events_read(int fd, addr_event_handler_t handler, void * arg)
+{
+    struct addr_events_ctx ctx;
+    struct sockaddr_nl nladdr;
+    struct iovec iov;
+    struct msghdr msg;
+    char buf[16384];
+    int status;
+    struct nlmsghdr *h;
+
+    ctx.handler = handler;
+    ctx.arg = arg;
+    ctx.cnt = 0;
+
+    while (1) {
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = buf;
+	iov.iov_len = sizeof(buf);
+	msg.msg_name = &nladdr;
+	msg.msg_namelen = sizeof(nladdr);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	status = recvmsg(fd, &msg, MSG_DONTWAIT);
+	if (status < 0) {
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		break;
+	    /* ENOBUFS: kernel dropped notifications */
+	    sprintf(Message, "Address events lost (errno=%d).", errno);
+	    return LOWLEVEL_ERROR_SOCKET;
+	}
+	if (status == 0)
+	    break;
+
+	for (h = (struct nlmsghdr*)buf; NLMSG_OK(h, status); h = NLMSG_NEXT(h, status))
+	    addr_events_parse(&nladdr, h, &ctx);
+    }
+
+    return ctx.cnt;
+}
+
+void addr_events_close(int fd)
+{
+    if (fd >= 0)
+	close(fd);
+}
+
+/* files written, renamed or removed; attribute changes cover chmod of a key */
+#define DIR_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ATTRIB | \
+			IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+/*
+ * starts watching a directory for changes
+ *
+ * returns: descriptor or LOWLEVEL_ERROR_FILE
+ */
+int dir_watch_open(const char * dir)
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+	sprintf(Message, "Unable to initialize inotify (errno=%d).", errno);
+	return LOWLEVEL_ERROR_FILE;
+    }
+    if (inotify_add_watch(fd, dir, DIR_WATCH_MASK) < 0) {
+	snprintf(Message, sizeof(Message), "Unable to watch directory %s (errno=%d).", dir, errno);
+	close(fd);
+	return LOWLEVEL_ERROR_FILE;
+    }
+    return fd;
+}
+
+/*
+ * reads all pending notifications, does not block
+ *
+ * returns: number of changed files, LOWLEVEL_ERROR_FILE if notifications
+ *          were lost or the directory itself was removed (everything should
+ *          be considered changed and the watch reopened)
+ */
+int dir_watch_read(int fd, dir_watch_handler_t handler, void * arg)
+{
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event * ev;
+    int cnt = 0;
+    ssize_t len;
+    char * ptr;
+
+    while (1) {
+	len = read(fd, buf, sizeof(buf));
+	if (len < 0) {
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		break;
+	    sprintf(Message, "Unable to read directory notifications (errno=%d).", errno);
+	    return LOWLEVEL_ERROR_FILE;
+	}
+	if (len == 0)
+	    break;
+
+	for (ptr = buf; ptr < buf + len; ptr += sizeof(struct inotify_event) + ev->len) {
+	    ev = (const struct inotify_event *)ptr;
+	    if (ev->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+		sprintf(Message, "Directory notifications lost or directory removed.");
+		return LOWLEVEL_ERROR_FILE;
+	    }
+	    if (ev->len && ev->name[0]) {
+		handler(ev->name, arg);
+		cnt++;
+	    }
+	}
+    }
+
+    return cnt;
+}
+
+void dir_watch_close(int fd)
+{
+    if (fd >= 0)
+	close(fd);
+}
@@ -34,6 +34,7 @@
 #include <fnmatch.h>
 #include <time.h>
 #include <errno.h>
+#include <linux/filter.h>
 
 
 #include "libnetlink.h"
@@ -512,8 +513,22 @@ int sock_add(char * ifacename,int ifaceid, char * addr, int port, int thisifaceo
 	}
     }
 
-    /* allow address reuse (this option sucks - why allow running multiple servers?) */
-    if (reuse!=0) {
+    if (reuse & LOWLEVEL_REUSE_PORT) {
+	/* several sockets bound to the same address and port, kernel spreads
+	   received packets among them (see sock_steer()) */
+#ifdef SO_REUSEPORT
+	if (setsockopt(Insock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0)  {
+	    sprintf(Message, "Unable to set up socket option SO_REUSEPORT.");
+	    close(Insock);
+	    return LOWLEVEL_ERROR_REUSE_FAILED;
+	}
+#else
+	sprintf(Message, "Socket option SO_REUSEPORT is not supported.");
+	close(Insock);
+	return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+#endif
+    } else if (reuse!=0) {
+	/* allow address reuse (this option sucks - why allow running multiple servers?) */
 	if (setsockopt(Insock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0)  {
 	    sprintf(Message, "Unable to set up socket option SO_REUSEADDR.");
 	    return LOWLEVEL_ERROR_REUSE_FAILED;
@@ -557,6 +572,54 @@ int sock_add(char * ifacename,int ifaceid, char * addr, int port, int thisifaceo
     return Insock;
 }
 
+/*
+ * attaches program that selects one of the sockets sharing address and port
+ * (opened with LOWLEVEL_REUSE_PORT, in order of binding) for received
+ * packets. All messages from one client go to the same socket: RELAY-FORW
+ * messages are spread by the relay's link-address, other messages by the
+ * client's DUID (if CLIENTID is the first option) or by transaction-id.
+ *
+ * fd - any socket of the group
+ * shards - number of sockets in the group
+ */
+int sock_steer(int fd, int shards)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+    struct sock_filter code[] = {
+	BPF_STMT(BPF_LD  | BPF_B | BPF_ABS, 0),          /* msg-type */
+	BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 12, 0, 2),   /* RELAY-FORW? */
+	BPF_STMT(BPF_LD  | BPF_W | BPF_ABS, 14),         /* last 4 bytes of link-address */
+	BPF_JUMP(BPF_JMP | BPF_JA, 8, 0, 0),
+	BPF_STMT(BPF_LD  | BPF_H | BPF_ABS, 4),          /* first option */
+	BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 1, 0, 5),    /* CLIENTID? */
+	BPF_STMT(BPF_LD  | BPF_H | BPF_ABS, 6),          /* DUID length */
+	BPF_STMT(BPF_ALU | BPF_ADD | BPF_K, 4),
+	BPF_STMT(BPF_MISC | BPF_TAX, 0),
+	BPF_STMT(BPF_LD  | BPF_W | BPF_IND, 0),          /* last 4 bytes of DUID */
+	BPF_JUMP(BPF_JMP | BPF_JA, 1, 0, 0),
+	BPF_STMT(BPF_LD  | BPF_W | BPF_ABS, 0),          /* msg-type and transaction-id */
+	BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (unsigned int)shards),
+	BPF_STMT(BPF_RET | BPF_A, 0)
+    };
+    struct sock_fprog prog;
+
+    if (shards < 1) {
+	sprintf(Message, "Invalid number of sockets: %d", shards);
+	return LOWLEVEL_ERROR_UNSPEC;
+    }
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0) {
+	sprintf(Message, "Unable to attach socket selection program: %s", strerror(errno));
+	return LOWLEVEL_ERROR_SOCK_OPTS;
+    }
+    return LOWLEVEL_NO_ERROR;
+#else
+    sprintf(Message, "Socket selection programs are not supported.");
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
 int sock_del(int fd)
 {
     return close(fd);
@@ -587,13 +650,12 @@ int sock_send(int sock, char *addr, char *buf, int message_len, int port, int if
 }
 
 /*
- *
+ * receives data, addresses are returned in packed (16 bytes) form
  */
-int sock_recv(int fd, char * myPlainAddr, char * peerPlainAddr, char * buf, int buflen)
+int sock_recv_packed(int fd, char * myAddr, char * peerAddr, char * buf, int buflen)
 {
     struct msghdr msg;            /* message received by recvmsg */
-    struct sockaddr_in6 peerAddr; /* sender address */
-    struct sockaddr_in6 myAddr;   /* my address */
+    struct sockaddr_in6 peer;     /* sender address */
     struct iovec iov;             /* simple structure containing buffer address and length */
 
     struct cmsghdr *cm;           /* control message */
@@ -603,14 +665,14 @@ int sock_recv(int fd, char * myPlainAddr, char * peerPlainAddr, char * buf, int
     char controlLen = CMSG_SPACE(sizeof(struct in6_pktinfo));
     int result = 0;
     bzero(&msg, sizeof(msg));
-    bzero(&peerAddr, sizeof(peerAddr));
-    bzero(&myAddr, sizeof(myAddr));
+    bzero(&peer, sizeof(peer));
     bzero(&control, sizeof(control));
+    bzero(myAddr, 16);
     iov.iov_base = buf;
     iov.iov_len  = buflen;
 
-    msg.msg_name       = &peerAddr;
-    msg.msg_namelen    = sizeof(peerAddr);
+    msg.msg_name       = &peer;
+    msg.msg_namelen    = sizeof(peer);
     msg.msg_iov        = &iov;
     msg.msg_iovlen     = 1;
     msg.msg_control    = control;
@@ -623,18 +685,33 @@ int sock_recv(int fd, char * myPlainAddr, char * peerPlainAddr, char * buf, int
     }
 
     /* get source address */
-    inet_ntop6((void*)&peerAddr.sin6_addr, peerPlainAddr);
+    memcpy(peerAddr, &peer.sin6_addr, 16);
 
     /* get destination address */
     for(cm = (struct cmsghdr *) CMSG_FIRSTHDR(&msg); cm; cm = (struct cmsghdr *) CMSG_NXTHDR(&msg, cm)){
 	if (cm->cmsg_level != IPPROTO_IPV6 || cm->cmsg_type != IPV6_PKTINFO)
 	    continue;
 	pktinfo= (struct in6_pktinfo *) (CMSG_DATA(cm));
-	inet_ntop6((void*)&pktinfo->ipi6_addr, myPlainAddr);
+	memcpy(myAddr, &pktinfo->ipi6_addr, 16);
     }
     return result;
 }
 
+/*
+ *
+ */
+int sock_recv(int fd, char * myPlainAddr, char * peerPlainAddr, char * buf, int buflen)
+{
+    char myAddr[16];
+    char peerAddr[16];
+    int result = sock_recv_packed(fd, myAddr, peerAddr, buf, buflen);
+    if (result < 0)
+	return result;
+    inet_ntop6(peerAddr, peerPlainAddr);
+    inet_ntop6(myAddr, myPlainAddr);
+    return result;
+}
+
 void microsleep(int microsecs)
 {
     struct timespec x,y;
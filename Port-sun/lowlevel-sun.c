@@ -341,6 +341,13 @@ int sock_add(char * ifacename, int ifaceid, char * addr, int port,
 #endif
     }
 
+    /* sockets sharing address and port get duplicates or nothing here */
+    if (reuse & LOWLEVEL_REUSE_PORT) {
+        sprintf(Message, "Sockets sharing address and port are not supported.");
+        close(Insock);
+        return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+    }
+
     /* allow address reuse (this option sucks - why allow running multiple servers?) */
     if (reuse != 0) {
         if (setsockopt(Insock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on)) < 0) {
@@ -382,6 +389,10 @@ int sock_add(char * ifacename, int ifaceid, char * addr, int port,
     return Insock;
 }
 
+int sock_steer(int fd, int shards) {
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+}
+
 int sock_del(int fd) {
     return close(fd);
 }
@@ -407,13 +418,12 @@ int sock_send(int sock, char *addr, char *buf, int message_len, int port, int if
 }
 
 /*
- *
+ * receives data, addresses are returned in packed (16 bytes) form
  */
-int sock_recv(int fd, char * myPlainAddr, char * peerPlainAddr, char * buf,
+int sock_recv_packed(int fd, char * myAddr, char * peerAddr, char * buf,
         int buflen) {
     struct msghdr msg; /* message received by recvmsg */
-    struct sockaddr_in6 peerAddr; /* sender address */
-    struct sockaddr_in6 myAddr; /* my address */
+    struct sockaddr_in6 peer; /* sender address */
     struct iovec iov; /* simple structure containing buffer address and length */
 
     struct cmsghdr *cm; /* control message */
@@ -423,14 +433,14 @@ int sock_recv(int fd, char * myPlainAddr, char * peerPlainAddr, char * buf,
     char controlLen = CMSG_SPACE(sizeof (struct in6_pktinfo));
     int result = 0;
     bzero(&msg, sizeof (msg));
-    bzero(&peerAddr, sizeof (peerAddr));
-    bzero(&myAddr, sizeof (myAddr));
+    bzero(&peer, sizeof (peer));
     bzero(&control, sizeof (control));
+    bzero(myAddr, 16);
     iov.iov_base = buf;
     iov.iov_len = buflen;
 
-    msg.msg_name = &peerAddr;
-    msg.msg_namelen = sizeof (peerAddr);
+    msg.msg_name = &peer;
+    msg.msg_namelen = sizeof (peer);
     msg.msg_iov = &iov;
     msg.msg_iovlen = 1;
     msg.msg_control = control;
@@ -443,18 +453,33 @@ int sock_recv(int fd, char * myPlainAddr, char * peerPlainAddr, char * buf,
     }
 
     /* get source address */
-    inet_ntop6((void*) & peerAddr.sin6_addr, peerPlainAddr);
+    memcpy(peerAddr, &peer.sin6_addr, 16);
 
     /* get destination address */
     for (cm = (struct cmsghdr *) CMSG_FIRSTHDR(&msg); cm; cm = (struct cmsghdr *) CMSG_NXTHDR(&msg, cm)) {
         if (cm->cmsg_level != IPPROTO_IPV6 || cm->cmsg_type != IPV6_PKTINFO)
             continue;
         pktinfo = (struct in6_pktinfo *) (CMSG_DATA(cm));
-        inet_ntop6((void*) & pktinfo->ipi6_addr, myPlainAddr);
+        memcpy(myAddr, &pktinfo->ipi6_addr, 16);
     }
     return result;
 }
 
+/*
+ *
+ */
+int sock_recv(int fd, char * myPlainAddr, char * peerPlainAddr, char * buf,
+        int buflen) {
+    char myAddr[16];
+    char peerAddr[16];
+    int result = sock_recv_packed(fd, myAddr, peerAddr, buf, buflen);
+    if (result < 0)
+        return result;
+    inet_ntop6(peerAddr, peerPlainAddr);
+    inet_ntop6(myAddr, myPlainAddr);
+    return result;
+}
+
 #if 0
 void microsleep(int microsecs) {
     struct timespec x, y;
@@ -554,6 +579,35 @@ void link_state_change_cleanup()
     return;
 }
 
+int addr_events_open(addr_event_handler_t handler, void * arg)
+{
+    /// @todo: implement this (routing socket)
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+}
+
+int addr_events_read(int fd, addr_event_handler_t handler, void * arg)
+{
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+}
+
+void addr_events_close(int fd)
+{
+}
+
+int dir_watch_open(const char * dir)
+{
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+}
+
+int dir_watch_read(int fd, dir_watch_handler_t handler, void * arg)
+{
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+}
+
+void dir_watch_close(int fd)
+{
+}
+
 
 int get_mac_from_ipv6(const char* iface_name, int ifindex, const char* v6addr,
                       char* mac, int* mac_len) {
@@ -375,6 +375,10 @@ extern int sock_add(char * ifacename,int ifaceid, char * addr, int port, int thi
     int	hops=1;
     char packedAddr[16];
     
+    // SO_REUSEADDR (set always) does not spread packets among sockets
+    if (reuse & LOWLEVEL_REUSE_PORT)
+        return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+
     inet_pton6(addr,packedAddr);
     if ((s=socket(AF_INET6,SOCK_DGRAM, 0)) == INVALID_SOCKET)
 	return -2;
@@ -417,6 +421,11 @@ extern int sock_add(char * ifacename,int ifaceid, char * addr, int port, int thi
     return s;
 }
 
+int sock_steer(int fd, int shards)
+{
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+}
+
 int sock_del(int fd)
 {
     return closesocket(fd);
@@ -463,22 +472,35 @@ int sock_send(int fd, char * addr, char * buf, int buflen, int port,int iface)
     return LOWLEVEL_NO_ERROR;
 }
 
-int sock_recv(int fd, char * myPlainAddr, char * peerPlainAddr, char * buf, int buflen)
+int sock_recv_packed(int fd, char * myAddr, char * peerAddr, char * buf, int buflen)
 {
     struct sockaddr_in6 info;  
     int	infolen ;		
     int	readBytes;
     
+    memset(myAddr, 0, 16);
     infolen=sizeof(info);
     if(!(readBytes=recvfrom(fd,buf,buflen,0,(SOCKADDR*)&info,&infolen))) {
         sprintf(Message, "socket reception failed (recvfrom() function returned 0 bytes read)\n");
         return LOWLEVEL_ERROR_UNSPEC;
     } else {
-        inet_ntop6(info.sin6_addr.u.Byte,peerPlainAddr);
+        memcpy(peerAddr, info.sin6_addr.u.Byte, 16);
         return	readBytes;
     }
 }
 
+int sock_recv(int fd, char * myPlainAddr, char * peerPlainAddr, char * buf, int buflen)
+{
+    char myAddr[16];
+    char peerAddr[16];
+    int readBytes = sock_recv_packed(fd, myAddr, peerAddr, buf, buflen);
+    if (readBytes < 0)
+        return readBytes;
+    inet_ntop6(peerAddr, peerPlainAddr);
+    inet_ntop6(myAddr, myPlainAddr);
+    return readBytes;
+}
+
 extern int dns_add(const char* ifname, int ifaceid, const char* addrPlain) {
     
     // netsh interface ipv6 add dns "eth0" address=2000::123
@@ -671,6 +693,35 @@ void link_state_change_cleanup()
    /// @todo: implement this
 }
 
+int addr_events_open(addr_event_handler_t handler, void * arg)
+{
+    /// @todo: implement this (NotifyUnicastIpAddressChange)
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+}
+
+int addr_events_read(int fd, addr_event_handler_t handler, void * arg)
+{
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+}
+
+void addr_events_close(int fd)
+{
+}
+
+int dir_watch_open(const char * dir)
+{
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+}
+
+int dir_watch_read(int fd, dir_watch_handler_t handler, void * arg)
+{
+    return LOWLEVEL_ERROR_NOT_IMPLEMENTED;
+}
+
+void dir_watch_close(int fd)
+{
+}
+
 int execute(const char *filename, const char * argv[], const char *env[])
 {
     intptr_t i;
@@ -0,0 +1,286 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <fstream>
+#include <sstream>
+#include "SrvAddrCache.h"
+#include "Portable.h"
+#include "Logger.h"
+
+using namespace std;
+
+bool TSrvAddrCache::TAddrKey::operator<(const TAddrKey& other) const {
+    if (addr != other.addr)
+        return addr < other.addr;
+    return type < other.type;
+}
+
+TSrvAddrCache::TSrvAddrCache()
+    :MaxSize_(0), JournalEnabled_(true), JournalLines_(0) {
+}
+
+TSrvAddrCache::TAddrKey TSrvAddrCache::makeKey(TIAType type, SPtr<TIPv6Addr> addr) {
+    TAddrKey key;
+    key.addr = addr->getValue();
+    key.type = type;
+    return key;
+}
+
+TSrvAddrCache::TDuidKey TSrvAddrCache::makeKey(TIAType type, SPtr<TDUID> duid) {
+    return TDuidKey(type, string(duid->get(), duid->getLen()));
+}
+
+const char* TSrvAddrCache::typeName(TIAType type) {
+    return type == IATYPE_PD ? "prefix" : "addr";
+}
+
+/// @brief estimates memory used by a single entry
+///
+/// Counts the list node, both index nodes, the address and DUID objects
+/// with their reference counters, and the DUID bytes (kept in TDUID as
+/// binary and text, and as the index key). Tree and list nodes are assumed
+/// to hold parent/child (or prev/next) links and a color, padded to a
+/// pointer, on top of their values.
+///
+/// @param duidLen length of the client's DUID
+///
+/// @return entry size (in bytes)
+size_t TSrvAddrCache::entrySize(size_t duidLen) {
+    size_t size = sizeof(TEntry) + 2*sizeof(void*);
+    size += sizeof(std::pair<const TDuidKey, TEntryLst::iterator>) + 4*sizeof(void*);
+    size += sizeof(std::pair<const TAddrKey, TEntryLst::iterator>) + 4*sizeof(void*);
+    size += sizeof(TIPv6Addr) + sizeof(TDUID) + 2*sizeof(Ptr);
+    size += duidLen          // TDUID binary form
+        + 3*duidLen          // TDUID text form (xx:)
+        + duidLen;           // DUID index key
+    return size;
+}
+
+/// @brief sets maximum number of entries. Oldest entries are removed if necessary.
+///
+/// @param entries maximum number of entries (0 disables cache)
+void TSrvAddrCache::setMaxSize(size_t entries) {
+    MaxSize_ = entries;
+    while (Entries_.size() > MaxSize_) {
+        record('-', Entries_.front());
+        remove(Entries_.begin());
+    }
+}
+
+size_t TSrvAddrCache::getMaxSize() const {
+    return MaxSize_;
+}
+
+size_t TSrvAddrCache::count() const {
+    return Entries_.size();
+}
+
+void TSrvAddrCache::clear() {
+    Entries_.clear();
+    DuidIndex_.clear();
+    AddrIndex_.clear();
+}
+
+/// @brief returns address or prefix cached for a client
+///
+/// Entry that is found becomes the most recently used one.
+///
+/// @param duid client's DUID
+/// @param type entry type (IATYPE_IA for address or IATYPE_PD for prefix)
+///
+/// @return cached address or prefix (or NULL)
+SPtr<TIPv6Addr> TSrvAddrCache::get(SPtr<TDUID> duid, TIAType type) {
+    map<TDuidKey, TEntryLst::iterator>::const_iterator it = DuidIndex_.find(makeKey(type, duid));
+    if (it == DuidIndex_.end())
+        return SPtr<TIPv6Addr>();
+
+    // move it to the end (most recently used), iterators stay valid
+    Entries_.splice(Entries_.end(), Entries_, it->second);
+    return it->second->addr;
+}
+
+/// @brief adds address or prefix to the cache
+///
+/// Previous entry for this client (and any entry for this address) is
+/// replaced. If cache is full, the least recently used entry is removed.
+///
+/// @param duid client's DUID
+/// @param addr address or prefix
+/// @param type entry type (IATYPE_IA for address or IATYPE_PD for prefix)
+void TSrvAddrCache::add(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr, TIAType type) {
+    if (!MaxSize_ || !duid || !addr)
+        return;
+
+    del(duid, type);
+    del(addr, type);
+
+    TEntry entry;
+    entry.type = type;
+    entry.duid = duid;
+    entry.addr = addr;
+    TEntryLst::iterator it = Entries_.insert(Entries_.end(), entry);
+    DuidIndex_[makeKey(type, duid)] = it;
+    AddrIndex_[makeKey(type, addr)] = it;
+    record('+', entry);
+
+    if (Entries_.size() > MaxSize_) {
+        record('-', Entries_.front());
+        remove(Entries_.begin());
+    }
+}
+
+/// @brief removes entry for specified client
+///
+/// @param duid client's DUID
+/// @param type entry type
+///
+/// @return true if entry was found and removed
+bool TSrvAddrCache::del(SPtr<TDUID> duid, TIAType type) {
+    map<TDuidKey, TEntryLst::iterator>::iterator it = DuidIndex_.find(makeKey(type, duid));
+    if (it == DuidIndex_.end())
+        return false;
+    record('-', *it->second);
+    remove(it->second);
+    return true;
+}
+
+/// @brief removes entry for specified address or prefix
+///
+/// @param addr address or prefix
+/// @param type entry type
+///
+/// @return true if entry was found and removed
+bool TSrvAddrCache::del(SPtr<TIPv6Addr> addr, TIAType type) {
+    map<TAddrKey, TEntryLst::iterator>::iterator it = AddrIndex_.find(makeKey(type, addr));
+    if (it == AddrIndex_.end())
+        return false;
+    record('-', *it->second);
+    remove(it->second);
+    return true;
+}
+
+void TSrvAddrCache::remove(TEntryLst::iterator entry) {
+    DuidIndex_.erase(makeKey(entry->type, entry->duid));
+    AddrIndex_.erase(makeKey(entry->type, entry->addr));
+    Entries_.erase(entry);
+}
+
+/// @brief records a change in the journal (in memory, see flush())
+///
+/// @param op '+' for added entry, '-' for removed entry
+/// @param entry changed entry
+void TSrvAddrCache::record(char op, const TEntry& entry) {
+    if (!JournalEnabled_)
+        return;
+    ostringstream line;
+    line << op << " " << typeName(entry.type) << " " << entry.duid->getPlain();
+    if (op == '+')
+        line << " " << entry.addr->getPlain();
+    line << "\n";
+    Journal_ += line.str();
+    JournalLines_++;
+}
+
+/// @brief enables or disables journaling (e.g. when cache is loaded from a snapshot)
+void TSrvAddrCache::setJournal(bool enabled) {
+    JournalEnabled_ = enabled;
+}
+
+/// returns number of changes recorded since the last snapshot
+size_t TSrvAddrCache::getJournalSize() const {
+    return JournalLines_;
+}
+
+/// @brief appends pending journal lines to a file
+///
+/// @param file journal file
+///
+/// @return true if successful
+bool TSrvAddrCache::flush(const std::string& file) {
+    if (Journal_.empty())
+        return true;
+
+    ofstream f(file.c_str(), ios::out | ios::app);
+    if (!f.is_open()) {
+        Log(Error) << "Cache: Unable to open journal file " << file << "." << LogEnd;
+        return false;
+    }
+    f << Journal_;
+    f.close();
+    if (f.fail()) {
+        Log(Error) << "Cache: Failed to write journal file " << file << "." << LogEnd;
+        return false;
+    }
+    Journal_.clear();
+    return true;
+}
+
+/// @brief truncates journal file, called after full snapshot was written
+///
+/// @param file journal file
+void TSrvAddrCache::resetJournal(const std::string& file) {
+    Journal_.clear();
+    JournalLines_ = 0;
+    ofstream f(file.c_str(), ios::out | ios::trunc);
+}
+
+/// @brief applies changes recorded in a journal file
+///
+/// @param file journal file
+///
+/// @return number of changes applied
+int TSrvAddrCache::replay(const std::string& file) {
+    ifstream f(file.c_str());
+    if (!f.is_open())
+        return 0;
+
+    // changes are already in the journal file, don't record them again
+    bool journal = JournalEnabled_;
+    JournalEnabled_ = false;
+
+    int applied = 0;
+    int lineno = 0;
+    string line;
+    while (getline(f, line)) {
+        lineno++;
+        if (line.empty())
+            continue;
+
+        istringstream tokens(line);
+        string op, typeStr, duidStr, addrStr;
+        tokens >> op >> typeStr >> duidStr >> addrStr;
+
+        TIAType type;
+        if (typeStr == "addr")
+            type = IATYPE_IA;
+        else if (typeStr == "prefix")
+            type = IATYPE_PD;
+        else {
+            Log(Warning) << "Cache: Invalid entry type in line " << lineno << " of "
+                         << file << ", line ignored." << LogEnd;
+            continue;
+        }
+
+        SPtr<TDUID> duid = new TDUID(duidStr.c_str());
+        if (op == "+" && !addrStr.empty()) {
+            add(duid, new TIPv6Addr(addrStr.c_str(), true), type);
+        } else if (op == "-") {
+            del(duid, type);
+        } else {
+            Log(Warning) << "Cache: Invalid line " << lineno << " in " << file
+                         << ", line ignored." << LogEnd;
+            continue;
+        }
+        applied++;
+    }
+
+    JournalEnabled_ = journal;
+    JournalLines_ += applied;
+    return applied;
+}
@@ -0,0 +1,95 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVADDRCACHE_H
+#define SRVADDRCACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include "SmartPtr.h"
+#include "DHCPConst.h"
+#include "DUID.h"
+#include "IPv6Addr.h"
+
+/// @brief Cache of addresses and prefixes previously assigned to clients.
+///
+/// When a client returns after its lease expired or was released, the
+/// server tries to assign the same address (or prefix) again. Entries are
+/// kept in least recently used order and indexed by client DUID and by
+/// address, so lookups do not depend on the cache size. When the cache is
+/// full, the least recently used entry is dropped.
+///
+/// Every change is also recorded as a line in a journal. Pending journal
+/// lines are appended to the journal file by flush(), so the whole cache
+/// does not have to be rewritten whenever a single entry changes. The
+/// journal is replayed on top of the last snapshot during startup.
+class TSrvAddrCache
+{
+  public:
+    /// single cached address or prefix
+    struct TEntry
+    {
+        TIAType type;          // address or prefix
+        SPtr<TDUID> duid;      // client's duid
+        SPtr<TIPv6Addr> addr;  // cached address, previously assigned to a client
+    };
+    typedef std::list<TEntry> TEntryLst;
+
+    TSrvAddrCache();
+
+    static size_t entrySize(size_t duidLen);
+    void setMaxSize(size_t entries);
+    size_t getMaxSize() const;
+    size_t count() const;
+    void clear();
+
+    SPtr<TIPv6Addr> get(SPtr<TDUID> duid, TIAType type);
+    void add(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr, TIAType type);
+    bool del(SPtr<TDUID> duid, TIAType type);
+    bool del(SPtr<TIPv6Addr> addr, TIAType type);
+
+    /// returns all entries, least recently used first
+    const TEntryLst& getEntries() const { return Entries_; }
+
+    // journal
+    void setJournal(bool enabled);
+    size_t getJournalSize() const;
+    bool flush(const std::string& file);
+    void resetJournal(const std::string& file);
+    int replay(const std::string& file);
+
+  private:
+
+    /// key of the address index: entry type and 128-bit address
+    struct TAddrKey {
+        TIPv6AddrValue addr;
+        int type;
+        bool operator<(const TAddrKey& other) const;
+    };
+    typedef std::pair<int, std::string> TDuidKey;
+
+    static TAddrKey makeKey(TIAType type, SPtr<TIPv6Addr> addr);
+    static TDuidKey makeKey(TIAType type, SPtr<TDUID> duid);
+    static const char* typeName(TIAType type);
+
+    void remove(TEntryLst::iterator entry);
+    void record(char op, const TEntry& entry);
+
+    TEntryLst Entries_;
+    std::map<TDuidKey, TEntryLst::iterator> DuidIndex_;
+    std::map<TAddrKey, TEntryLst::iterator> AddrIndex_;
+    size_t MaxSize_;
+
+    bool JournalEnabled_;
+    std::string Journal_;   // journal lines not written to disk yet
+    size_t JournalLines_;   // journal lines written since the last snapshot
+};
+
+#endif
@@ -11,6 +11,8 @@
  */
 
 #include <cstdlib>
+#include <fstream>
+#include <time.h>
 #include "SrvAddrMgr.h"
 #include "AddrClient.h"
 #include "AddrIA.h"
@@ -25,10 +27,31 @@ using namespace std;
 TSrvAddrMgr * TSrvAddrMgr::Instance = 0;
 
 TSrvAddrMgr::TSrvAddrMgr(const std::string& xmlfile, bool loadDB)
-    :TAddrMgr(xmlfile, loadDB) {
+    :TAddrMgr(xmlfile, loadDB), DirtySince_(0),
+     CommitRetry_(0) {
 
-    this->CacheMaxSize = 999999999;
+    // cache is trimmed to the configured size in setCacheSize()
+    Cache_.setMaxSize(999999999);
+    Cache_.setJournal(false);
     this->cacheRead();
+    int changes = Cache_.replay(SRVCACHE_JOURNAL_FILE);
+    if (changes) {
+        Log(Debug) << "Cache: " << changes << " change(s) replayed from "
+                   << SRVCACHE_JOURNAL_FILE << ", " << Cache_.count()
+                   << " entries cached." << LogEnd;
+    }
+    Cache_.setJournal(true);
+
+    // changes committed after the last snapshot
+    string journal = journalName(xmlfile);
+    if (loadDB) {
+        int records = Journal_.replay(journal, &TSrvAddrMgr::journalHandler, this);
+        if (records) {
+            Log(Info) << records << " change(s) replayed from lease journal " << journal
+                      << "." << LogEnd;
+        }
+    }
+    Journal_.open(journal, !loadDB);
 }
 
 TSrvAddrMgr::~TSrvAddrMgr() {
@@ -69,12 +92,7 @@ bool TSrvAddrMgr::addClntAddr(SPtr<TDUID> clntDuid , SPtr<TIPv6Addr> clntAddr,
     }
 
     // find this client
-    SPtr <TAddrClient> ptrClient;
-    this->firstClient();
-    while ( ptrClient = this->getClient() ) {
-        if ( (*ptrClient->getDUID()) == (*clntDuid) )
-            break;
-    }
+    SPtr <TAddrClient> ptrClient = getClient(clntDuid);
 
     // have we found this client?
     if (!ptrClient) {
@@ -103,7 +121,7 @@ bool TSrvAddrMgr::addClntAddr(SPtr<TDUID> clntDuid , SPtr<TIPv6Addr> clntAddr,
     SPtr <TAddrAddr> ptrAddr;
     ptrIA->firstAddr();
     while ( ptrAddr = ptrIA->getAddr() ) {
-        if (*ptrAddr->get()==*addr)
+        if (ptrAddr->getValue() == addr->getValue())
             break;
     }
 
@@ -117,6 +135,7 @@ bool TSrvAddrMgr::addClntAddr(SPtr<TDUID> clntDuid , SPtr<TIPv6Addr> clntAddr,
     // add address
     ptrAddr = new TAddrAddr(addr, pref, valid);
     ptrIA->addAddr(ptrAddr);
+    leaseChanged(clntDuid);
     if (!quiet)
         Log(Debug) << "Adding " << ptrAddr->get()->getPlain()
                    << " to IA (IAID=" << IAID << ") to addrDB." << LogEnd;
@@ -136,12 +155,7 @@ bool TSrvAddrMgr::delClntAddr(SPtr<TDUID> clntDuid, unsigned long IAID,
 {
 
     // find this client
-    SPtr <TAddrClient> ptrClient;
-    this->firstClient();
-    while ( ptrClient = this->getClient() ) {
-        if ( (*ptrClient->getDUID()) == (*clntDuid) )
-            break;
-    }
+    SPtr <TAddrClient> ptrClient = getClient(clntDuid);
     if (!ptrClient) { // have we found this client?
         Log(Warning) << "Client (DUID=" << clntDuid->getPlain()
                      << ") not found in addrDB, cannot delete address and/or client." << LogEnd;
@@ -165,7 +179,7 @@ bool TSrvAddrMgr::delClntAddr(SPtr<TDUID> clntDuid, unsigned long IAID,
     SPtr <TAddrAddr> ptrAddr;
     ptrIA->firstAddr();
     while ( ptrAddr = ptrIA->getAddr() ) {
-        if (*ptrAddr->get()==*clntAddr)
+        if (ptrAddr->getValue() == clntAddr->getValue())
             break;
     }
     if (!ptrAddr) {
@@ -174,6 +188,7 @@ bool TSrvAddrMgr::delClntAddr(SPtr<TDUID> clntDuid, unsigned long IAID,
     }
 
     ptrIA->delAddr(clntAddr);
+    leaseChanged(clntDuid);
     this->addCachedEntry(clntDuid, clntAddr, IATYPE_IA);
     if (!quiet)
         Log(Debug) << "Deleted address " << *clntAddr << " from addrDB." << LogEnd;
@@ -220,12 +235,7 @@ bool TSrvAddrMgr::addTAAddr(SPtr<TDUID> clntDuid , SPtr<TIPv6Addr> clntAddr,
     }
 
     // find this client
-    SPtr <TAddrClient> ptrClient;
-    this->firstClient();
-    while ( ptrClient = this->getClient() ) {
-        if ( (*ptrClient->getDUID()) == (*clntDuid) )
-            break;
-    }
+    SPtr <TAddrClient> ptrClient = getClient(clntDuid);
 
     // have we found this client?
     if (!ptrClient) {
@@ -253,7 +263,7 @@ bool TSrvAddrMgr::addTAAddr(SPtr<TDUID> clntDuid , SPtr<TIPv6Addr> clntAddr,
     SPtr <TAddrAddr> ptrAddr;
     ta->firstAddr();
     while ( ptrAddr = ta->getAddr() ) {
-        if (*ptrAddr->get()==*addr)
+        if (ptrAddr->getValue() == addr->getValue())
             break;
     }
 
@@ -267,6 +277,7 @@ bool TSrvAddrMgr::addTAAddr(SPtr<TDUID> clntDuid , SPtr<TIPv6Addr> clntAddr,
     // add address
     ptrAddr = new TAddrAddr(addr, pref, valid);
     ta->addAddr(ptrAddr);
+    leaseChanged(clntDuid);
     Log(Debug) << "Adding " << ptrAddr->get()->getPlain() << " to TA (IAID=" << iaid
                << ") to addrDB." << LogEnd;
     return true;
@@ -285,12 +296,7 @@ bool TSrvAddrMgr::addTAAddr(SPtr<TDUID> clntDuid , SPtr<TIPv6Addr> clntAddr,
 bool TSrvAddrMgr::delTAAddr(SPtr<TDUID> clntDuid, unsigned long iaid,
                             SPtr<TIPv6Addr> clntAddr, bool quiet) {
     // find this client
-    SPtr <TAddrClient> ptrClient;
-    this->firstClient();
-    while ( ptrClient = this->getClient() ) {
-        if ( (*ptrClient->getDUID()) == (*clntDuid) )
-            break;
-    }
+    SPtr <TAddrClient> ptrClient = getClient(clntDuid);
 
     // have we found this client?
     if (!ptrClient) {
@@ -317,7 +323,7 @@ bool TSrvAddrMgr::delTAAddr(SPtr<TDUID> clntDuid, unsigned long iaid,
     SPtr <TAddrAddr> ptrAddr;
     ta->firstAddr();
     while ( ptrAddr = ta->getAddr() ) {
-        if (*ptrAddr->get()==*clntAddr)
+        if (ptrAddr->getValue() == clntAddr->getValue())
             break;
     }
 
@@ -328,6 +334,7 @@ bool TSrvAddrMgr::delTAAddr(SPtr<TDUID> clntDuid, unsigned long iaid,
     }
 
     ta->delAddr(clntAddr);
+    leaseChanged(clntDuid);
     if (!quiet)
         Log(Debug) << "Deleted temp. address " << *clntAddr << " from addrDB." << LogEnd;
 
@@ -347,14 +354,43 @@ bool TSrvAddrMgr::delTAAddr(SPtr<TDUID> clntDuid, unsigned long iaid,
     return true;
 }
 
+bool TSrvAddrMgr::addPrefix(SPtr<TDUID> clntDuid, SPtr<TIPv6Addr> clntAddr,
+                            const std::string& ifname, int ifindex, unsigned long IAID,
+                            unsigned long T1, unsigned long T2, SPtr<TIPv6Addr> prefix,
+                            unsigned long pref, unsigned long valid, int length, bool quiet)
+{
+    if (!TAddrMgr::addPrefix(clntDuid, clntAddr, ifname, ifindex, IAID, T1, T2,
+                             prefix, pref, valid, length, quiet))
+        return false;
+    leaseChanged(clntDuid);
+    return true;
+}
+
 bool TSrvAddrMgr::delPrefix(SPtr<TDUID> clntDuid, unsigned long IAID, SPtr<TIPv6Addr> prefix, bool quiet)
 {
     bool result = TAddrMgr::delPrefix(clntDuid, IAID, prefix, quiet);
-    if (result)
+    if (result) {
+        leaseChanged(clntDuid);
         addCachedEntry(clntDuid, prefix, IATYPE_PD);
+    }
     return result;
 }
 
+/// @brief adds client to the database
+///
+/// @param x client to be added
+void TSrvAddrMgr::addClient(SPtr<TAddrClient> x)
+{
+    TAddrMgr::addClient(x);
+    leaseChanged(x->getDUID());
+}
+
+bool TSrvAddrMgr::delClient(SPtr<TDUID> duid)
+{
+    leaseChanged(duid);
+    return TAddrMgr::delClient(duid);
+}
+
 /// @brief returns how many leases does this client have?
 ///
 /// @param duid client's DUID
@@ -645,20 +681,15 @@ bool TSrvAddrMgr::verifyPrefix(SPtr<TIPv6Addr> prefix) {
  * @return cached address or prefix. 0 if cached address is not found.
  */
 SPtr<TIPv6Addr> TSrvAddrMgr::getCachedEntry(SPtr<TDUID> clntDuid, TIAType type) {
-    if (!this->CacheMaxSize)
+    if (!Cache_.getMaxSize())
         return SPtr<TIPv6Addr>();
-    SPtr<TSrvCacheEntry> entry;
-    this->Cache.first();
-
-    while (entry = this->Cache.get()) {
-            if (!entry->Duid)
-                continue; // something is wrong. VERY wrong. But shut up and continue.
-            if ((entry->type==type) && (*entry->Duid == *clntDuid) ) {
-                Log(Debug) << "Cache: Cached " << (type==IATYPE_IA?"address":"prefix")
-                           << " for client (DUID=" << clntDuid->getPlain() << ") found: "
-                           << entry->Addr->getPlain() << LogEnd;
-                return entry->Addr;
-            }
+
+    SPtr<TIPv6Addr> cached = Cache_.get(clntDuid, type);
+    if (cached) {
+        Log(Debug) << "Cache: Cached " << (type==IATYPE_IA?"address":"prefix")
+                   << " for client (DUID=" << clntDuid->getPlain() << ") found: "
+                   << cached->getPlain() << LogEnd;
+        return cached;
     }
 
     Log(Debug) << "Cache: There are no cached " << (type==IATYPE_IA?"address":"prefix")
@@ -675,21 +706,13 @@ SPtr<TIPv6Addr> TSrvAddrMgr::getCachedEntry(SPtr<TDUID> clntDuid, TIAType type)
  * @return
  */
 bool TSrvAddrMgr::delCachedEntry(SPtr<TIPv6Addr> addr, TIAType type) {
-    if (!this->CacheMaxSize)
+    if (!Cache_.getMaxSize())
             return false;
 
-    this->Cache.first();
-    SPtr<TSrvCacheEntry> entry;
-    while (entry = this->Cache.get()) {
-            if (!entry->Addr)
-                continue; // something is wrong. VERY wrong. But shut up and continue.
-            if ( (entry->type==type) && (*(entry->Addr) == *addr) ) {
-                this->Cache.del();
-                this->Cache.first();
-                Log(Debug) << "Cache: " << (type==IATYPE_IA?"Address ":"Prefix ")
-                           << *addr << " was deleted." << LogEnd;
-                return true;
-            }
+    if (Cache_.del(addr, type)) {
+        Log(Debug) << "Cache: " << (type==IATYPE_IA?"Address ":"Prefix ")
+                   << *addr << " was deleted." << LogEnd;
+        return true;
     }
     Log(Debug) << "Cache: Attempt to delete " << *addr << " failed." << LogEnd;
     return false;
@@ -704,23 +727,14 @@ bool TSrvAddrMgr::delCachedEntry(SPtr<TIPv6Addr> addr, TIAType type) {
  * @return
  */
 bool TSrvAddrMgr::delCachedEntry(SPtr<TDUID> clntDuid, TIAType type) {
-    if (!this->CacheMaxSize)
+    if (!Cache_.getMaxSize())
         return false;
 
-    this->Cache.first();
-    SPtr<TSrvCacheEntry> entry;
-    while (entry = this->Cache.get()) {
-        if (!entry->Duid)
-            continue; // something is wrong. VERY wrong. But shut up and continue.
-        if ( (entry->type==type) && (*(entry->Duid) == *clntDuid) ) {
-            this->Cache.del();
-            this->Cache.first();
-            Log(Debug) << "Cache: Entry for client (DUID=" << clntDuid->getPlain() << ") was deleted." << LogEnd;
-            return true;
-        }
+    if (Cache_.del(clntDuid, type)) {
+        Log(Debug) << "Cache: Entry for client (DUID=" << clntDuid->getPlain() << ") was deleted." << LogEnd;
+        return true;
     }
     // delete attempt is done on multiple occasions as a safety precausion, so don't warn if it is missing
-    // Log(Debug) << "Cache: Attempt to delete entry for client (DUID=" << clntDuid->getPlain() << ") failed." << LogEnd;
     return false;
 }
 
@@ -734,7 +748,7 @@ bool TSrvAddrMgr::delCachedEntry(SPtr<TDUID> clntDuid, TIAType type) {
 void TSrvAddrMgr::addCachedEntry(SPtr<TDUID> clntDuid, SPtr<TIPv6Addr> cachedAddr, TIAType type) {
 
     // if cache is disabled (size set to 0)
-    if (!this->CacheMaxSize)
+    if (!Cache_.getMaxSize())
         return;
 
     // if this address is reserved, don't add it to cache)
@@ -745,55 +759,211 @@ void TSrvAddrMgr::addCachedEntry(SPtr<TDUID> clntDuid, SPtr<TIPv6Addr> cachedAdd
     if ( (type == IATYPE_PD) && (SrvCfgMgr().prefixReserved(cachedAddr)))
         return;
 
-    SPtr<TSrvCacheEntry> entry;
-
-    // is there an entry for this client, delete it. New entry will be added at the end
-    this->delCachedEntry(clntDuid, type);
-
-    entry = new TSrvCacheEntry();
-    entry->type = type;
-    entry->Duid = clntDuid;
-    entry->Addr = cachedAddr;
+    // existing entry for this client is replaced, oldest entry is dropped if cache is full
+    Cache_.add(clntDuid, cachedAddr, type);
     Log(Debug) << "Cache: " << (type==IATYPE_IA?"Address ":"Prefix ") << cachedAddr->getPlain()
                << " added for client (DUID=" << clntDuid->getPlain() << "). " << LogEnd;
-    this->Cache.append(entry);
-    this->checkCacheSize();
 }
 
 void TSrvAddrMgr::setCacheSize(int bytes) {
-    int entrySize = sizeof(TSrvCacheEntry) + sizeof(TIPv6Addr) + sizeof(TDUID);
-    this->CacheMaxSize = bytes/entrySize;
+    int entrySize = TSrvAddrCache::entrySize(SERVER_CACHE_DUID_LEN);
+    Cache_.setMaxSize(bytes/entrySize);
     Log(Debug) << "Cache: size set to " << bytes << " bytes, 1 cache entry size is " << entrySize
-                   << " bytes, so maximum " << this->CacheMaxSize << " address-client pair(s) may be cached." << LogEnd;
-    this->checkCacheSize();
+               << " bytes, so maximum " << Cache_.getMaxSize() << " address-client pair(s) may be cached." << LogEnd;
 }
 
-/**
- * this function checks if the cache size was not exceeded. If that is so, oldest entries are removed
- *
- */
-void TSrvAddrMgr::checkCacheSize() {
-    if (this->Cache.count() <= this->CacheMaxSize)
+void TSrvAddrMgr::print(std::ostream & out) {
+    out << "  <cache size=\"" << Cache_.count() << "\"/>" << endl;
+}
+
+/// @brief writes snapshot of the whole database
+///
+/// Snapshots are written in binary format only (see AddrMgrBinary.h), XML
+/// is written on explicit export (see exportXml()). Pending changes are
+/// included in the snapshot, so the lease journal is truncated once the
+/// snapshot is on disk. Used during startup and shutdown and when the
+/// journal grows too large (see commit()).
+void TSrvAddrMgr::dump() {
+
+    if (dbStoreBinary(binaryDbName(XmlFile).c_str())) {
+        // pending changes and journal records are in the snapshot
+        Dirty_.clear();
+        Journal_.reset();
+    } else {
+        journalDirty();
+    }
+
+    cacheCommit();
+}
+
+/// @brief writes the whole database in XML format
+///
+/// XML is not used by the server itself. It is loaded during startup only
+/// if it is newer than the binary database, e.g. when it was exported and
+/// edited by hand.
+///
+/// @param xmlFile name of the file to be written
+///
+/// @return true if the file was written
+bool TSrvAddrMgr::exportXml(const std::string& xmlFile) {
+    std::ofstream xmlDump(xmlFile.c_str(), std::ios::trunc);
+    xmlDump << *this;
+    xmlDump.close();
+    if (xmlDump.fail()) {
+        Log(Error) << "Unable to export address database to " << xmlFile << "." << LogEnd;
+        return false;
+    }
+    Log(Notice) << "Address database (" << countClient() << " client(s)) exported to "
+                << xmlFile << "." << LogEnd;
+    return true;
+}
+
+/// @brief returns name of the lease journal that accompanies XML file
+///
+/// server-AddrMgr.xml is accompanied by server-AddrMgr.journal.
+std::string TSrvAddrMgr::journalName(const std::string& xmlFile) {
+    string name = xmlFile;
+    size_t pos = name.rfind(".xml");
+    if (pos != string::npos && pos == name.size() - 4)
+        name = name.substr(0, pos);
+    return name + ".journal";
+}
+
+/// @brief marks client as changed, its leases will be written by commit()
+///
+/// @param duid client's DUID
+void TSrvAddrMgr::leaseChanged(SPtr<TDUID> duid) {
+    if (!duid)
         return;
+    if (Dirty_.empty())
+        DirtySince_ = (unsigned long)time(NULL);
+    Dirty_[string(duid->get(), duid->getLen())] = duid;
+}
 
-    // there are too many cached elements, delete some
-    while (this->Cache.count() > this->CacheMaxSize) {
-        this->Cache.delFirst();
+/// returns true if there are changes that are not committed yet
+bool TSrvAddrMgr::commitPending() const {
+    return !Dirty_.empty();
+}
+
+/// @brief checks if changes should be committed now
+///
+/// In the default mode, every change is committed as soon as possible. In
+/// performance mode changes are collected until SERVER_LEASE_COMMIT_BATCH
+/// clients are changed or SERVER_LEASE_COMMIT_DELAY seconds elapse. Failed
+/// commit is retried after SERVER_LEASE_COMMIT_RETRY seconds.
+///
+/// @param now current time
+///
+/// @return true if commit() should be called
+bool TSrvAddrMgr::commitDue(unsigned long now) const {
+    if (Dirty_.empty() || now < CommitRetry_)
+        return false;
+    if (!SrvCfgMgr().getPerformanceMode())
+        return true;
+    return Dirty_.size() >= SERVER_LEASE_COMMIT_BATCH
+        || now >= DirtySince_ + SERVER_LEASE_COMMIT_DELAY;
+}
+
+/// @brief returns time (in seconds) until pending changes are due
+///
+/// @param now current time
+unsigned long TSrvAddrMgr::getCommitTimeout(unsigned long now) const {
+    if (Dirty_.empty())
+        return DHCPV6_INFINITY;
+    if (now < CommitRetry_)
+        return CommitRetry_ - now;
+    if (commitDue(now))
+        return 0;
+    return DirtySince_ + SERVER_LEASE_COMMIT_DELAY - now;
+}
+
+/// @brief writes changed clients to the lease journal (group commit)
+///
+/// Current state of every client changed since the last commit is appended
+/// to the journal, all of them with a single disk flush. When the journal
+/// becomes larger than the database (or the journal can't be used), a new
+/// snapshot is written instead (see dump()). If changes can't be written,
+/// clients stay marked as changed and the commit is retried later.
+///
+/// @return true if changes are on disk
+bool TSrvAddrMgr::commit() {
+    if (Dirty_.empty())
+        return true;
+
+    if (!Journal_.isOpen() ||
+        Journal_.getSize() + Dirty_.size() > (size_t)countClient() + SERVER_LEASE_JOURNAL_SLACK) {
+        dump();
+    } else {
+        journalDirty();
+        cacheCommit();
     }
+
+    if (Dirty_.empty()) {
+        CommitRetry_ = 0;
+        return true;
+    }
+
+    CommitRetry_ = (unsigned long)time(NULL) + SERVER_LEASE_COMMIT_RETRY;
+    Log(Error) << "Unable to commit changes of " << Dirty_.size() << " client(s), next attempt in "
+               << SERVER_LEASE_COMMIT_RETRY << " second(s)." << LogEnd;
+    return false;
 }
 
-void TSrvAddrMgr::print(std::ostream & out) {
-    out << "  <cache size=\"" << this->Cache.count() << "\"/>" << endl;
+/// @brief appends current state of changed clients to the lease journal
+///
+/// Clients stay marked as changed, unless their records are on disk.
+///
+/// @return true if records were written and flushed to disk
+bool TSrvAddrMgr::journalDirty() {
+    for (map<string, SPtr<TDUID> >::const_iterator it = Dirty_.begin(); it != Dirty_.end();
+         ++it) {
+        vector<char> data;
+        SPtr<TAddrClient> client = getClient(it->second);
+        if (client) {
+            List(TAddrClient) clients;
+            clients.append(client);
+            dbSerializeBinary(clients, data);
+            Journal_.add(TSrvLeaseJournal::JOURNAL_CLIENT, it->second, data);
+        } else {
+            Journal_.add(TSrvLeaseJournal::JOURNAL_DELETE, it->second, data);
+        }
+    }
+    if (!Journal_.commit())
+        return false;
+    Dirty_.clear();
+    return true;
 }
 
-void TSrvAddrMgr::dump() {
+/// @brief applies a record read from the lease journal
+void TSrvAddrMgr::journalHandler(char type, SPtr<TDUID> duid, const char* data, size_t len,
+                                 void* arg) {
+    TSrvAddrMgr* self = static_cast<TSrvAddrMgr*>(arg);
+
+    // lease table is not populated yet
+    self->TAddrMgr::delClient(duid);
+    if (type != TSrvLeaseJournal::JOURNAL_CLIENT)
+        return;
 
-    // Do not write anything to disk if there is performance mode enabled
-    if (SrvCfgMgr().getPerformanceMode())
+    List(TAddrClient) loaded;
+    if (!self->dbParseBinary(journalName(self->XmlFile).c_str(), data, len, loaded))
         return;
+    SPtr<TAddrClient> client;
+    loaded.first();
+    while (client = loaded.get())
+        self->TAddrMgr::addClient(client);
+}
 
-    TAddrMgr::dump(); // perform normal dump of the AddrMgr
-    cacheDump();
+/// @brief writes address cache changes
+///
+/// Cache changes are appended to the cache journal. Full cache snapshot is
+/// written only when the journal becomes larger than the cache itself.
+void TSrvAddrMgr::cacheCommit() {
+    if (Cache_.getJournalSize() > Cache_.count() + SERVER_CACHE_JOURNAL_SLACK) {
+        cacheDump();
+        Cache_.resetJournal(SRVCACHE_JOURNAL_FILE);
+    } else {
+        Cache_.flush(SRVCACHE_JOURNAL_FILE);
+    }
 }
 
 /**
@@ -807,10 +977,9 @@ void TSrvAddrMgr::cacheDump() {
         Log(Error) << "Cache: File " << SRVCACHE_FILE << " creation failed." << LogEnd;
         return;
     }
-    f << "<cache size=\"" << this->Cache.count() << "\">" << endl;
-    SPtr<TSrvCacheEntry> x;
-    this->Cache.first();
-    while (x=this->Cache.get()) {
+    f << "<cache size=\"" << Cache_.count() << "\">" << endl;
+    const TSrvAddrCache::TEntryLst& entries = Cache_.getEntries();
+    for (TSrvAddrCache::TEntryLst::const_iterator x = entries.begin(); x != entries.end(); ++x) {
         f << "  <entry type=\"";
         switch (x->type) {
         case IATYPE_IA:
@@ -824,12 +993,8 @@ void TSrvAddrMgr::cacheDump() {
             continue;
         }
 
-        f << "\" duid=\"";
-        if (x->Duid)
-            f << x->Duid->getPlain();
-        f << "\">";
-        if (x->Addr)
-            f << x->Addr->getPlain();
+        f << "\" duid=\"" << x->duid->getPlain() << "\">";
+        f << x->addr->getPlain();
         f << "</entry>" << endl;
     }
     f << "</cache>" << endl;
@@ -842,7 +1007,7 @@ void TSrvAddrMgr::cacheDump() {
  */
 void TSrvAddrMgr::cacheRead() {
 
-    this->Cache.clear();
+    Cache_.clear();
     bool started = false;
     bool ended = false;
     bool parsed = false;
@@ -928,9 +1093,9 @@ void TSrvAddrMgr::cacheRead() {
     }
     f.close();
 
-    if (this->Cache.count() != entries) {
+    if (Cache_.count() != entries) {
         Log(Debug) << "Cache: " << SRVCACHE_FILE << " file: " << entries << " entries expected, but "
-                   << this->Cache.count() << " found." << LogEnd;
+                   << Cache_.count() << " found." << LogEnd;
     }
     if (!parsed) {
         Log(Info) << "Did not find any useful information in " << SRVCACHE_FILE << LogEnd;
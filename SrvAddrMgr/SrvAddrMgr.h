@@ -12,10 +12,14 @@
 #ifndef SRVADDRMGR_H
 #define SRVADDRMGR_H
 
+#include <map>
+#include <string>
 #include <vector>
 #include "AddrMgr.h"
 #include "SrvCfgAddrClass.h"
 #include "SrvCfgPD.h"
+#include "SrvAddrCache.h"
+#include "SrvLeaseJournal.h"
 
 #define SrvAddrMgr() (TSrvAddrMgr::instance())
 
@@ -25,14 +29,6 @@ class TSrvAddrMgr : public TAddrMgr
     static void instanceCreate(const std::string& xmlFile, bool loadDB);
     static TSrvAddrMgr & instance();
 
-    class TSrvCacheEntry
-    {
-    public:
-        TIAType type; // address or prefix
-        SPtr<TIPv6Addr> Addr;  // cached address, previously assigned to a client
-        SPtr<TDUID>     Duid;  // client's duid
-    };
-
     struct TExpiredInfo
     {
         SPtr<TAddrClient> client;
@@ -43,6 +39,10 @@ class TSrvAddrMgr : public TAddrMgr
 
     ~TSrvAddrMgr();
 
+    // client container (changes are journaled)
+    void addClient(SPtr<TAddrClient> x);
+    bool delClient(SPtr<TDUID> duid);
+
     // IA address management
     bool addClntAddr(SPtr<TDUID> clntDuid, SPtr<TIPv6Addr> clntAddr,
                      int iface, unsigned long IAID, unsigned long T1, unsigned long T2,
@@ -59,6 +59,11 @@ class TSrvAddrMgr : public TAddrMgr
     bool delTAAddr(SPtr<TDUID> duid,unsigned long iaid, SPtr<TIPv6Addr> addr, bool quiet);
 
     // prefix management
+    virtual bool addPrefix(SPtr<TDUID> clntDuid, SPtr<TIPv6Addr> clntAddr,
+                           const std::string& ifname,
+                           int ifindex, unsigned long IAID, unsigned long T1, unsigned long T2,
+                           SPtr<TIPv6Addr> prefix, unsigned long pref, unsigned long valid,
+                           int length, bool quiet);
     virtual bool delPrefix(SPtr<TDUID> clntDuid, unsigned long IAID, SPtr<TIPv6Addr> prefix, bool quiet);
     virtual bool verifyPrefix(SPtr<TIPv6Addr> addr);
 
@@ -84,7 +89,16 @@ class TSrvAddrMgr : public TAddrMgr
     void addCachedEntry(SPtr<TDUID> clntDuid, SPtr<TIPv6Addr> cachedEntry, TIAType type);
 
     void setCacheSize(int bytes);
+
+    // persistence: snapshots and lease journal with group commit
+    static std::string journalName(const std::string& xmlFile);
     void dump();
+    bool exportXml(const std::string& xmlFile);
+    void leaseChanged(SPtr<TDUID> duid);
+    bool commitPending() const;
+    bool commitDue(unsigned long now) const;
+    unsigned long getCommitTimeout(unsigned long now) const;
+    bool commit();
 
  protected:
     void print(std::ostream & out);
@@ -94,9 +108,17 @@ class TSrvAddrMgr : public TAddrMgr
 
     void cacheRead();
     void cacheDump();
-    void checkCacheSize();
-    List(TSrvCacheEntry) Cache; // list of cached addresses
-    size_t CacheMaxSize; // maximum number of cached elements
+    void cacheCommit();
+    bool journalDirty();
+    static void journalHandler(char type, SPtr<TDUID> duid, const char* data, size_t len,
+                               void* arg);
+    TSrvAddrCache Cache_; // addresses and prefixes previously assigned to clients
+
+
+    TSrvLeaseJournal Journal_;
+    std::map<std::string, SPtr<TDUID> > Dirty_; // clients changed since the last commit
+    unsigned long DirtySince_;                  // time of the oldest uncommitted change
+    unsigned long CommitRetry_;                 // failed commit is not retried before
 };
 
 #endif
@@ -0,0 +1,194 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <fcntl.h>
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef WIN32
+#include <io.h>
+#endif
+#include "SrvLeaseJournal.h"
+#include "Portable.h"
+#include "Logger.h"
+
+using namespace std;
+
+const char TSrvLeaseJournal::JOURNAL_CLIENT;
+const char TSrvLeaseJournal::JOURNAL_DELETE;
+
+TSrvLeaseJournal::TSrvLeaseJournal()
+    :FD_(-1), PendingCnt_(0), Size_(0) {
+}
+
+TSrvLeaseJournal::~TSrvLeaseJournal() {
+    close();
+}
+
+/// @brief reads journal file and calls handler for every record
+///
+/// Truncated record at the end of the file (e.g. interrupted write) is
+/// ignored.
+///
+/// @param file journal file
+/// @param handler called for every record
+/// @param arg passed to the handler
+///
+/// @return number of replayed records
+int TSrvLeaseJournal::replay(const std::string& file, THandler handler, void* arg) {
+    ifstream f(file.c_str(), ios::in | ios::binary);
+    if (!f.is_open())
+        return 0;
+
+    int cnt = 0;
+    vector<char> rec;
+    char hdr[4];
+    while (f.read(hdr, sizeof(hdr))) {
+        size_t len = readUint32(hdr);
+        if (len < 3) {
+            Log(Warning) << "Journal " << file << ": record " << cnt + 1
+                         << " is corrupted, remaining records ignored." << LogEnd;
+            break;
+        }
+        rec.resize(len);
+        if (!f.read(&rec[0], len)) {
+            Log(Warning) << "Journal " << file << ": last record is truncated, ignored." << LogEnd;
+            break;
+        }
+        size_t duidLen = readUint16(&rec[1]);
+        if (3 + duidLen > len || !duidLen) {
+            Log(Warning) << "Journal " << file << ": record " << cnt + 1
+                         << " is corrupted, remaining records ignored." << LogEnd;
+            break;
+        }
+        SPtr<TDUID> duid = new TDUID(&rec[3], duidLen);
+        size_t off = 3 + duidLen;
+        handler(rec[0], duid, len > off ? &rec[off] : 0, len - off, arg);
+        cnt++;
+    }
+    Size_ = cnt;
+    return cnt;
+}
+
+/// @brief opens journal file for appending
+///
+/// @param file journal file
+/// @param truncate removes existing records
+///
+/// @return true if successful
+bool TSrvLeaseJournal::open(const std::string& file, bool truncate) {
+    close();
+    File_ = file;
+    int flags = O_WRONLY | O_CREAT | O_APPEND;
+    if (truncate) {
+        flags |= O_TRUNC;
+        Size_ = 0;
+    }
+#ifdef WIN32
+    flags |= O_BINARY;
+#endif
+    FD_ = ::open(file.c_str(), flags, 0640);
+    if (FD_ < 0) {
+        Log(Error) << "Unable to open lease journal " << file << "." << LogEnd;
+        return false;
+    }
+    return true;
+}
+
+void TSrvLeaseJournal::close() {
+    if (FD_ >= 0)
+        ::close(FD_);
+    FD_ = -1;
+}
+
+/// @brief adds a record (written by the next commit())
+///
+/// @param type JOURNAL_CLIENT or JOURNAL_DELETE
+/// @param duid client's DUID
+/// @param data client data (binary database with a single client)
+void TSrvLeaseJournal::add(char type, SPtr<TDUID> duid, const std::vector<char>& data) {
+    size_t duidLen = duid->getLen();
+    char hdr[7];
+    writeUint32(hdr, 3 + duidLen + data.size());
+    hdr[4] = type;
+    writeUint16(hdr + 5, duidLen);
+
+    Pending_.insert(Pending_.end(), hdr, hdr + sizeof(hdr));
+    Pending_.insert(Pending_.end(), duid->get(), duid->get() + duidLen);
+    Pending_.insert(Pending_.end(), data.begin(), data.end());
+    PendingCnt_++;
+}
+
+/// returns number of records that are not written yet
+size_t TSrvLeaseJournal::pending() const {
+    return PendingCnt_;
+}
+
+/// returns true if the journal file is open for appending
+bool TSrvLeaseJournal::isOpen() const {
+    return FD_ >= 0;
+}
+
+/// @brief writes pending records and flushes them to disk
+///
+/// Pending records are discarded even if they were not written, the caller
+/// is expected to add them again before the next attempt.
+///
+/// @return true if records are on disk (or there was nothing to write)
+bool TSrvLeaseJournal::commit() {
+    if (!PendingCnt_)
+        return true;
+    if (FD_ < 0) {
+        Pending_.clear();
+        PendingCnt_ = 0;
+        return false;
+    }
+
+    size_t off = 0;
+    while (off < Pending_.size()) {
+        int written = ::write(FD_, &Pending_[off], Pending_.size() - off);
+        if (written <= 0) {
+            Log(Error) << "Failed to write lease journal " << File_ << "." << LogEnd;
+            Pending_.clear();
+            PendingCnt_ = 0;
+            return false;
+        }
+        off += written;
+    }
+#ifdef WIN32
+    int status = _commit(FD_);
+#else
+    int status = fsync(FD_);
+#endif
+    Size_ += PendingCnt_;
+    Pending_.clear();
+    PendingCnt_ = 0;
+    if (status) {
+        Log(Error) << "Failed to flush lease journal " << File_ << " to disk." << LogEnd;
+        return false;
+    }
+    return true;
+}
+
+/// returns number of records written since the journal was reset
+size_t TSrvLeaseJournal::getSize() const {
+    return Size_;
+}
+
+/// @brief removes all records (called after a database snapshot was written)
+///
+/// @return true if successful
+bool TSrvLeaseJournal::reset() {
+    Pending_.clear();
+    PendingCnt_ = 0;
+    Size_ = 0;
+    if (File_.empty())
+        return true;
+    return open(File_, true);
+}
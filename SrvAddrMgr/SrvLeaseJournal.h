@@ -0,0 +1,67 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVLEASEJOURNAL_H
+#define SRVLEASEJOURNAL_H
+
+#include <string>
+#include <vector>
+#include "SmartPtr.h"
+#include "DUID.h"
+
+/// @brief Append-only journal of lease database changes.
+///
+/// Each record describes the current state of a single client: either
+/// its whole lease set (in the binary database format, see
+/// AddrMgrBinary.h) or its removal. Records are collected in memory by
+/// add() and written by commit() with a single write and a single fsync,
+/// so many changes share the cost of one disk flush (group commit).
+///
+/// The journal is replayed on top of the last database snapshot during
+/// startup and truncated every time a new snapshot is written.
+///
+/// Record layout (integers in network byte order):
+/// - uint32: length of the rest of the record
+/// - uint8: record type (JOURNAL_CLIENT or JOURNAL_DELETE)
+/// - uint16: DUID length, followed by the DUID
+/// - client data (JOURNAL_CLIENT only)
+class TSrvLeaseJournal
+{
+  public:
+    static const char JOURNAL_CLIENT = 'C';
+    static const char JOURNAL_DELETE = 'D';
+
+    /// called for every replayed record
+    typedef void (*THandler)(char type, SPtr<TDUID> duid, const char* data, size_t len,
+                             void* arg);
+
+    TSrvLeaseJournal();
+    ~TSrvLeaseJournal();
+
+    int replay(const std::string& file, THandler handler, void* arg);
+    bool open(const std::string& file, bool truncate);
+    void close();
+
+    void add(char type, SPtr<TDUID> duid, const std::vector<char>& data);
+    size_t pending() const;
+    bool isOpen() const;
+    bool commit();
+
+    size_t getSize() const;
+    bool reset();
+
+  private:
+    std::string File_;
+    int FD_;
+    std::vector<char> Pending_; // records not written yet
+    size_t PendingCnt_;
+    size_t Size_;               // records written since the last reset
+};
+
+#endif
@@ -33,7 +33,6 @@ TSrvCfgAddrClass::TSrvCfgAddrClass() {
     ValidMin_ = SERVER_DEFAULT_MIN_VALID;
     ValidMax_ = SERVER_DEFAULT_MAX_VALID;
     ID_ = StaticID_++; // client-class ID
-    AddrsAssigned_ = 0;
     AddrsCount_ = 0;
     Share_ = 100;
     ClassMaxLease_ = SERVER_DEFAULT_CLASSMAXLEASE;
@@ -196,7 +195,8 @@ void TSrvCfgAddrClass::setOptions(SPtr<TSrvParsGlobalOpt> opt)
 
     // set up address counter counts
     AddrsCount_ = Pool_->rangeCount();
-    AddrsAssigned_ = 0;
+    AddrsAssigned_.setTotal(AddrsCount_);
+    AddrsAssigned_.set(0);
 
     if (ClassMaxLease_ > AddrsCount_)
         ClassMaxLease_ = AddrsCount_;
@@ -240,17 +240,27 @@ unsigned long TSrvCfgAddrClass::getShare() {
 }
 
 long TSrvCfgAddrClass::incrAssigned(int count) {
-    AddrsAssigned_ += count;
-    return AddrsAssigned_;
+    return AddrsAssigned_.incr(count);
 }
 
 long TSrvCfgAddrClass::decrAssigned(int count) {
-    AddrsAssigned_ -= count;
-    return AddrsAssigned_;
+    return AddrsAssigned_.decr(count);
+}
+
+/// sets number of assigned addresses (used when leases are recounted)
+void TSrvCfgAddrClass::setAssigned(unsigned long count) {
+    AddrsAssigned_.set(count);
 }
 
 unsigned long TSrvCfgAddrClass::getAssignedCount() {
-    return AddrsAssigned_;
+    return AddrsAssigned_.get();
+}
+
+/// @brief returns class usage statistics
+///
+/// @param now current time (used to compute allocation rate)
+TSrvPoolCounter::TSnapshot TSrvCfgAddrClass::getStats(unsigned long now) {
+    return AddrsAssigned_.snapshot(now);
 }
 
 bool TSrvCfgAddrClass::isLinkLocal() {
@@ -293,7 +303,7 @@ ostream& operator<<(ostream& out,TSrvCfgAddrClass& addrClass)
 {
     out << "    <class id=\"" << addrClass.ID_ << "\" share=\"" << addrClass.Share_ << "\">" << std::endl;
     out << "      <!-- total addrs in class: " << addrClass.AddrsCount_
-        << ", addrs assigned: " << addrClass.AddrsAssigned_ << " -->" << endl;
+        << ", addrs assigned: " << addrClass.AddrsAssigned_.get() << " -->" << endl;
     out << "      <T1 min=\"" << addrClass.T1Min_ << "\" max=\"" << addrClass.T1Max_  << "\" />" << endl;
     out << "      <T2 min=\"" << addrClass.T2Min_ << "\" max=\"" << addrClass.T2Max_  << "\" />" << endl;
     out << "      <pref min=\"" << addrClass.PrefMin_ << "\" max=\""<< addrClass.PrefMax_  << "\" />" <<endl;
@@ -27,6 +27,7 @@ class TSrvCfgAddrClass;
 #include "SmartPtr.h"
 #include "SrvOptAddrParams.h"
 #include "SrvCfgClientClass.h"
+#include "SrvPoolCounter.h"
 
 class TSrvCfgAddrClass
 {
@@ -61,6 +62,8 @@ class TSrvCfgAddrClass
     unsigned long getAssignedCount();
     long incrAssigned(int count=1);
     long decrAssigned(int count=1);
+    void setAssigned(unsigned long count);
+    TSrvPoolCounter::TSnapshot getStats(unsigned long now);
 
     void setOptions(SPtr<TSrvParsGlobalOpt> opt);
     SPtr<TSrvOptAddrParams> getAddrParams();
@@ -83,7 +86,7 @@ class TSrvCfgAddrClass
 
     SPtr<THostRange> Pool_;
     unsigned long ClassMaxLease_;
-    unsigned long AddrsAssigned_;
+    TSrvPoolCounter AddrsAssigned_;
     unsigned long AddrsCount_;
 
     SPtr<TSrvOptAddrParams> AddrParams_; // AddrParams - experimental option
@@ -70,12 +70,21 @@ SPtr<TSrvCfgOptions> TSrvCfgIface::getClientException(SPtr<TDUID> duid,
             return x;
         }
     }
-    return SPtr<TSrvCfgOptions>();
+
+    x = HostDB_.find(duid, remoteID, peer);
+    if (x && !quiet)
+        Log(Debug) << "Found host reservation for client in " << HostDB_.getFile() << LogEnd;
+    return x;
+}
+
+/// returns database with reservations kept outside of config file
+TSrvHostDB& TSrvCfgIface::getHostDB() {
+    return HostDB_;
 }
 
 /// @brief Checks if address is reserved.
 ///
-/// Iterates over exceptions list and checks if specified address is reserved.
+/// Checks exceptions list and host reservations database.
 ///
 /// @param addr Address in question.
 ///
@@ -88,7 +97,7 @@ bool TSrvCfgIface::addrReserved(SPtr<TIPv6Addr> addr)
         if ( (x->getAddr()) && (*x->getAddr() == *addr) )
             return true;
     }
-    return false;
+    return HostDB_.findAddr(addr);
 }
 
 /// @brief removes reserved addresses/prefixes from cache
@@ -104,12 +113,19 @@ unsigned int TSrvCfgIface::removeReservedFromCache() {
         if (x->getPrefix())
             cnt += SrvAddrMgr().delCachedEntry(x->getPrefix(), IATYPE_PD);
     }
+    for (uint32_t i = 0; i < HostDB_.count(); i++) {
+        x = HostDB_.get(i);
+        if (x->getAddr())
+            cnt += SrvAddrMgr().delCachedEntry(x->getAddr(), IATYPE_IA);
+        if (x->getPrefix())
+            cnt += SrvAddrMgr().delCachedEntry(x->getPrefix(), IATYPE_PD);
+    }
     return cnt;
 }
 
 /// @brief Checks if prefix is reserved.
 ///
-/// Iterates over exceptions list and checks if specified prefix is reserved.
+/// Checks exceptions list and host reservations database.
 ///
 /// @param prefix prefix in question.
 ///
@@ -122,7 +138,7 @@ bool TSrvCfgIface::prefixReserved(SPtr<TIPv6Addr> prefix)
         if (x->getPrefix() && (*x->getPrefix() == *prefix) )
             return true;
     }
-    return false;
+    return HostDB_.findPrefix(prefix);
 }
 
 /// @brief Checks if a prefix is reserved for another client.
@@ -151,58 +167,61 @@ bool TSrvCfgIface::checkReservedPrefix(SPtr<TIPv6Addr> pfx, SPtr<TDUID> duid,
         if (!x->getPrefix()) // that is not prefix reservation
             continue;
 
-        if ( *(x->getPrefix()) != (*pfx) )
-            continue; // that is not the prefix we are looking for
+        if ( *(x->getPrefix()) == (*pfx) )
+            break; // that is the prefix we are looking for
+    }
+    if (!x)
+        x = HostDB_.findPrefix(pfx);
+    if (!x)
+        return false;
 
-        // we found the prefix we are looking for. Let's check if we can use it
+    // we found the prefix we are looking for. Let's check if we can use it
 
-        // DUID based reservation?
-        if (x->getDuid()) {
-            if (*duid == *x->getDuid()) {
-                return false; // reserved for us!
-            } else {
-                Log(Debug) << "Prefix " << x->getPrefix()->getPlain() << " is reserved for DUID="
-                           << x->getDuid()->getPlain() << LogEnd;
-                return true;
-            }
+    // DUID based reservation?
+    if (x->getDuid()) {
+        if (*duid == *x->getDuid()) {
+            return false; // reserved for us!
+        } else {
+            Log(Debug) << "Prefix " << x->getPrefix()->getPlain() << " is reserved for DUID="
+                       << x->getDuid()->getPlain() << LogEnd;
+            return true;
         }
+    }
 
-        // remote-id based reservation?
-        SPtr<TOptVendorData> remoteid = x->getRemoteID();
-        if (remoteid) {
-            if ( (myRemoteID->getVendor() == remoteid->getVendor()) &&
-                 (myRemoteID->getVendorDataLen() == remoteid->getVendorDataLen()) &&
-                 (!memcmp(myRemoteID->getVendorData(), remoteid->getVendorData(), remoteid->getVendorDataLen())) ) {
-                return false; // reserved for us!
-            } else {
-                Log(Debug) << "Prefix " << x->getPrefix()->getPlain() << "is reserved for remote-id="
-                           << remoteid->getPlain() << LogEnd;
-                return true; // no, sorry. It's somebody else's prefix
-            }
+    // remote-id based reservation?
+    SPtr<TOptVendorData> remoteid = x->getRemoteID();
+    if (remoteid) {
+        if ( myRemoteID && (myRemoteID->getVendor() == remoteid->getVendor()) &&
+             (myRemoteID->getVendorDataLen() == remoteid->getVendorDataLen()) &&
+             (!memcmp(myRemoteID->getVendorData(), remoteid->getVendorData(), remoteid->getVendorDataLen())) ) {
+            return false; // reserved for us!
+        } else {
+            Log(Debug) << "Prefix " << x->getPrefix()->getPlain() << "is reserved for remote-id="
+                       << remoteid->getPlain() << LogEnd;
+            return true; // no, sorry. It's somebody else's prefix
         }
+    }
 
 
-        // link-local based reservation
-        SPtr<TIPv6Addr> addr = x->getClntAddr();
-        if (addr) {
-            if (*linkLocal == *addr) {
-                return false; // reserved for us!
-            } else {
-                Log(Debug) << "Prefix " << x->getPrefix()->getPlain()
-                           << " is reserved for link-local address "
-                           << addr->getPlain() << LogEnd;
-                return true;
-            }
+    // link-local based reservation
+    SPtr<TIPv6Addr> addr = x->getClntAddr();
+    if (addr) {
+        if (linkLocal && *linkLocal == *addr) {
+            return false; // reserved for us!
+        } else {
+            Log(Debug) << "Prefix " << x->getPrefix()->getPlain()
+                       << " is reserved for link-local address "
+                       << addr->getPlain() << LogEnd;
+            return true;
         }
+    }
 
-        Log(Error) << "Found reservation for prefix " << x->getPrefix()->getPlain()
-                   << ", but it is misconfigured (no DUID, remote-id nor link-local specified)"
-                   << LogEnd;
+    Log(Error) << "Found reservation for prefix " << x->getPrefix()->getPlain()
+               << ", but it is misconfigured (no DUID, remote-id nor link-local specified)"
+               << LogEnd;
 
-        // this reservation is malformed let's not use it
-        return true;
-    }
-  return false;
+    // this reservation is malformed let's not use it
+    return true;
 }
 
 void TSrvCfgIface::firstAddrClass() {
@@ -330,6 +349,22 @@ SPtr<TSrvCfgAddrClass> TSrvCfgIface::getClassByID(unsigned long id) {
     return SPtr<TSrvCfgAddrClass>(); // NULL
 }
 
+/// @brief returns the first class whose pool contains specified address
+///        (the class that addClntAddr() and delClntAddr() update)
+///
+/// @param addr leased address
+///
+/// @return address class (or NULL if address is not in any pool)
+SPtr<TSrvCfgAddrClass> TSrvCfgIface::getClassByAddr(SPtr<TIPv6Addr> addr) {
+    firstAddrClass();
+    SPtr<TSrvCfgAddrClass> ptrClass;
+    while (ptrClass = getAddrClass()) {
+        if (ptrClass->addrInPool(addr))
+            return ptrClass;
+    }
+    return SPtr<TSrvCfgAddrClass>(); // NULL
+}
+
 void TSrvCfgIface::addClntAddr(SPtr<TIPv6Addr> ptrAddr, bool quiet /* =false*/) {
     SPtr<TSrvCfgAddrClass> ptrClass;
     firstAddrClass();
@@ -411,12 +446,29 @@ SPtr<TSrvCfgPD> TSrvCfgIface::getPDByID(unsigned long id) {
     return SPtr<TSrvCfgPD>(); // NULL
 }
 
+/// @brief returns the first PD class whose pool contains specified prefix
+///        (the class that addClntPrefix() and delClntPrefix() update)
+///
+/// @param prefix leased prefix
+///
+/// @return PD class (or NULL if prefix is not in any pool)
+SPtr<TSrvCfgPD> TSrvCfgIface::getPDByPrefix(SPtr<TIPv6Addr> prefix) {
+    firstPD();
+    SPtr<TSrvCfgPD> ptrPD;
+    while (ptrPD = getPD()) {
+        if (ptrPD->prefixInPool(prefix))
+            return ptrPD;
+    }
+    return SPtr<TSrvCfgPD>(); // NULL
+}
+
 bool TSrvCfgIface::addClntPrefix(SPtr<TIPv6Addr> ptrAddr, bool quiet /* =false */) {
     SPtr<TSrvCfgPD> ptrPD;
     firstPD();
     while (ptrPD = getPD() ) {
         if (ptrPD->prefixInPool(ptrAddr)) {
             unsigned long count = ptrPD->incrAssigned();
+            ptrPD->markUsed(ptrAddr);
             if (quiet)
                 return true;
             Log(Debug) << "PD: Prefix usage for class " << ptrPD->getID()
@@ -435,6 +487,7 @@ bool TSrvCfgIface::delClntPrefix(SPtr<TIPv6Addr> ptrAddr, bool quiet /* =false *
     while (ptrPD = getPD() ) {
         if (ptrPD->prefixInPool(ptrAddr)) {
             unsigned long count = ptrPD->decrAssigned();
+            ptrPD->markFree(ptrAddr);
             if (quiet)
                 return true;
             Log(Debug) << "PD: Prefix usage for class " << ptrPD->getID()
@@ -626,12 +679,17 @@ void TSrvCfgIface::setRelayID(int id) {
 
 // --- option: FQDN ---
 void TSrvCfgIface::setFQDNLst(List(TFQDN) *fqdn) {
-    FQDNLst_ = *fqdn;
+    FQDNs_.clear();
+    SPtr<TFQDN> f;
+    fqdn->first();
+    while (f = fqdn->get())
+        FQDNs_.add(f, false);
 }
 
 /**
  * this method tries to find a name for a client. It check client's hint, and possible reservations
- * by duid or by address
+ * by duid or by address (see TSrvFQDNRegistry::find()). Names accepted from
+ * (or generated for) clients are registered as dynamic.
  *
  * @param duid
  * @param addr
@@ -642,51 +700,9 @@ void TSrvCfgIface::setFQDNLst(List(TFQDN) *fqdn) {
 SPtr<TFQDN> TSrvCfgIface::getFQDNName(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr,
                                       const std::string& hint) {
 
-    SPtr<TFQDN> alternative; // best FQDN found for that client
-    SPtr<TFQDN> foo;
-
-    FQDNLst_.first();
-    while ( foo = FQDNLst_.get()) {
-
-        if (foo->isUsed()) {
-            // client sent a hint, but it is used currently
-            if ( (foo->getDuid()) && (*foo->getDuid() == *duid) &&
-                 (foo->getAddr()) && (*foo->getAddr() == *addr)) {
-                Log(Debug) << "FQDN: This client (DUID=" << duid->getPlain()
-                           << ") has already assigned name " << foo->getName()
-                           <<" to its address " << foo->getAddr()->getPlain() << "." << LogEnd;
-                return foo;
-            }
-
-            if ( (foo->getName() == hint) && (*foo->getDuid() == *duid) ) {
-                Log(Debug) << "FQDN: Client requested " << hint << ", it is already assinged to this client. Reusing." << LogEnd;
-                return foo;
-            }
-            continue;
-        }
-
-        if (duid && (foo->getDuid()) && *(foo->getDuid())== *duid) {
-            Log(Debug) << "FQDN found: " << foo->getName() << " using duid " << duid->getPlain() << LogEnd;
-            return foo;
-        }
-        if (addr && (foo->getAddr()) && *(foo->getAddr())==*addr) {
-            Log(Debug) << "FQDN found: " << foo->getName() << " using address " << addr->getPlain() << LogEnd;
-            return foo;
-        }
-
-        if (foo->getName() == hint){
-            // client asked for this name. Let's check if client is allowed to get this name.
-            if ( (!foo->getDuid()) && (!foo->getAddr()) ) {
-                Log(Debug) << "Client's hint: " << hint << " found in fqdn list, setting fqdn to "
-                           << foo->getName() << LogEnd;
-                return foo;
-            }
-        }
-        if (!foo->getAddr() && !foo->getDuid()) {
-            if (!alternative)
-                alternative = foo;
-        }
-    }
+    SPtr<TFQDN> fqdn = FQDNs_.find(duid, addr, hint);
+    if (fqdn)
+        return fqdn;
 
     switch (UnknownFQDN_)
     {
@@ -705,6 +721,7 @@ SPtr<TFQDN> TSrvCfgIface::getFQDNName(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr,
     }
     case UNKKOWN_FQDN_ACCEPT_POOL:
     {
+        SPtr<TFQDN> alternative = FQDNs_.getFree();
         if (alternative)
             Log(Info) << "FQDN: Client requested " << hint << ", but assigning other name ("
                       << alternative->getName() << ") from available pool instead." << LogEnd;
@@ -714,8 +731,8 @@ SPtr<TFQDN> TSrvCfgIface::getFQDNName(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr,
     {
         Log(Info) << "FQDN: Accepting unknown (" << hint <<") FQDN requested by client." <<LogEnd;
         SPtr<TFQDN> newEntry = new TFQDN(duid, hint, false);
-        FQDNLst_.append(newEntry);
-        // Log(Debug) << "Retured FQDN  " << newEntry->getName() <<LogEnd;
+        if (!FQDNs_.add(newEntry, true))
+            return SPtr<TFQDN>(); // NULL
         return newEntry;
     }
     case UNKNOWN_FQDN_APPEND:
@@ -734,7 +751,8 @@ SPtr<TFQDN> TSrvCfgIface::getFQDNName(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr,
 
         assignedDomain += "." + FQDNDomain_;
         SPtr<TFQDN> newEntry = new TFQDN(duid, assignedDomain, false);
-        FQDNLst_.append(newEntry);
+        if (!FQDNs_.add(newEntry, true))
+            return SPtr<TFQDN>(); // NULL
         Log(Info) << "FQDN: Client requested " << hint <<", assigning " << assignedDomain
                   << "." <<LogEnd;
         return newEntry;
@@ -749,7 +767,8 @@ SPtr<TFQDN> TSrvCfgIface::getFQDNName(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr,
             tmp.replace(j, 1, "-");
         tmp = tmp + "." + FQDNDomain_;
         SPtr<TFQDN> newEntry = new TFQDN(duid, tmp, false);
-        FQDNLst_.append(newEntry);
+        if (!FQDNs_.add(newEntry, true))
+            return SPtr<TFQDN>(); // NULL
         Log(Info) << "FQDN: Client requested " << hint <<", assigning " << tmp << "." <<LogEnd;
         return newEntry;
     }
@@ -760,18 +779,20 @@ SPtr<TFQDN> TSrvCfgIface::getFQDNName(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr,
     return SPtr<TFQDN>(); // NULL
 }
 
+/// returns DUID the name is reserved for (or assigned to), NULL if there is none
 SPtr<TDUID> TSrvCfgIface::getFQDNDuid(const std::string& name) {
-    /// @todo: Implement this!
-    SPtr<TDUID> res = new TDUID();
-    return res;
+    SPtr<TFQDN> fqdn = FQDNs_.getByName(name);
+    if (!fqdn)
+        return SPtr<TDUID>(); // NULL
+    return fqdn->getDuid();
 }
 
-List(TFQDN) *TSrvCfgIface::getFQDNLst() {
-    return &FQDNLst_;
+TSrvFQDNRegistry& TSrvCfgIface::getFQDNRegistry() {
+    return FQDNs_;
 }
 
 bool TSrvCfgIface::supportFQDN() const {
-    return FQDNLst_.count() || (UnknownFQDN_ >= UNKNOWN_FQDN_ACCEPT);
+    return FQDNs_.count() || (UnknownFQDN_ >= UNKNOWN_FQDN_ACCEPT);
 }
 
 int TSrvCfgIface::getFQDNMode() const{
@@ -825,6 +846,10 @@ void TSrvCfgIface::addSubnet(SPtr<TIPv6Addr> min, SPtr<TIPv6Addr> max) {
 }
 
 bool TSrvCfgIface::addrInSubnet(SPtr<TIPv6Addr> addr) {
+    return addrInSubnet(addr->getValue());
+}
+
+bool TSrvCfgIface::addrInSubnet(const TIPv6AddrValue& addr) {
     for (std::vector<THostRange>::const_iterator range = Subnets_.begin();
          range != Subnets_.end(); ++range) {
         if (range->in(addr)) {
@@ -962,16 +987,15 @@ ostream& operator<<(ostream& out,TSrvCfgIface& iface) {
 
     // option: FQDN
     if (iface.supportFQDN()) {
-      SPtr<TFQDN> f;
-      List(TFQDN) * lst = iface.getFQDNLst();
-      out << "    <fqdnOptions count=\"" << lst->count() << "\" prefix=\""
+      vector<SPtr<TFQDN> > names;
+      iface.FQDNs_.getAll(names);
+      out << "    <fqdnOptions count=\"" << names.size() << "\" prefix=\""
           << iface.getRevDNSZoneRootLength() << "\""
           << " domain=\"" << iface.FQDNDomain_ << "\""
           << " unknownFqdnMode=\"" << iface.UnknownFQDN_ << "\""
           << ">" << endl;
-      lst->first();
-      while ((f = lst->get())) {
-            out << "       " << *f;
+      for (size_t i = 0; i < names.size(); i++) {
+            out << "       " << *names[i];
       }
       out << "    </fqdnOptions>" << endl;
     } else {
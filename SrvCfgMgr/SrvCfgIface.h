@@ -23,6 +23,8 @@ class TSrvCfgIface;
 #include <vector>
 #include "OptVendorSpecInfo.h"
 #include "SrvCfgOptions.h"
+#include "SrvFQDNRegistry.h"
+#include "SrvHostDB.h"
 
 class TSrvCfgIface: public TSrvCfgOptions
 {
@@ -46,6 +48,7 @@ public:
 
     SPtr<TSrvCfgAddrClass> getAddrClass();
     SPtr<TSrvCfgAddrClass> getClassByID(unsigned long id);
+    SPtr<TSrvCfgAddrClass> getClassByAddr(SPtr<TIPv6Addr> addr);
     SPtr<TSrvCfgAddrClass> getRandomClass(SPtr<TDUID> clntDuid, SPtr<TIPv6Addr> clntAddr);
     long countAddrClass() const;
 
@@ -58,6 +61,7 @@ public:
     // prefix management (IA_PD)
     void addPDClass(SPtr<TSrvCfgPD> PDClass);
     SPtr<TSrvCfgPD> getPDByID(unsigned long id);
+    SPtr<TSrvCfgPD> getPDByPrefix(SPtr<TIPv6Addr> prefix);
     //SPtr<TSrvCfgPD> getRandomPrefix(SPtr<TDUID> clntDuid, SPtr<TIPv6Addr> clntAddr);
     long countPD() const;
     void addPD(SPtr<TSrvCfgPD> pd);
@@ -76,6 +80,7 @@ public:
     // subnet management
     void addSubnet(SPtr<TIPv6Addr> min, SPtr<TIPv6Addr> max);
     bool addrInSubnet(SPtr<TIPv6Addr> addr);
+    bool addrInSubnet(const TIPv6AddrValue& addr);
     bool subnetDefined();
 
     // other
@@ -116,9 +121,10 @@ public:
                              SPtr<TIPv6Addr> linkLocal);
     bool addrReserved(SPtr<TIPv6Addr> addr);
     bool prefixReserved(SPtr<TIPv6Addr> prefix);
+    TSrvHostDB& getHostDB();
 
     // option: FQDN
-    List(TFQDN) * getFQDNLst();
+    TSrvFQDNRegistry& getFQDNRegistry();
     SPtr<TFQDN> getFQDNName(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr, const std::string& hint);
     SPtr<TDUID> getFQDNDuid(const std::string& name);
     void setFQDNLst(List(TFQDN) * fqdn);
@@ -167,7 +173,7 @@ private:
     SPtr<TSrvOptInterfaceID> RelayInterfaceID_; // value of interface-id option (optional)
 
     // --- option: FQDN ---
-    List(TFQDN) FQDNLst_;
+    TSrvFQDNRegistry FQDNs_;
     int FQDNMode_;
     int RevDNSZoneRootLength_;
     EUnknownFQDNMode UnknownFQDN_;
@@ -175,6 +181,7 @@ private:
 
     // --- per-client parameters (exceptions) ---
     List(TSrvCfgOptions) ExceptionsLst_;
+    TSrvHostDB HostDB_; // reservations kept outside of config file
     uint32_t T1Min_;
     uint32_t T1Max_;
     uint32_t T2Min_;
@@ -17,6 +17,7 @@
 #include <sstream>
 #include <fstream>
 #include <string>
+#include <map>
 #include "SmartPtr.h"
 #include "Portable.h"
 #include "FlexLexer.h"
@@ -37,7 +38,9 @@ TSrvCfgMgr * TSrvCfgMgr::Instance = 0;
 int TSrvCfgMgr::NextRelayID = RELAY_MIN_IFINDEX;
 
 TSrvCfgMgr::TSrvCfgMgr(const std::string& cfgFile, const std::string& xmlFile)
-    :TCfgMgr(), XmlFile(xmlFile), Reconfigure_(false), PerformanceMode_(false),
+    :TCfgMgr(), XmlFile(xmlFile), Reconfigure_(false),
+     ReconfigureRate_(SERVER_RECONFIGURE_RATE), SocketShards_(SERVER_SOCKET_SHARDS),
+     PerformanceMode_(false),
      DropUnicast_(false)
 {
     setDefaults();
@@ -121,6 +124,8 @@ bool TSrvCfgMgr::parseConfigFile(const std::string& cfgFile) {
         return false;
     }
 
+    openHostDBs();
+
     if (this->stateless()) {
         Log(Notice) << "Running in stateless mode." << LogEnd;
     } else {
@@ -679,6 +684,9 @@ bool TSrvCfgMgr::validateIface(SPtr<TSrvCfgIface> ptrIface)
         return false;
     }
 
+    // static options are encoded once, so replies can just copy them
+    ptrIface->encodeOptions();
+
     SPtr<TSrvCfgAddrClass> ptrClass;
     ptrIface->firstAddrClass();
     while(ptrClass=ptrIface->getAddrClass()) {
@@ -962,6 +970,22 @@ bool TSrvCfgMgr::getReconfigureSupport()
     return Reconfigure_;
 }
 
+void TSrvCfgMgr::setReconfigureRate(unsigned int rate) {
+    ReconfigureRate_ = rate;
+}
+
+unsigned int TSrvCfgMgr::getReconfigureRate() {
+    return ReconfigureRate_;
+}
+
+void TSrvCfgMgr::setSocketShards(unsigned int shards) {
+    SocketShards_ = shards ? shards : 1;
+}
+
+unsigned int TSrvCfgMgr::getSocketShards() {
+    return SocketShards_;
+}
+
 /// @brief removes reserved entries from the cache
 void TSrvCfgMgr::removeReservedFromCache() {
     SPtr<TSrvCfgIface> iface;
@@ -975,13 +999,57 @@ void TSrvCfgMgr::removeReservedFromCache() {
     }
 }
 
+/// @brief returns name of the host reservations database of an interface
+///
+/// The database is optional. It is kept in working directory, e.g.
+/// server-hosts-eth0.bin for eth0.
+///
+/// @param ifaceName name of the interface
+///
+/// @return name of the database
+std::string TSrvCfgMgr::hostDBName(const std::string& ifaceName) {
+    return string(SRVHOSTDB_FILE) + "-" + ifaceName + ".bin";
+}
+
+/// @brief opens host reservations databases of all interfaces
+void TSrvCfgMgr::openHostDBs() {
+    SPtr<TSrvCfgIface> iface;
+    SrvCfgIfaceLst.first();
+    while (iface = SrvCfgIfaceLst.get())
+        iface->getHostDB().open(hostDBName(iface->getName()));
+    InactiveLst.first();
+    while (iface = InactiveLst.get())
+        iface->getHostDB().open(hostDBName(iface->getName()));
+}
+
+/// @brief reloads host reservations databases that were replaced
+///
+/// Newly reserved addresses and prefixes are removed from the cache.
+///
+/// @param now current time
+void TSrvCfgMgr::updateHostDBs(unsigned long now) {
+    SPtr<TSrvCfgIface> iface;
+    SrvCfgIfaceLst.first();
+    while (iface = SrvCfgIfaceLst.get()) {
+        if (iface->getHostDB().update(now))
+            iface->removeReservedFromCache();
+    }
+}
+
 /**
  * sets pool usage counters (used during bringup, after AddrDB is loaded from file)
  *
+ * Each lease is credited to one class only: the first class (or PD class)
+ * on the lease's interface whose pool contains it, which is the class that
+ * addClntAddr()/delClntAddr() update at runtime. Counters are set rather
+ * than incremented, so calling this again does not count the leases twice.
  */
 void TSrvCfgMgr::setCounters()
 {
-    int iaCnt = 0, pdCnt = 0;
+    std::map<TSrvCfgAddrClass*, unsigned long> addrCounts;
+    std::map<TSrvCfgPD*, unsigned long> pdCounts;
+    unsigned long iaCnt = 0, pdCnt = 0;
+
     SrvAddrMgr().firstClient();
     SPtr<TAddrClient> client;
     SPtr<TSrvCfgIface> iface;
@@ -998,7 +1066,10 @@ void TSrvCfgMgr::setCounters()
             SPtr<TAddrAddr> addr;
             ia->firstAddr();
             while ( addr=ia->getAddr() ) {
-                iface->addClntAddr(addr->get(), true/*quiet*/);
+                SPtr<TSrvCfgAddrClass> addrClass = iface->getClassByAddr(addr->get());
+                if (!addrClass)
+                    continue;
+                addrCounts[&(*addrClass)]++;
                 iaCnt++;
             }
         }
@@ -1012,14 +1083,74 @@ void TSrvCfgMgr::setCounters()
             SPtr<TAddrPrefix> prefix;
             ia->firstPrefix();
             while ( prefix=ia->getPrefix() ) {
-                iface->addClntPrefix(prefix->get(), true);
+                SPtr<TSrvCfgPD> pd = iface->getPDByPrefix(prefix->get());
+                if (!pd)
+                    continue;
+                pd->markUsed(prefix->get());
+                pdCounts[&(*pd)]++;
                 pdCnt++;
             }
         }
     }
+
+    SrvCfgIfaceLst.first();
+    while (iface = SrvCfgIfaceLst.get()) {
+        SPtr<TSrvCfgAddrClass> addrClass;
+        iface->firstAddrClass();
+        while (addrClass = iface->getAddrClass())
+            addrClass->setAssigned(addrCounts[&(*addrClass)]);
+
+        SPtr<TSrvCfgPD> pd;
+        iface->firstPD();
+        while (pd = iface->getPD())
+            pd->setAssigned(pdCounts[&(*pd)]);
+    }
     Log(Debug) << "Increased pools usage: currently " << iaCnt << " address(es) and " << pdCnt << " prefix(es) are leased." << LogEnd;
 }
 
+/// @brief returns usage of all pools (address classes, temporary address
+///        classes and prefix pools)
+///
+/// @param stats pool statistics will be appended here
+void TSrvCfgMgr::getPoolStats(std::vector<TPoolStats>& stats)
+{
+    unsigned long now = (unsigned long)time(NULL);
+    SPtr<TSrvCfgIface> iface;
+    SrvCfgIfaceLst.first();
+    while (iface = SrvCfgIfaceLst.get()) {
+        TPoolStats pool;
+        pool.iface = iface->getName();
+        pool.ifindex = iface->getID();
+
+        SPtr<TSrvCfgAddrClass> addrClass;
+        iface->firstAddrClass();
+        while (addrClass = iface->getAddrClass()) {
+            pool.type = IATYPE_IA;
+            pool.id = addrClass->getID();
+            pool.usage = addrClass->getStats(now);
+            stats.push_back(pool);
+        }
+
+        SPtr<TSrvCfgTA> ta;
+        iface->firstTA();
+        while (ta = iface->getTA()) {
+            pool.type = IATYPE_TA;
+            pool.id = ta->getID();
+            pool.usage = ta->getStats(now);
+            stats.push_back(pool);
+        }
+
+        SPtr<TSrvCfgPD> pd;
+        iface->firstPD();
+        while (pd = iface->getPD()) {
+            pool.type = IATYPE_PD;
+            pool.id = pd->getID();
+            pool.usage = pd->getStats(now);
+            stats.push_back(pool);
+        }
+    }
+}
+
 
 void TSrvCfgMgr::instanceCreate(const std::string& cfgFile, const std::string& xmlDumpFile )
 {
@@ -1125,6 +1256,24 @@ int TSrvCfgMgr::getRelayByInterfaceID(SPtr<TSrvOptInterfaceID> interfaceID) {
     return -1;
 }
 
+/// @brief returns ifindex of an interface with specified interface-id
+///
+/// @param data content of the interface-id option (as received)
+/// @param len length of the content
+///
+/// @return interface index (or -1 if not found)
+int TSrvCfgMgr::getRelayByInterfaceID(const char* data, int len) {
+    firstIface();
+    while (SPtr<TSrvCfgIface> cfgIface = getIface()) {
+        SPtr<TSrvOptInterfaceID> cfgIfaceID = cfgIface->getRelayInterfaceID();
+        if (cfgIfaceID && cfgIfaceID->isEqual(data, len)) {
+            return cfgIface->getID();
+        }
+    }
+
+    return -1;
+}
+
 
 /// @brief returns ifindex of an interface with matched address
 ///
@@ -1132,13 +1281,25 @@ int TSrvCfgMgr::getRelayByInterfaceID(SPtr<TSrvOptInterfaceID> interfaceID) {
 ///
 /// @return interface index (or -1 if not found)
 int TSrvCfgMgr::getRelayByLinkAddr(SPtr<TIPv6Addr> addr) {
+    return getRelayByLinkAddr(addr->getAddr());
+}
+
+/// @brief returns ifindex of an interface with matched address
+///
+/// @param linkAddr address to be matched (16 bytes, as received)
+///
+/// @return interface index (or -1 if not found)
+int TSrvCfgMgr::getRelayByLinkAddr(const char* linkAddr) {
+    TIPv6AddrValue addr(linkAddr);
     SPtr<TSrvCfgIface> cfgIface;
 
     firstIface();
     while (cfgIface = getIface()) {
         if (cfgIface->addrInSubnet(addr)) {
-            Log(Debug) << "Address " << addr->getPlain() << " matched on interface "
-                       << cfgIface->getFullName() << LogEnd;
+            if (logger::enabled(logger::LEVEL_DEBUG)) {
+                Log(Debug) << "Address " << addr.getPlain() << " matched on interface "
+                           << cfgIface->getFullName() << LogEnd;
+            }
             return cfgIface->getID();
         }
     }
@@ -14,6 +14,7 @@ class TSrvCfgMgr;
 
 #ifndef SRVCONFMGR_H
 #define SRVCONFMGR_H
+#include <vector>
 #include "SmartPtr.h"
 #include "SrvCfgIface.h"
 #include "SrvIfaceMgr.h"
@@ -23,6 +24,7 @@ class TSrvCfgMgr;
 #include "DUID.h"
 #include "KeyList.h"
 #include "SrvCfgClientClass.h"
+#include "SrvPoolCounter.h"
 
 #define SrvCfgMgr() (TSrvCfgMgr::instance())
 
@@ -53,11 +55,26 @@ public:
 
     bool setupRelay(SPtr<TSrvCfgIface> cfgIface);
 
+    /// usage of a single pool (see getPoolStats())
+    struct TPoolStats {
+        std::string iface;
+        int ifindex;
+        TIAType type;       ///< IATYPE_IA (address class), IATYPE_TA or IATYPE_PD
+        unsigned long id;   ///< class or prefix pool ID
+        TSrvPoolCounter::TSnapshot usage;
+    };
+
     //Address assignment connected methods
     void setCounters();
+    void getPoolStats(std::vector<TPoolStats>& stats);
 
     void removeReservedFromCache();
 
+    // host reservations kept outside of config file
+    static std::string hostDBName(const std::string& ifaceName);
+    void openHostDBs();
+    void updateHostDBs(unsigned long now);
+
     long countAvailAddrs(SPtr<TDUID> clntDuid, SPtr<TIPv6Addr> clntAddr, int iface);
     SPtr<TSrvCfgAddrClass> getClassByAddr(int iface, SPtr<TIPv6Addr> addr);
     SPtr<TSrvCfgPD> getClassByPrefix(int iface, SPtr<TIPv6Addr> prefix);
@@ -101,6 +118,22 @@ public:
     /// @param reconf tells whether reconfigure should be supported
     void setReconfigureSupport(bool reconf);
 
+    /// returns maximum number of RECONFIGUREs sent per second (0 - unlimited)
+    unsigned int getReconfigureRate();
+
+    /// sets maximum number of RECONFIGUREs sent per second
+    ///
+    /// @param rate RECONFIGUREs per second (0 - unlimited)
+    void setReconfigureRate(unsigned int rate);
+
+    /// returns number of sockets bound to every unicast and link-local address
+    unsigned int getSocketShards();
+
+    /// sets number of sockets bound to every unicast and link-local address
+    ///
+    /// @param shards number of sockets (received packets are spread among them)
+    void setSocketShards(unsigned int shards);
+
     void setDDNSAddress(SPtr<TIPv6Addr> ddnsAddress);
     SPtr<TIPv6Addr> getDDNSAddress(int iface);
 
@@ -128,7 +161,9 @@ public:
 
     // Used to find specific relay
     int getRelayByInterfaceID(SPtr<TSrvOptInterfaceID> interfaceID);
+    int getRelayByInterfaceID(const char* data, int len);
     int getRelayByLinkAddr(SPtr<TIPv6Addr> addr);
+    int getRelayByLinkAddr(const char* linkAddr);
     int getAnyRelay();
 
 
@@ -149,6 +184,12 @@ protected:
     /// specifies whether the server should support reconfigure or not
     bool Reconfigure_;
 
+    /// RECONFIGUREs sent per second
+    unsigned int ReconfigureRate_;
+
+    /// sockets bound to every unicast and link-local address
+    unsigned int SocketShards_;
+
     bool IsDone;
     bool validateConfig();
     bool validateIface(SPtr<TSrvCfgIface> ptrIface);
@@ -54,6 +54,10 @@ void TSrvCfgOptions::SetDefaults() {
 
     ExtraOpts_.clear();
     ForcedOpts_.clear();
+
+    EncodedValid_ = false;
+    EncodedExtraOpts_.clear();
+    EncodedForcedOpts_.clear();
 }
 
 // --------------------------------------------------------------------
@@ -119,6 +123,8 @@ void TSrvCfgOptions::addExtraOption(SPtr<TOpt> custom, bool always) {
 
     if (always)
         ForcedOpts_.push_back(custom); // also add to forced, if requested so
+
+    EncodedValid_ = false;
 }
 
 const TOptList& TSrvCfgOptions::getExtraOptions() {
@@ -156,6 +162,7 @@ bool TSrvCfgOptions::setOptions(SPtr<TSrvParsGlobalOpt> opt) {
 void TSrvCfgOptions::addExtraOptions(const TOptList& extra) {
     for (TOptList::const_iterator opt = extra.begin(); opt != extra.end(); ++opt)
         ExtraOpts_.push_back(*opt);
+    EncodedValid_ = false;
 }
 
 /// @brief Copies a list of forced options.
@@ -167,6 +174,72 @@ void TSrvCfgOptions::addExtraOptions(const TOptList& extra) {
 void TSrvCfgOptions::addForcedOptions(const TOptList& forced) {
     for (TOptList::const_iterator opt = forced.begin(); opt != forced.end(); ++opt)
         ForcedOpts_.push_back(*opt);
+    EncodedValid_ = false;
+}
+
+/// @brief Converts an option into its pre-encoded form.
+///
+/// Returned option carries the on-wire representation of the original option
+/// (including all its suboptions), so getSize() and storeSelf() are a simple
+/// copy, regardless of how complex the original option is.
+///
+/// @param opt option to be encoded
+///
+/// @return pre-encoded option
+TOptPtr TSrvCfgOptions::encodeOption(TOptPtr opt) {
+    size_t len = opt->getSize();
+    std::vector<char> buf(len);
+    opt->storeSelf(&buf[0]);
+    return TOptPtr(new TOptGeneric(opt->getOptType(), &buf[0] + TOpt::OPTION6_HDR_LEN,
+                                   len - TOpt::OPTION6_HDR_LEN, NULL));
+}
+
+/// @brief Encodes all extra and forced options.
+///
+/// Extra and forced options are static, i.e. they are the same for every
+/// client that is handled by this interface (or exception). They are encoded
+/// once and the encoded forms are then appended to responses, without any
+/// per-response encoding. Extra options are indexed by their type, so
+/// appending requested options depends only on the client's ORO, not on the
+/// number of configured options.
+///
+/// This is called after the configuration is loaded. If the options are
+/// modified later, they will be encoded again when needed.
+void TSrvCfgOptions::encodeOptions() {
+    EncodedExtraOpts_.clear();
+    EncodedForcedOpts_.clear();
+
+    for (TOptList::const_iterator opt = ExtraOpts_.begin(); opt != ExtraOpts_.end(); ++opt)
+        EncodedExtraOpts_[(*opt)->getOptType()].push_back(encodeOption(*opt));
+
+    for (TOptList::const_iterator opt = ForcedOpts_.begin(); opt != ForcedOpts_.end(); ++opt)
+        EncodedForcedOpts_.push_back(encodeOption(*opt));
+
+    EncodedValid_ = true;
+}
+
+/// @brief Returns pre-encoded extra options of specified type.
+///
+/// @param type option type
+///
+/// @return list of encoded options (empty if there are no such options)
+const TOptList& TSrvCfgOptions::getEncodedExtraOptions(uint16_t type) {
+    static const TOptList empty;
+    if (!EncodedValid_)
+        encodeOptions();
+    std::map<uint16_t, TOptList>::const_iterator it = EncodedExtraOpts_.find(type);
+    if (it == EncodedExtraOpts_.end())
+        return empty;
+    return it->second;
+}
+
+/// @brief Returns pre-encoded forced options.
+///
+/// @return list of encoded forced options
+const TOptList& TSrvCfgOptions::getEncodedForcedOptions() {
+    if (!EncodedValid_)
+        encodeOptions();
+    return EncodedForcedOpts_;
 }
 
 // --------------------------------------------------------------------
@@ -15,6 +15,7 @@
 #include <iostream>
 #include <string>
 #include <list>
+#include <map>
 
 #include "SmartPtr.h"
 #include "Container.h"
@@ -73,6 +74,11 @@ public:
     void addExtraOptions(const TOptList& extra);
     void addForcedOptions(const TOptList& extra);
 
+    // pre-encoded (static) options, ready to be appended to a reply
+    void encodeOptions();
+    const TOptList& getEncodedExtraOptions(uint16_t type);
+    const TOptList& getEncodedForcedOptions();
+
 private:
     // options
     bool VendorSpecSupport;
@@ -86,6 +92,12 @@ private:
     TOptList ExtraOpts_;  // extra options ALWAYS sent to client (may also include ForcedOpts)
     TOptList ForcedOpts_; // list of options that are forced to client
 
+    // the same options, but already encoded (see encodeOptions())
+    bool EncodedValid_;
+    std::map<uint16_t, TOptList> EncodedExtraOpts_; // indexed by option type
+    TOptList EncodedForcedOpts_;
+    static TOptPtr encodeOption(TOptPtr opt);
+
     void SetDefaults();
 
     //client specification
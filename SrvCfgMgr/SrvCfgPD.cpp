@@ -9,15 +9,52 @@
  *
  */
 
+#include <stdlib.h>
 #include "SrvCfgPD.h"
 #include "SmartPtr.h"
 #include "SrvParsGlobalOpt.h"
 #include "DHCPConst.h"
 #include "Logger.h"
 #include "SrvMsg.h"
+#include "Portable.h"
 
 using namespace std;
 
+/// @brief extracts count bits (at most 63), starting at bit start, from an address
+///
+/// Bit 0 is the most significant bit of the address.
+static uint64_t getAddrBits(uint64_t hi, uint64_t lo, int start, int count) {
+    if (!count)
+        return 0;
+    int shift = 128 - start - count;
+    uint64_t x;
+    if (shift >= 64)
+        x = hi >> (shift - 64);
+    else if (shift == 0)
+        x = lo;
+    else
+        x = (lo >> shift) | (hi << (64 - shift));
+    return x & ((((uint64_t)1) << count) - 1);
+}
+
+/// @brief sets count bits (at most 63), starting at bit start, in an address
+static void setAddrBits(uint64_t& hi, uint64_t& lo, int start, int count, uint64_t value) {
+    if (!count)
+        return;
+    uint64_t mask = (((uint64_t)1) << count) - 1;
+    value &= mask;
+    int shift = 128 - start - count;
+    if (shift >= 64) {
+        hi = (hi & ~(mask << (shift - 64))) | (value << (shift - 64));
+        return;
+    }
+    lo = (lo & ~(mask << shift)) | (value << shift);
+    if (shift + count > 64) {
+        // remaining bits go to the upper half
+        hi = (hi & ~(mask >> (64 - shift))) | (value >> (64 - shift));
+    }
+}
+
 /*
  * static field initialization
  */
@@ -31,9 +68,10 @@ TSrvCfgPD::TSrvCfgPD()
 {
     ID_ = StaticID_++;
     PD_MaxLease_ = SERVER_DEFAULT_CLASSMAXLEASE;
-    PD_Assigned_ = 0;
     PD_Count_ = 0;
     PD_Length_ = 0;
+    IndexBits_ = 0;
+    IndexMax_ = 0;
 }
 
 TSrvCfgPD::~TSrvCfgPD() {
@@ -135,8 +173,20 @@ bool TSrvCfgPD::setOptions(SPtr<TSrvParsGlobalOpt> opt, int prefixLength)
        << CommonPool->getAddrR()->getPlain() << ", pool length: "
        << CommonPool->getPrefixLength() << "." << LogEnd; */
 
+    // all prefixes are free initially. Only the last 63 bits of the common section
+    // are used as a prefix index, which is way more than could ever be leased.
+    IndexBits_ = prefixLength - poolLength;
+    if (IndexBits_ < 0)
+        IndexBits_ = 0;
+    if (IndexBits_ > 63)
+        IndexBits_ = 63;
+    IndexMax_ = (((uint64_t)1) << IndexBits_) - 1;
+    FreePrefixes_.clear();
+    FreePrefixes_[0] = IndexMax_;
+
     // set up prefix counter counts
-    PD_Assigned_ = 0;
+    PD_Assigned_.setTotal(PD_Count_);
+    PD_Assigned_.set(0);
     if (PD_MaxLease_ > PD_Count_)
         PD_MaxLease_ = PD_Count_;
     Log(Debug) << "PD: Up to " << PD_Count_ << " prefixes may be assigned." << LogEnd;
@@ -189,7 +239,7 @@ List(TIPv6Addr) TSrvCfgPD::getRandomList() {
     commonPart->truncate(0, getPD_Length());
 
     /// @todo: it's just workaround. Prefix random generation should be implemented for real.
-    if (PD_Count_ == PD_Assigned_ + 1) {
+    if (PD_Count_ == PD_Assigned_.get() + 1) {
         commonPart = new TIPv6Addr(*CommonPool_->getAddrR());
     }
 
@@ -203,6 +253,189 @@ List(TIPv6Addr) TSrvCfgPD::getRandomList() {
     return lst;
 }
 
+/// @brief finds a free prefix index
+///
+/// Search starts at a random index, so subsequent clients do not get
+/// consecutive prefixes. Returned index is not marked as used: prefixes
+/// are marked as used when they are actually leased (see markUsed()).
+///
+/// @param index free index will be stored here
+///
+/// @return true if free index was found, false if the pool is exhausted
+bool TSrvCfgPD::getFreeIndex(uint64_t& index) {
+    if (FreePrefixes_.empty())
+        return false;
+
+    uint64_t start = ((((uint64_t)rand()) << 32) ^ (((uint64_t)rand()) << 16) ^ rand())
+        & IndexMax_;
+
+    // find the extent that contains start or the first one after it
+    map<uint64_t, uint64_t>::iterator it = FreePrefixes_.upper_bound(start);
+    if (it != FreePrefixes_.begin()) {
+        map<uint64_t, uint64_t>::iterator prev = it;
+        --prev;
+        if (prev->second >= start) {
+            index = start;
+            return true;
+        }
+    }
+    if (it == FreePrefixes_.end())
+        it = FreePrefixes_.begin(); // wrap around
+    index = it->first;
+    return true;
+}
+
+/// @brief returns prefix with specified index from the first pool
+///
+/// @param index prefix index
+///
+/// @return prefix (or NULL if there are no pools)
+SPtr<TIPv6Addr> TSrvCfgPD::getPrefix(uint64_t index) {
+    SPtr<THostRange> pool;
+    PoolLst_.first();
+    if (!(pool = PoolLst_.get()))
+        return SPtr<TIPv6Addr>(); // NULL
+
+    char buf[16];
+    uint64_t hi = readUint64(pool->getAddrL()->getAddr());
+    uint64_t lo = readUint64(pool->getAddrL()->getAddr() + 8);
+    setAddrBits(hi, lo, PD_Length_ - IndexBits_, IndexBits_, index);
+    writeUint64(buf, hi);
+    writeUint64(buf + 8, lo);
+    return new TIPv6Addr(buf);
+}
+
+/// @brief returns prefixes with specified index (one from each pool)
+///
+/// @param index prefix index
+///
+/// @return list of prefixes
+List(TIPv6Addr) TSrvCfgPD::getPrefixList(uint64_t index) {
+    List(TIPv6Addr) lst;
+    SPtr<THostRange> pool;
+    char buf[16];
+
+    PoolLst_.first();
+    while (pool = PoolLst_.get()) {
+        uint64_t hi = readUint64(pool->getAddrL()->getAddr());
+        uint64_t lo = readUint64(pool->getAddrL()->getAddr() + 8);
+        setAddrBits(hi, lo, PD_Length_ - IndexBits_, IndexBits_, index);
+        writeUint64(buf, hi);
+        writeUint64(buf + 8, lo);
+        lst.append(new TIPv6Addr(buf));
+    }
+    return lst;
+}
+
+/// @brief calculates index of a prefix
+///
+/// @param prefix prefix
+/// @param index calculated index will be stored here
+///
+/// @return true if prefix is one of the prefixes tracked by this class
+bool TSrvCfgPD::getIndex(SPtr<TIPv6Addr> prefix, uint64_t& index) {
+    if (!prefix || !CommonPool_)
+        return false;
+
+    uint64_t hi = readUint64(prefix->getAddr());
+    uint64_t lo = readUint64(prefix->getAddr() + 8);
+    index = getAddrBits(hi, lo, PD_Length_ - IndexBits_, IndexBits_);
+
+    // make sure that the prefix is exactly the one that index points to
+    // in one of the pools
+    SPtr<THostRange> pool;
+    PoolLst_.first();
+    while (pool = PoolLst_.get()) {
+        uint64_t poolHi = readUint64(pool->getAddrL()->getAddr());
+        uint64_t poolLo = readUint64(pool->getAddrL()->getAddr() + 8);
+        setAddrBits(poolHi, poolLo, PD_Length_ - IndexBits_, IndexBits_, index);
+        if (poolHi == hi && poolLo == lo)
+            return true;
+    }
+    return false;
+}
+
+/// @brief marks prefix as used
+///
+/// @param prefix leased prefix
+///
+/// @return true if prefix belongs to this class
+bool TSrvCfgPD::markUsed(SPtr<TIPv6Addr> prefix) {
+    uint64_t index;
+    if (!getIndex(prefix, index))
+        return false;
+    markUsed(index);
+    return true;
+}
+
+/// @brief marks prefix as free
+///
+/// @param prefix released prefix
+///
+/// @return true if prefix belongs to this class
+bool TSrvCfgPD::markFree(SPtr<TIPv6Addr> prefix) {
+    uint64_t index;
+    if (!getIndex(prefix, index))
+        return false;
+    markFree(index);
+    return true;
+}
+
+/// @brief removes index from the free extent that contains it (if any)
+///
+/// @param index prefix index
+void TSrvCfgPD::markUsed(uint64_t index) {
+    map<uint64_t, uint64_t>::iterator it = FreePrefixes_.upper_bound(index);
+    if (it == FreePrefixes_.begin())
+        return;
+    --it;
+    uint64_t start = it->first;
+    uint64_t end = it->second;
+    if (end < index)
+        return; // already used
+
+    FreePrefixes_.erase(it);
+    if (start < index)
+        FreePrefixes_[start] = index - 1;
+    if (index < end)
+        FreePrefixes_[index + 1] = end;
+}
+
+/// @brief returns index to the free extents, merging it with its neighbours
+///
+/// @param index prefix index
+void TSrvCfgPD::markFree(uint64_t index) {
+    if (index > IndexMax_)
+        return;
+
+    uint64_t start = index;
+    uint64_t end = index;
+    map<uint64_t, uint64_t>::iterator next = FreePrefixes_.upper_bound(index);
+    if (next != FreePrefixes_.begin()) {
+        map<uint64_t, uint64_t>::iterator prev = next;
+        --prev;
+        if (prev->second >= index)
+            return; // already free
+        if (prev->second + 1 == index)
+            start = prev->first;
+    }
+    if (next != FreePrefixes_.end() && next->first == index + 1) {
+        end = next->second;
+        FreePrefixes_.erase(next);
+    }
+    FreePrefixes_[start] = end;
+}
+
+/// @brief returns number of free prefix indexes
+uint64_t TSrvCfgPD::countFree() {
+    uint64_t cnt = 0;
+    for (map<uint64_t, uint64_t>::const_iterator it = FreePrefixes_.begin();
+         it != FreePrefixes_.end(); ++it) {
+        cnt += it->second - it->first + 1;
+    }
+    return cnt;
+}
+
 unsigned long TSrvCfgPD::getPD_MaxLease() {
     return PD_MaxLease_;
 }
@@ -213,17 +446,35 @@ unsigned long TSrvCfgPD::getID()
 }
 
 long TSrvCfgPD::incrAssigned(int count) {
-    PD_Assigned_ += count;
-    return PD_Assigned_;
+    return PD_Assigned_.incr(count);
 }
 
 long TSrvCfgPD::decrAssigned(int count) {
-    PD_Assigned_ -= count;
-    return PD_Assigned_;
+    return PD_Assigned_.decr(count);
+}
+
+/// sets number of assigned prefixes (used when leases are recounted)
+void TSrvCfgPD::setAssigned(unsigned long count) {
+    PD_Assigned_.set(count);
 }
 
 unsigned long TSrvCfgPD::getAssignedCount() {
-    return PD_Assigned_;
+    return PD_Assigned_.get();
+}
+
+/// @brief returns prefix pool usage statistics
+///
+/// @param now current time (used to compute allocation rate)
+TSrvPoolCounter::TSnapshot TSrvCfgPD::getStats(unsigned long now) {
+    return PD_Assigned_.snapshot(now);
+}
+
+void TSrvCfgPD::firstPool() {
+    PoolLst_.first();
+}
+
+SPtr<THostRange> TSrvCfgPD::getPool() {
+    return PoolLst_.get();
 }
 
 unsigned long TSrvCfgPD::getTotalCount() {
@@ -235,7 +486,7 @@ ostream& operator<<(ostream& out,TSrvCfgPD& prefix)
 {
     out << "    <PD id=\"" << prefix.ID_ << "\">" << std::endl;
     out << "      <!-- total prefixes in class: " << prefix.PD_Count_
-        << ", prefixes assigned: " << prefix.PD_Assigned_ << " -->" << endl;
+        << ", prefixes assigned: " << prefix.PD_Assigned_.get() << " -->" << endl;
     out << "      <T1 min=\"" << prefix.PD_T1Beg_ << "\" max=\"" << prefix.PD_T1End_  << "\" />" << endl;
     out << "      <T2 min=\"" << prefix.PD_T2Beg_ << "\" max=\"" << prefix.PD_T2End_  << "\" />" << endl;
     out << "      <prefered-lifetime min=\"" << prefix.PD_PrefBeg_ << "\" max=\"" << prefix.PD_PrefEnd_  << "\" />" << endl;
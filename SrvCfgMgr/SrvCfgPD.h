@@ -25,6 +25,11 @@
   (a) becomes pool-specific prefix
   (b) becomes common part
   (c) stays zeroed tail
+
+  Free prefixes are tracked as indexes of section (b): index k denotes
+  the k-th /PD_Length prefix in every pool. Free indexes are kept as a
+  map of disjoint [start, end] extents, so allocation, release and
+  exhaustion checks are O(log n) regardless of the pool size.
 */
 
 class TSrvCfgPD;
@@ -34,6 +39,7 @@ class TSrvCfgPD;
 #include <string>
 #include <iostream>
 #include <iomanip>
+#include <map>
 
 #include "SrvAddrMgr.h"
 #include "SrvParsGlobalOpt.h"
@@ -44,6 +50,7 @@ class TSrvCfgPD;
 #include "SmartPtr.h"
 #include "SrvCfgPD.h"
 #include "Node.h"
+#include "SrvPoolCounter.h"
 
 class TSrvCfgClientClass;
 
@@ -65,6 +72,16 @@ class TSrvCfgPD
     SPtr<TIPv6Addr> getRandomPrefix();
     List(TIPv6Addr) getRandomList();
 
+    // free prefix tracking
+    bool getFreeIndex(uint64_t& index);
+    SPtr<TIPv6Addr> getPrefix(uint64_t index);
+    List(TIPv6Addr) getPrefixList(uint64_t index);
+    bool markUsed(SPtr<TIPv6Addr> prefix);
+    bool markFree(SPtr<TIPv6Addr> prefix);
+    void markUsed(uint64_t index);
+    void markFree(uint64_t index);
+    uint64_t countFree();
+
     unsigned long getT1(unsigned long hintT1);
     unsigned long getT2(unsigned long hintT2);
     unsigned long getPrefered(unsigned long hintPrefered);
@@ -80,6 +97,10 @@ class TSrvCfgPD
     unsigned long getTotalCount();
     long incrAssigned(int count=1);
     long decrAssigned(int count=1);
+    void setAssigned(unsigned long count);
+    TSrvPoolCounter::TSnapshot getStats(unsigned long now);
+    void firstPool();
+    SPtr<THostRange> getPool();
 
     bool setOptions(SPtr<TSrvParsGlobalOpt> opt, int PDPrefix);
     virtual ~TSrvCfgPD();
@@ -104,9 +125,14 @@ class TSrvCfgPD
     List(THostRange) PoolLst_;
     SPtr<THostRange> CommonPool_; /* common part of all available prefix pools (section b in the description above) */
     unsigned long PD_MaxLease_;
-    unsigned long PD_Assigned_;
+    TSrvPoolCounter PD_Assigned_;
     unsigned long PD_Count_;
 
+    bool getIndex(SPtr<TIPv6Addr> prefix, uint64_t& index);
+    int IndexBits_;   // number of bits in section (b) used as a prefix index
+    uint64_t IndexMax_;
+    std::map<uint64_t, uint64_t> FreePrefixes_; // free indexes: start -> end (inclusive)
+
     List(std::string) AllowLst_;
     List(std::string) DenyLst_;
 
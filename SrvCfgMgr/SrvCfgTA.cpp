@@ -25,7 +25,7 @@ unsigned long TSrvCfgTA::staticID=0;
 
 TSrvCfgTA::TSrvCfgTA() 
     :Pref(SERVER_DEFAULT_TA_PREF_LIFETIME), Valid(SERVER_DEFAULT_TA_VALID_LIFETIME),
-     ClassMaxLease(SERVER_DEFAULT_CLASS_MAX_LEASE), AddrsAssigned(0), AddrsCount(0) {
+     ClassMaxLease(SERVER_DEFAULT_CLASS_MAX_LEASE), AddrsCount(0) {
     ID = staticID++;
 }
 
@@ -176,7 +176,8 @@ void TSrvCfgTA::setOptions(SPtr<TSrvParsGlobalOpt> opt)
 
     // set up address counter counts
     this->AddrsCount = this->Pool->rangeCount();
-    this->AddrsAssigned = 0;
+    this->AddrsAssigned.setTotal(this->AddrsCount);
+    this->AddrsAssigned.set(0);
 
     if (this->ClassMaxLease > this->AddrsCount)
 	this->ClassMaxLease = this->AddrsCount;
@@ -208,17 +209,22 @@ unsigned long TSrvCfgTA::getID()
 }
 
 long TSrvCfgTA::incrAssigned(int count) {
-    this->AddrsAssigned += count;
-    return this->AddrsAssigned;
+    return this->AddrsAssigned.incr(count);
 }
 
 long TSrvCfgTA::decrAssigned(int count) {
-    this->AddrsAssigned -= count;
-    return this->AddrsAssigned;
+    return this->AddrsAssigned.decr(count);
 }
 
 unsigned long TSrvCfgTA::getAssignedCount() {
-    return this->AddrsAssigned;
+    return this->AddrsAssigned.get();
+}
+
+/// @brief returns temporary address pool usage statistics
+///
+/// @param now current time (used to compute allocation rate)
+TSrvPoolCounter::TSnapshot TSrvCfgTA::getStats(unsigned long now) {
+    return this->AddrsAssigned.snapshot(now);
 }
 
 bool TSrvCfgTA::addrInPool(SPtr<TIPv6Addr> addr) 
@@ -231,7 +237,7 @@ ostream& operator<<(ostream& out,TSrvCfgTA& addrClass)
     out << "    <taClass id=\"" << addrClass.ID << "\" pref=\"" << addrClass.Pref
 	<< "\" valid=\"" << addrClass.Valid << "\">" << endl;
     out << "      <!-- total addrs in class: " << addrClass.AddrsCount
-	<< ", addrs assigned: " << addrClass.AddrsAssigned << " -->" << endl;
+	<< ", addrs assigned: " << addrClass.AddrsAssigned.get() << " -->" << endl;
     out << "      <ClassMaxLease>" << addrClass.ClassMaxLease << "</ClassMaxLease>" << endl;
 
     SPtr<THostRange> statRange;
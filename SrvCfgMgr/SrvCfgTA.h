@@ -22,6 +22,7 @@ class TSrcCfgTA;
 #include "SmartPtr.h"
 #include "IPv6Addr.h"
 #include "DUID.h"
+#include "SrvPoolCounter.h"
 
 class TSrvCfgTA
 {
@@ -46,6 +47,7 @@ class TSrvCfgTA
     unsigned long getAssignedCount();
     long incrAssigned(int count=1);
     long decrAssigned(int count=1);
+    TSrvPoolCounter::TSnapshot getStats(unsigned long now);
 
     void setOptions(SPtr<TSrvParsGlobalOpt> opt);
     virtual ~TSrvCfgTA();
@@ -63,7 +65,7 @@ class TSrvCfgTA
     TContainer<SPtr<THostRange> > AcceptClnt;
     SPtr<THostRange> Pool;
     unsigned long ClassMaxLease;
-    unsigned long AddrsAssigned;
+    TSrvPoolCounter AddrsAssigned;
     unsigned long AddrsCount;
 
     List(std::string) allowLst;
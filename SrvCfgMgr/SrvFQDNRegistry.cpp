@@ -0,0 +1,267 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "SrvFQDNRegistry.h"
+#include "DHCPDefaults.h"
+#include "Logger.h"
+
+using namespace std;
+
+TSrvFQDNRegistry::TSrvFQDNRegistry()
+    :NextSeq_(0), Dynamic_(0), Limit_(SERVER_FQDN_DYNAMIC_NAMES) {
+}
+
+void TSrvFQDNRegistry::clear() {
+    Entries_.clear();
+    Seqs_.clear();
+    Names_.clear();
+    Duids_.clear();
+    Addrs_.clear();
+    Free_.clear();
+    Idle_.clear();
+    Dynamic_ = 0;
+}
+
+/// @brief sets maximum number of dynamic names
+///
+/// @param limit maximum number of names accepted from (or generated for) clients
+void TSrvFQDNRegistry::setLimit(size_t limit) {
+    Limit_ = limit;
+}
+
+size_t TSrvFQDNRegistry::getLimit() const {
+    return Limit_;
+}
+
+std::string TSrvFQDNRegistry::duidKey(SPtr<TDUID> duid) {
+    return string(duid->get(), duid->getLen());
+}
+
+/// returns true if name is not reserved for any DUID or address
+bool TSrvFQDNRegistry::isAnonymous(SPtr<TFQDN> fqdn) {
+    return !fqdn->getDuid() && !fqdn->getAddr();
+}
+
+template<class TIndex>
+void TSrvFQDNRegistry::unindex(TIndex& index, const typename TIndex::key_type& key,
+                               uint32_t seq) {
+    pair<typename TIndex::iterator, typename TIndex::iterator> range = index.equal_range(key);
+    for (typename TIndex::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == seq) {
+            index.erase(it);
+            return;
+        }
+    }
+}
+
+/// @brief adds a name
+///
+/// If there are too many dynamic names, the oldest unused one is evicted.
+///
+/// @param fqdn name to be added
+/// @param dynamic true for names accepted from (or generated for) clients
+///
+/// @return true if added, false if the name is already registered or there
+///         is no room for another dynamic name
+bool TSrvFQDNRegistry::add(SPtr<TFQDN> fqdn, bool dynamic) {
+    if (!fqdn || Seqs_.count(&(*fqdn)))
+        return false;
+
+    if (dynamic && Dynamic_ >= Limit_) {
+        if (Idle_.empty()) {
+            Log(Warning) << "FQDN: All " << Dynamic_ << " names accepted from clients are in use, "
+                         << fqdn->getName() << " not accepted." << LogEnd;
+            return false;
+        }
+        SPtr<TFQDN> oldest = Entries_[*Idle_.begin()].fqdn;
+        Log(Debug) << "FQDN: Too many names accepted from clients, " << oldest->getName()
+                   << " evicted." << LogEnd;
+        del(oldest);
+    }
+
+    uint32_t seq = NextSeq_++;
+    TEntry& entry = Entries_[seq];
+    entry.fqdn = fqdn;
+    entry.dynamic = dynamic;
+    Seqs_[&(*fqdn)] = seq;
+
+    Names_.insert(make_pair(fqdn->getName(), seq));
+    if (fqdn->getDuid())
+        Duids_.insert(make_pair(duidKey(fqdn->getDuid()), seq));
+    if (fqdn->getAddr())
+        Addrs_.insert(make_pair(fqdn->getAddr()->getValue(), seq));
+    if (dynamic)
+        Dynamic_++;
+    updateState(seq);
+    return true;
+}
+
+/// @brief removes a name
+///
+/// @param fqdn name to be removed
+///
+/// @return true if name was registered
+bool TSrvFQDNRegistry::del(SPtr<TFQDN> fqdn) {
+    if (!fqdn)
+        return false;
+    map<const TFQDN*, uint32_t>::iterator ptr = Seqs_.find(&(*fqdn));
+    if (ptr == Seqs_.end())
+        return false;
+    uint32_t seq = ptr->second;
+    Seqs_.erase(ptr);
+
+    unindex(Names_, fqdn->getName(), seq);
+    if (fqdn->getDuid())
+        unindex(Duids_, duidKey(fqdn->getDuid()), seq);
+    if (fqdn->getAddr())
+        unindex(Addrs_, fqdn->getAddr()->getValue(), seq);
+    Free_.erase(seq);
+    Idle_.erase(seq);
+
+    map<uint32_t, TEntry>::iterator it = Entries_.find(seq);
+    if (it->second.dynamic)
+        Dynamic_--;
+    Entries_.erase(it);
+    return true;
+}
+
+/// @brief finds name for a client (not using the pool)
+///
+/// Names of the client (reserved for its DUID or accepted from it) are
+/// checked first: a used one is returned if it is assigned to the same
+/// address or if the client asked for it, an unused one is returned
+/// regardless of the hint. Then unused names reserved for the address and
+/// unused anonymous name equal to the hint are checked.
+///
+/// @param duid client's DUID
+/// @param addr client's address (may be NULL)
+/// @param hint name requested by client
+///
+/// @return name (or NULL)
+SPtr<TFQDN> TSrvFQDNRegistry::find(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr,
+                                   const std::string& hint) const {
+    if (duid) {
+        pair<TStrIndex::const_iterator, TStrIndex::const_iterator> range =
+            Duids_.equal_range(duidKey(duid));
+        uint32_t best = 0;
+        bool found = false;
+        for (TStrIndex::const_iterator it = range.first; it != range.second; ++it) {
+            SPtr<TFQDN> fqdn = Entries_.find(it->second)->second.fqdn;
+            if (fqdn->isUsed() && fqdn->getName() != hint &&
+                !(addr && fqdn->getAddr() && *fqdn->getAddr() == *addr))
+                continue;
+            if (!found || it->second < best) {
+                best = it->second;
+                found = true;
+            }
+        }
+        if (found) {
+            SPtr<TFQDN> fqdn = Entries_.find(best)->second.fqdn;
+            Log(Debug) << "FQDN found: " << fqdn->getName() << " using duid " << duid->getPlain()
+                       << LogEnd;
+            return fqdn;
+        }
+    }
+
+    if (addr) {
+        pair<TAddrIndex::const_iterator, TAddrIndex::const_iterator> range =
+            Addrs_.equal_range(addr->getValue());
+        for (TAddrIndex::const_iterator it = range.first; it != range.second; ++it) {
+            SPtr<TFQDN> fqdn = Entries_.find(it->second)->second.fqdn;
+            if (!fqdn->isUsed()) {
+                Log(Debug) << "FQDN found: " << fqdn->getName() << " using address "
+                           << addr->getPlain() << LogEnd;
+                return fqdn;
+            }
+        }
+    }
+
+    pair<TStrIndex::const_iterator, TStrIndex::const_iterator> range = Names_.equal_range(hint);
+    for (TStrIndex::const_iterator it = range.first; it != range.second; ++it) {
+        if (Free_.count(it->second)) {
+            SPtr<TFQDN> fqdn = Entries_.find(it->second)->second.fqdn;
+            Log(Debug) << "Client's hint: " << hint << " found in fqdn list, setting fqdn to "
+                       << fqdn->getName() << LogEnd;
+            return fqdn;
+        }
+    }
+    return SPtr<TFQDN>(); // NULL
+}
+
+/// returns the first registered name equal to name (or NULL)
+SPtr<TFQDN> TSrvFQDNRegistry::getByName(const std::string& name) const {
+    TStrIndex::const_iterator it = Names_.find(name);
+    if (it == Names_.end())
+        return SPtr<TFQDN>(); // NULL
+    return Entries_.find(it->second)->second.fqdn;
+}
+
+/// returns the first unused anonymous name (or NULL if pool is exhausted)
+SPtr<TFQDN> TSrvFQDNRegistry::getFree() const {
+    if (Free_.empty())
+        return SPtr<TFQDN>(); // NULL
+    return Entries_.find(*Free_.begin())->second.fqdn;
+}
+
+/// @brief marks name as used (or unused)
+///
+/// @param fqdn name (it does not have to be registered)
+/// @param used true if DNS Update was done for this name
+void TSrvFQDNRegistry::setUsed(SPtr<TFQDN> fqdn, bool used) {
+    fqdn->setUsed(used);
+    map<const TFQDN*, uint32_t>::const_iterator it = Seqs_.find(&(*fqdn));
+    if (it != Seqs_.end())
+        updateState(it->second);
+}
+
+/// @brief marks name as unused, dynamic names are removed
+///
+/// @param fqdn name released by client (or its lease expired)
+void TSrvFQDNRegistry::release(SPtr<TFQDN> fqdn) {
+    fqdn->setUsed(false);
+    map<const TFQDN*, uint32_t>::const_iterator it = Seqs_.find(&(*fqdn));
+    if (it == Seqs_.end())
+        return;
+    if (Entries_[it->second].dynamic)
+        del(fqdn);
+    else
+        updateState(it->second);
+}
+
+size_t TSrvFQDNRegistry::count() const {
+    return Entries_.size();
+}
+
+size_t TSrvFQDNRegistry::countDynamic() const {
+    return Dynamic_;
+}
+
+size_t TSrvFQDNRegistry::countFree() const {
+    return Free_.size();
+}
+
+/// returns all names (in order of addition)
+void TSrvFQDNRegistry::getAll(std::vector<SPtr<TFQDN> >& names) const {
+    for (map<uint32_t, TEntry>::const_iterator it = Entries_.begin(); it != Entries_.end(); ++it)
+        names.push_back(it->second.fqdn);
+}
+
+/// updates pool and eviction candidates after name's used flag changed
+void TSrvFQDNRegistry::updateState(uint32_t seq) {
+    const TEntry& entry = Entries_[seq];
+    bool unused = !entry.fqdn->isUsed();
+    if (unused && isAnonymous(entry.fqdn))
+        Free_.insert(seq);
+    else
+        Free_.erase(seq);
+    if (unused && entry.dynamic)
+        Idle_.insert(seq);
+    else
+        Idle_.erase(seq);
+}
@@ -0,0 +1,84 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVFQDNREGISTRY_H
+#define SRVFQDNREGISTRY_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "FQDN.h"
+
+/// @brief Names (FQDNs) the server may assign to clients on an interface.
+///
+/// Names come from the configuration (reserved for a DUID, for an address
+/// or anonymous, i.e. available to any client) or are accepted from (or
+/// generated for) clients when unknown-fqdn mode allows it. The latter are
+/// called dynamic.
+///
+/// Names are indexed by name, DUID and address. Anonymous names that are
+/// not used form a pool, assigned in configuration order. Dynamic names
+/// are removed when released (lease released or expired). Their number is
+/// limited: when the limit is reached, the oldest unused dynamic name is
+/// evicted; if all of them are in use, no new name is accepted.
+///
+/// Whether a name is used (DNS Update was done for it) must be changed
+/// with setUsed() or release(), so the pool stays accurate.
+class TSrvFQDNRegistry
+{
+  public:
+    TSrvFQDNRegistry();
+
+    void clear();
+    void setLimit(size_t limit);
+    size_t getLimit() const;
+
+    bool add(SPtr<TFQDN> fqdn, bool dynamic);
+    bool del(SPtr<TFQDN> fqdn);
+
+    SPtr<TFQDN> find(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr, const std::string& hint) const;
+    SPtr<TFQDN> getByName(const std::string& name) const;
+    SPtr<TFQDN> getFree() const;
+
+    void setUsed(SPtr<TFQDN> fqdn, bool used);
+    void release(SPtr<TFQDN> fqdn);
+
+    size_t count() const;
+    size_t countDynamic() const;
+    size_t countFree() const;
+    void getAll(std::vector<SPtr<TFQDN> >& names) const;
+
+  private:
+    struct TEntry {
+        SPtr<TFQDN> fqdn;
+        bool dynamic;
+    };
+    typedef std::multimap<std::string, uint32_t> TStrIndex;
+    typedef std::multimap<TIPv6AddrValue, uint32_t> TAddrIndex;
+
+    static std::string duidKey(SPtr<TDUID> duid);
+    static bool isAnonymous(SPtr<TFQDN> fqdn);
+    void updateState(uint32_t seq);
+    template<class TIndex> static void unindex(TIndex& index, const typename TIndex::key_type& key,
+                                               uint32_t seq);
+
+    std::map<uint32_t, TEntry> Entries_;   // by sequence number (order of addition)
+    std::map<const TFQDN*, uint32_t> Seqs_;
+    TStrIndex Names_;
+    TStrIndex Duids_;                      // packed DUID -> entries
+    TAddrIndex Addrs_;
+    std::set<uint32_t> Free_;              // unused anonymous names (pool)
+    std::set<uint32_t> Idle_;              // unused dynamic names (eviction candidates)
+    uint32_t NextSeq_;
+    size_t Dynamic_;
+    size_t Limit_;
+};
+
+#endif
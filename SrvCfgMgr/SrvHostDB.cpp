@@ -0,0 +1,699 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include "SrvHostDB.h"
+#include "DHCPConst.h"
+#include "DHCPDefaults.h"
+#include "Portable.h"
+#include "Logger.h"
+#include "hex.h"
+
+using namespace std;
+
+namespace {
+
+/// host reservation parsed from the text file
+struct THost {
+    int type;
+    string key;
+    bool hasAddr;
+    char addr[16];
+    bool hasPrefix;
+    char prefix[16];
+    uint8_t prefixLen;
+};
+
+/// compares keys: length first, then bytes
+int compareKeys(const char* a, size_t aLen, const char* b, size_t bLen) {
+    if (aLen != bLen)
+        return aLen < bLen ? -1 : 1;
+    return memcmp(a, b, aLen);
+}
+
+/// orders records in one of the indexes
+class THostOrder {
+public:
+    THostOrder(const vector<THost>& hosts, int index) :Hosts_(hosts), Index_(index) {}
+
+    bool operator()(uint32_t a, uint32_t b) const {
+        const THost& x = Hosts_[a];
+        const THost& y = Hosts_[b];
+        switch (Index_) {
+        case HOSTDB_INDEX_ADDR:
+            return memcmp(x.addr, y.addr, 16) < 0;
+        case HOSTDB_INDEX_PREFIX:
+            return memcmp(x.prefix, y.prefix, 16) < 0;
+        default:
+            return compareKeys(x.key.data(), x.key.size(), y.key.data(), y.key.size()) < 0;
+        }
+    }
+
+private:
+    const vector<THost>& Hosts_;
+    int Index_;
+};
+
+string trim(const string& s) {
+    string::size_type start = s.find_first_not_of(" \t\r");
+    if (start == string::npos)
+        return "";
+    string::size_type end = s.find_last_not_of(" \t\r");
+    return s.substr(start, end - start + 1);
+}
+
+/// parses hex data (e.g. 00:01:02 or 0x000102)
+bool parseHex(string text, string& out) {
+    if (text.length() >= 2 && text[0] == '0' && text[1] == 'x')
+        text = text.substr(2);
+    size_t digits = 0;
+    for (size_t i = 0; i < text.length(); i++) {
+        if (isxdigit((unsigned char)text[i]))
+            digits++;
+        else if (text[i] != ':')
+            return false;
+    }
+    if (!digits || digits % 2)
+        return false;
+    vector<uint8_t> bin = textToHex(text);
+    out.assign((const char*)&bin[0], bin.size());
+    return true;
+}
+
+/// parses host key (second field of a line)
+bool parseKey(const string& type, const string& text, THost& host) {
+    if (type == "duid") {
+        host.type = HOSTDB_KEY_DUID;
+        return parseHex(text, host.key);
+    }
+    if (type == "remote-id") {
+        host.type = HOSTDB_KEY_REMOTE_ID;
+        string::size_type dash = text.find('-');
+        if (dash == string::npos || !dash)
+            return false;
+        char* end = 0;
+        unsigned long enterprise = strtoul(text.substr(0, dash).c_str(), &end, 10);
+        if (*end)
+            return false;
+        string data;
+        if (!parseHex(text.substr(dash + 1), data))
+            return false;
+        char buf[4];
+        writeUint32(buf, (uint32_t)enterprise);
+        host.key = string(buf, 4) + data;
+        return true;
+    }
+    if (type == "link-local") {
+        host.type = HOSTDB_KEY_LINK_LOCAL;
+        char addr[16];
+        if (!inet_pton6(text.c_str(), addr))
+            return false;
+        host.key.assign(addr, 16);
+        return true;
+    }
+    return false;
+}
+
+/// parses one line: type,key[,address[,prefix/length]]
+bool parseHost(const string& line, THost& host) {
+    vector<string> fields;
+    string::size_type start = 0;
+    while (true) {
+        string::size_type comma = line.find(',', start);
+        fields.push_back(trim(line.substr(start, comma == string::npos ? string::npos
+                                                                         : comma - start)));
+        if (comma == string::npos)
+            break;
+        start = comma + 1;
+    }
+    if (fields.size() < 3 || fields.size() > 4)
+        return false;
+
+    host.hasAddr = !fields[2].empty();
+    host.hasPrefix = fields.size() == 4 && !fields[3].empty();
+    host.prefixLen = 0;
+    memset(host.addr, 0, 16);
+    memset(host.prefix, 0, 16);
+
+    if (!parseKey(fields[0], fields[1], host))
+        return false;
+    if (host.hasAddr && !inet_pton6(fields[2].c_str(), host.addr))
+        return false;
+    if (host.hasPrefix) {
+        string::size_type slash = fields[3].find('/');
+        if (slash == string::npos)
+            return false;
+        char* end = 0;
+        unsigned long len = strtoul(fields[3].c_str() + slash + 1, &end, 10);
+        if (*end || !len || len > 128)
+            return false;
+        if (!inet_pton6(fields[3].substr(0, slash).c_str(), host.prefix))
+            return false;
+        host.prefixLen = (uint8_t)len;
+    }
+    return host.hasAddr || host.hasPrefix;
+}
+
+}
+
+TSrvHostDB::TMapping::TMapping()
+    :data(0), len(0), mapped(false) {
+}
+
+TSrvHostDB::TSrvHostDB()
+    :Records_(0), RecLen_(0), RecCnt_(0), Strings_(0), Inode_(0), Mtime_(0), Size_(0),
+     NextCheck_(0) {
+    for (int i = 0; i < HOSTDB_INDEX_CNT; i++) {
+        Indexes_[i] = 0;
+        IndexCnt_[i] = 0;
+    }
+}
+
+TSrvHostDB::~TSrvHostDB() {
+    close();
+}
+
+/**
+ * @brief compiles text file with host reservations into binary database
+ *
+ * Each line of the text file defines one host: key type (duid, remote-id or
+ * link-local), key, reserved address and reserved prefix, separated with
+ * commas. Address or prefix may be empty, but not both. Empty lines and
+ * lines starting with # are ignored. Example:
+ *
+ * @code
+ * duid,00:01:00:00:00:01:02:03:04:05:06:07,2001:db8::10
+ * remote-id,5-01:02:03:04,,2001:db8:1::/48
+ * link-local,fe80::1,2001:db8::11,2001:db8:2::/56
+ * @endcode
+ *
+ * The database is written to a temporary file that is renamed over the
+ * destination, so a running server never sees a partially written database.
+ *
+ * @param csvFile text file with reservations
+ * @param binFile binary database to be written
+ *
+ * @return true if the whole file was valid and database was written
+ */
+bool TSrvHostDB::compile(const std::string& csvFile, const std::string& binFile) {
+    ifstream in(csvFile.c_str());
+    if (!in.is_open()) {
+        Log(Error) << "Unable to open host reservations file " << csvFile << "." << LogEnd;
+        return false;
+    }
+
+    vector<THost> hosts;
+    map<string, int> keys[HOSTDB_INDEX_CNT]; // key -> line, for duplicate detection
+    string line;
+    int lineNo = 0;
+    while (getline(in, line)) {
+        lineNo++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        THost host;
+        if (!parseHost(line, host)) {
+            Log(Error) << "Invalid host reservation in " << csvFile << ", line " << lineNo
+                       << ": " << line << LogEnd;
+            return false;
+        }
+
+        string values[HOSTDB_INDEX_CNT];
+        values[host.type] = host.key;
+        if (host.hasAddr)
+            values[HOSTDB_INDEX_ADDR].assign(host.addr, 16);
+        if (host.hasPrefix)
+            values[HOSTDB_INDEX_PREFIX].assign(host.prefix, 16);
+        for (int i = 0; i < HOSTDB_INDEX_CNT; i++) {
+            if (values[i].empty())
+                continue;
+            map<string, int>::const_iterator dup = keys[i].find(values[i]);
+            if (dup != keys[i].end()) {
+                Log(Error) << "Host reservation in " << csvFile << ", line " << lineNo
+                           << " conflicts with line " << dup->second << "." << LogEnd;
+                return false;
+            }
+            keys[i][values[i]] = lineNo;
+        }
+        hosts.push_back(host);
+    }
+
+    // indexes
+    vector<uint32_t> indexes[HOSTDB_INDEX_CNT];
+    for (uint32_t i = 0; i < hosts.size(); i++) {
+        indexes[hosts[i].type].push_back(i);
+        if (hosts[i].hasAddr)
+            indexes[HOSTDB_INDEX_ADDR].push_back(i);
+        if (hosts[i].hasPrefix)
+            indexes[HOSTDB_INDEX_PREFIX].push_back(i);
+    }
+    for (int i = 0; i < HOSTDB_INDEX_CNT; i++)
+        sort(indexes[i].begin(), indexes[i].end(), THostOrder(hosts, i));
+
+    // header and records
+    size_t stringsLen = 0;
+    for (size_t i = 0; i < hosts.size(); i++)
+        stringsLen += hosts[i].key.size();
+    size_t total = HOSTDB_HEADER_LEN + hosts.size() * HOSTDB_REC_LEN + stringsLen;
+    for (int i = 0; i < HOSTDB_INDEX_CNT; i++)
+        total += indexes[i].size() * sizeof(uint32_t);
+
+    vector<char> buf(total, 0);
+    char* hdr = &buf[0];
+    memcpy(hdr + HOSTDB_HDR_MAGIC, HOSTDB_MAGIC, HOSTDB_MAGIC_LEN);
+    writeUint16(hdr + HOSTDB_HDR_VERSION, HOSTDB_VERSION);
+    writeUint16(hdr + HOSTDB_HDR_HEADER_LEN, HOSTDB_HEADER_LEN);
+    writeUint16(hdr + HOSTDB_HDR_REC_LEN, HOSTDB_REC_LEN);
+    writeUint32(hdr + HOSTDB_HDR_REC_CNT, hosts.size());
+    for (int i = 0; i < HOSTDB_INDEX_CNT; i++)
+        writeUint32(hdr + HOSTDB_HDR_INDEX_CNT + 4*i, indexes[i].size());
+    writeUint32(hdr + HOSTDB_HDR_STRINGS_LEN, stringsLen);
+    writeUint32(hdr + HOSTDB_HDR_TOTAL_LEN, total);
+
+    char* ptr = hdr + HOSTDB_HEADER_LEN;
+    uint32_t keyOff = 0;
+    for (size_t i = 0; i < hosts.size(); i++, ptr += HOSTDB_REC_LEN) {
+        const THost& host = hosts[i];
+        writeUint8(ptr + HOSTDB_REC_TYPE, host.type);
+        writeUint8(ptr + HOSTDB_REC_FLAGS, (host.hasAddr ? HOSTDB_REC_FLAG_ADDR : 0) |
+                                           (host.hasPrefix ? HOSTDB_REC_FLAG_PREFIX : 0));
+        writeUint8(ptr + HOSTDB_REC_PREFIX_LEN, host.prefixLen);
+        writeUint16(ptr + HOSTDB_REC_KEY_LEN, host.key.size());
+        writeUint32(ptr + HOSTDB_REC_KEY_OFF, keyOff);
+        memcpy(ptr + HOSTDB_REC_ADDR, host.addr, 16);
+        memcpy(ptr + HOSTDB_REC_PREFIX, host.prefix, 16);
+        keyOff += host.key.size();
+    }
+    for (int i = 0; i < HOSTDB_INDEX_CNT; i++) {
+        for (size_t j = 0; j < indexes[i].size(); j++)
+            ptr = writeUint32(ptr, indexes[i][j]);
+    }
+    for (size_t i = 0; i < hosts.size(); i++) {
+        memcpy(ptr, hosts[i].key.data(), hosts[i].key.size());
+        ptr += hosts[i].key.size();
+    }
+
+    string tmpFile = binFile + ".tmp";
+    FILE* f = fopen(tmpFile.c_str(), "wb");
+    if (!f) {
+        Log(Error) << "Unable to create host reservations database " << tmpFile << "." << LogEnd;
+        return false;
+    }
+    bool ok = fwrite(&buf[0], 1, buf.size(), f) == buf.size();
+#ifndef WIN32
+    if (ok && (fflush(f) || fsync(fileno(f))))
+        ok = false;
+#endif
+    if (fclose(f))
+        ok = false;
+    if (!ok) {
+        Log(Error) << "Failed to write host reservations database " << tmpFile << "." << LogEnd;
+        unlink(tmpFile.c_str());
+        return false;
+    }
+
+#ifdef WIN32
+    // rename() does not overwrite existing files on Windows
+    unlink(binFile.c_str());
+#endif
+    if (rename(tmpFile.c_str(), binFile.c_str())) {
+        Log(Error) << "Unable to rename " << tmpFile << " to " << binFile << "." << LogEnd;
+        unlink(tmpFile.c_str());
+        return false;
+    }
+
+    Log(Info) << hosts.size() << " host reservation(s) compiled from " << csvFile << " to "
+              << binFile << "." << LogEnd;
+    return true;
+}
+
+/// @brief maps database into memory (or reads it, if mapping is not available)
+///
+/// @param binFile name of the database
+/// @param m mapping will be stored here
+///
+/// @return true if file was loaded
+bool TSrvHostDB::load(const std::string& binFile, TMapping& m) {
+    int fd = ::open(binFile.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size < HOSTDB_HEADER_LEN) {
+        Log(Warning) << "Host reservations database " << binFile << " is truncated." << LogEnd;
+        ::close(fd);
+        return false;
+    }
+    m.len = st.st_size;
+
+#ifndef WIN32
+    void* map = mmap(NULL, m.len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        Log(Error) << "Unable to map host reservations database " << binFile
+                   << " into memory." << LogEnd;
+        return false;
+    }
+    m.data = (const char*)map;
+    m.mapped = true;
+#else
+    m.buf.resize(m.len);
+    bool ok = read(fd, &m.buf[0], m.len) == (int)m.len;
+    ::close(fd);
+    if (!ok)
+        return false;
+    m.data = &m.buf[0];
+    m.mapped = false;
+#endif
+    return true;
+}
+
+void TSrvHostDB::unload(TMapping& m) {
+#ifndef WIN32
+    if (m.mapped)
+        munmap((void*)m.data, m.len);
+#endif
+    m.buf.clear();
+    m.data = 0;
+    m.len = 0;
+    m.mapped = false;
+}
+
+/**
+ * @brief checks that database is consistent
+ *
+ * All offsets and record numbers are verified once, so lookups may use
+ * them without further checks.
+ *
+ * @param binFile name of the database (used for logging only)
+ * @param data database
+ * @param len length of the database
+ *
+ * @return true if database is valid
+ */
+bool TSrvHostDB::validate(const std::string& binFile, const char* data, size_t len) {
+    if (len < HOSTDB_HEADER_LEN || memcmp(data + HOSTDB_HDR_MAGIC, HOSTDB_MAGIC, HOSTDB_MAGIC_LEN)) {
+        Log(Warning) << "File " << binFile << " is not a host reservations database." << LogEnd;
+        return false;
+    }
+    uint16_t version = readUint16(data + HOSTDB_HDR_VERSION);
+    if (version != HOSTDB_VERSION) {
+        Log(Warning) << "Host reservations database " << binFile << " has unsupported version "
+                     << version << " (expected " << HOSTDB_VERSION << ")." << LogEnd;
+        return false;
+    }
+
+    size_t hdrLen = readUint16(data + HOSTDB_HDR_HEADER_LEN);
+    size_t recLen = readUint16(data + HOSTDB_HDR_REC_LEN);
+    uint32_t recCnt = readUint32(data + HOSTDB_HDR_REC_CNT);
+    size_t stringsLen = readUint32(data + HOSTDB_HDR_STRINGS_LEN);
+    uint64_t expected = (uint64_t)hdrLen + (uint64_t)recCnt * recLen + stringsLen;
+    for (int i = 0; i < HOSTDB_INDEX_CNT; i++)
+        expected += (uint64_t)readUint32(data + HOSTDB_HDR_INDEX_CNT + 4*i) * sizeof(uint32_t);
+    if (hdrLen < HOSTDB_HEADER_LEN || recLen < HOSTDB_REC_LEN ||
+        readUint32(data + HOSTDB_HDR_TOTAL_LEN) != len || expected != len) {
+        Log(Warning) << "Host reservations database " << binFile << " is corrupted (invalid "
+                     << "section lengths)." << LogEnd;
+        return false;
+    }
+
+    const char* rec = data + hdrLen;
+    for (uint32_t i = 0; i < recCnt; i++, rec += recLen) {
+        uint8_t type = readUint8(rec + HOSTDB_REC_TYPE);
+        size_t keyLen = readUint16(rec + HOSTDB_REC_KEY_LEN);
+        size_t keyOff = readUint32(rec + HOSTDB_REC_KEY_OFF);
+        if (type > HOSTDB_KEY_LINK_LOCAL || !keyLen || keyOff + keyLen > stringsLen ||
+            (type == HOSTDB_KEY_REMOTE_ID && keyLen < 4) ||
+            (type == HOSTDB_KEY_LINK_LOCAL && keyLen != 16) ||
+            readUint8(rec + HOSTDB_REC_PREFIX_LEN) > 128) {
+            Log(Warning) << "Host reservations database " << binFile << " is corrupted (invalid "
+                         << "record " << i << ")." << LogEnd;
+            return false;
+        }
+    }
+
+    const char* index = rec;
+    for (int i = 0; i < HOSTDB_INDEX_CNT; i++) {
+        uint32_t cnt = readUint32(data + HOSTDB_HDR_INDEX_CNT + 4*i);
+        for (uint32_t j = 0; j < cnt; j++, index += sizeof(uint32_t)) {
+            if (readUint32(index) >= recCnt) {
+                Log(Warning) << "Host reservations database " << binFile << " is corrupted "
+                             << "(invalid index " << i << ")." << LogEnd;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief opens host reservations database
+ *
+ * If the file is missing or invalid, currently open database (if any) is
+ * kept. The file is remembered, so update() will pick it up once it is
+ * (re)created.
+ *
+ * @param binFile name of the database
+ *
+ * @return true if database was opened
+ */
+bool TSrvHostDB::open(const std::string& binFile) {
+    File_ = binFile;
+
+    struct stat st;
+    if (stat(binFile.c_str(), &st)) {
+        Log(Debug) << "Host reservations database " << binFile << " not found." << LogEnd;
+        return false;
+    }
+    Inode_ = st.st_ino;
+    Mtime_ = st.st_mtime;
+    Size_ = st.st_size;
+
+    TMapping m;
+    if (!load(binFile, m))
+        return false;
+    if (!validate(binFile, m.data, m.len)) {
+        unload(m);
+        return false;
+    }
+
+    close();
+    Map_.data = m.data;
+    Map_.len = m.len;
+    Map_.mapped = m.mapped;
+    Map_.buf.swap(m.buf);
+    if (!Map_.mapped)
+        Map_.data = &Map_.buf[0];
+
+    const char* data = Map_.data;
+    RecLen_ = readUint16(data + HOSTDB_HDR_REC_LEN);
+    RecCnt_ = readUint32(data + HOSTDB_HDR_REC_CNT);
+    Records_ = data + readUint16(data + HOSTDB_HDR_HEADER_LEN);
+    const char* index = Records_ + RecCnt_ * RecLen_;
+    for (int i = 0; i < HOSTDB_INDEX_CNT; i++) {
+        Indexes_[i] = index;
+        IndexCnt_[i] = readUint32(data + HOSTDB_HDR_INDEX_CNT + 4*i);
+        index += IndexCnt_[i] * sizeof(uint32_t);
+    }
+    Strings_ = index;
+
+    Log(Info) << RecCnt_ << " host reservation(s) loaded from " << binFile << "." << LogEnd;
+    return true;
+}
+
+void TSrvHostDB::close() {
+    unload(Map_);
+    Records_ = 0;
+    RecLen_ = 0;
+    RecCnt_ = 0;
+    Strings_ = 0;
+    for (int i = 0; i < HOSTDB_INDEX_CNT; i++) {
+        Indexes_[i] = 0;
+        IndexCnt_[i] = 0;
+    }
+}
+
+/// @brief reopens database if its file was replaced
+///
+/// File is checked at most once per SERVER_HOSTDB_CHECK_INTERVAL seconds.
+///
+/// @param now current time
+///
+/// @return true if new database was loaded
+bool TSrvHostDB::update(unsigned long now) {
+    if (File_.empty() || now < NextCheck_)
+        return false;
+    NextCheck_ = now + SERVER_HOSTDB_CHECK_INTERVAL;
+
+    struct stat st;
+    if (stat(File_.c_str(), &st))
+        return false;
+    if ((unsigned long)st.st_ino == Inode_ && (unsigned long)st.st_mtime == Mtime_ &&
+        (unsigned long)st.st_size == Size_)
+        return false;
+
+    Log(Notice) << "Host reservations database " << File_ << " has changed, reloading." << LogEnd;
+    return open(File_);
+}
+
+bool TSrvHostDB::isOpen() const {
+    return Map_.data != 0;
+}
+
+const std::string& TSrvHostDB::getFile() const {
+    return File_;
+}
+
+/// returns number of reservations
+uint32_t TSrvHostDB::count() const {
+    return RecCnt_;
+}
+
+const char* TSrvHostDB::record(uint32_t rec) const {
+    return Records_ + rec * RecLen_;
+}
+
+/// returns value of a record that is used as a key in specified index
+void TSrvHostDB::key(int index, uint32_t rec, const char*& data, size_t& len) const {
+    const char* ptr = record(rec);
+    switch (index) {
+    case HOSTDB_INDEX_ADDR:
+        data = ptr + HOSTDB_REC_ADDR;
+        len = 16;
+        return;
+    case HOSTDB_INDEX_PREFIX:
+        data = ptr + HOSTDB_REC_PREFIX;
+        len = 16;
+        return;
+    default:
+        data = Strings_ + readUint32(ptr + HOSTDB_REC_KEY_OFF);
+        len = readUint16(ptr + HOSTDB_REC_KEY_LEN);
+    }
+}
+
+/// @brief binary search in one of the indexes
+///
+/// @return record number (or -1 if not found)
+int TSrvHostDB::search(int index, const char* data, size_t len) const {
+    uint32_t lo = 0;
+    uint32_t hi = IndexCnt_[index];
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t rec = readUint32(Indexes_[index] + mid * sizeof(uint32_t));
+        const char* recData;
+        size_t recLen;
+        key(index, rec, recData, recLen);
+        int cmp = compareKeys(recData, recLen, data, len);
+        if (!cmp)
+            return rec;
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return -1;
+}
+
+/// @brief returns reservation as a per-client configuration
+///
+/// @param rec record number (0..count()-1)
+///
+/// @return reservation (NULL if record number is invalid)
+SPtr<TSrvCfgOptions> TSrvHostDB::get(uint32_t rec) const {
+    if (rec >= RecCnt_)
+        return SPtr<TSrvCfgOptions>(); // NULL
+
+    const char* ptr = record(rec);
+    const char* keyData;
+    size_t keyLen;
+    key(HOSTDB_KEY_DUID, rec, keyData, keyLen);
+
+    SPtr<TSrvCfgOptions> x;
+    switch (readUint8(ptr + HOSTDB_REC_TYPE)) {
+    case HOSTDB_KEY_DUID:
+        x = new TSrvCfgOptions(SPtr<TDUID>(new TDUID(keyData, keyLen)));
+        break;
+    case HOSTDB_KEY_REMOTE_ID:
+        x = new TSrvCfgOptions(SPtr<TOptVendorData>(
+                new TOptVendorData(OPTION_REMOTE_ID, keyData, keyLen, 0)));
+        break;
+    default:
+        x = new TSrvCfgOptions(SPtr<TIPv6Addr>(new TIPv6Addr(keyData, false)));
+        break;
+    }
+
+    uint8_t flags = readUint8(ptr + HOSTDB_REC_FLAGS);
+    if (flags & HOSTDB_REC_FLAG_ADDR)
+        x->setAddr(new TIPv6Addr(ptr + HOSTDB_REC_ADDR, false));
+    if (flags & HOSTDB_REC_FLAG_PREFIX)
+        x->setPrefix(new TIPv6Addr(ptr + HOSTDB_REC_PREFIX, false),
+                     readUint8(ptr + HOSTDB_REC_PREFIX_LEN));
+    return x;
+}
+
+/// @brief finds reservation for a client
+///
+/// DUID is checked first, then remote-id and link-local address.
+///
+/// @param duid client's DUID (may be NULL)
+/// @param remoteID remote-id inserted by relay (may be NULL)
+/// @param linkLocal client's link-local address (may be NULL)
+///
+/// @return reservation (or NULL)
+SPtr<TSrvCfgOptions> TSrvHostDB::find(SPtr<TDUID> duid, SPtr<TOptVendorData> remoteID,
+                                      SPtr<TIPv6Addr> linkLocal) const {
+    if (!RecCnt_)
+        return SPtr<TSrvCfgOptions>(); // NULL
+
+    int rec = -1;
+    if (duid && duid->getLen())
+        rec = search(HOSTDB_KEY_DUID, duid->get(), duid->getLen());
+    if (rec < 0 && remoteID) {
+        string key(4 + remoteID->getVendorDataLen(), 0);
+        writeUint32(&key[0], remoteID->getVendor());
+        if (remoteID->getVendorDataLen())
+            memcpy(&key[4], remoteID->getVendorData(), remoteID->getVendorDataLen());
+        rec = search(HOSTDB_KEY_REMOTE_ID, key.data(), key.size());
+    }
+    if (rec < 0 && linkLocal)
+        rec = search(HOSTDB_KEY_LINK_LOCAL, linkLocal->getAddr(), 16);
+    if (rec < 0)
+        return SPtr<TSrvCfgOptions>(); // NULL
+    return get(rec);
+}
+
+/// returns reservation of specified address (or NULL)
+SPtr<TSrvCfgOptions> TSrvHostDB::findAddr(SPtr<TIPv6Addr> addr) const {
+    int rec = RecCnt_ ? search(HOSTDB_INDEX_ADDR, addr->getAddr(), 16) : -1;
+    if (rec < 0)
+        return SPtr<TSrvCfgOptions>(); // NULL
+    return get(rec);
+}
+
+/// returns reservation of specified prefix (or NULL)
+SPtr<TSrvCfgOptions> TSrvHostDB::findPrefix(SPtr<TIPv6Addr> prefix) const {
+    int rec = RecCnt_ ? search(HOSTDB_INDEX_PREFIX, prefix->getAddr(), 16) : -1;
+    if (rec < 0)
+        return SPtr<TSrvCfgOptions>(); // NULL
+    return get(rec);
+}
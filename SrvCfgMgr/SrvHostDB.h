@@ -0,0 +1,145 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVHOSTDB_H
+#define SRVHOSTDB_H
+
+#include <string>
+#include <vector>
+#include "SrvCfgOptions.h"
+
+/// @file SrvHostDB.h
+///
+/// @brief On-disk layout of the host reservation database.
+///
+/// Host reservations may be kept outside of the config file, in a text file
+/// (one reservation per line, see TSrvHostDB::compile()) that is compiled
+/// into a binary database. The database is mapped into memory and queried
+/// directly, so no parsing is needed at startup and its size does not affect
+/// memory used by the server. All integers are stored in network byte order.
+/// The file consists of a fixed header followed by these sections, stored
+/// back to back:
+///
+/// - host records (HOSTDB_REC_LEN bytes each)
+/// - five indexes (arrays of uint32 record numbers): by DUID, by remote-id,
+///   by link-local address (each sorted by key: length first, then bytes),
+///   by reserved address and by reserved prefix (sorted by value)
+/// - string section: keys of the records, referenced by (offset, length)
+///   pairs. DUIDs are stored as they are, remote-ids as enterprise number
+///   followed by the data, link-local addresses as 16 bytes.
+///
+/// The header stores the record length, so a newer writer may append fields
+/// to records without breaking older readers. Incompatible changes must bump
+/// HOSTDB_VERSION.
+
+#define HOSTDB_MAGIC          "DIBHOSTS"
+#define HOSTDB_MAGIC_LEN      8
+#define HOSTDB_VERSION        1
+
+#define HOSTDB_HEADER_LEN     48
+#define HOSTDB_REC_LEN        48
+
+/// header: offsets of the fields
+#define HOSTDB_HDR_MAGIC         0  ///< 8 bytes: HOSTDB_MAGIC
+#define HOSTDB_HDR_VERSION       8  ///< uint16: format version
+#define HOSTDB_HDR_HEADER_LEN    10 ///< uint16: length of this header
+#define HOSTDB_HDR_REC_LEN       12 ///< uint16: length of a host record
+#define HOSTDB_HDR_FLAGS         14 ///< uint16: reserved, must be 0
+#define HOSTDB_HDR_REC_CNT       16 ///< uint32: number of host records
+#define HOSTDB_HDR_INDEX_CNT     20 ///< 5 x uint32: number of entries in each index
+#define HOSTDB_HDR_STRINGS_LEN   40 ///< uint32: length of the string section
+#define HOSTDB_HDR_TOTAL_LEN     44 ///< uint32: length of the whole file
+
+/// host record
+#define HOSTDB_REC_TYPE          0  ///< uint8: key type (HOSTDB_KEY_*)
+#define HOSTDB_REC_FLAGS         1  ///< uint8: HOSTDB_REC_FLAG_* bits
+#define HOSTDB_REC_PREFIX_LEN    2  ///< uint8: length of the reserved prefix
+#define HOSTDB_REC_KEY_LEN       4  ///< uint16: key length
+#define HOSTDB_REC_KEY_OFF       8  ///< uint32: key (string section offset)
+#define HOSTDB_REC_ADDR          16 ///< 16 bytes: reserved address
+#define HOSTDB_REC_PREFIX        32 ///< 16 bytes: reserved prefix
+
+#define HOSTDB_REC_FLAG_ADDR     0x01 ///< address is reserved
+#define HOSTDB_REC_FLAG_PREFIX   0x02 ///< prefix is reserved
+
+/// key types, also used as index numbers
+#define HOSTDB_KEY_DUID          0
+#define HOSTDB_KEY_REMOTE_ID     1
+#define HOSTDB_KEY_LINK_LOCAL    2
+#define HOSTDB_INDEX_ADDR        3
+#define HOSTDB_INDEX_PREFIX      4
+#define HOSTDB_INDEX_CNT         5
+
+/// @brief Host reservations kept in a memory mapped database.
+///
+/// The database is only read by the server. It is replaced by writing a new
+/// file and renaming it over the old one (see compile()). update() notices
+/// that and maps the new file; the old mapping stays valid until then, as it
+/// refers to the old (already unlinked) file.
+///
+/// Only address and prefix reservations are supported. Reservations that
+/// include options must be defined in the config file.
+class TSrvHostDB
+{
+  public:
+    TSrvHostDB();
+    ~TSrvHostDB();
+
+    static bool compile(const std::string& csvFile, const std::string& binFile);
+
+    bool open(const std::string& binFile);
+    void close();
+    bool update(unsigned long now);
+    bool isOpen() const;
+    const std::string& getFile() const;
+    uint32_t count() const;
+
+    SPtr<TSrvCfgOptions> get(uint32_t rec) const;
+    SPtr<TSrvCfgOptions> find(SPtr<TDUID> duid, SPtr<TOptVendorData> remoteID,
+                              SPtr<TIPv6Addr> linkLocal) const;
+    SPtr<TSrvCfgOptions> findAddr(SPtr<TIPv6Addr> addr) const;
+    SPtr<TSrvCfgOptions> findPrefix(SPtr<TIPv6Addr> prefix) const;
+
+  private:
+    TSrvHostDB(const TSrvHostDB&);
+    TSrvHostDB& operator=(const TSrvHostDB&);
+
+    struct TMapping {
+        TMapping();
+        const char* data;
+        size_t len;
+        bool mapped;
+        std::vector<char> buf;
+    };
+
+    static bool load(const std::string& binFile, TMapping& m);
+    static void unload(TMapping& m);
+    static bool validate(const std::string& binFile, const char* data, size_t len);
+
+    const char* record(uint32_t rec) const;
+    void key(int index, uint32_t rec, const char*& data, size_t& len) const;
+    int search(int index, const char* data, size_t len) const;
+
+    std::string File_;
+    TMapping Map_;
+    const char* Records_;
+    size_t RecLen_;
+    uint32_t RecCnt_;
+    const char* Indexes_[HOSTDB_INDEX_CNT];
+    uint32_t IndexCnt_[HOSTDB_INDEX_CNT];
+    const char* Strings_;
+
+    // identity of the last examined file (to detect replacement)
+    unsigned long Inode_;
+    unsigned long Mtime_;
+    unsigned long Size_;
+    unsigned long NextCheck_;
+};
+
+#endif
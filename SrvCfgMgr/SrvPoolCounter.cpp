@@ -0,0 +1,89 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "SrvPoolCounter.h"
+
+TSrvPoolCounter::TSrvPoolCounter()
+    :Total_(0), LastTime_(0), LastAllocs_(0) {
+    Assigned_.value = 0;
+    Allocs_.value = 0;
+    Releases_.value = 0;
+}
+
+/// @brief atomically adds delta to the value
+///
+/// @return new value
+unsigned long TSrvPoolCounter::add(volatile unsigned long* value, long delta) {
+#if defined(__GNUC__)
+    return __sync_add_and_fetch(value, (unsigned long)delta);
+#else
+    // no atomic builtins, the server is single-threaded anyway
+    *value += delta;
+    return *value;
+#endif
+}
+
+void TSrvPoolCounter::setTotal(unsigned long total) {
+    Total_ = total;
+}
+
+unsigned long TSrvPoolCounter::getTotal() const {
+    return Total_;
+}
+
+/// @brief records allocated lease(s)
+///
+/// @return number of assigned leases
+unsigned long TSrvPoolCounter::incr(int count) {
+    add(&Allocs_.value, count);
+    return add(&Assigned_.value, count);
+}
+
+/// @brief records released lease(s)
+///
+/// @return number of assigned leases
+unsigned long TSrvPoolCounter::decr(int count) {
+    add(&Releases_.value, count);
+    return add(&Assigned_.value, -count);
+}
+
+/// @brief sets number of assigned leases (after recount), does not count allocations
+///
+/// @param assigned number of assigned leases
+void TSrvPoolCounter::set(unsigned long assigned) {
+    Assigned_.value = assigned;
+}
+
+unsigned long TSrvPoolCounter::get() const {
+    return Assigned_.value;
+}
+
+/// @brief returns current pool usage
+///
+/// @param now current time (in seconds), used to compute allocation rate
+///
+/// @return pool usage snapshot
+TSrvPoolCounter::TSnapshot TSrvPoolCounter::snapshot(unsigned long now) {
+    TSnapshot s;
+    s.total = Total_;
+    s.assigned = Assigned_.value;
+    s.allocs = Allocs_.value;
+    s.releases = Releases_.value;
+    s.free = s.assigned < s.total ? s.total - s.assigned : 0;
+    s.utilization = s.total ? (unsigned int)(100.0 * s.assigned / s.total) : 0;
+
+    s.allocRate = 0.0;
+    if (LastTime_ && now > LastTime_)
+        s.allocRate = (double)(s.allocs - LastAllocs_) / (now - LastTime_);
+    if (!LastTime_ || now > LastTime_) {
+        LastTime_ = now;
+        LastAllocs_ = s.allocs;
+    }
+    return s;
+}
@@ -0,0 +1,68 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVPOOLCOUNTER_H
+#define SRVPOOLCOUNTER_H
+
+#include <stdint.h>
+
+/// @brief Usage counter of a single address or prefix pool.
+///
+/// Counts leases currently assigned from the pool, as well as all
+/// allocations and releases. Counters are updated with atomic operations
+/// (where the compiler provides them) and each of them is padded to its
+/// own cache line, so pools used by different threads don't invalidate
+/// each other's counters.
+///
+/// snapshot() returns a consistent enough view for monitoring: usage,
+/// free count and allocation rate since the previous snapshot.
+class TSrvPoolCounter
+{
+  public:
+    struct TSnapshot {
+        unsigned long total;      ///< pool size
+        unsigned long assigned;   ///< currently assigned leases
+        unsigned long free;       ///< total - assigned
+        unsigned int utilization; ///< assigned leases, in percent of the pool size
+        unsigned long allocs;     ///< allocations since the counter was created
+        unsigned long releases;   ///< releases since the counter was created
+        double allocRate;         ///< allocations per second since the previous snapshot
+    };
+
+    TSrvPoolCounter();
+
+    void setTotal(unsigned long total);
+    unsigned long getTotal() const;
+
+    unsigned long incr(int count = 1);
+    unsigned long decr(int count = 1);
+    void set(unsigned long assigned);
+    unsigned long get() const;
+
+    TSnapshot snapshot(unsigned long now);
+
+  private:
+    static unsigned long add(volatile unsigned long* value, long delta);
+
+    /// counter padded to a cache line
+    union TPadded {
+        volatile unsigned long value;
+        char pad[64];
+    };
+
+    TPadded Assigned_;
+    TPadded Allocs_;
+    TPadded Releases_;
+
+    unsigned long Total_;
+    unsigned long LastTime_;   // time of the previous snapshot (0 = none yet)
+    unsigned long LastAllocs_; // allocations at the time of the previous snapshot
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include "SrvFQDNRegistry.h"
+#include "SrvCfgIface.h"
+
+using namespace std;
+
+namespace {
+
+template<class T>
+const T* raw(SPtr<T> ptr) {
+    return ptr ? &(*ptr) : 0;
+}
+
+class FQDNRegistryTest : public ::testing::Test {
+public:
+    FQDNRegistryTest()
+        :Duid1_(new TDUID("00:01:02:03:04:05:06:07")),
+         Duid2_(new TDUID("00:01:02:03:04:05:06:08")),
+         Addr_(new TIPv6Addr("2001:db8::1", true)),
+         ByDuid_(new TFQDN(Duid1_, "duid.example.com", false)),
+         ByAddr_(new TFQDN(Addr_, "addr.example.com", false)),
+         Anon1_(new TFQDN("anon1.example.com", false)),
+         Anon2_(new TFQDN("anon2.example.com", false)) {
+        Names_.add(ByDuid_, false);
+        Names_.add(ByAddr_, false);
+        Names_.add(Anon1_, false);
+        Names_.add(Anon2_, false);
+    }
+
+    SPtr<TDUID> Duid1_;
+    SPtr<TDUID> Duid2_;
+    SPtr<TIPv6Addr> Addr_;
+    SPtr<TFQDN> ByDuid_;
+    SPtr<TFQDN> ByAddr_;
+    SPtr<TFQDN> Anon1_;
+    SPtr<TFQDN> Anon2_;
+    TSrvFQDNRegistry Names_;
+};
+
+// This test verifies that names are found by DUID, address and hint.
+TEST_F(FQDNRegistryTest, find) {
+    SPtr<TIPv6Addr> other = new TIPv6Addr("2001:db8::2", true);
+
+    EXPECT_EQ(4u, Names_.count());
+    EXPECT_FALSE(Names_.add(Anon1_, false));
+
+    // reserved for DUID, regardless of hint
+    EXPECT_EQ(raw(ByDuid_), raw(Names_.find(Duid1_, Addr_, "anon1.example.com")));
+
+    // reserved for address
+    EXPECT_EQ(raw(ByAddr_), raw(Names_.find(Duid2_, Addr_, "anon1.example.com")));
+
+    // anonymous name requested by client
+    EXPECT_EQ(raw(Anon2_), raw(Names_.find(Duid2_, other, "anon2.example.com")));
+
+    // reserved names are not available to others
+    EXPECT_FALSE(Names_.find(Duid2_, other, "duid.example.com"));
+    EXPECT_FALSE(Names_.find(Duid2_, other, "unknown.example.com"));
+
+    // used name is returned to its client only if requested
+    Names_.setUsed(ByDuid_, true);
+    EXPECT_EQ(raw(ByDuid_), raw(Names_.find(Duid1_, other, "duid.example.com")));
+    EXPECT_FALSE(Names_.find(Duid1_, other, "foo.example.com"));
+
+    // used anonymous name is not available
+    Names_.setUsed(Anon2_, true);
+    EXPECT_FALSE(Names_.find(Duid2_, other, "anon2.example.com"));
+
+    EXPECT_EQ(raw(Duid1_), raw(Names_.getByName("duid.example.com")->getDuid()));
+    EXPECT_FALSE(Names_.getByName("unknown.example.com"));
+}
+
+// This test verifies that the pool of anonymous names is maintained.
+TEST_F(FQDNRegistryTest, pool) {
+    EXPECT_EQ(2u, Names_.countFree());
+    EXPECT_EQ(raw(Anon1_), raw(Names_.getFree()));
+
+    Names_.setUsed(Anon1_, true);
+    EXPECT_EQ(raw(Anon2_), raw(Names_.getFree()));
+    Names_.setUsed(Anon2_, true);
+    EXPECT_FALSE(Names_.getFree());
+
+    // configured names stay after release
+    Names_.release(Anon1_);
+    EXPECT_EQ(raw(Anon1_), raw(Names_.getFree()));
+    EXPECT_EQ(4u, Names_.count());
+}
+
+// This test verifies that dynamic names are removed when released and
+// that their number is limited.
+TEST_F(FQDNRegistryTest, dynamic) {
+    Names_.setLimit(2);
+
+    SPtr<TFQDN> dyn1 = new TFQDN(Duid2_, "dyn1.example.com", false);
+    SPtr<TFQDN> dyn2 = new TFQDN(Duid2_, "dyn2.example.com", false);
+    SPtr<TFQDN> dyn3 = new TFQDN(Duid2_, "dyn3.example.com", false);
+    EXPECT_TRUE(Names_.add(dyn1, true));
+    EXPECT_TRUE(Names_.add(dyn2, true));
+    EXPECT_EQ(2u, Names_.countDynamic());
+    EXPECT_EQ(raw(dyn1), raw(Names_.find(Duid2_, SPtr<TIPv6Addr>(), "")));
+
+    // the oldest unused one is evicted
+    Names_.setUsed(dyn2, true);
+    EXPECT_TRUE(Names_.add(dyn3, true));
+    EXPECT_EQ(2u, Names_.countDynamic());
+    EXPECT_FALSE(Names_.getByName("dyn1.example.com"));
+    EXPECT_EQ(raw(dyn2), raw(Names_.getByName("dyn2.example.com")));
+
+    // no room if all are in use
+    Names_.setUsed(dyn3, true);
+    EXPECT_FALSE(Names_.add(dyn1, true));
+
+    // released dynamic name is removed
+    Names_.release(dyn2);
+    EXPECT_FALSE(Names_.getByName("dyn2.example.com"));
+    EXPECT_EQ(1u, Names_.countDynamic());
+    EXPECT_EQ(5u, Names_.count());
+}
+
+// This test verifies that interface assigns names using the registry.
+TEST_F(FQDNRegistryTest, cfgIface) {
+    List(TFQDN) lst;
+    lst.append(ByDuid_);
+    lst.append(Anon1_);
+
+    TSrvCfgIface iface("eth0");
+    EXPECT_FALSE(iface.supportFQDN());
+    iface.setFQDNLst(&lst);
+    EXPECT_TRUE(iface.supportFQDN());
+    EXPECT_EQ(2u, iface.getFQDNRegistry().count());
+
+    EXPECT_EQ(raw(ByDuid_), raw(iface.getFQDNName(Duid1_, Addr_, "")));
+    EXPECT_EQ(raw(Anon1_), raw(iface.getFQDNName(Duid2_, Addr_, "anon1.example.com")));
+
+    // unknown names are rejected by default
+    EXPECT_FALSE(iface.getFQDNName(Duid2_, Addr_, "unknown.example.com"));
+
+    EXPECT_EQ(raw(Duid1_), raw(iface.getFQDNDuid("duid.example.com")));
+    EXPECT_FALSE(iface.getFQDNDuid("anon1.example.com"));
+}
+
+}
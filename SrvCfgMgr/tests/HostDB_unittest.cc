@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string.h>
+#include <unistd.h>
+#include "SrvHostDB.h"
+#include "SrvCfgIface.h"
+#include "DHCPConst.h"
+#include "DHCPDefaults.h"
+
+using namespace std;
+
+namespace {
+
+class HostDBTest : public ::testing::Test {
+public:
+    HostDBTest()
+        :Csv_("testdata/server-hosts.csv"), Bin_("testdata/server-hosts.bin"),
+         Duid1_(new TDUID("00:01:00:00:00:01:02:03:04:05:06:07")),
+         Duid2_(new TDUID("00:01:00:00:00:01:02:03:04:05:06:08")) {
+    }
+
+    ~HostDBTest() {
+        unlink(Csv_.c_str());
+        unlink(Bin_.c_str());
+    }
+
+    bool compile(const string& content) {
+        ofstream csv(Csv_.c_str());
+        csv << content;
+        csv.close();
+        return TSrvHostDB::compile(Csv_, Bin_);
+    }
+
+    static string hosts() {
+        return "# test reservations\n"
+            "duid,00:01:00:00:00:01:02:03:04:05:06:07,2001:db8::10\n"
+            "\n"
+            "remote-id, 5-01:02:03:04, , 2001:db8:1::/48\n"
+            "link-local,fe80::1,2001:db8::11,2001:db8:2::/56\n";
+    }
+
+    static SPtr<TOptVendorData> remoteID(int enterprise, const char* data, int len) {
+        return new TOptVendorData(OPTION_REMOTE_ID, enterprise, (char*)data, len, 0);
+    }
+
+    string Csv_;
+    string Bin_;
+    SPtr<TDUID> Duid1_;
+    SPtr<TDUID> Duid2_;
+};
+
+// This test verifies that reservations are compiled and found by all keys.
+TEST_F(HostDBTest, find) {
+    ASSERT_TRUE(compile(hosts()));
+
+    TSrvHostDB db;
+    ASSERT_TRUE(db.open(Bin_));
+    EXPECT_EQ(3u, db.count());
+
+    SPtr<TSrvCfgOptions> x = db.find(Duid1_, SPtr<TOptVendorData>(), SPtr<TIPv6Addr>());
+    ASSERT_TRUE(x);
+    ASSERT_TRUE(x->getDuid());
+    EXPECT_TRUE(*x->getDuid() == *Duid1_);
+    ASSERT_TRUE(x->getAddr());
+    EXPECT_EQ(string("2001:db8::10"), x->getAddr()->getPlain());
+    EXPECT_FALSE(x->getPrefix());
+
+    EXPECT_FALSE(db.find(Duid2_, SPtr<TOptVendorData>(), SPtr<TIPv6Addr>()));
+
+    const char data[] = { 1, 2, 3, 4 };
+    x = db.find(Duid2_, remoteID(5, data, 4), SPtr<TIPv6Addr>());
+    ASSERT_TRUE(x);
+    ASSERT_TRUE(x->getRemoteID());
+    EXPECT_EQ(5, x->getRemoteID()->getVendor());
+    EXPECT_EQ(4, x->getRemoteID()->getVendorDataLen());
+    EXPECT_FALSE(x->getAddr());
+    ASSERT_TRUE(x->getPrefix());
+    EXPECT_EQ(string("2001:db8:1::"), x->getPrefix()->getPlain());
+    EXPECT_EQ(48, x->getPrefixLen());
+    EXPECT_FALSE(db.find(Duid2_, remoteID(6, data, 4), SPtr<TIPv6Addr>()));
+    EXPECT_FALSE(db.find(Duid2_, remoteID(5, data, 3), SPtr<TIPv6Addr>()));
+
+    x = db.find(Duid2_, SPtr<TOptVendorData>(), new TIPv6Addr("fe80::1", true));
+    ASSERT_TRUE(x);
+    ASSERT_TRUE(x->getClntAddr());
+    EXPECT_EQ(string("fe80::1"), x->getClntAddr()->getPlain());
+
+    // DUID takes precedence
+    x = db.find(Duid1_, remoteID(5, data, 4), new TIPv6Addr("fe80::1", true));
+    ASSERT_TRUE(x);
+    EXPECT_TRUE(x->getDuid());
+
+    EXPECT_TRUE(db.findAddr(new TIPv6Addr("2001:db8::11", true)));
+    EXPECT_FALSE(db.findAddr(new TIPv6Addr("2001:db8::12", true)));
+    x = db.findPrefix(new TIPv6Addr("2001:db8:2::", true));
+    ASSERT_TRUE(x);
+    EXPECT_EQ(56, x->getPrefixLen());
+    EXPECT_FALSE(db.findPrefix(new TIPv6Addr("2001:db8:3::", true)));
+}
+
+// This test verifies that invalid files are rejected.
+TEST_F(HostDBTest, invalid) {
+    EXPECT_FALSE(compile("duid,00:01:0,2001:db8::10\n"));
+    EXPECT_FALSE(compile("duid,00:01:02\n"));
+    EXPECT_FALSE(compile("duid,00:01:02,,\n"));
+    EXPECT_FALSE(compile("mac,00:01:02,2001:db8::10\n"));
+    EXPECT_FALSE(compile("remote-id,01:02,2001:db8::10\n"));
+    EXPECT_FALSE(compile("link-local,fe80::1,,2001:db8::/129\n"));
+
+    // the same address reserved twice
+    EXPECT_FALSE(compile("duid,00:01,2001:db8::10\nduid,00:02,2001:db8::10\n"));
+    EXPECT_FALSE(compile("duid,00:01,2001:db8::10\nduid,00:01,2001:db8::11\n"));
+    EXPECT_EQ(-1, access(Bin_.c_str(), F_OK));
+
+    ofstream bin(Bin_.c_str());
+    bin << "DIBHOSTS but certainly not a database of hosts";
+    bin.close();
+
+    TSrvHostDB db;
+    EXPECT_FALSE(db.open(Bin_));
+    EXPECT_FALSE(db.isOpen());
+    EXPECT_EQ(0u, db.count());
+    EXPECT_FALSE(db.findAddr(new TIPv6Addr("2001:db8::10", true)));
+}
+
+// This test verifies that replaced database is picked up by update().
+TEST_F(HostDBTest, update) {
+    TSrvHostDB db;
+    EXPECT_FALSE(db.open(Bin_));
+    EXPECT_FALSE(db.update(1000));
+
+    // database created after it was opened
+    ASSERT_TRUE(compile(hosts()));
+    EXPECT_FALSE(db.update(1000 + SERVER_HOSTDB_CHECK_INTERVAL - 1));
+    EXPECT_TRUE(db.update(1000 + SERVER_HOSTDB_CHECK_INTERVAL));
+    EXPECT_EQ(3u, db.count());
+
+    // replaced database, the old one is used until update
+    ASSERT_TRUE(compile("duid,00:01:00:00:00:01:02:03:04:05:06:08,2001:db8::20\n"));
+    EXPECT_TRUE(db.find(Duid1_, SPtr<TOptVendorData>(), SPtr<TIPv6Addr>()));
+    EXPECT_TRUE(db.update(2000));
+    EXPECT_EQ(1u, db.count());
+    EXPECT_FALSE(db.find(Duid1_, SPtr<TOptVendorData>(), SPtr<TIPv6Addr>()));
+    EXPECT_TRUE(db.find(Duid2_, SPtr<TOptVendorData>(), SPtr<TIPv6Addr>()));
+
+    // unchanged file is not reloaded
+    EXPECT_FALSE(db.update(3000));
+
+    // invalid file does not replace valid database
+    unlink(Bin_.c_str());
+    ofstream bin(Bin_.c_str());
+    bin << "garbage";
+    bin.close();
+    EXPECT_FALSE(db.update(4000));
+    EXPECT_EQ(1u, db.count());
+}
+
+// This test verifies that interface checks reservations in the database.
+TEST_F(HostDBTest, cfgIface) {
+    ASSERT_TRUE(compile(hosts()));
+
+    TSrvCfgIface iface("eth0");
+    EXPECT_FALSE(iface.getClientException(Duid1_, 0));
+    EXPECT_FALSE(iface.addrReserved(new TIPv6Addr("2001:db8::10", true)));
+
+    ASSERT_TRUE(iface.getHostDB().open(Bin_));
+    SPtr<TSrvCfgOptions> x = iface.getClientException(Duid1_, 0);
+    ASSERT_TRUE(x);
+    EXPECT_EQ(string("2001:db8::10"), x->getAddr()->getPlain());
+    EXPECT_FALSE(iface.getClientException(Duid2_, 0));
+
+    EXPECT_TRUE(iface.addrReserved(new TIPv6Addr("2001:db8::10", true)));
+    EXPECT_FALSE(iface.addrReserved(new TIPv6Addr("2001:db8::12", true)));
+    EXPECT_TRUE(iface.prefixReserved(new TIPv6Addr("2001:db8:2::", true)));
+
+    // prefix reserved for link-local address
+    SPtr<TIPv6Addr> pfx = new TIPv6Addr("2001:db8:2::", true);
+    EXPECT_FALSE(iface.checkReservedPrefix(pfx, Duid2_, SPtr<TOptVendorData>(),
+                                           new TIPv6Addr("fe80::1", true)));
+    EXPECT_TRUE(iface.checkReservedPrefix(pfx, Duid2_, SPtr<TOptVendorData>(),
+                                          new TIPv6Addr("fe80::2", true)));
+    EXPECT_FALSE(iface.checkReservedPrefix(new TIPv6Addr("2001:db8:3::", true), Duid2_,
+                                           SPtr<TOptVendorData>(), SPtr<TIPv6Addr>()));
+}
+
+}
@@ -38,6 +38,7 @@
 #include "AddrClient.h"
 #include "Iface.h"
 #include "OptOptionRequest.h"
+#include "hex.h"
 #include "OptGeneric.h"
 #include "OptVendorData.h"
 #include "OptIAAddress.h"
@@ -359,163 +360,56 @@ SPtr<TSrvMsg> TSrvIfaceMgr::decodeRelayForw(SPtr<TIfaceIface> physicalIface,
                                             SPtr<TIPv6Addr> peer,
                                             char * buf, int bufsize) {
 
-    SPtr<TIPv6Addr> linkAddrTbl[HOP_COUNT_LIMIT];
-    SPtr<TIPv6Addr> peerAddrTbl[HOP_COUNT_LIMIT];
-    int hopTbl[HOP_COUNT_LIMIT];
-    TOptList echoListTbl[HOP_COUNT_LIMIT];
-    int relays=0; // number of nested RELAY_FORW messages
-    SPtr<TOptVendorData> remoteID;
-    SPtr<TOptOptionRequest> echo;
-    SPtr<TOpt> gen;
+    // relay hops are copied once and referenced by offsets, nothing is
+    // allocated per hop (see TSrvRelayChain)
+    TSrvRelayChain relays;
     int ifindex = -1;
 
-    char * relay_buf = buf;
+    const char* relay_buf = buf;
     int relay_bufsize = bufsize;
 
-    for (int j=0;j<HOP_COUNT_LIMIT; j++)
-        echoListTbl[j].clear();
-
     string how_found = "";
 
+    // hop addresses are formatted only if they are going to be logged
+    bool infoEnabled = logger::enabled(logger::LEVEL_INFO);
+    bool noticeEnabled = logger::enabled(logger::LEVEL_NOTICE);
 
     while (bufsize>0 && buf[0]==RELAY_FORW_MSG) {
         /* decode RELAY_FORW message */
-        if (bufsize < 34) {
-            Log(Warning) << "Truncated RELAY_FORW message received." << LogEnd;
+        if (!relays.addHop(buf, bufsize, relay_buf, relay_bufsize)) {
             return SPtr<TSrvMsg>(); // NULL
         }
-
-        SPtr<TSrvOptInterfaceID> ptrIfaceID;
+        int hop = relays.size() - 1;
 
 	how_found = "";
 
-        char type = buf[0];
-        if (type!=RELAY_FORW_MSG)
-            return SPtr<TSrvMsg>(); // NULL
-        int hopCount = buf[1];
-        int optRelayCnt = 0;
-        int optIfaceIDCnt = 0;
-
-        SPtr<TIPv6Addr> linkAddr = new TIPv6Addr(buf+2,false);
-        SPtr<TIPv6Addr> peerAddr = new TIPv6Addr(buf+18, false);
-        buf+=34;
-        bufsize-=34;
-
-        // options: only INTERFACE-ID and RELAY_MSG are allowed
-        while (bufsize>=4) {
-            unsigned short code = readUint16(buf);
-            buf += sizeof(uint16_t);
-            bufsize -= sizeof(uint16_t);
-            int len = readUint16(buf);
-            buf += sizeof(uint16_t);
-            bufsize -= sizeof(uint16_t);
-
-            gen.reset();
-
-            if (len > bufsize) {
-                Log(Warning) << "Truncated option " << code << ": " << bufsize
-                             << " bytes remaining, but length is " << len
-                             << "." << LogEnd;
-                return SPtr<TSrvMsg>(); // NULL
-            }
-
-            switch (code) {
-            case OPTION_INTERFACE_ID:
-                if (bufsize < 1) {
-                    Log(Warning) << "Truncated INTERFACE_ID option (length: " << bufsize
-                                 << ") in RELAY_FORW message. Message dropped." << LogEnd;
-                    return SPtr<TSrvMsg>(); // NULL
-                }
-                ptrIfaceID = new TSrvOptInterfaceID(buf, len, 0);
-                gen = SPtr_cast<TOpt>(ptrIfaceID);
-                optIfaceIDCnt++;
-                break;
-            case OPTION_RELAY_MSG:
-                relay_buf = buf;
-                relay_bufsize = len;
-                optRelayCnt++;
-                break;
-            case OPTION_REMOTE_ID:
-                remoteID = new TOptVendorData(OPTION_REMOTE_ID, buf, len, 0);
-                gen = SPtr_cast<TOpt>(remoteID);
-                break;
-            case OPTION_ERO:
-                Log(Debug) << "Echo Request received in RELAY_FORW." << LogEnd;
-                gen.reset(new TOptOptionRequest(OPTION_ERO, buf, len, 0));
-                break;
-            default:
-                gen.reset(new TOptGeneric(code, buf, len, 0));
-
-            }
-            if (gen) {
-                echoListTbl[relays].push_back(gen);
-            }
-            buf     += len;
-            bufsize -= len;
-        }
-
-#if 0
-        // remember options to be echoed
-        echoListTbl[relays].first();
-        while (gen = echoListTbl[relays].get()) {
-            if (!echo) {
-                Log(Warning) << "Invalid option (" << gen->getOptType()
-                             << ") in RELAY_FORW message was ignored." << LogEnd;
-                echoListTbl[relays].del();
-            } else {
-                if (!echo->isOption(gen->getOptType())) {
-                    Log(Warning) << "Invalid option (" << gen->getOptType()
-                                 << ") in RELAY_FORW message was ignored." << LogEnd;
-                    echoListTbl[relays].del();
-                } else {
-                    Log(Info) << "Option " << gen->getOptType() << " will be echoed back." << LogEnd;
-                }
-            }
-
-        }
-#endif
-
-        // remember those links
-        linkAddrTbl[relays] = linkAddr;
-        peerAddrTbl[relays] = peerAddr;
-        hopTbl[relays] = hopCount;
-        relays++;
-
-        if (relays> HOP_COUNT_LIMIT) {
-            Log(Error) << "Message is nested more than allowed " << HOP_COUNT_LIMIT
-                       << " times. Message dropped." << LogEnd;
-            return SPtr<TSrvMsg>(); // NULL
+        char linkAddr[48] = "";
+        char peerAddr[48] = "";
+        if (infoEnabled) {
+            inet_ntop6(relays.getLinkAddr(hop), linkAddr);
+            inet_ntop6(relays.getPeerAddr(hop), peerAddr);
         }
-
-        if (optRelayCnt!=1) {
-            Log(Error) << optRelayCnt << " RELAY_MSG options received, but exactly one was "
-                       << "expected. Message dropped." << LogEnd;
-            return SPtr<TSrvMsg>(); // NULL
-        }
-        if (optIfaceIDCnt>1) {
-            Log(Error) << "More than one (" << optIfaceIDCnt
-                       << ") interface-ID options received, but exactly 1 was expected. "
-                       << "Message dropped." << LogEnd;
-            return SPtr<TSrvMsg>(); // NULL
-        }
-
-        Log(Info) << "RELAY_FORW was decapsulated: link=" << linkAddr->getPlain()
-                  << ", peer=" << peerAddr->getPlain();
+        Log(Info) << "RELAY_FORW was decapsulated: link=" << linkAddr
+                  << ", peer=" << peerAddr;
 
 	// --- selectSubnet() starts here ---
 
         bool guessMode = SrvCfgMgr().guessMode();
 
         // First try to find a relay based on the interface-id option
-        if (ptrIfaceID) {
-            Log(Cont) << ", interfaceID len=" << ptrIfaceID->getSize() << LogEnd;
-            ifindex = SrvCfgMgr().getRelayByInterfaceID(ptrIfaceID);
+        const char* ifaceID;
+        int ifaceIDLen;
+        if (relays.getInterfaceID(hop, ifaceID, ifaceIDLen)) {
+            Log(Cont) << ", interfaceID len=" << ifaceIDLen + 4 << LogEnd;
+            ifindex = SrvCfgMgr().getRelayByInterfaceID(ifaceID, ifaceIDLen);
             if (ifindex == -1) {
 		Log(Debug) << "Unable to find relay interface with interfaceID="
-			   << ptrIfaceID->getPlain() << " defined on the "
+			   << hexToText((const uint8_t*)ifaceID, ifaceIDLen, true)
+			   << " defined on the "
 			   << physicalIface->getFullName() << " interface." << LogEnd;
             } else {
-		how_found = "using interface-id=" + ptrIfaceID->getPlain();
+		how_found = "using interface-id="
+		    + hexToText((const uint8_t*)ifaceID, ifaceIDLen, true);
 	    }
         } else {
             Log(Cont) << ", no interface-id option." << LogEnd;
@@ -523,12 +417,14 @@ SPtr<TSrvMsg> TSrvIfaceMgr::decodeRelayForw(SPtr<TIfaceIface> physicalIface,
 
         // then try to find a relay based on the link address
         if (ifindex == -1) {
-            ifindex = SrvCfgMgr().getRelayByLinkAddr(linkAddr);
+            ifindex = SrvCfgMgr().getRelayByLinkAddr(relays.getLinkAddr(hop));
 	    if (ifindex == -1) {
                 Log(Info) << "Unable to find relay interface using link address: "
-			  << linkAddr->getPlain() << LogEnd;
-	    } else {
-		how_found = string("using link-addr=") + linkAddr->getPlain();
+			  << linkAddr << LogEnd;
+	    } else if (noticeEnabled) {
+                if (!linkAddr[0])
+                    inet_ntop6(relays.getLinkAddr(hop), linkAddr);
+		how_found = string("using link-addr=") + linkAddr;
             }
         }
 
@@ -543,7 +439,7 @@ SPtr<TSrvMsg> TSrvIfaceMgr::decodeRelayForw(SPtr<TIfaceIface> physicalIface,
 	// --- selectSubnet() ends here ---
 
         // now switch to relay interface
-        buf = relay_buf;
+        buf = (char*)relay_buf;
         bufsize = relay_bufsize;
     }
 
@@ -556,27 +452,31 @@ SPtr<TSrvMsg> TSrvIfaceMgr::decodeRelayForw(SPtr<TIfaceIface> physicalIface,
 		    << " by " << how_found << LogEnd;
     }
 
-    SPtr<TSrvMsg> msg = decodeMsg(ifindex, peer, relay_buf, relay_bufsize);
+    SPtr<TSrvMsg> msg = decodeMsg(ifindex, peer, (char*)relay_buf, relay_bufsize);
     if (!msg) {
         return SPtr<TSrvMsg>(); // NULL
     }
-    for (int i=0; i<relays; i++) {
-        msg->addRelayInfo(linkAddrTbl[i], peerAddrTbl[i], hopTbl[i], echoListTbl[i]);
-    }
     msg->setPhysicalIface(physicalIface->getID());
 
-    if (remoteID) {
-        Log(Debug) << "RemoteID received: vendor=" << remoteID->getVendor()
-                   << ", length=" << remoteID->getVendorDataLen() << "." << LogEnd;
-        msg->setRemoteID(remoteID);
-
-        /// @todo: WTF is that? ----v
-        remoteID.reset();
-        remoteID = msg->getRemoteID();
-        
-        PrintHex("RemoteID:", (uint8_t*)remoteID->getVendorData(), remoteID->getVendorDataLen());
+    // remote-id inserted by the relay closest to the client is used
+    for (int hop = relays.size() - 1; hop >= 0; hop--) {
+        const char* data;
+        int len;
+        if (relays.getOption(hop, OPTION_REMOTE_ID, data, len)) {
+            SPtr<TOptVendorData> remoteID =
+                new TOptVendorData(OPTION_REMOTE_ID, (char*)data, len, 0);
+            Log(Debug) << "RemoteID received: vendor=" << remoteID->getVendor()
+                       << ", length=" << remoteID->getVendorDataLen() << "." << LogEnd;
+            msg->setRemoteID(remoteID);
+
+            PrintHex("RemoteID:", (uint8_t*)remoteID->getVendorData(),
+                     remoteID->getVendorDataLen());
+            break;
+        }
     }
 
+    msg->setRelayChain(relays);
+
     return msg;
  }
 
@@ -821,22 +721,22 @@ void TSrvIfaceMgr::notifyScripts(const std::string& scriptName, SPtr<TMsg> quest
         return;
     }
 
-    const vector<TSrvMsg::RelayInfo> relayInfo = reply->RelayInfo_;
+    const TSrvRelayChain& relays = reply->getRelayChain();
 
     stringstream relaysNum;
-    relaysNum << relayInfo.size();
+    relaysNum << relays.size();
     params->addParam("RELAYS", relaysNum.str());
 
     int cnt = 1;
-    for (vector<TSrvMsg::RelayInfo>::const_reverse_iterator relay = relayInfo.rbegin();
-         relay != relayInfo.rend(); ++relay) {
+    for (int hop = relays.size() - 1; hop >= 0; hop--) {
         stringstream peer;
         stringstream link;
         peer << "RELAY" << cnt << "_PEER";
         link << "RELAY" << cnt << "_LINK";
 
-        params->addParam(peer.str(), relay->PeerAddr_->getPlain());
-        params->addParam(link.str(), relay->LinkAddr_->getPlain());
+        char addr[48];
+        params->addParam(peer.str(), inet_ntop6(relays.getPeerAddr(hop), addr));
+        params->addParam(link.str(), inet_ntop6(relays.getLinkAddr(hop), addr));
 
         cnt++;
     }
@@ -10,6 +10,7 @@
  */
 
 #include <sstream>
+#include <set>
 #include "Portable.h"
 #include "SrvMsg.h"
 #include "OptEmpty.h"
@@ -345,50 +346,101 @@ unsigned long TSrvMsg::getTimeout() {
         return 0;
 }
 
+/// @brief appends relay hop (used in tests and for messages built locally)
+///
+/// @param linkAddr link-address field
+/// @param peerAddr peer-address field
+/// @param hop hop count
+/// @param echolist relay options (interface-id, ERO and options it lists are echoed)
 void TSrvMsg::addRelayInfo(SPtr<TIPv6Addr> linkAddr,
                            SPtr<TIPv6Addr> peerAddr,
                            int hop,
                            const TOptList&  echolist) {
-    RelayInfo info;
-    info.LinkAddr_ = linkAddr;
-    info.PeerAddr_ = peerAddr;
-    info.Hop_      = hop;
-    info.EchoList_ = echolist;
-    info.Len_      = 0; /// @todo: what about this?
-    RelayInfo_.push_back(info);
+    // encode as it would be received: header, options and empty relay-msg
+    size_t len = RELAY_HEADER_LEN + 4;
+    for (TOptList::const_iterator it = echolist.begin(); it != echolist.end(); ++it) {
+        len += (*it)->getSize();
+    }
+    std::vector<char> buf(len);
+    buf[0] = RELAY_FORW_MSG;
+    buf[1] = hop;
+    linkAddr->storeSelf(&buf[2]);
+    peerAddr->storeSelf(&buf[18]);
+    char* ptr = &buf[RELAY_HEADER_LEN];
+    for (TOptList::const_iterator it = echolist.begin(); it != echolist.end(); ++it) {
+        ptr = (*it)->storeSelf(ptr);
+    }
+    ptr = writeUint16(ptr, OPTION_RELAY_MSG);
+    writeUint16(ptr, 0);
+
+    const char* inner;
+    int innerLen;
+    RelayChain_.addHop(&buf[0], len, inner, innerLen);
 }
 
-void TSrvMsg::send(int dstPort /* = 0 */)
+/// @brief sets relay hops the message was received over
+///
+/// @param chain decoded hops (will be left empty)
+void TSrvMsg::setRelayChain(TSrvRelayChain& chain) {
+    RelayChain_.swap(chain);
+}
+
+/// @brief returns decoded relay hops
+///
+/// Addresses and options are decoded for every call, so this is intended
+/// for diagnostics and tests only. Len_ is not set.
+///
+/// @return relay hops, the outermost one first
+std::vector<TSrvMsg::RelayInfo> TSrvMsg::getRelayInfo() const {
+    std::vector<RelayInfo> relays(RelayChain_.size());
+    for (int i = 0; i < RelayChain_.size(); i++) {
+        relays[i].Hop_ = RelayChain_.getHopCount(i);
+        relays[i].LinkAddr_ = new TIPv6Addr(RelayChain_.getLinkAddr(i));
+        relays[i].PeerAddr_ = new TIPv6Addr(RelayChain_.getPeerAddr(i));
+        relays[i].Len_ = 0;
+        relays[i].EchoList_ = RelayChain_.getOptions(i);
+    }
+    return relays;
+}
+
+/// @brief encodes message (with relay headers, if relayed) for transmission
+///
+/// @param data wire format will be stored here
+/// @param ifindex index of the physical interface to send it over
+/// @param port destination port
+///
+/// @return true if successful
+bool TSrvMsg::encode(std::vector<char>& data, int& ifindex, int& port)
 {
-    char* buf = new char[getSize() < 2048? 2048:getSize()];
+    // message size is calculated only once, relay headers are copied as
+    // they were received (see TSrvRelayChain)
+    ESrvIfaceIdOrder order = SrvCfgMgr().getInterfaceIDOrder();
+    size_t len = getSize();
+    size_t bufSize = RelayChain_.getSize(len, order);
+    data.resize(bufSize);
+    char* buf = &data[0];
     int offset = 0;
-    int port;
 
-    SPtr<TOptGeneric> gen;
     SPtr<TIfaceIface> ptrIface;
-    SPtr<TIfaceIface> under;
     ptrIface = SrvIfaceMgr().getIfaceByID(this->Iface);
     if (!ptrIface) {
         SPtr<TSrvCfgIface> cfgIface = SrvCfgMgr().getIfaceByID(this->Iface);
         if (!cfgIface) {
             Log(Error) << "Can't send message: interface with ifindex=" << this->Iface
                        << " not found." << LogEnd;
-            delete [] buf;
-            return;
+            return false;
         }
         if (cfgIface->getRelayID()==-1) {
             Log(Error) << "Can't send message: interface " << cfgIface->getFullName()
                        << " is invalid relay." << LogEnd;
-            delete [] buf;
-            return;
+            return false;
         }
         ptrIface = SrvIfaceMgr().getIfaceByID(cfgIface->getRelayID());
         if (!ptrIface) {
             Log(Error) << "Can't send message: interface " << cfgIface->getFullName()
                        << " has invalid physical interface defined (ifindex="
                        << cfgIface->getRelayID() << "." << LogEnd;
-            delete [] buf;
-            return;
+            return false;
         }
     }
     Log(Notice) << "Sending " << this->getName() << " on " << ptrIface->getFullName()
@@ -397,76 +449,47 @@ void TSrvMsg::send(int dstPort /* = 0 */)
     this->firstOption();
     while (ptrOpt = this->getOption() )
         Log(Cont) << " " << ptrOpt->getOptType();
-    Log(Cont) << ", " << RelayInfo_.size() << " relay(s)." << LogEnd;
+    Log(Cont) << ", " << RelayChain_.size() << " relay(s)." << LogEnd;
 
     port = DHCPCLIENT_PORT;
-    if (!RelayInfo_.empty()) {
+    if (!RelayChain_.empty()) {
         port = DHCPSERVER_PORT;
-        if (RelayInfo_.size() > HOP_COUNT_LIMIT) {
-            Log(Error) << "Unable to send message. Got " << RelayInfo_.size()
-                       << " relay entries (" << HOP_COUNT_LIMIT
-                       << " is allowed maximum." << LogEnd;
-            delete [] buf;
-            return;
-        }
-
-        size_t len = getSize();
-        RelayInfo_.back().Len_ = len;
-
-        for (int i = RelayInfo_.size() - 1; i > 0; i--) {
-
-            SPtr<TOpt> interface_id = TOpt::getOption(RelayInfo_[i].EchoList_, OPTION_INTERFACE_ID);
-            // 38 = 34 bytes (relay header) + 4 bytes (relay-msg option header)
-            RelayInfo_[i-1].Len_ = RelayInfo_[i].Len_ + 38;
-            if (interface_id && (SrvCfgMgr().getInterfaceIDOrder()!=SRV_IFACE_ID_ORDER_NONE)) {
-                RelayInfo_[i-1].Len_ += interface_id->getSize();
-
-                for (TOptList::iterator it = RelayInfo_[i].EchoList_.begin();
-                     it != RelayInfo_[i].EchoList_.end(); ++it) {
-                    RelayInfo_[i-1].Len_ += (*it)->getSize();
-                }
-                //RelayInfo_[i].EchoList_.first();
-                //while (gen = RelayInfo_[i].EchoList_.get()) {
-                //    RelayInfo_[i-1].Len_ += gen->getSize();
-                //}
-
-            }
-
-        }
-
-#if 0
-        // calculate lengths of all relays
-        Len_[Relays_ - 1] = getSize();
-        for (int i = Relays_ - 1; i > 0; i--) {
-            Len_[i-1] = Len_[i] + 38; // 34 bytes (relay header) + 4 bytes (relay-msg option header)
-            if (InterfaceIDTbl_[i] && (SrvCfgMgr().getInterfaceIDOrder()!=SRV_IFACE_ID_ORDER_NONE)) {
-                Len_[i-1] += InterfaceIDTbl_[i]->getSize();
-
-                EchoListTbl_[i].first();
-                while (gen = EchoListTbl_[i].get()) {
-                    Len_[i-1] += gen->getSize();
-                }
 
-            }
+        size_t msgOffset = 0;
+        offset = RelayChain_.storeSelf(buf, len, order,
+                                       forceMsgType_ ? forceMsgType_ : RELAY_REPL_MSG,
+                                       msgOffset);
+        if (storeSelf(buf + msgOffset, len) != static_cast<int>(len)) {
+            return false;
         }
-#endif
-
-        // recursive storeSelf
-        offset += storeSelfRelay(buf, 0, SrvCfgMgr().getInterfaceIDOrder() );
 
-        Log(Debug) << "Sending " << this->getSize() << "(packet)+" << offset
+        Log(Debug) << "Sending " << len << "(packet)+" << (offset - static_cast<int>(len))
                    << "(relay headers) data on the "
                    << ptrIface->getFullName() << " interface." << LogEnd;
     } else {
-        offset += this->storeSelf(buf+offset);
+        offset = this->storeSelf(buf, bufSize);
+        if (offset < 0) {
+            return false;
+        }
     }
 
+    data.resize(offset);
+    ifindex = ptrIface->getID();
+    return true;
+}
+
+void TSrvMsg::send(int dstPort /* = 0 */)
+{
+    std::vector<char> data;
+    int ifindex, port;
+    if (!encode(data, ifindex, port))
+        return;
+
     if (dstPort) {
         port = dstPort;
     }
 
-    SrvIfaceMgr().send(ptrIface->getID(), buf, offset, PeerAddr_, port);
-    delete [] buf;
+    SrvIfaceMgr().send(ifindex, &data[0], data.size(), PeerAddr_, port);
 }
 
 SPtr<TDUID> TSrvMsg::getClientDUID() {
@@ -617,7 +640,7 @@ SPtr<TSrvOptFQDN> TSrvMsg::addFQDN(int iface, SPtr<TSrvOptFQDN> requestFQDN,
         return optFQDN;
     }
 
-    fqdn->setUsed(true);
+    cfgIface->getFQDNRegistry().setUsed(fqdn, true);
 
     int FQDNMode = cfgIface->getFQDNMode();
     Log(Debug) << "FQDN: Adding FQDN Option in REPLY message: " << fqdnName << ", FQDNMode="
@@ -681,7 +704,7 @@ SPtr<TSrvOptFQDN> TSrvMsg::addFQDN(int iface, SPtr<TSrvOptFQDN> requestFQDN,
 
 void TSrvMsg::delFQDN(SPtr<TSrvCfgIface> cfgIface, SPtr<TAddrIA> ptrIA, SPtr<TFQDN> fqdn) {
     string fqdnName = fqdn->getName();
-    fqdn->setUsed(false);
+    cfgIface->getFQDNRegistry().release(fqdn);
 
     SPtr<TIPv6Addr> dns = ptrIA->getFQDNDnsServer();
     if (!dns) {
@@ -726,97 +749,14 @@ bool TSrvMsg::copyClientID(SPtr<TMsg> donor) {
 
 SPtr<TIPv6Addr> TSrvMsg::getClientPeer()
 {
-    if (!RelayInfo_.empty()) {
-       return RelayInfo_[0].PeerAddr_; //first hop ?
-   }
+    if (!RelayChain_.empty()) {
+        return new TIPv6Addr(RelayChain_.getPeerAddr(0)); // first hop ?
+    }
    return PeerAddr_;
 }
 
 void TSrvMsg::copyRelayInfo(SPtr<TSrvMsg> q) {
-    RelayInfo_ = q->RelayInfo_;
-}
-
-
-/**
- * stores message in a buffer, used in relayed messages
- *
- * @param buf buffer for data to be stored
- * @param relayDepth number or current relay level
- * @param order order of the interface-id option (before, after or omit)
- *
- * @return - number of bytes used
- */
-int TSrvMsg::storeSelfRelay(char * buf, uint8_t relayDepth, ESrvIfaceIdOrder order)
-{
-    int offset = 0;
-    if (relayDepth == RelayInfo_.size()) {
-        return storeSelf(buf);
-    }
-    buf[offset++] = forceMsgType_?forceMsgType_:RELAY_REPL_MSG;
-    buf[offset++] = RelayInfo_[relayDepth].Hop_;
-    RelayInfo_[relayDepth].LinkAddr_->storeSelf(buf+offset);
-    RelayInfo_[relayDepth].PeerAddr_->storeSelf(buf+offset+16);
-    offset += 32;
-
-    SPtr<TOpt> interfaceid = TOpt::getOption(RelayInfo_[relayDepth].EchoList_, OPTION_INTERFACE_ID);
-
-    if (order == SRV_IFACE_ID_ORDER_BEFORE)
-    {
-        if (interfaceid) {
-            interfaceid->storeSelf(buf+offset);
-            offset += interfaceid->getSize();
-        }
-    }
-
-    writeUint16((buf+offset), OPTION_RELAY_MSG);
-    offset += sizeof(uint16_t);
-    writeUint16((buf+offset), RelayInfo_[relayDepth].Len_);
-    offset += sizeof(uint16_t);
-
-    offset += storeSelfRelay(buf+offset, relayDepth+1, order);
-
-    if (order == SRV_IFACE_ID_ORDER_AFTER)
-    {
-        if (interfaceid) {
-            interfaceid->storeSelf(buf+offset);
-            offset += interfaceid->getSize();
-        }
-    }
-
-    SPtr<TOpt> echo;
-    for (TOptList::const_iterator it = RelayInfo_[relayDepth].EchoList_.begin();
-         it != RelayInfo_[relayDepth].EchoList_.end(); ++it) {
-        if ((*it)->getOptType() == OPTION_ERO) {
-            echo = *it;
-        }
-    }
-
-    if (echo) {
-        SPtr<TOptOptionRequest> ero = SPtr_cast<TOptOptionRequest>(echo);
-
-        for (TOptList::const_iterator it = RelayInfo_[relayDepth].EchoList_.begin();
-             it != RelayInfo_[relayDepth].EchoList_.end(); ++it) {
-            if (ero->isOption((*it)->getOptType())) {
-                    Log(Debug) << "Echoing back option " << (*it)->getOptType() << ", length "
-                               << (*it)->getSize() << LogEnd;
-                    (*it)->storeSelf(buf+offset);
-                    offset += (*it)->getSize();
-            }
-        }
-    }
-
-#if 0
-    SPtr<TOptGeneric> gen;
-    RelayInfo_[relayDepth].EchoList_.first();
-    while (gen = RelayInfo_[relayDepth].EchoList_.get()) {
-        Log(Debug) << "Echoing back option " << gen->getOptType() << ", length "
-                   << gen->getSize() << LogEnd;
-        gen->storeSelf(buf+offset);
-        offset += gen->getSize();
-    }
-#endif
-
-    return offset;
+    RelayChain_ = q->RelayChain_;
 }
 
 
@@ -989,21 +929,20 @@ bool TSrvMsg::appendRequestedOptions(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr,
     // this option should be checked last
 
     // --- option: forced options first ---
-    TOptList extraOpts; // possible additional options
-    TOptList forcedOpts; // forced (asked for or not, will send them anyway)
-
-    if (ex) {
-        extraOpts = ex->getExtraOptions();
-        forcedOpts = ex->getForcedOptions();
-    }
+    // Extra and forced options are static, so they are appended in their
+    // pre-encoded form (see TSrvCfgOptions::encodeOptions()). Per-client
+    // exception options (if defined) take precedence over interface options.
+    TSrvCfgOptions* extraCfg = &(*ptrIface);
+    TSrvCfgOptions* forcedCfg = extraCfg;
 
-    if (!ex || !extraOpts.size())
-        extraOpts = ptrIface->getExtraOptions();
+    if (ex && ex->getExtraOptions().size())
+        extraCfg = &(*ex);
 
-    if (!ex || !forcedOpts.size())
-        forcedOpts = ptrIface->getForcedOptions();
+    if (ex && ex->getForcedOptions().size())
+        forcedCfg = &(*ex);
 
-    for (TOptList::iterator gen = forcedOpts.begin(); gen!=forcedOpts.end(); ++gen)
+    const TOptList& forcedOpts = forcedCfg->getEncodedForcedOptions();
+    for (TOptList::const_iterator gen = forcedOpts.begin(); gen!=forcedOpts.end(); ++gen)
     {
         Log(Debug) << "Appending mandatory extra option " << (*gen)->getOptType()
                    << " (" << (*gen)->getSize() << ")" << LogEnd;
@@ -1012,9 +951,19 @@ bool TSrvMsg::appendRequestedOptions(SPtr<TDUID> duid, SPtr<TIPv6Addr> addr,
         newOptionAssigned = true;
     }
 
-    for (TOptList::iterator gen = extraOpts.begin(); gen!=extraOpts.end(); ++gen)
+    // walk over client's ORO, so the cost does not depend on the number of
+    // configured options
+    std::set<uint16_t> appended;
+    for (int i = 0; i < reqOpts->count(); ++i)
     {
-        if (reqOpts->isOption( (*gen)->getOptType()))
+        uint16_t type = reqOpts->getReqOpt(i);
+
+        // don't append the same option twice if client requested it twice
+        if (!appended.insert(type).second)
+            continue;
+
+        const TOptList& extraOpts = extraCfg->getEncodedExtraOptions(type);
+        for (TOptList::const_iterator gen = extraOpts.begin(); gen!=extraOpts.end(); ++gen)
         {
             Log(Debug) << "Appending requested extra option " << (*gen)->getOptType()
                        << " (" << (*gen)->getSize() << ")" << LogEnd;
@@ -27,10 +27,12 @@
 #include "SrvOptIA_PD.h"
 #include "OptVendorData.h"
 #include "OptGeneric.h"
+#include "SrvRelayChain.h"
 
 class TSrvMsg : public TMsg
 {
 public:
+    /// @brief Relay hop with decoded fields (see getRelayInfo())
     struct RelayInfo {
         int Hop_;
         SPtr<TIPv6Addr> LinkAddr_;
@@ -60,7 +62,6 @@ public:
     bool validateReplayDetection();
 #endif
 
-    /// @todo: modify this to use RelayInfo structure
     void addRelayInfo(SPtr<TIPv6Addr> linkAddr,
                       SPtr<TIPv6Addr> peerAddr,
                       int hop,
@@ -77,6 +78,7 @@ public:
 
     unsigned long getTimeout();
     void doDuties();
+    bool encode(std::vector<char>& data, int& ifindex, int& port);
     void send(int dstPort = 0);
 
     void processOptions(SPtr<TSrvMsg> clientMsg, bool quiet);
@@ -92,14 +94,16 @@ public:
 
     /// @brief clears relay information (used in testing only)
     void clearRelayInfo() {
-        RelayInfo_.clear();
+        RelayChain_.clear();
     }
 
-    /// @brief Relay information
-    ///
-    /// Let's make this public, so there are issues with reference
-    /// being returned and then used past them message lifetime
-    std::vector<RelayInfo> RelayInfo_;
+    /// @brief returns relay hops this message was received over (in wire format)
+    const TSrvRelayChain& getRelayChain() const {
+        return RelayChain_;
+    }
+
+    void setRelayChain(TSrvRelayChain& chain);
+    std::vector<RelayInfo> getRelayInfo() const;
 
     void setPhysicalIface(int iface);
     int  getPhysicalIface() const;
@@ -130,15 +134,16 @@ protected:
     void delFQDN(SPtr<TSrvCfgIface> cfgIface, SPtr<TAddrIA> ptrIA, SPtr<TFQDN> fqdn);
 
 
-    int storeSelfRelay(char * buf, uint8_t relayLevel, ESrvIfaceIdOrder order);
-
     unsigned long FirstTimeStamp_; // timestamp of first message transmission
     unsigned long MRT_;            // maximum retransmission timeout
 
-    /// @todo: this should be moved to RelayInfo_ structure
+    /// @todo: this should be taken from RelayChain_
     SPtr<TOptVendorData> RemoteID; // this MAY be set, if message was recevied via relay
                                    // AND relay appended RemoteID
 
+    /// relay hops the message was received over (copied to the answer)
+    TSrvRelayChain RelayChain_;
+
     /// used in tests only. If non-zero, send message type is set to that type
     uint8_t forceMsgType_;
 
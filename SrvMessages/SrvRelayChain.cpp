@@ -0,0 +1,334 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <algorithm>
+#include <string.h>
+#include "SrvRelayChain.h"
+#include "Portable.h"
+#include "SrvOptInterfaceID.h"
+#include "OptVendorData.h"
+#include "OptOptionRequest.h"
+#include "OptGeneric.h"
+#include "Logger.h"
+
+using namespace std;
+
+namespace {
+
+/// option groups, in the order they are stored in
+enum {
+    GROUP_INTERFACE_ID = 0,
+    GROUP_ECHO = 1,
+    GROUP_OTHER = 2,
+    GROUP_SKIP = 3
+};
+
+int optionGroup(uint16_t code, const char* ero, int eroLen) {
+    switch (code) {
+    case OPTION_RELAY_MSG:
+        return GROUP_SKIP;
+    case OPTION_INTERFACE_ID:
+        return GROUP_INTERFACE_ID;
+    default:
+        for (int i = 0; i + 1 < eroLen; i += 2) {
+            if (readUint16(ero + i) == code) {
+                return GROUP_ECHO;
+            }
+        }
+        return GROUP_OTHER;
+    }
+}
+
+}
+
+TSrvRelayChain::TSrvRelayChain()
+    :Cnt_(0) {
+}
+
+/// @brief decodes a single RELAY-FORW hop and appends it to the chain
+///
+/// @param buf RELAY-FORW message
+/// @param bufSize length of the RELAY-FORW message
+/// @param inner encapsulated message (content of relay-msg) will be pointed here
+/// @param innerSize length of the encapsulated message will be stored here
+///
+/// @return true if the hop was valid and appended
+bool TSrvRelayChain::addHop(const char* buf, int bufSize,
+                            const char*& inner, int& innerSize) {
+    if (Cnt_ == HOP_COUNT_LIMIT) {
+        Log(Error) << "Message is nested more than allowed " << HOP_COUNT_LIMIT
+                   << " times. Message dropped." << LogEnd;
+        return false;
+    }
+    if (bufSize < RELAY_HEADER_LEN) {
+        Log(Warning) << "Truncated RELAY_FORW message received." << LogEnd;
+        return false;
+    }
+
+    const char* opts = buf + RELAY_HEADER_LEN;
+    int optsLen = bufSize - RELAY_HEADER_LEN;
+    const char* ero = 0;
+    int eroLen = 0;
+    int optRelayCnt = 0;
+    int optIfaceIDCnt = 0;
+
+    // options: exactly one RELAY_MSG, at most one INTERFACE_ID
+    for (int pos = 0; pos + 4 <= optsLen; ) {
+        uint16_t code = readUint16(opts + pos);
+        int len = readUint16(opts + pos + 2);
+        pos += 4;
+        if (len > optsLen - pos) {
+            Log(Warning) << "Truncated option " << code << ": " << optsLen - pos
+                         << " bytes remaining, but length is " << len
+                         << "." << LogEnd;
+            return false;
+        }
+
+        switch (code) {
+        case OPTION_INTERFACE_ID:
+            if (len < 1) {
+                Log(Warning) << "Truncated INTERFACE_ID option (length: " << len
+                             << ") in RELAY_FORW message. Message dropped." << LogEnd;
+                return false;
+            }
+            optIfaceIDCnt++;
+            break;
+        case OPTION_RELAY_MSG:
+            inner = opts + pos;
+            innerSize = len;
+            optRelayCnt++;
+            break;
+        case OPTION_ERO:
+            Log(Debug) << "Echo Request received in RELAY_FORW." << LogEnd;
+            ero = opts + pos;
+            eroLen = len;
+            break;
+        default:
+            break;
+        }
+        pos += len;
+    }
+
+    if (optRelayCnt != 1) {
+        Log(Error) << optRelayCnt << " RELAY_MSG options received, but exactly one was "
+                   << "expected. Message dropped." << LogEnd;
+        return false;
+    }
+    if (optIfaceIDCnt > 1) {
+        Log(Error) << "More than one (" << optIfaceIDCnt
+                   << ") interface-ID options received, but exactly 1 was expected. "
+                   << "Message dropped." << LogEnd;
+        return false;
+    }
+
+    THop& hop = Hops_[Cnt_];
+    hop.Offset_ = Buf_.size();
+    Buf_.insert(Buf_.end(), buf, buf + RELAY_HEADER_LEN);
+
+    size_t start = Buf_.size();
+    appendOptions(opts, optsLen, GROUP_INTERFACE_ID, ero, eroLen);
+    hop.IfaceIdLen_ = Buf_.size() - start;
+
+    start = Buf_.size();
+    appendOptions(opts, optsLen, GROUP_ECHO, ero, eroLen);
+    hop.EchoLen_ = Buf_.size() - start;
+
+    appendOptions(opts, optsLen, GROUP_OTHER, ero, eroLen);
+    hop.OptsLen_ = Buf_.size() - hop.Offset_ - RELAY_HEADER_LEN;
+
+    Cnt_++;
+    return true;
+}
+
+/// @brief copies options of the specified group (already validated) to the buffer
+void TSrvRelayChain::appendOptions(const char* buf, int bufSize, int group,
+                                   const char* ero, int eroLen) {
+    for (int pos = 0; pos + 4 <= bufSize; ) {
+        int len = readUint16(buf + pos + 2) + 4;
+        if (optionGroup(readUint16(buf + pos), ero, eroLen) == group) {
+            Buf_.insert(Buf_.end(), buf + pos, buf + pos + len);
+        }
+        pos += len;
+    }
+}
+
+void TSrvRelayChain::clear() {
+    Buf_.clear();
+    Cnt_ = 0;
+}
+
+void TSrvRelayChain::swap(TSrvRelayChain& other) {
+    Buf_.swap(other.Buf_);
+    for (int i = 0; i < max(Cnt_, other.Cnt_); i++) {
+        std::swap(Hops_[i], other.Hops_[i]);
+    }
+    std::swap(Cnt_, other.Cnt_);
+}
+
+uint8_t TSrvRelayChain::getHopCount(int hop) const {
+    return Buf_[Hops_[hop].Offset_ + 1];
+}
+
+/// @brief returns link-address field of the specified hop (16 bytes, packed)
+const char* TSrvRelayChain::getLinkAddr(int hop) const {
+    return &Buf_[Hops_[hop].Offset_ + 2];
+}
+
+/// @brief returns peer-address field of the specified hop (16 bytes, packed)
+const char* TSrvRelayChain::getPeerAddr(int hop) const {
+    return &Buf_[Hops_[hop].Offset_ + 18];
+}
+
+/// @brief returns content of the interface-id option of the specified hop
+///
+/// @param hop hop index (0 is the outermost one)
+/// @param data content of the option will be pointed here
+/// @param len length of the content will be stored here
+///
+/// @return true if the hop included interface-id
+bool TSrvRelayChain::getInterfaceID(int hop, const char*& data, int& len) const {
+    if (!Hops_[hop].IfaceIdLen_) {
+        return false;
+    }
+    data = &Buf_[Hops_[hop].Offset_ + RELAY_HEADER_LEN + 4];
+    len = Hops_[hop].IfaceIdLen_ - 4;
+    return true;
+}
+
+/// @brief returns content of the first option of specified type in the hop
+///
+/// @param hop hop index (0 is the outermost one)
+/// @param code option type
+/// @param data content of the option will be pointed here
+/// @param len length of the content will be stored here
+///
+/// @return true if the option was found
+bool TSrvRelayChain::getOption(int hop, uint16_t code, const char*& data, int& len) const {
+    const char* opts = &Buf_[0] + Hops_[hop].Offset_ + RELAY_HEADER_LEN;
+    for (uint32_t pos = 0; pos + 4 <= Hops_[hop].OptsLen_; ) {
+        int optLen = readUint16(opts + pos + 2);
+        if (readUint16(opts + pos) == code) {
+            data = opts + pos + 4;
+            len = optLen;
+            return true;
+        }
+        pos += optLen + 4;
+    }
+    return false;
+}
+
+/// @brief builds option objects of the specified hop
+///
+/// This is slow, it is intended for diagnostics and tests only.
+///
+/// @param hop hop index (0 is the outermost one)
+///
+/// @return list of options (interface-id first, relay-msg excluded)
+TOptList TSrvRelayChain::getOptions(int hop) const {
+    TOptList opts;
+    const char* buf = &Buf_[0] + Hops_[hop].Offset_ + RELAY_HEADER_LEN;
+    for (uint32_t pos = 0; pos + 4 <= Hops_[hop].OptsLen_; ) {
+        uint16_t code = readUint16(buf + pos);
+        int len = readUint16(buf + pos + 2);
+        char* data = (char*)buf + pos + 4;
+        switch (code) {
+        case OPTION_INTERFACE_ID:
+            opts.push_back(new TSrvOptInterfaceID(data, len, 0));
+            break;
+        case OPTION_REMOTE_ID:
+            opts.push_back(new TOptVendorData(OPTION_REMOTE_ID, data, len, 0));
+            break;
+        case OPTION_ERO:
+            opts.push_back(new TOptOptionRequest(OPTION_ERO, data, len, 0));
+            break;
+        default:
+            opts.push_back(new TOptGeneric(code, data, len, 0));
+        }
+        pos += len + 4;
+    }
+    return opts;
+}
+
+/// @brief returns length of the message encapsulated in all hops
+///
+/// @param msgLen length of the encapsulated message
+/// @param order order of the interface-id option (before, after or omit)
+///
+/// @return length of the outermost RELAY-REPL
+size_t TSrvRelayChain::getSize(size_t msgLen, ESrvIfaceIdOrder order) const {
+    size_t len = msgLen;
+    for (int i = 0; i < Cnt_; i++) {
+        // 38 = 34 bytes (relay header) + 4 bytes (relay-msg option header)
+        len += RELAY_HEADER_LEN + 4 + Hops_[i].EchoLen_;
+        if (order != SRV_IFACE_ID_ORDER_NONE) {
+            len += Hops_[i].IfaceIdLen_;
+        }
+    }
+    return len;
+}
+
+/// @brief stores relay headers, leaving space for the encapsulated message
+///
+/// Headers are copied as received, only the message type is replaced.
+/// Interface-id and options requested in the ERO are echoed back.
+///
+/// @param buf buffer (at least getSize(msgLen, order) bytes long)
+/// @param msgLen length of the encapsulated message
+/// @param order order of the interface-id option (before, after or omit)
+/// @param msgType type of the relay messages (RELAY-REPL)
+/// @param msgOffset offset of the encapsulated message will be stored here
+///
+/// @return number of bytes used (including the encapsulated message)
+size_t TSrvRelayChain::storeSelf(char* buf, size_t msgLen, ESrvIfaceIdOrder order,
+                                 uint8_t msgType, size_t& msgOffset) const {
+    bool ifaceId = (order != SRV_IFACE_ID_ORDER_NONE);
+
+    // content length of relay-msg in each hop, computed from the inside
+    size_t lens[HOP_COUNT_LIMIT];
+    size_t len = msgLen;
+    for (int i = Cnt_ - 1; i >= 0; i--) {
+        lens[i] = len;
+        len += RELAY_HEADER_LEN + 4 + Hops_[i].EchoLen_ + (ifaceId ? Hops_[i].IfaceIdLen_ : 0);
+    }
+
+    size_t offset = 0;
+    for (int i = 0; i < Cnt_; i++) {
+        const char* hop = &Buf_[Hops_[i].Offset_];
+        memcpy(buf + offset, hop, RELAY_HEADER_LEN);
+        buf[offset] = msgType;
+        offset += RELAY_HEADER_LEN;
+
+        if (order == SRV_IFACE_ID_ORDER_BEFORE && Hops_[i].IfaceIdLen_) {
+            memcpy(buf + offset, hop + RELAY_HEADER_LEN, Hops_[i].IfaceIdLen_);
+            offset += Hops_[i].IfaceIdLen_;
+        }
+
+        writeUint16(buf + offset, OPTION_RELAY_MSG);
+        writeUint16(buf + offset + 2, lens[i]);
+        offset += 4;
+    }
+
+    msgOffset = offset;
+    offset += msgLen;
+
+    for (int i = Cnt_ - 1; i >= 0; i--) {
+        const char* hop = &Buf_[Hops_[i].Offset_];
+        if (order == SRV_IFACE_ID_ORDER_AFTER && Hops_[i].IfaceIdLen_) {
+            memcpy(buf + offset, hop + RELAY_HEADER_LEN, Hops_[i].IfaceIdLen_);
+            offset += Hops_[i].IfaceIdLen_;
+        }
+        if (Hops_[i].EchoLen_) {
+            memcpy(buf + offset, hop + RELAY_HEADER_LEN + Hops_[i].IfaceIdLen_,
+                   Hops_[i].EchoLen_);
+            offset += Hops_[i].EchoLen_;
+        }
+    }
+
+    return offset;
+}
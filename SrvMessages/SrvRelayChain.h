@@ -0,0 +1,80 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVRELAYCHAIN_H
+#define SRVRELAYCHAIN_H
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include "DHCPConst.h"
+#include "Opt.h"
+#include "SrvParsGlobalOpt.h"
+
+/// length of the RELAY-FORW/RELAY-REPL header (type, hop count, link and peer addresses)
+#define RELAY_HEADER_LEN 34
+
+/// @brief Relay headers of a relayed message, kept in wire format.
+///
+/// Every RELAY-FORW hop is copied once, as it was received: its header
+/// followed by its options (except relay-msg). Options are grouped, so
+/// interface-id goes first, then options listed in the ERO (to be echoed
+/// back), then everything else (e.g. remote-id or the ERO itself). When the
+/// reply is encapsulated, those byte ranges are copied back verbatim, so
+/// relay options are never parsed into objects or re-encoded.
+///
+/// Hops are stored from the outermost one (sent by the relay closest to
+/// the server) to the innermost one (closest to the client). All hops share
+/// a single buffer.
+class TSrvRelayChain
+{
+  public:
+    TSrvRelayChain();
+
+    bool addHop(const char* buf, int bufSize, const char*& inner, int& innerSize);
+    void clear();
+    void swap(TSrvRelayChain& other);
+
+    bool empty() const { return Cnt_ == 0; }
+    int size() const { return Cnt_; }
+
+    uint8_t getHopCount(int hop) const;
+    const char* getLinkAddr(int hop) const;
+    const char* getPeerAddr(int hop) const;
+    bool getInterfaceID(int hop, const char*& data, int& len) const;
+    bool getOption(int hop, uint16_t code, const char*& data, int& len) const;
+    TOptList getOptions(int hop) const;
+
+    /// @brief returns all hops (headers and options) as stored
+    ///
+    /// Used as a compact identification of the relay path.
+    const char* data() const { return Buf_.empty() ? 0 : &Buf_[0]; }
+    size_t length() const { return Buf_.size(); }
+
+    size_t getSize(size_t msgLen, ESrvIfaceIdOrder order) const;
+    size_t storeSelf(char* buf, size_t msgLen, ESrvIfaceIdOrder order,
+                     uint8_t msgType, size_t& msgOffset) const;
+
+  private:
+    /// single hop, offsets point to Buf_
+    struct THop {
+        uint32_t Offset_;     ///< relay header
+        uint32_t IfaceIdLen_; ///< interface-id option (follows the header)
+        uint32_t EchoLen_;    ///< options to be echoed back (follow interface-id)
+        uint32_t OptsLen_;    ///< all options of this hop
+    };
+
+    void appendOptions(const char* buf, int bufSize, int group, const char* ero, int eroLen);
+
+    std::vector<char> Buf_;
+    THop Hops_[HOP_COUNT_LIMIT];
+    int Cnt_;
+};
+
+#endif
@@ -602,10 +602,9 @@ List(TIPv6Addr) TSrvOptIA_PD::getFreePrefixes(SPtr<TSrvMsg> clientMsg, SPtr<TIPv
                 } else {
 
                     // case 3: hint is used, but we can assign another prefix from the same pool
-                    do {
-                        prefix=ptrPD->getRandomPrefix();
-                    } while (!SrvAddrMgr().prefixIsFree(prefix));
-                    lst.append(prefix);
+                    lst = allocPrefixes(ptrPD, true);
+                    if (!lst.count())
+                        return lst;
 
                     this->PDLength = ptrPD->getPD_Length();
                     this->Prefered = ptrPD->getPrefered(this->Prefered);
@@ -635,27 +634,66 @@ List(TIPv6Addr) TSrvOptIA_PD::getFreePrefixes(SPtr<TSrvMsg> clientMsg, SPtr<TIPv
         return lst;  // return empty list
     }
 
+    lst = allocPrefixes(ptrPD, false);
+    if (lst.count()) {
+        this->PDLength = ptrPD->getPD_Length();
+        this->Prefered = ptrPD->getPrefered(this->Prefered);
+        this->Valid    = ptrPD->getValid(this->Valid);
+        T1_       = ptrPD->getT1(T1_);
+        T2_       = ptrPD->getT2(T2_);
+    }
+    return lst;
+}
+
+/// @brief finds free prefixes in a PD class
+///
+/// Free prefixes are tracked by the class itself, so this does not depend on
+/// the pool size. Candidates are verified against leases and reservations.
+/// If a candidate turns out to be leased, it is marked as used, so it is not
+/// tried again. Reserved candidates are skipped, but stay free.
+///
+/// @param pd PD class
+/// @param firstPoolOnly return only prefix from the first pool (one from each pool otherwise)
+///
+/// @return list of free prefixes (empty, if the class is exhausted)
+List(TIPv6Addr) TSrvOptIA_PD::allocPrefixes(SPtr<TSrvCfgPD> pd, bool firstPoolOnly) {
+    List(TIPv6Addr) lst;
+    SPtr<TIPv6Addr> prefix;
+    uint64_t index;
+
     int attempts = SERVER_MAX_PD_RANDOM_TRIES;
     while (attempts--) {
-        List(TIPv6Addr) lst;
-        lst = ptrPD->getRandomList();
+        if (!pd->getFreeIndex(index)) {
+            Log(Warning) << "PD: All prefixes in class " << pd->getID() << " are used."
+                         << LogEnd;
+            break;
+        }
+
+        lst.clear();
+        if (firstPoolOnly)
+            lst.append(pd->getPrefix(index));
+        else
+            lst = pd->getPrefixList(index);
+
+        bool leased = false;
+        bool reserved = false;
         lst.first();
-        bool allFree = true;
         while (prefix = lst.get()) {
-            if (!SrvAddrMgr().prefixIsFree(prefix) || SrvCfgMgr().prefixReserved(prefix)) {
-                allFree = false;
+            if (!SrvAddrMgr().prefixIsFree(prefix)) {
+                leased = true;
+                break;
             }
+            if (SrvCfgMgr().prefixReserved(prefix))
+                reserved = true;
         }
-        if (allFree) {
-            this->PDLength = ptrPD->getPD_Length();
-            this->Prefered = ptrPD->getPrefered(this->Prefered);
-            this->Valid    = ptrPD->getValid(this->Valid);
-            T1_       = ptrPD->getT1(T1_);
-            T2_       = ptrPD->getT2(T2_);
+        if (!leased && !reserved)
             return lst;
-        }
-    };
 
-    // failed to find available prefixes after 100 attempts. Return empty list
+        // leased by someone else, don't try it again. Reserved prefixes are
+        // not leased, so they stay free.
+        if (leased)
+            pd->markUsed(index);
+    }
+
     return List(TIPv6Addr)();
 }
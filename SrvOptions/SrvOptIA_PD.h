@@ -53,6 +53,7 @@ class TSrvOptIA_PD : public TOptIA_PD
     bool assignFixedLease(SPtr<TSrvOptIA_PD> request);
 
     List(TIPv6Addr) getFreePrefixes(SPtr<TSrvMsg> clientMsg, SPtr<TIPv6Addr> hint);
+    List(TIPv6Addr) allocPrefixes(SPtr<TSrvCfgPD> pd, bool firstPoolOnly);
 
     uint32_t Prefered;
     uint32_t Valid;
@@ -29,9 +29,22 @@
  */
 bool TSrvOptInterfaceID::operator==(const TSrvOptInterfaceID &other) const
 {
-    if (DataLen != other.DataLen)
+    return isEqual(other.Data, other.DataLen);
+}
+
+/** 
+ * compares interface-id with content of the option in wire format
+ * 
+ * @param data content of the interface-id option
+ * @param len length of the content
+ * 
+ * @return true, if interface-id has the same value
+ */
+bool TSrvOptInterfaceID::isEqual(const char* data, int len) const
+{
+    if (DataLen != len)
 	return false;
-    if (!memcmp(Data, other.Data, DataLen))
+    if (!memcmp(Data, data, DataLen))
 	return true;
     return false;
 }
@@ -17,6 +17,7 @@ class TSrvOptInterfaceID : public TOptGeneric
 
   public:
     bool operator==(const TSrvOptInterfaceID &other) const;
+    bool isEqual(const char* data, int len) const;
     TSrvOptInterfaceID(int id, TMsg * parent);
     TSrvOptInterfaceID(const char * buf,  int n, TMsg* parent);
     bool doDuties();
@@ -112,10 +112,10 @@ size_t TSrvOptLQClientData::getSize()
 
 char* TSrvOptLQClientData::storeSelf(char* buf)
 {
-    buf = writeUint16(buf, OptType);
-    buf = writeUint16(buf, getSize()-4);
+    char* start = buf;
+    buf = storeHeaderType(buf);
     buf = storeSubOpt(buf);
-    return buf;
+    return storeLength(start, buf);
 }
 
 bool TSrvOptLQClientData::doDuties()
@@ -0,0 +1,306 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <string.h>
+#include <time.h>
+#include "SrvAdmission.h"
+#include "DHCPConst.h"
+#include "DHCPDefaults.h"
+#include "Logger.h"
+
+using namespace std;
+
+namespace {
+
+/// names of priorities, used in the log
+const char* PrioNames[TSrvAdmission::PRIO_COUNT] = {
+    "RENEW/REBIND", "REQUEST", "INF-REQUEST", "SOLICIT"
+};
+
+}
+
+TSrvAdmission::TSrvAdmission()
+    :Count_(0), MaxSize_(SERVER_ADMISSION_QUEUE), MaxDelay_(SERVER_ADMISSION_SOLICIT_DELAY),
+     Overload_(SERVER_ADMISSION_OVERLOAD), LastReport_(0) {
+    ClientRate_.perSecond = SERVER_ADMISSION_CLIENT_RATE;
+    ClientRate_.burst = SERVER_ADMISSION_CLIENT_BURST;
+    RelayRate_.perSecond = SERVER_ADMISSION_RELAY_RATE;
+    RelayRate_.burst = SERVER_ADMISSION_RELAY_BURST;
+    memset(Stats_, 0, sizeof(Stats_));
+    memset(Reported_, 0, sizeof(Reported_));
+}
+
+/// @brief returns priority of a message type
+///
+/// @param msgType message type (of the client's message, not RELAY-FORW)
+///
+/// @return priority (see EPriority)
+int TSrvAdmission::getPriority(int msgType) {
+    switch (msgType) {
+    case RENEW_MSG:
+    case REBIND_MSG:
+    case RELEASE_MSG:
+    case DECLINE_MSG:
+    case CONFIRM_MSG:
+        return PRIO_BOUND;
+    case REQUEST_MSG:
+        return PRIO_REQUEST;
+    case SOLICIT_MSG:
+        return PRIO_SOLICIT;
+    default:
+        return PRIO_INFO;
+    }
+}
+
+/// @brief returns current time (in msec), not affected by clock changes
+uint64_t TSrvAdmission::now() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    return (uint64_t)time(NULL) * 1000;
+}
+
+/// @brief sets maximum number of queued messages (all priorities)
+void TSrvAdmission::setQueueLimit(size_t maxSize) {
+    MaxSize_ = maxSize;
+}
+
+/// @brief sets rate limit of a single client
+///
+/// @param perSecond messages per second (0 - unlimited)
+/// @param burst number of messages accepted at once
+void TSrvAdmission::setClientRate(unsigned int perSecond, unsigned int burst) {
+    ClientRate_.perSecond = perSecond;
+    ClientRate_.burst = burst;
+    Clients_.clear();
+}
+
+/// @brief sets rate limit of a single relay
+///
+/// @param perSecond messages per second (0 - unlimited)
+/// @param burst number of messages accepted at once
+void TSrvAdmission::setRelayRate(unsigned int perSecond, unsigned int burst) {
+    RelayRate_.perSecond = perSecond;
+    RelayRate_.burst = burst;
+    Relays_.clear();
+}
+
+/// @brief sets how long SOLICIT may wait in the queue
+///
+/// @param msec maximum delay (in msec, 0 - unlimited)
+void TSrvAdmission::setMaxDelay(unsigned int msec) {
+    MaxDelay_ = msec;
+}
+
+/// @brief sets when the server is considered overloaded
+///
+/// Rate limits are enforced only while the server is overloaded, i.e. when
+/// at least specified number of messages is queued or the oldest queued
+/// SOLICIT waited longer than allowed (see setMaxDelay()).
+///
+/// @param queued number of queued messages (0 - rate limits always apply)
+void TSrvAdmission::setOverload(size_t queued) {
+    Overload_ = queued;
+}
+
+/// @brief checks if rate limits should be enforced
+bool TSrvAdmission::overloaded(uint64_t now) const {
+    if (Count_ >= Overload_)
+        return true;
+    const deque<TQueued>& solicits = Queues_[PRIO_SOLICIT];
+    return MaxDelay_ && !solicits.empty() && now - solicits.front().received > MaxDelay_;
+}
+
+/// @brief takes a token from the bucket of specified key
+///
+/// @return true if there was a token (message may be accepted)
+bool TSrvAdmission::take(TBucketMap& buckets, const std::string& key,
+                         const TRate& rate, uint64_t now) {
+    if (!rate.perSecond)
+        return true;
+
+    uint64_t full = (uint64_t)rate.burst * 1000;
+    TBucketMap::iterator it = buckets.find(key);
+    if (it == buckets.end()) {
+        if (buckets.size() >= SERVER_ADMISSION_BUCKETS)
+            prune(buckets, rate, now);
+        TBucket& bucket = buckets[key];
+        bucket.tokens = full;
+        bucket.updated = now;
+        it = buckets.find(key);
+    }
+
+    TBucket& bucket = it->second;
+    if (now > bucket.updated) {
+        bucket.tokens += (now - bucket.updated) * rate.perSecond;
+        if (bucket.tokens > full)
+            bucket.tokens = full;
+        bucket.updated = now;
+    }
+    if (bucket.tokens < 1000)
+        return false;
+    bucket.tokens -= 1000;
+    return true;
+}
+
+/// @brief removes buckets that are full again (nothing to remember about them)
+void TSrvAdmission::prune(TBucketMap& buckets, const TRate& rate, uint64_t now) {
+    uint64_t full = (uint64_t)rate.burst * 1000;
+    for (TBucketMap::iterator it = buckets.begin(); it != buckets.end(); ) {
+        const TBucket& bucket = it->second;
+        if (bucket.tokens + (now - bucket.updated) * rate.perSecond >= full)
+            buckets.erase(it++);
+        else
+            ++it;
+    }
+
+    // still too many active clients, start over
+    if (buckets.size() >= SERVER_ADMISSION_BUCKETS)
+        buckets.clear();
+}
+
+/// @brief queues a received message
+///
+/// @param msg message received (relay headers are already decoded)
+/// @param now current time (in msec, see now())
+///
+/// @return true if the message was queued, false if it was dropped
+bool TSrvAdmission::enqueue(SPtr<TSrvMsg> msg, uint64_t now) {
+    int prio = getPriority(msg->getType());
+    Stats_[prio].received++;
+
+    // new SOLICITs would not be processed in time anyway
+    if (prio == PRIO_SOLICIT && MaxDelay_ && !Queues_[prio].empty() &&
+        now - Queues_[prio].front().received > MaxDelay_) {
+        Stats_[prio].delay++;
+        return false;
+    }
+
+    if (overloaded(now)) {
+        if (!msg->getRelayChain().empty()) {
+            SPtr<TIPv6Addr> relay = msg->getRemoteAddr();
+            string key = relay ? string(relay->getAddr(), 16) : string();
+            if (!take(Relays_, key, RelayRate_, now)) {
+                Stats_[prio].relay++;
+                return false;
+            }
+        }
+
+        SPtr<TDUID> duid = msg->getClientDUID();
+        string key;
+        if (duid)
+            key.assign(duid->get(), duid->getLen());
+        else if (msg->getRemoteAddr())
+            key.assign(msg->getRemoteAddr()->getAddr(), 16);
+        if (!take(Clients_, key, ClientRate_, now)) {
+            Stats_[prio].client++;
+            return false;
+        }
+    }
+
+    if (Count_ >= MaxSize_) {
+        // make room by dropping the newest less important message
+        int victim = PRIO_COUNT - 1;
+        while (victim > prio && Queues_[victim].empty())
+            victim--;
+        if (victim == prio) {
+            Stats_[prio].full++;
+            return false;
+        }
+        Queues_[victim].pop_back();
+        Count_--;
+        Stats_[victim].full++;
+    }
+
+    TQueued queued;
+    queued.msg = msg;
+    queued.received = now;
+    Queues_[prio].push_back(queued);
+    Count_++;
+    return true;
+}
+
+/// @brief returns the most important queued message
+///
+/// SOLICITs that waited too long are dropped.
+///
+/// @param now current time (in msec, see now())
+///
+/// @return message to be processed (or NULL if there is none)
+SPtr<TSrvMsg> TSrvAdmission::dequeue(uint64_t now) {
+    for (int prio = 0; prio < PRIO_COUNT; prio++) {
+        deque<TQueued>& queue = Queues_[prio];
+        while (!queue.empty()) {
+            TQueued queued = queue.front();
+            queue.pop_front();
+            Count_--;
+            if (prio == PRIO_SOLICIT && MaxDelay_ && now - queued.received > MaxDelay_) {
+                Stats_[prio].delay++;
+                continue;
+            }
+            Stats_[prio].processed++;
+            return queued.msg;
+        }
+    }
+    return SPtr<TSrvMsg>();
+}
+
+size_t TSrvAdmission::count() const {
+    return Count_;
+}
+
+const TSrvAdmission::TStats& TSrvAdmission::getStats(int prio) const {
+    return Stats_[prio];
+}
+
+/// @brief returns number of dropped messages of specified priority
+unsigned long TSrvAdmission::dropped(int prio) const {
+    const TStats& stats = Stats_[prio];
+    return stats.client + stats.relay + stats.delay + stats.full;
+}
+
+/// @brief logs messages dropped since the last report
+///
+/// Nothing is logged unless messages were dropped. Reports are logged at
+/// most every SERVER_ADMISSION_REPORT seconds.
+///
+/// @param now current time (in msec, see now())
+/// @param force log the report now (e.g. when server shuts down)
+void TSrvAdmission::report(uint64_t now, bool force /* = false */) {
+    if (!force && now - LastReport_ < SERVER_ADMISSION_REPORT * 1000)
+        return;
+
+    bool any = false;
+    for (int prio = 0; prio < PRIO_COUNT; prio++) {
+        if (dropped(prio) != Reported_[prio])
+            any = true;
+    }
+    if (!any)
+        return;
+    LastReport_ = now;
+
+    Log(Warning) << "Server overloaded, messages dropped since the last report "
+                 << "(totals: client rate/relay rate/delay/queue full):";
+    for (int prio = 0; prio < PRIO_COUNT; prio++) {
+        const TStats& stats = Stats_[prio];
+        Log(Cont) << " " << PrioNames[prio] << " " << dropped(prio) - Reported_[prio]
+                  << " of " << stats.received << " (" << stats.client << "/" << stats.relay
+                  << "/" << stats.delay << "/" << stats.full << ")";
+        Reported_[prio] = dropped(prio);
+    }
+    Log(Cont) << "." << LogEnd;
+}
+
+void TSrvAdmission::clear() {
+    for (int prio = 0; prio < PRIO_COUNT; prio++)
+        Queues_[prio].clear();
+    Count_ = 0;
+    Clients_.clear();
+    Relays_.clear();
+}
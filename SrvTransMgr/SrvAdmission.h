@@ -0,0 +1,130 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVADMISSION_H
+#define SRVADMISSION_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include "SmartPtr.h"
+#include "SrvMsg.h"
+
+/// @brief Admission control for received messages.
+///
+/// Messages are not processed in the order they were received. They are
+/// queued per priority and the most important one is processed first:
+///
+/// - RENEW, REBIND, RELEASE, DECLINE and CONFIRM (clients that already
+///   have leases and will lose them if not answered),
+/// - REQUEST (clients that completed the SOLICIT/ADVERTISE exchange),
+/// - INFORMATION-REQUEST,
+/// - SOLICIT.
+///
+/// When the server is overloaded (e.g. after a mass outage), messages are
+/// shed before any work is done on them:
+///
+/// - every client (DUID) and every relay (its address) has a token bucket,
+///   messages over the rate are dropped. Buckets are charged only while
+///   the server is overloaded (see setOverload()), an idle server accepts
+///   any rate,
+/// - SOLICIT that waited longer than the configured delay is dropped (the
+///   client has retransmitted it already). New SOLICITs are dropped as
+///   long as the oldest queued one is late,
+/// - when the queues are full, the newest message with the lowest priority
+///   is dropped.
+///
+/// Every dropped message is counted per message type and reason, and
+/// summarized in the log (see report()).
+class TSrvAdmission
+{
+  public:
+    /// message priorities, the lower the more important
+    enum EPriority {
+        PRIO_BOUND = 0,    // RENEW, REBIND, RELEASE, DECLINE, CONFIRM
+        PRIO_REQUEST = 1,  // REQUEST
+        PRIO_INFO = 2,     // INFORMATION-REQUEST
+        PRIO_SOLICIT = 3,  // SOLICIT
+        PRIO_COUNT = 4
+    };
+
+    /// counters of a single priority
+    struct TStats {
+        unsigned long received;   // messages received
+        unsigned long processed;  // messages handed over for processing
+        unsigned long client;     // dropped: client over its rate
+        unsigned long relay;      // dropped: relay over its rate
+        unsigned long delay;      // dropped: waited too long
+        unsigned long full;       // dropped: queues full
+    };
+
+    TSrvAdmission();
+
+    static int getPriority(int msgType);
+    static uint64_t now();
+
+    void setQueueLimit(size_t maxSize);
+    void setClientRate(unsigned int perSecond, unsigned int burst);
+    void setRelayRate(unsigned int perSecond, unsigned int burst);
+    void setMaxDelay(unsigned int msec);
+    void setOverload(size_t queued);
+
+    bool enqueue(SPtr<TSrvMsg> msg, uint64_t now);
+    SPtr<TSrvMsg> dequeue(uint64_t now);
+    size_t count() const;
+
+    const TStats& getStats(int prio) const;
+    unsigned long dropped(int prio) const;
+    void report(uint64_t now, bool force = false);
+    void clear();
+
+  private:
+    /// queued message
+    struct TQueued {
+        SPtr<TSrvMsg> msg;
+        uint64_t received;   // time the message was queued at (in msec)
+    };
+
+    /// token bucket (tokens are counted in 1/1000 of a message)
+    struct TBucket {
+        uint64_t tokens;
+        uint64_t updated;    // time the bucket was last refilled at (in msec)
+    };
+
+    /// token bucket limit
+    struct TRate {
+        unsigned int perSecond; // 0 means unlimited
+        unsigned int burst;
+    };
+
+    typedef std::map<std::string, TBucket> TBucketMap;
+
+    static bool take(TBucketMap& buckets, const std::string& key,
+                     const TRate& rate, uint64_t now);
+    static void prune(TBucketMap& buckets, const TRate& rate, uint64_t now);
+    bool overloaded(uint64_t now) const;
+
+    std::deque<TQueued> Queues_[PRIO_COUNT];
+    size_t Count_;
+    size_t MaxSize_;
+    unsigned int MaxDelay_;
+    size_t Overload_;
+
+    TBucketMap Clients_;
+    TBucketMap Relays_;
+    TRate ClientRate_;
+    TRate RelayRate_;
+
+    TStats Stats_[PRIO_COUNT];
+    unsigned long Reported_[PRIO_COUNT]; // dropped messages already reported
+    uint64_t LastReport_;
+};
+
+#endif
@@ -0,0 +1,329 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <algorithm>
+#include <time.h>
+#include "SrvLeaseReconciler.h"
+#include "SrvReconfCampaign.h"
+#include "SrvCfgMgr.h"
+#include "SrvAddrMgr.h"
+#include "AddrClient.h"
+#include "AddrAddr.h"
+#include "AddrPrefix.h"
+#include "HostRange.h"
+#include "Logger.h"
+
+using namespace std;
+
+namespace {
+
+/// index of the pool list for specified lease type
+int poolIndex(TIAType type) {
+    return type == IATYPE_PD ? 1 : 0;
+}
+
+}
+
+TSrvLeaseReconciler::TSrvLeaseReconciler()
+    :Leases_(0) {
+}
+
+/// @brief returns current time (in msec), used to measure phases
+uint64_t TSrvLeaseReconciler::msec() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    return (uint64_t)time(NULL) * 1000;
+}
+
+bool TSrvLeaseReconciler::startsBefore(const TPool& a, const TPool& b) {
+    return a.first < b.first;
+}
+
+bool TSrvLeaseReconciler::startsAfter(const TIPv6AddrValue& addr, const TPool& pool) {
+    return addr < pool.first;
+}
+
+/// @brief records that a phase has finished
+///
+/// @param name name of the phase
+/// @param start time the phase started at, set to the current time
+void TSrvLeaseReconciler::phase(const char* name, uint64_t& start) {
+    uint64_t now = msec();
+    TPhase p;
+    p.name = name;
+    p.msec = now - start;
+    Phases_.push_back(p);
+    start = now;
+}
+
+/// @brief reconciles the lease database with the configuration
+///
+/// Reserved addresses and prefixes are removed from the cache, pool usage
+/// counters are set and the RECONFIGURE campaign is started for clients
+/// with outdated leases.
+///
+/// @param campaign RECONFIGURE campaign (NULL if reconfigure is not supported)
+/// @param now current time
+///
+/// @return false if the database refers to interfaces not present in the system
+bool TSrvLeaseReconciler::run(TSrvReconfCampaign* campaign, unsigned long now) {
+    Phases_.clear();
+    Invalid_.clear();
+    Reconfigure_.clear();
+    Leases_ = 0;
+    uint64_t start = msec();
+
+    buildPoolIndex();
+    phase("pool index", start);
+
+    scan(campaign != 0);
+    phase("lease scan", start);
+
+    if (!Invalid_.empty()) {
+        Log(Crit) << Invalid_.size() << " IA(s) refer to interfaces not present in the OS. "
+                  << "Can't use this database." << LogEnd;
+        return false;
+    }
+
+    setCounters();
+    phase("pool counters", start);
+
+    SrvCfgMgr().removeReservedFromCache();
+    phase("reservations", start);
+
+    if (campaign) {
+        campaign->start(now, Reconfigure_);
+        phase("reconfigure", start);
+    }
+
+    Log(Info) << "Startup: " << Leases_ << " lease(s) checked:";
+    for (vector<TPhase>::const_iterator it = Phases_.begin(); it != Phases_.end(); ++it)
+        Log(Cont) << " " << it->name << " " << it->msec << "ms";
+    Log(Cont) << "." << LogEnd;
+    return true;
+}
+
+/// @brief builds index of pools from the current configuration
+void TSrvLeaseReconciler::buildPoolIndex() {
+    Pools_[0].clear();
+    Pools_[1].clear();
+    AddrCounts_.clear();
+    PDCounts_.clear();
+    NameToIndex_.clear();
+    IndexToName_.clear();
+
+    SPtr<TSrvCfgIface> iface;
+    SrvCfgMgr().firstIface();
+    while (iface = SrvCfgMgr().getIface()) {
+        NameToIndex_.insert(make_pair(iface->getName(), iface->getID()));
+        IndexToName_.insert(make_pair(iface->getID(), iface->getName()));
+
+        TPool pool;
+        pool.iface = iface->getID();
+        pool.order = 0;
+
+        SPtr<TSrvCfgAddrClass> addrClass;
+        iface->firstAddrClass();
+        while (addrClass = iface->getAddrClass()) {
+            if (!addrClass->getFirstAddr() || !addrClass->getLastAddr())
+                continue;
+            pool.first = addrClass->getFirstAddr()->getValue();
+            pool.last = addrClass->getLastAddr()->getValue();
+            pool.addrClass = addrClass;
+            pool.pd = SPtr<TSrvCfgPD>();
+            Pools_[poolIndex(IATYPE_IA)].push_back(pool);
+            pool.order++;
+            AddrCounts_[&(*addrClass)] = 0;
+        }
+
+        SPtr<TSrvCfgPD> pd;
+        iface->firstPD();
+        while (pd = iface->getPD()) {
+            SPtr<THostRange> range;
+            pd->firstPool();
+            while (range = pd->getPool()) {
+                pool.first = range->getAddrL()->getValue();
+                pool.last = range->getAddrR()->getValue();
+                pool.addrClass = SPtr<TSrvCfgAddrClass>();
+                pool.pd = pd;
+                Pools_[poolIndex(IATYPE_PD)].push_back(pool);
+                pool.order++;
+            }
+            PDCounts_[&(*pd)] = 0;
+        }
+    }
+
+    // sort pools, so the last pool starting at or before an address can be
+    // found with binary search. Pools may overlap, maxLast tells when to
+    // stop looking at the preceding ones.
+    for (int i = 0; i < 2; i++) {
+        vector<TPool>& pools = Pools_[i];
+        stable_sort(pools.begin(), pools.end(), startsBefore);
+        for (size_t j = 0; j < pools.size(); j++) {
+            pools[j].maxLast = pools[j].last;
+            if (j && pools[j].maxLast < pools[j - 1].maxLast)
+                pools[j].maxLast = pools[j - 1].maxLast;
+        }
+    }
+}
+
+/// @brief checks if address (or prefix) belongs to any pool configured on interface
+///
+/// @param iface interface index
+/// @param type IATYPE_IA (address classes) or IATYPE_PD (prefix pools)
+/// @param addr address or prefix
+///
+/// @return true if address is within any pool
+bool TSrvLeaseReconciler::inPool(int iface, TIAType type, const TIPv6AddrValue& addr) const {
+    const vector<TPool>& pools = Pools_[poolIndex(type)];
+    vector<TPool>::const_iterator it = upper_bound(pools.begin(), pools.end(), addr,
+                                                  startsAfter);
+    while (it != pools.begin()) {
+        --it;
+        if (it->maxLast < addr)
+            break;
+        if (it->iface == iface && addr <= it->last)
+            return true;
+    }
+    return false;
+}
+
+/// @brief counts lease in the first pool on its interface that contains it
+///
+/// That is the class (or PD class) TSrvCfgIface::addClntAddr() and
+/// addClntPrefix() update at runtime, so each lease is counted once.
+///
+/// @param iface interface the lease was assigned on
+/// @param type IATYPE_IA or IATYPE_PD
+/// @param lease address or prefix
+///
+/// @return true if lease belongs to a pool configured on its interface
+bool TSrvLeaseReconciler::classify(int iface, TIAType type, TAddrAddr& lease) {
+    const TIPv6AddrValue& addr = lease.getValue();
+    const vector<TPool>& pools = Pools_[poolIndex(type)];
+    vector<TPool>::const_iterator it = upper_bound(pools.begin(), pools.end(), addr,
+                                                  startsAfter);
+    const TPool* found = 0;
+    while (it != pools.begin()) {
+        --it;
+        if (it->maxLast < addr)
+            break;
+        if (it->iface != iface || it->last < addr)
+            continue;
+        if (!found || it->order < found->order)
+            found = &(*it);
+    }
+    if (!found)
+        return false;
+
+    if (found->addrClass) {
+        AddrCounts_[&(*found->addrClass)]++;
+    } else {
+        found->pd->markUsed(lease.get());
+        PDCounts_[&(*found->pd)]++;
+    }
+    return true;
+}
+
+/// @brief checks interface of an IA and classifies its leases
+///
+/// @param client client the IA belongs to
+/// @param ia IA, TA or PD
+/// @param type type of the IA
+///
+/// @return true if any lease is outside of pools configured on its interface
+bool TSrvLeaseReconciler::checkIA(SPtr<TAddrClient> client, SPtr<TAddrIA> ia, TIAType type) {
+    string ifname = ia->getIfacename();
+    if (!SrvAddrMgr().updateInterfacesInfoIA(ia, NameToIndex_, IndexToName_)) {
+        TInvalidLease invalid;
+        invalid.duid = client->getDUID();
+        invalid.type = type;
+        invalid.iaid = ia->getIAID();
+        invalid.iface = ifname;
+        Invalid_.push_back(invalid);
+        return false;
+    }
+
+    bool outdated = false;
+    switch (type) {
+    case IATYPE_IA: {
+        SPtr<TAddrAddr> addr;
+        ia->firstAddr();
+        while (addr = ia->getAddr()) {
+            Leases_++;
+            if (!classify(ia->getIfindex(), type, *addr))
+                outdated = true;
+        }
+        break;
+    }
+    case IATYPE_PD: {
+        SPtr<TAddrPrefix> prefix;
+        ia->firstPrefix();
+        while (prefix = ia->getPrefix()) {
+            Leases_++;
+            if (!classify(ia->getIfindex(), type, *prefix))
+                outdated = true;
+        }
+        break;
+    }
+    default:
+        // temporary addresses are not counted nor reconfigured
+        Leases_ += ia->countAddr();
+    }
+    return outdated;
+}
+
+/// @brief visits all leases once
+///
+/// @param reconfigure should clients with outdated leases be collected?
+void TSrvLeaseReconciler::scan(bool reconfigure) {
+    SPtr<TAddrClient> client;
+    SrvAddrMgr().firstClient();
+    while (client = SrvAddrMgr().getClient()) {
+        bool outdated = false;
+        SPtr<TAddrIA> ia;
+
+        client->firstIA();
+        while (ia = client->getIA()) {
+            if (checkIA(client, ia, IATYPE_IA))
+                outdated = true;
+        }
+
+        client->firstTA();
+        while (ia = client->getTA())
+            checkIA(client, ia, IATYPE_TA);
+
+        client->firstPD();
+        while (ia = client->getPD()) {
+            if (checkIA(client, ia, IATYPE_PD))
+                outdated = true;
+        }
+
+        if (outdated && reconfigure)
+            Reconfigure_.push_back(client->getDUID());
+    }
+}
+
+/// @brief sets pool usage counters to the counted values
+void TSrvLeaseReconciler::setCounters() {
+    unsigned long iaCnt = 0, pdCnt = 0;
+    for (map<TSrvCfgAddrClass*, unsigned long>::iterator it = AddrCounts_.begin();
+         it != AddrCounts_.end(); ++it) {
+        it->first->setAssigned(it->second);
+        iaCnt += it->second;
+    }
+    for (map<TSrvCfgPD*, unsigned long>::iterator it = PDCounts_.begin();
+         it != PDCounts_.end(); ++it) {
+        it->first->setAssigned(it->second);
+        pdCnt += it->second;
+    }
+    Log(Debug) << "Increased pools usage: currently " << iaCnt << " address(es) and "
+               << pdCnt << " prefix(es) are leased." << LogEnd;
+}
@@ -0,0 +1,105 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVLEASERECONCILER_H
+#define SRVLEASERECONCILER_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "SmartPtr.h"
+#include "DHCPConst.h"
+#include "DUID.h"
+#include "IPv6Addr.h"
+#include "AddrIA.h"
+#include "AddrClient.h"
+#include "SrvCfgAddrClass.h"
+#include "SrvCfgPD.h"
+
+class TSrvReconfCampaign;
+
+/// @brief Startup reconciliation of the lease database against the configuration.
+///
+/// After the configuration and the lease database are loaded, every lease
+/// is visited exactly once:
+///
+/// - interface names and indexes of its IA are checked (and updated, if the
+///   interface index has changed),
+/// - it is looked up in an index of configured pools (sorted ranges, binary
+///   search), pool usage counters are updated,
+/// - clients with leases outside of pools configured on their interface
+///   are collected as RECONFIGURE candidates.
+///
+/// Time spent in each phase of the startup is recorded and logged.
+class TSrvLeaseReconciler
+{
+  public:
+    /// IA that refers to an interface not present in the system
+    struct TInvalidLease {
+        SPtr<TDUID> duid;
+        TIAType type;
+        unsigned long iaid;
+        std::string iface;
+    };
+
+    /// single phase of the startup
+    struct TPhase {
+        std::string name;
+        uint64_t msec;
+    };
+
+    TSrvLeaseReconciler();
+
+    bool run(TSrvReconfCampaign* campaign, unsigned long now);
+
+    bool inPool(int iface, TIAType type, const TIPv6AddrValue& addr) const;
+
+    const std::vector<TInvalidLease>& getInvalid() const { return Invalid_; }
+    const std::vector<SPtr<TDUID> >& getReconfigure() const { return Reconfigure_; }
+    const std::vector<TPhase>& getPhases() const { return Phases_; }
+    unsigned long getLeaseCount() const { return Leases_; }
+
+  private:
+    /// configured pool (address class or prefix pool)
+    struct TPool {
+        TIPv6AddrValue first;
+        TIPv6AddrValue last;
+        TIPv6AddrValue maxLast; // the highest last of this and all preceding pools
+        int iface;
+        unsigned int order; // position on the interface, in configuration order
+        SPtr<TSrvCfgAddrClass> addrClass;
+        SPtr<TSrvCfgPD> pd;
+    };
+
+    static bool startsBefore(const TPool& a, const TPool& b);
+    static bool startsAfter(const TIPv6AddrValue& addr, const TPool& pool);
+    static uint64_t msec();
+    void phase(const char* name, uint64_t& start);
+
+    void buildPoolIndex();
+    bool checkIA(SPtr<TAddrClient> client, SPtr<TAddrIA> ia, TIAType type);
+    bool classify(int iface, TIAType type, TAddrAddr& lease);
+    void scan(bool reconfigure);
+    void setCounters();
+
+    std::vector<TPool> Pools_[2]; // IATYPE_IA and IATYPE_PD, sorted by first
+    std::map<TSrvCfgAddrClass*, unsigned long> AddrCounts_;
+    std::map<TSrvCfgPD*, unsigned long> PDCounts_;
+
+    std::map<std::string, int> NameToIndex_;
+    std::map<int, std::string> IndexToName_;
+
+    std::vector<TInvalidLease> Invalid_;
+    std::vector<SPtr<TDUID> > Reconfigure_;
+    std::vector<TPhase> Phases_;
+    unsigned long Leases_;
+};
+
+#endif
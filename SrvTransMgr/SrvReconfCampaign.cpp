@@ -0,0 +1,388 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <algorithm>
+#include "SrvReconfCampaign.h"
+#include "SrvTransMgr.h"
+#include "SrvCfgMgr.h"
+#include "SrvAddrMgr.h"
+#include "AddrIA.h"
+#include "AddrAddr.h"
+#include "AddrPrefix.h"
+#include "HostRange.h"
+#include "DHCPDefaults.h"
+#include "Logger.h"
+
+using namespace std;
+
+static string duidKey(SPtr<TDUID> duid) {
+    return string(duid->get(), duid->getLen());
+}
+
+TSrvReconfCampaign::TSrvReconfCampaign()
+    :Cursor_(0), Rate_(SERVER_RECONFIGURE_RATE), Tokens_(0), LastRefill_(0), Active_(false),
+     Progress_() {
+}
+
+/// @brief sets maximum number of RECONFIGUREs sent per second
+///
+/// @param perSecond rate (0 means unlimited)
+void TSrvReconfCampaign::setRate(unsigned int perSecond) {
+    Rate_ = perSecond;
+}
+
+unsigned int TSrvReconfCampaign::getRate() const {
+    return Rate_;
+}
+
+/// @brief starts a new campaign (all clients in the database will be checked)
+///
+/// @param now current time
+void TSrvReconfCampaign::start(unsigned long now) {
+    vector<SPtr<TDUID> > clients;
+    SPtr<TAddrClient> client;
+    SrvAddrMgr().firstClient();
+    while (client = SrvAddrMgr().getClient())
+        clients.push_back(client->getDUID());
+    start(now, clients);
+}
+
+/// @brief starts a new campaign for specified clients
+///
+/// Used when clients with outdated leases are already known (see
+/// TSrvLeaseReconciler), so the whole database is not checked again.
+///
+/// @param now current time
+/// @param clients clients to be checked
+void TSrvReconfCampaign::start(unsigned long now, const std::vector<SPtr<TDUID> >& clients) {
+    stop();
+    buildPoolIndex();
+    Clients_ = clients;
+
+    Progress_.clients = Clients_.size();
+    Tokens_ = Rate_;
+    LastRefill_ = now;
+    Active_ = true;
+    Log(Info) << "Reconfigure: Checking " << Clients_.size() << " client(s), up to " << Rate_
+              << " RECONFIGURE(s) per second will be sent." << LogEnd;
+}
+
+/// @brief stops the campaign (outdated leases are not removed)
+void TSrvReconfCampaign::stop() {
+    Clients_.clear();
+    Cursor_ = 0;
+    Waiting_.clear();
+    Affected_.clear();
+    Timers_.clear();
+    Progress_ = TProgress();
+    Active_ = false;
+}
+
+/// @brief checks some more clients and sends RECONFIGUREs that are due
+///
+/// @param now current time
+void TSrvReconfCampaign::doDuties(unsigned long now) {
+    if (!Active_)
+        return;
+    refill(now);
+
+    // find affected clients
+    for (size_t n = 0; n < SERVER_RECONFIGURE_CHECKS && Cursor_ < Clients_.size(); ++n) {
+        SPtr<TAddrClient> client = SrvAddrMgr().getClient(Clients_[Cursor_]);
+        Clients_[Cursor_++] = SPtr<TDUID>();
+        Progress_.checked++;
+
+        TClient state;
+        if (!client || !check(client, state))
+            continue;
+        Progress_.affected++;
+        if (!state.unicast) {
+            // That's odd. Unicast should be in the database. Are we dealing with a
+            // broken database here?
+            Log(Warning) << "Reconfigure: Unable to send RECONFIGURE to client "
+                         << state.duid->getPlain() << ": no unicast address recorded." << LogEnd;
+            Progress_.failed++;
+            continue;
+        }
+        string key = duidKey(state.duid);
+        Affected_[key] = state;
+        Waiting_.push_back(key);
+    }
+    if (Cursor_ && Cursor_ == Clients_.size()) {
+        Log(Info) << "Reconfigure: " << Progress_.checked << " client(s) checked, "
+                  << Progress_.affected << " of them use outdated leases." << LogEnd;
+        Clients_.clear();
+        Cursor_ = 0;
+    }
+
+    // retransmissions first
+    while (Tokens_ && !Timers_.empty() && Timers_.begin()->first <= now) {
+        unsigned long when = Timers_.begin()->first;
+        string key = Timers_.begin()->second;
+        Timers_.erase(Timers_.begin());
+
+        map<string, TClient>::iterator it = Affected_.find(key);
+        if (it == Affected_.end() || it->second.next != when)
+            continue; // client already responded
+        if (it->second.transmissions > REC_MAX_RC) {
+            Log(Info) << "Reconfigure: Client " << it->second.duid->getPlain()
+                      << " did not respond to RECONFIGURE." << LogEnd;
+            finish(key, false);
+            continue;
+        }
+        transmit(key, it->second, now);
+        Progress_.retransmitted++;
+    }
+
+    // then new clients
+    while (Tokens_ && !Waiting_.empty()) {
+        string key = Waiting_.front();
+        Waiting_.pop_front();
+
+        map<string, TClient>::iterator it = Affected_.find(key);
+        if (it == Affected_.end())
+            continue; // client renewed on its own
+        Log(Info) << "Reconfigure: Client " << it->second.duid->getPlain()
+                  << " uses outdated leases. Sending RECONFIGURE." << LogEnd;
+        transmit(key, it->second, now);
+        Progress_.sent++;
+    }
+
+    if (Clients_.empty() && Waiting_.empty() && Affected_.empty()) {
+        Log(Info) << "Reconfigure: Finished, " << Progress_.completed << " client(s) responded, "
+                  << Progress_.failed << " did not." << LogEnd;
+        Timers_.clear();
+        Active_ = false;
+    }
+}
+
+/// @brief returns number of seconds until doDuties() should be called
+///
+/// @param now current time
+unsigned long TSrvReconfCampaign::getTimeout(unsigned long now) const {
+    if (!Active_)
+        return DHCPV6_INFINITY;
+    if (!Clients_.empty() || !Waiting_.empty())
+        return Tokens_ ? 0 : 1; // waiting for the rate limit
+    if (Timers_.empty())
+        return 0; // finished
+    unsigned long next = Timers_.begin()->first;
+    if (next > now)
+        return next - now;
+    return Tokens_ ? 0 : 1;
+}
+
+/// @brief notes that client responded (to RECONFIGURE or on its own)
+///
+/// Client's outdated leases are removed, so the client will be told to
+/// stop using them.
+///
+/// @param duid DUID of the client that sent RENEW, REBIND or INFORMATION-REQUEST
+///
+/// @return true if the client was reconfigured by the campaign
+bool TSrvReconfCampaign::clientResponded(SPtr<TDUID> duid) {
+    if (!Active_ || !duid)
+        return false;
+    string key = duidKey(duid);
+    if (Affected_.find(key) == Affected_.end())
+        return false;
+    Log(Debug) << "Reconfigure: Client " << duid->getPlain() << " responded." << LogEnd;
+    finish(key, true);
+    return true;
+}
+
+bool TSrvReconfCampaign::isActive() const {
+    return Active_;
+}
+
+const TSrvReconfCampaign::TProgress& TSrvReconfCampaign::getProgress() const {
+    return Progress_;
+}
+
+static bool rangeStartsAfter(const TIPv6AddrValue& addr,
+                             const pair<TIPv6AddrValue, TIPv6AddrValue>& range) {
+    return addr < range.first;
+}
+
+/// @brief checks if address (or prefix) belongs to any pool configured on interface
+///
+/// @param iface interface index
+/// @param type IATYPE_IA (address classes) or IATYPE_PD (prefix pools)
+/// @param addr address or prefix
+///
+/// @return true if address is within any pool
+bool TSrvReconfCampaign::inPool(int iface, TIAType type, SPtr<TIPv6Addr> addr) const {
+    map<TPoolKey, vector<TRange> >::const_iterator it = Pools_.find(TPoolKey(iface, type));
+    if (it == Pools_.end())
+        return false;
+
+    // last pool that starts at or before the address
+    TIPv6AddrValue value = addr->getValue();
+    vector<TRange>::const_iterator range = upper_bound(it->second.begin(), it->second.end(),
+                                                       value, rangeStartsAfter);
+    if (range == it->second.begin())
+        return false;
+    --range;
+    return !(range->second < value);
+}
+
+/// @brief builds index of pools from the current configuration
+void TSrvReconfCampaign::buildPoolIndex() {
+    Pools_.clear();
+
+    SPtr<TSrvCfgIface> iface;
+    SrvCfgMgr().firstIface();
+    while (iface = SrvCfgMgr().getIface()) {
+        SPtr<TSrvCfgAddrClass> addrClass;
+        iface->firstAddrClass();
+        while (addrClass = iface->getAddrClass())
+            addPool(iface->getID(), IATYPE_IA, addrClass->getFirstAddr(), addrClass->getLastAddr());
+
+        SPtr<TSrvCfgPD> pd;
+        iface->firstPD();
+        while (pd = iface->getPD()) {
+            SPtr<THostRange> pool;
+            pd->firstPool();
+            while (pool = pd->getPool())
+                addPool(iface->getID(), IATYPE_PD, pool->getAddrL(), pool->getAddrR());
+        }
+    }
+
+    // sort pools and merge overlapping ones
+    for (map<TPoolKey, vector<TRange> >::iterator it = Pools_.begin(); it != Pools_.end(); ++it) {
+        vector<TRange>& ranges = it->second;
+        sort(ranges.begin(), ranges.end());
+        vector<TRange> merged;
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (!merged.empty() && !(merged.back().second < ranges[i].first)) {
+                if (merged.back().second < ranges[i].second)
+                    merged.back().second = ranges[i].second;
+            } else {
+                merged.push_back(ranges[i]);
+            }
+        }
+        ranges.swap(merged);
+    }
+}
+
+void TSrvReconfCampaign::addPool(int iface, TIAType type, SPtr<TIPv6Addr> first,
+                                 SPtr<TIPv6Addr> last) {
+    if (!first || !last)
+        return;
+    Pools_[TPoolKey(iface, type)].push_back(TRange(first->getValue(), last->getValue()));
+}
+
+/// @brief finds client's leases that are outside of the configured pools
+///
+/// @param client client to be checked
+/// @param state outdated leases, address and interface RECONFIGURE should
+///        be sent to will be stored here
+///
+/// @return true if client has outdated leases
+bool TSrvReconfCampaign::check(SPtr<TAddrClient> client, TClient& state) const {
+    state.duid = client->getDUID();
+    state.iface = -1;
+    state.transmissions = 0;
+    state.rt = REC_TIMEOUT;
+    state.next = 0;
+
+    SPtr<TAddrIA> ia;
+    client->firstIA();
+    while (ia = client->getIA()) {
+        SPtr<TAddrAddr> addr;
+        ia->firstAddr();
+        while (addr = ia->getAddr()) {
+            if (inPool(ia->getIfindex(), IATYPE_IA, addr->get()))
+                continue;
+            TLease lease;
+            lease.type = IATYPE_IA;
+            lease.iaid = ia->getIAID();
+            lease.addr = addr->get();
+            state.outdated.push_back(lease);
+            if (!state.unicast) {
+                state.unicast = ia->getSrvAddr();
+                state.iface = ia->getIfindex();
+            }
+        }
+    }
+
+    SPtr<TAddrIA> pd;
+    client->firstPD();
+    while (pd = client->getPD()) {
+        SPtr<TAddrPrefix> prefix;
+        pd->firstPrefix();
+        while (prefix = pd->getPrefix()) {
+            if (inPool(pd->getIfindex(), IATYPE_PD, prefix->get()))
+                continue;
+            TLease lease;
+            lease.type = IATYPE_PD;
+            lease.iaid = pd->getIAID();
+            lease.addr = prefix->get();
+            state.outdated.push_back(lease);
+            if (!state.unicast) {
+                state.unicast = pd->getSrvAddr();
+                state.iface = pd->getIfindex();
+            }
+        }
+    }
+
+    return !state.outdated.empty();
+}
+
+/// @brief sends (or retransmits) RECONFIGURE and schedules retransmission
+void TSrvReconfCampaign::transmit(const std::string& key, TClient& state, unsigned long now) {
+    SrvTransMgr().sendReconfigure(state.unicast, state.iface, RENEW_MSG, state.duid);
+    if (Rate_)
+        Tokens_--;
+
+    if (state.transmissions++)
+        state.rt *= 2;
+    state.next = now + state.rt;
+    Timers_.insert(make_pair(state.next, key));
+}
+
+/// @brief removes client's outdated leases and the client from the campaign
+void TSrvReconfCampaign::finish(const std::string& key, bool responded) {
+    map<string, TClient>::iterator it = Affected_.find(key);
+    if (it == Affected_.end())
+        return;
+
+    TClient& state = it->second;
+    for (size_t i = 0; i < state.outdated.size(); ++i) {
+        const TLease& lease = state.outdated[i];
+        bool deleted;
+        if (lease.type == IATYPE_PD)
+            deleted = SrvAddrMgr().delPrefix(state.duid, lease.iaid, lease.addr, true);
+        else
+            deleted = SrvAddrMgr().delClntAddr(state.duid, lease.iaid, lease.addr, true);
+        if (deleted) {
+            Log(Debug) << "Reconfigure: Outdated " << lease.addr->getPlain() << " deleted." << LogEnd;
+        }
+    }
+
+    if (responded)
+        Progress_.completed++;
+    else
+        Progress_.failed++;
+    Affected_.erase(it);
+}
+
+/// @brief adds tokens for RECONFIGUREs that can be sent now
+void TSrvReconfCampaign::refill(unsigned long now) {
+    if (!Rate_) {
+        Tokens_ = (unsigned long)-1;
+        return;
+    }
+    if (now > LastRefill_) {
+        Tokens_ += (now - LastRefill_) * Rate_;
+        if (Tokens_ > Rate_)
+            Tokens_ = Rate_;
+        LastRefill_ = now;
+    }
+}
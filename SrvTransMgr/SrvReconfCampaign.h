@@ -0,0 +1,115 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVRECONFCAMPAIGN_H
+#define SRVRECONFCAMPAIGN_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "SmartPtr.h"
+#include "DHCPConst.h"
+#include "DUID.h"
+#include "IPv6Addr.h"
+#include "AddrClient.h"
+
+/// @brief Paced RECONFIGURE campaign.
+///
+/// After the configuration changes (e.g. pools are renumbered), clients
+/// that hold addresses or prefixes outside of the configured pools are
+/// asked to renew by RECONFIGURE. Instead of checking the whole database
+/// and sending all RECONFIGUREs at once during startup, the campaign is
+/// driven by doDuties():
+///
+/// - a limited number of clients is checked per call, against an index
+///   of configured pools (sorted ranges per interface, binary search),
+/// - RECONFIGUREs are sent at most at the configured rate (per second),
+///   retransmissions first,
+/// - every affected client is retransmitted to (REC_TIMEOUT, doubled
+///   every time, at most REC_MAX_RC retransmissions) until it responds
+///   with RENEW, REBIND or INFORMATION-REQUEST (see clientResponded()).
+///
+/// Outdated leases of a client are removed when the client responds (or
+/// does not respond at all), so the client is told to stop using them.
+class TSrvReconfCampaign
+{
+  public:
+    /// campaign progress
+    struct TProgress {
+        size_t clients;       // clients to be checked
+        size_t checked;       // clients checked so far
+        size_t affected;      // clients with outdated leases
+        size_t sent;          // clients RECONFIGURE was sent to
+        size_t retransmitted; // RECONFIGURE retransmissions
+        size_t completed;     // clients that responded
+        size_t failed;        // clients that did not respond
+    };
+
+    TSrvReconfCampaign();
+
+    void setRate(unsigned int perSecond);
+    unsigned int getRate() const;
+
+    void start(unsigned long now);
+    void start(unsigned long now, const std::vector<SPtr<TDUID> >& clients);
+    void stop();
+    void doDuties(unsigned long now);
+    unsigned long getTimeout(unsigned long now) const;
+    bool clientResponded(SPtr<TDUID> duid);
+
+    bool isActive() const;
+    const TProgress& getProgress() const;
+
+    bool inPool(int iface, TIAType type, SPtr<TIPv6Addr> addr) const;
+
+  private:
+    /// outdated lease
+    struct TLease {
+        TIAType type;
+        unsigned long iaid;
+        SPtr<TIPv6Addr> addr;
+    };
+
+    /// state of an affected client
+    struct TClient {
+        SPtr<TDUID> duid;
+        SPtr<TIPv6Addr> unicast;
+        int iface;
+        std::vector<TLease> outdated;
+        unsigned int transmissions;
+        unsigned long rt;   // current retransmission timeout
+        unsigned long next; // time of the next retransmission
+    };
+
+    typedef std::pair<TIPv6AddrValue, TIPv6AddrValue> TRange;
+    typedef std::pair<int, TIAType> TPoolKey; // interface, lease type
+
+    void buildPoolIndex();
+    void addPool(int iface, TIAType type, SPtr<TIPv6Addr> first, SPtr<TIPv6Addr> last);
+    bool check(SPtr<TAddrClient> client, TClient& state) const;
+    void transmit(const std::string& key, TClient& state, unsigned long now);
+    void finish(const std::string& key, bool responded);
+    void refill(unsigned long now);
+
+    std::map<TPoolKey, std::vector<TRange> > Pools_; // sorted, not overlapping
+    std::vector<SPtr<TDUID> > Clients_;  // clients to be checked
+    size_t Cursor_;                      // next client to be checked
+    std::deque<std::string> Waiting_;    // affected clients, not sent to yet
+    std::map<std::string, TClient> Affected_;
+    std::multimap<unsigned long, std::string> Timers_; // retransmissions
+
+    unsigned int Rate_;
+    unsigned long Tokens_;
+    unsigned long LastRefill_;
+    bool Active_;
+    TProgress Progress_;
+};
+
+#endif
@@ -0,0 +1,193 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "SrvReplyCache.h"
+#include "DHCPConst.h"
+#include "DHCPDefaults.h"
+#include "Portable.h"
+
+using namespace std;
+
+TSrvReplyCache::TSrvReplyCache()
+    :MaxSize_(SERVER_REPLY_CACHE_SIZE), Lifetime_(SERVER_REPLY_CACHE_LIFETIME) {
+}
+
+/// @brief appends 32 bits to a key
+static void appendUint32(string& key, uint32_t value) {
+    char buf[4];
+    writeUint32(buf, value);
+    key.append(buf, 4);
+}
+
+/// @brief appends IPv6 address (or zeros, if not specified) to a key
+static void appendAddr(string& key, SPtr<TIPv6Addr> addr) {
+    if (addr)
+        key.append(addr->getAddr(), 16);
+    else
+        key.append(16, '\0');
+}
+
+/// @brief creates cache key for a client's message
+///
+/// Retransmission has the same type, transaction ID and client DUID, and
+/// is received on the same interface, from the same address and over the
+/// same relays (with the same echoed options, e.g. interface-id) as the
+/// original message.
+///
+/// @param query message received from a client
+/// @param key key will be stored here
+///
+/// @return true if answer to this message can be cached
+bool TSrvReplyCache::makeKey(SPtr<TSrvMsg> query, std::string& key) {
+    switch (query->getType()) {
+    case SOLICIT_MSG:
+    case REQUEST_MSG:
+    case CONFIRM_MSG:
+    case RENEW_MSG:
+    case REBIND_MSG:
+    case DECLINE_MSG:
+    case RELEASE_MSG:
+        break;
+    default:
+        return false;
+    }
+    SPtr<TDUID> duid = query->getClientDUID();
+    if (!duid)
+        return false;
+
+    key.clear();
+    key.push_back((char)query->getType());
+    appendUint32(key, (uint32_t)query->getTransID());
+    appendUint32(key, (uint32_t)query->getIface());
+    appendUint32(key, (uint32_t)duid->getLen());
+    key.append(duid->get(), duid->getLen());
+    appendAddr(key, query->getRemoteAddr());
+
+    // relay hops, as received
+    const TSrvRelayChain& relays = query->getRelayChain();
+    if (relays.length()) {
+        key.append(relays.data(), relays.length());
+    }
+    return true;
+}
+
+/// @brief sets cache limits
+///
+/// @param maxSize maximum number of entries
+/// @param lifetime number of seconds the entries are kept for
+void TSrvReplyCache::setLimits(size_t maxSize, unsigned long lifetime) {
+    MaxSize_ = maxSize;
+    Lifetime_ = lifetime;
+    while (Entries_.size() > MaxSize_) {
+        Entries_.erase(Order_.front());
+        Order_.pop_front();
+    }
+}
+
+/// @brief stores answer sent to a client
+///
+/// @param key key of the client's message (see makeKey())
+/// @param reply answer
+/// @param now current time
+void TSrvReplyCache::add(const std::string& key, SPtr<TSrvMsg> reply, unsigned long now) {
+    if (!MaxSize_)
+        return;
+    expire(now);
+
+    map<string, TEntry>::iterator it = Entries_.find(key);
+    if (it == Entries_.end()) {
+        if (Entries_.size() >= MaxSize_) {
+            Entries_.erase(Order_.front());
+            Order_.pop_front();
+        }
+        it = Entries_.insert(make_pair(key, TEntry())).first;
+    } else {
+        // the same key, moved to the end
+        for (deque<string>::iterator k = Order_.begin(); k != Order_.end(); ++k) {
+            if (*k == key) {
+                Order_.erase(k);
+                break;
+            }
+        }
+    }
+    Order_.push_back(key);
+
+    TEntry& entry = it->second;
+    entry.reply = reply;
+    entry.data.clear();
+    entry.ifindex = 0;
+    entry.port = 0;
+    entry.expires = now + Lifetime_;
+}
+
+/// @brief returns answer sent to a client
+///
+/// @param key key of the client's message (see makeKey())
+/// @param now current time
+///
+/// @return cached entry (or NULL, if there is no valid entry)
+TSrvReplyCache::TEntry* TSrvReplyCache::find(const std::string& key, unsigned long now) {
+    map<string, TEntry>::iterator it = Entries_.find(key);
+    if (it == Entries_.end() || it->second.expires <= now)
+        return 0;
+    return &it->second;
+}
+
+/// @brief removes answer from the cache (e.g. if it was not sent after all)
+///
+/// @param reply answer to be removed
+void TSrvReplyCache::remove(SPtr<TSrvMsg> reply) {
+    for (map<string, TEntry>::iterator it = Entries_.begin(); it != Entries_.end(); ++it) {
+        if (&(*it->second.reply) != &(*reply))
+            continue;
+        for (deque<string>::iterator k = Order_.begin(); k != Order_.end(); ++k) {
+            if (*k == it->first) {
+                Order_.erase(k);
+                break;
+            }
+        }
+        Entries_.erase(it);
+        return;
+    }
+}
+
+/// @brief encodes cached answer (only once)
+///
+/// @param entry cache entry
+///
+/// @return true if wire data is available
+bool TSrvReplyCache::encode(TEntry& entry) {
+    if (!entry.data.empty())
+        return true;
+    return entry.reply->encode(entry.data, entry.ifindex, entry.port);
+}
+
+/// @brief removes expired entries
+///
+/// @param now current time
+void TSrvReplyCache::expire(unsigned long now) {
+    while (!Order_.empty()) {
+        map<string, TEntry>::iterator it = Entries_.find(Order_.front());
+        if (it != Entries_.end()) {
+            if (it->second.expires > now)
+                break;
+            Entries_.erase(it);
+        }
+        Order_.pop_front();
+    }
+}
+
+size_t TSrvReplyCache::count() const {
+    return Entries_.size();
+}
+
+void TSrvReplyCache::clear() {
+    Entries_.clear();
+    Order_.clear();
+}
@@ -0,0 +1,66 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVREPLYCACHE_H
+#define SRVREPLYCACHE_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "SmartPtr.h"
+#include "SrvMsg.h"
+
+/// @brief Short-lived cache of answers sent to clients.
+///
+/// Clients retransmit their messages (with the same transaction ID) when
+/// the answer is lost. Retransmissions are answered from this cache, with
+/// the same ADVERTISE or REPLY that was sent the first time, so they are
+/// not processed again (no allocation, DNS updates, scripts or database
+/// writes) and duplicates are handled idempotently.
+///
+/// Entries are keyed by message type, transaction ID, client DUID,
+/// interface, remote address and the relay chain (see makeKey()). The
+/// answer is encoded when it is retransmitted for the first time and the
+/// wire data is reused afterwards. Entries expire after a few seconds, the
+/// oldest entries are dropped when the cache is full.
+class TSrvReplyCache
+{
+  public:
+    /// single cached answer
+    struct TEntry
+    {
+        SPtr<TSrvMsg> reply;     // answer sent to the client
+        std::vector<char> data;  // encoded answer (once retransmitted)
+        int ifindex;             // physical interface to send data over
+        int port;                // destination port
+        unsigned long expires;   // time the entry expires at
+    };
+
+    TSrvReplyCache();
+
+    static bool makeKey(SPtr<TSrvMsg> query, std::string& key);
+
+    void setLimits(size_t maxSize, unsigned long lifetime);
+    void add(const std::string& key, SPtr<TSrvMsg> reply, unsigned long now);
+    TEntry* find(const std::string& key, unsigned long now);
+    void remove(SPtr<TSrvMsg> reply);
+    static bool encode(TEntry& entry);
+    void expire(unsigned long now);
+    size_t count() const;
+    void clear();
+
+  private:
+    std::map<std::string, TEntry> Entries_;
+    std::deque<std::string> Order_; // keys, oldest first
+    size_t MaxSize_;
+    unsigned long Lifetime_;
+};
+
+#endif
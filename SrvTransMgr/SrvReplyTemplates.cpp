@@ -0,0 +1,185 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <string.h>
+#include "SrvReplyTemplates.h"
+#include "SrvCfgMgr.h"
+#include "OptOptionRequest.h"
+#include "DHCPConst.h"
+#include "DHCPDefaults.h"
+#include "Portable.h"
+#include "Logger.h"
+
+using namespace std;
+
+TSrvReplyTemplates::TSrvReplyTemplates()
+    :MaxSize_(SERVER_REPLY_TEMPLATES) {
+}
+
+/// @brief appends 16 bits to a key
+static void appendUint16(string& key, uint16_t value) {
+    char buf[2];
+    writeUint16(buf, value);
+    key.append(buf, 2);
+}
+
+/// @brief creates template key for a client's message
+///
+/// Key consists of the interface and the options client requested: those
+/// listed in the ORO and extension options included in the message (the
+/// server answers with them as well, see TSrvMsg::handleDefaultOption()).
+///
+/// @param query message received from a client
+/// @param key key will be stored here
+///
+/// @return true if the message can be answered with a template
+bool TSrvReplyTemplates::makeKey(SPtr<TSrvMsg> query, std::string& key) {
+    if (query->getType() != INFORMATION_REQUEST_MSG)
+        return false;
+
+    // answers that are not just configuration
+    if (!SrvCfgMgr().getScriptName().empty() || query->getOption(OPTION_AUTH))
+        return false;
+#ifndef MOD_DISABLE_AUTH
+    if (SrvCfgMgr().getAuthProtocol() != AUTH_PROTO_NONE)
+        return false;
+#endif
+
+    SPtr<TSrvCfgIface> cfgIface = SrvCfgMgr().getIfaceByID(query->getIface());
+    if (!cfgIface || cfgIface->getClientException(query->getClientDUID(), &(*query), true))
+        return false;
+
+    key.clear();
+    char buf[4];
+    writeUint32(buf, (uint32_t)query->getIface());
+    key.append(buf, 4);
+
+    SPtr<TOptOptionRequest> oro = SPtr_cast<TOptOptionRequest>(query->getOption(OPTION_ORO));
+    if (oro) {
+        for (int i = 0; i < oro->count(); ++i)
+            appendUint16(key, oro->getReqOpt(i));
+    }
+
+    const TOptList& opts = query->getOptLst();
+    for (TOptList::const_iterator opt = opts.begin(); opt != opts.end(); ++opt) {
+        int type = (*opt)->getOptType();
+        if (type > OPTION_RECONF_ACCEPT && !(oro && oro->isOption(type)))
+            appendUint16(key, type);
+    }
+    return true;
+}
+
+/// @brief sets maximum number of templates
+///
+/// @param maxSize maximum number of templates (0 disables templates)
+void TSrvReplyTemplates::setLimit(size_t maxSize) {
+    MaxSize_ = maxSize;
+    if (Templates_.size() > MaxSize_)
+        Templates_.clear();
+}
+
+/// @brief stores answer as a template
+///
+/// @param key key of the client's message (see makeKey())
+/// @param reply answer (templates are not stored for unanswered messages)
+void TSrvReplyTemplates::add(const std::string& key, SPtr<TSrvMsg> reply) {
+    if (!reply)
+        return;
+    if (Templates_.size() >= MaxSize_ && !Templates_.count(key))
+        return;
+
+    TTemplate& tmpl = Templates_[key];
+    tmpl.data.clear();
+    tmpl.clientIdOffset = 0;
+    tmpl.data.resize(reply->getSize());
+    reply->storeSelf(&tmpl.data[0]);
+
+    // transaction-id is set for every answer
+    memset(&tmpl.data[1], 0, 3);
+
+    // client-id is removed, it will be inserted after server-id (the first
+    // option), as TSrvMsgReply does
+    size_t pos = 4;
+    tmpl.clientIdOffset = pos;
+    while (pos + 4 <= tmpl.data.size()) {
+        uint16_t type = readUint16(&tmpl.data[pos]);
+        size_t len = readUint16(&tmpl.data[pos + 2]) + 4;
+        if (type == OPTION_CLIENTID) {
+            tmpl.data.erase(tmpl.data.begin() + pos, tmpl.data.begin() + pos + len);
+            continue;
+        }
+        if (type == OPTION_SERVERID)
+            tmpl.clientIdOffset = pos + len;
+        pos += len;
+    }
+}
+
+/// @brief returns template for a client's message
+///
+/// @param key key of the client's message (see makeKey())
+///
+/// @return template (or NULL, if there is none)
+const TSrvReplyTemplates::TTemplate* TSrvReplyTemplates::find(const std::string& key) const {
+    map<string, TTemplate>::const_iterator it = Templates_.find(key);
+    if (it == Templates_.end())
+        return 0;
+    return &it->second;
+}
+
+/// @brief encodes answer to a client's message
+///
+/// @param tmpl template (must not be empty)
+/// @param query message received from a client
+/// @param data wire format will be stored here
+/// @param ifindex index of the physical interface to send it over
+/// @param port destination port
+///
+/// @return true if successful
+bool TSrvReplyTemplates::encode(const TTemplate& tmpl, SPtr<TSrvMsg> query,
+                                std::vector<char>& data, int& ifindex, int& port) {
+    SPtr<TOpt> clientId = query->getOption(OPTION_CLIENTID);
+    size_t clientIdLen = clientId ? clientId->getSize() : 0;
+    size_t len = tmpl.data.size() + clientIdLen;
+
+    const TSrvRelayChain& relays = query->getRelayChain();
+    ESrvIfaceIdOrder order = SrvCfgMgr().getInterfaceIDOrder();
+    data.resize(relays.getSize(len, order));
+
+    size_t offset = 0;
+    if (!relays.empty()) {
+        relays.storeSelf(&data[0], len, order, RELAY_REPL_MSG, offset);
+        ifindex = query->getPhysicalIface();
+        port = DHCPSERVER_PORT;
+    } else {
+        ifindex = query->getIface();
+        port = DHCPCLIENT_PORT;
+    }
+
+    char* buf = &data[offset];
+    memcpy(buf, &tmpl.data[0], tmpl.clientIdOffset);
+    uint32_t transid = (uint32_t)query->getTransID();
+    buf[1] = (transid >> 16) & 0xff;
+    buf[2] = (transid >> 8) & 0xff;
+    buf[3] = transid & 0xff;
+    buf += tmpl.clientIdOffset;
+    if (clientId) {
+        clientId->storeSelf(buf);
+        buf += clientIdLen;
+    }
+    memcpy(buf, &tmpl.data[tmpl.clientIdOffset], tmpl.data.size() - tmpl.clientIdOffset);
+    return true;
+}
+
+size_t TSrvReplyTemplates::count() const {
+    return Templates_.size();
+}
+
+void TSrvReplyTemplates::clear() {
+    Templates_.clear();
+}
@@ -0,0 +1,59 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * authors: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef SRVREPLYTEMPLATES_H
+#define SRVREPLYTEMPLATES_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "SmartPtr.h"
+#include "SrvMsg.h"
+
+/// @brief Pre-encoded answers to INFORMATION-REQUEST messages.
+///
+/// Unless there is a per-client configuration (exception) for the client,
+/// the REPLY to INFORMATION-REQUEST depends only on the interface and the
+/// options the client requested. The first answer is built as usual and
+/// stored in wire format. Subsequent messages with the same interface and
+/// requested options are answered with a copy of it. Only the transaction
+/// ID, client-id and relay headers are patched, no message objects are
+/// built, no scripts are called and nothing is written to disk.
+///
+/// Templates are not used with authentication, notify scripts or for
+/// clients with exceptions (see makeKey()). The configuration does not
+/// change at run-time, so templates do not expire.
+class TSrvReplyTemplates
+{
+  public:
+    /// pre-encoded answer
+    struct TTemplate
+    {
+        std::vector<char> data;  // REPLY without client-id
+        size_t clientIdOffset;   // client-id is inserted here
+    };
+
+    TSrvReplyTemplates();
+
+    static bool makeKey(SPtr<TSrvMsg> query, std::string& key);
+    static bool encode(const TTemplate& tmpl, SPtr<TSrvMsg> query,
+                       std::vector<char>& data, int& ifindex, int& port);
+
+    void setLimit(size_t maxSize);
+    void add(const std::string& key, SPtr<TSrvMsg> reply);
+    const TTemplate* find(const std::string& key) const;
+    size_t count() const;
+    void clear();
+
+  private:
+    std::map<std::string, TTemplate> Templates_;
+    size_t MaxSize_;
+};
+
+#endif
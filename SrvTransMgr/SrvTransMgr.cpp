@@ -13,6 +13,7 @@
 #include <sstream>
 #include <map>
 #include <limits.h>
+#include <time.h>
 #include "SrvTransMgr.h"
 #include "SmartPtr.h"
 #include "SrvCfgIface.h"
@@ -35,6 +36,7 @@
 #include "SrvMsg.h"
 #include "SrvMsgLeaseQuery.h"
 #include "SrvMsgLeaseQueryReply.h"
+#include "SrvLeaseReconciler.h"
 #include "SrvOptIA_NA.h"
 #include "OptStatusCode.h"
 #include "NodeClientSpecific.h"
@@ -44,7 +46,7 @@ using namespace std;
 TSrvTransMgr * TSrvTransMgr::Instance = 0;
 
 TSrvTransMgr::TSrvTransMgr(const std::string xmlFile, int port)
-    : XmlFile(xmlFile), IsDone(false), port_(port)
+    : XmlFile(xmlFile), IsDone(false), port_(port), GroupCommit_(false)
 {
     // TransMgr is certainly not done yet. We're just getting started
 
@@ -58,134 +60,15 @@ TSrvTransMgr::TSrvTransMgr(const std::string xmlFile, int port)
         }
     }
     
-    if (SrvCfgMgr().getReconfigureSupport()) {
-        int clients = checkReconfigures();
-        Log(Info) << "Sent Reconfigure to " << clients << " client(s)." << LogEnd;
-    } else {
+    // clients with outdated leases are reconfigured in doDuties(), once
+    // they are found by reconcileLeases()
+    Reconfigures_.setRate(SrvCfgMgr().getReconfigureRate());
+    if (!SrvCfgMgr().getReconfigureSupport())
         Log(Info) << "Reconfigure support was not enabled." << LogEnd;
-    }
 
     SrvAddrMgr().setCacheSize(SrvCfgMgr().getCacheSize());
 }
 
-/// @brief Checks loaded database and sends RECONFIGURE to some clients.
-///
-/// Checks loaded database against current configuration and finds addresses
-/// that are outdated (do not match current configuration). RECONFIGURE message
-/// is sent to clients that currently hold those addresses.
-///
-/// @return number of clients that were reconfigured
-int TSrvTransMgr::checkReconfigures() {
-
-    int clients = 0; // how many client did we reconfigure?
-    int iface;
-    bool PD;
-    bool check;
-    SPtr<TAddrClient> cli;
-    SPtr<TDUID> ptrDUID;
-    SrvAddrMgr().firstClient();
-    unsigned long IAID;
-
-    Log(Debug) << "Checking which clients need RECONFIGURE." << LogEnd;
-
-    while (cli = SrvAddrMgr().getClient() ) 
-    {
-        /// @todo clean up this shit
-        check=true;
-        ptrDUID=cli->getDUID();
-        SPtr<TAddrIA> ia;
-        cli->firstIA();
-        while ( (ia = cli->getIA()) && check) 
-        {
-            IAID=ia->getIAID();	
-            iface=ia->getIfindex();
-            SPtr<TIfaceIface> ptrIface = SrvIfaceMgr().getIfaceByID(iface);
-            SPtr<TIPv6Addr> unicast=ia->getSrvAddr();
-            SPtr<TAddrAddr> adr;
-            SPtr<TIPv6Addr> addra;
-            ia->firstAddr();
-            while( (adr=ia->getAddr()) && check ) 
-            {
-                PD=false;
-                if(ClientInPool1(adr->get(),iface,PD))
-                {
-                    Log(Debug) << "Client " << cli->getDUID()->getPlain()
-                               << " doesn't need to reconfigure IA (iaid=" << ia->getIAID() << ")." << LogEnd;
-                }
-                else 
-                {
-                    Log(Info) << "Client " << cli->getDUID()->getPlain()
-                              << " uses outdated info. Sending RECONFIGURE." << LogEnd;
-                    if (!unicast) {
-                        Log(Warning) << "Unable to send RECONFIGURE to client " << cli->getDUID()->getPlain()
-                                  << ": no unicast address recorded." << LogEnd;
-                        check = false;
-                        // Can't do anything here if we don't have unicast address of the client.
-                        // (That's odd. Unicast should be in the database. Are we dealing with a
-                        // broken database here?)
-                        break;
-                    }
-
-                    sendReconfigure(unicast, iface, RENEW_MSG, ptrDUID);
-                    clients++;
-                    if (SrvAddrMgr().delClntAddr(cli->getDUID(), ia->getIAID(), adr->get(),false)) {
-                        Log(Debug) << "Outdated " << *adr->get() << " address deleted." << LogEnd;
-                   }
-                    check = false;
-                    break; // break inner while loop
-                }
-            }
-        } 
-        SPtr<TAddrIA> pd;
-        cli->firstPD();
-        while ( (pd = cli->getPD()) && check ) 
-        {
-            IAID=pd->getIAID();
-            iface=pd->getIfindex();
-            SPtr<TAddrPrefix> prefix;
-            SPtr<TIPv6Addr> addra;
-            SPtr<TIfaceIface> ptrIface = SrvIfaceMgr().getIfaceByID(iface);
-            SPtr<TIPv6Addr> unicast=pd->getSrvAddr();
-            pd->firstPrefix();
-            while(prefix=pd->getPrefix() ) 
-            {
-                PD=true;
-                if(ClientInPool1(prefix->get(),iface,PD))
-                {
-                    Log(Debug) << "Client " << cli->getDUID()->getPlain() << " doesn't need to reconfigure PD (iaid="
-                               << pd->getIAID() << ")." << LogEnd;
-                }
-                else
-                {
-                    if (!unicast) {
-                        Log(Warning) << "Unable to send RECONFIGURE to client " << cli->getDUID()->getPlain()
-                                  << ": no unicast address recorded." << LogEnd;
-                        check = false;
-                        // Can't do anything here if we don't have unicast address of the client.
-                        // (That's odd. Unicast should be in the database. Are we dealing with a
-                        // broken database here?)
-                        break;
-                    }
-
-                    Log(Info) << "Client " << cli->getDUID()->getPlain()
-                              << "uses outdated info. Sending RECONFIGURE." << LogEnd;
-
-                    sendReconfigure(unicast, iface, RENEW_MSG, ptrDUID);
-                    clients++;
-                    check=false;
-                    if(SrvAddrMgr().delPrefix(ptrDUID, IAID, prefix->get(),true)) {
-                        Log(Debug) << "Outdated " << *prefix->get() << " prefix for client "
-                                   << cli->getDUID()->getPlain() << " deleted." << LogEnd;
-                    }
-                    break;
-                }
-            }
-        }
-    }
-
-    return clients;
-}
-
 /*
  * opens proper (multicast or unicast) socket on interface
  */
@@ -213,7 +96,7 @@ bool TSrvTransMgr::openSocket(SPtr<TSrvCfgIface> confIface, int port) {
         /* unicast */
         Log(Notice) << "Creating unicast (" << *unicast << ") socket on "
 		    << confIface->getFullName() << " interface." << LogEnd;
-        if (!iface->addSocket(unicast, port, true, false)) {
+        if (!iface->addSocketShards(unicast, port, true, SrvCfgMgr().getSocketShards())) {
             Log(Crit) << "Proper socket creation failed." << LogEnd;
             return false;
         }
@@ -236,6 +119,7 @@ bool TSrvTransMgr::openSocket(SPtr<TSrvCfgIface> confIface, int port) {
         return true;
     }
 
+    // not sharded, every socket would receive its own copy of multicast packets
     if (!iface->addSocket(ipAddr, port, true, false)) {
         Log(Crit) << "Proper socket creation failed." << LogEnd;
         return false;
@@ -255,7 +139,7 @@ bool TSrvTransMgr::openSocket(SPtr<TSrvCfgIface> confIface, int port) {
     } else {
         Log(Notice) << "Creating link-local (" << llAddr->getPlain() << ") socket on " << iface->getFullName()
                     << " interface." << LogEnd;
-        if (!iface->addSocket(llAddr, port, true, false)) {
+        if (!iface->addSocketShards(llAddr, port, true, SrvCfgMgr().getSocketShards())) {
             Log(Crit) << "Failed to create link-local socket on " << iface->getFullName() << " interface." << LogEnd;
             return false;
         }
@@ -281,6 +165,15 @@ long TSrvTransMgr::getTimeout()
         min = ifaceRecheckPeriod;
     }
     addrTimeout = SrvAddrMgr().getValidTimeout();
+    unsigned long now = (unsigned long)time(NULL);
+    unsigned long commitTimeout = SrvAddrMgr().getCommitTimeout(now);
+    if (commitTimeout < min) {
+        min = commitTimeout;
+    }
+    unsigned long reconfTimeout = Reconfigures_.getTimeout(now);
+    if (reconfTimeout < min) {
+        min = reconfTimeout;
+    }
     if (min < addrTimeout) {
         return min;
     } else {
@@ -311,6 +204,32 @@ void TSrvTransMgr::relayMsg(SPtr<TSrvMsg> msg)
         return;
     }
 
+    // Client reconfigured by RECONFIGURE campaign has responded
+    if (msg->getType() == RENEW_MSG || msg->getType() == REBIND_MSG ||
+        msg->getType() == INFORMATION_REQUEST_MSG) {
+        Reconfigures_.clientResponded(msg->getClientDUID());
+    }
+
+    // INF-REQUEST answers depend on configuration only, they are built once
+    // and then copied (in stateless mode, clients are not checked at all)
+    string templateKey;
+    bool templated = TSrvReplyTemplates::makeKey(msg, templateKey);
+    if (templated && SrvCfgMgr().stateless() && answerFromTemplate(msg, templateKey)) {
+        return;
+    }
+
+    // Retransmitted message gets the same answer as the original one
+    unsigned long now = (unsigned long)time(NULL);
+    string cacheKey;
+    bool cacheable = TSrvReplyCache::makeKey(msg, cacheKey);
+    if (cacheable) {
+        TSrvReplyCache::TEntry* cached = ReplyCache_.find(cacheKey, now);
+        if (cached) {
+            resendReply(msg, *cached);
+            return;
+        }
+    }
+
     // LEASE ASSIGN STEP 1: Evaluate defined expressions (client classification)
     // Ask NodeClietSpecific to analyse the message
     NodeClientSpecific::analyseMessage(msg);
@@ -321,6 +240,10 @@ void TSrvTransMgr::relayMsg(SPtr<TSrvMsg> msg)
         return;
     }
 
+    if (templated && !SrvCfgMgr().stateless() && answerFromTemplate(msg, templateKey)) {
+        return;
+    }
+
     SPtr<TMsg> q, a; // question and answer
     q = SPtr_cast<TMsg>(msg);
 
@@ -397,19 +320,135 @@ void TSrvTransMgr::relayMsg(SPtr<TSrvMsg> msg)
     }
     }
 
+    // lifetimes extended by RENEW and REBIND must be persisted as well
+    if (msg->getType() == RENEW_MSG || msg->getType() == REBIND_MSG) {
+        SrvAddrMgr().leaseChanged(msg->getClientDUID());
+    }
+
+    if (templated && a && !a->isDone()) {
+        Templates_.add(templateKey, SPtr_cast<TSrvMsg>(a));
+    }
+
     if (a && !a->isDone()) {
         SPtr<TSrvMsg> answ = SPtr_cast<TSrvMsg>(a);
+        if (cacheable) {
+            ReplyCache_.add(cacheKey, answ, now);
+        }
 
-        // Send the packet
-        sendPacket(answ);
+        // Send the packet. Unless performance mode is enabled, REPLY is held
+        // until lease changes it confirms are committed to disk.
+        if (answ->getType() == REPLY_MSG && !SrvCfgMgr().getPerformanceMode() &&
+            SrvAddrMgr().commitPending()) {
+            Replies_.push_back(answ);
+        } else {
+            sendPacket(answ);
+        }
 
         // Call notify script
         SrvIfaceMgr().notifyScripts(SrvCfgMgr().getScriptName(), q, a);
     }
 
-    // save DB state regardless of action taken
-    SrvAddrMgr().dump();
-    SrvCfgMgr().dump();
+    // save DB state regardless of action taken (in group commit mode, once
+    // there are no more messages waiting or the batch is full)
+    if (!GroupCommit_ || Replies_.size() >= SERVER_LEASE_COMMIT_BATCH) {
+        commitLeases(!GroupCommit_);
+    }
+}
+
+/// @brief answers retransmitted message with the cached answer
+///
+/// @param msg retransmitted message
+/// @param cached cache entry with the answer to the original message
+///
+/// @return true if the answer was sent
+bool TSrvTransMgr::resendReply(SPtr<TSrvMsg> msg, TSrvReplyCache::TEntry& cached) {
+    // the answer is still waiting for a commit, it will be sent soon
+    for (size_t i = 0; i < Replies_.size(); ++i) {
+        if (&(*Replies_[i]) == &(*cached.reply)) {
+            Log(Debug) << "Retransmitted " << msg->getName() << " (transid=0x" << hex
+                       << msg->getTransID() << dec << ") dropped, answer is not sent yet."
+                       << LogEnd;
+            return false;
+        }
+    }
+
+    if (!TSrvReplyCache::encode(cached))
+        return false;
+    Log(Info) << "Retransmitted " << msg->getName() << " (transid=0x" << hex
+              << msg->getTransID() << dec << ") answered with cached "
+              << cached.reply->getName() << "." << LogEnd;
+    SrvIfaceMgr().send(cached.ifindex, &cached.data[0], cached.data.size(),
+                       cached.reply->getRemoteAddr(), cached.port);
+    return true;
+}
+
+/// @brief answers INFORMATION-REQUEST with a pre-encoded REPLY
+///
+/// @param msg received INFORMATION-REQUEST
+/// @param key template key (see TSrvReplyTemplates::makeKey())
+///
+/// @return true if there was a template for this message
+bool TSrvTransMgr::answerFromTemplate(SPtr<TSrvMsg> msg, const std::string& key) {
+    const TSrvReplyTemplates::TTemplate* tmpl = Templates_.find(key);
+    if (!tmpl)
+        return false;
+
+    std::vector<char> data;
+    int ifindex, port;
+    TSrvReplyTemplates::encode(*tmpl, msg, data, ifindex, port);
+    Log(Info) << "INF-REQUEST (transid=0x" << hex << msg->getTransID() << dec
+              << ") answered with pre-encoded REPLY." << LogEnd;
+    SrvIfaceMgr().send(ifindex, &data[0], data.size(), msg->getRemoteAddr(), port);
+    return true;
+}
+
+/// @brief enables group commit
+///
+/// In group commit mode, lease changes (and replies that confirm them) are
+/// not committed after every message. The server loop calls commitLeases()
+/// once there are no more messages waiting, so all of them share a single
+/// disk flush.
+///
+/// @param enabled true to enable group commit
+void TSrvTransMgr::setGroupCommit(bool enabled) {
+    GroupCommit_ = enabled;
+}
+
+/// returns true if there are replies waiting for a commit
+bool TSrvTransMgr::hasPendingReplies() const {
+    return !Replies_.empty();
+}
+
+/// @brief commits lease changes (if due) and sends replies waiting for them
+///
+/// Replies are sent only once the changes they confirm are on disk. If the
+/// commit fails, they are dropped (and removed from the reply cache), so
+/// clients retransmit and get their answers after a successful commit.
+///
+/// @param force commit pending changes even if they are not due yet
+///              (performance mode)
+void TSrvTransMgr::commitLeases(bool force) {
+    if (SrvAddrMgr().commitPending()) {
+        if (!force && !SrvAddrMgr().commitDue((unsigned long)time(NULL)))
+            return; // held replies (if any) wait for the commit
+
+        if (!SrvAddrMgr().commit()) {
+            if (!Replies_.empty())
+                Log(Error) << Replies_.size() << " REPLY(s) dropped, lease changes they confirm "
+                           << "are not on disk." << LogEnd;
+            for (size_t i = 0; i < Replies_.size(); ++i) {
+                ReplyCache_.remove(Replies_[i]);
+            }
+            Replies_.clear();
+            return;
+        }
+        SrvCfgMgr().dump();
+    }
+
+    for (size_t i = 0; i < Replies_.size(); ++i) {
+        sendPacket(Replies_[i]);
+    }
+    Replies_.clear();
 }
 
 void TSrvTransMgr::sendPacket(SPtr<TSrvMsg> msg) {
@@ -423,7 +462,7 @@ void TSrvTransMgr::sendPacket(SPtr<TSrvMsg> msg) {
 bool TSrvTransMgr::unicastCheck(SPtr<TSrvMsg> msg) {
 
     // If it's relayed message, then it's ok
-    if (!msg->RelayInfo_.empty())
+    if (!msg->getRelayChain().empty())
         return true;
 
     // Ok, we don't know what address it was received on.
@@ -478,6 +517,11 @@ void TSrvTransMgr::doDuties()
     std::vector<TSrvAddrMgr::TExpiredInfo> tempAddrLst;
     std::vector<TSrvAddrMgr::TExpiredInfo> prefixLst;
 
+    unsigned long now = (unsigned long)time(NULL);
+    ReplyCache_.expire(now);
+    Reconfigures_.doDuties(now);
+    SrvCfgMgr().updateHostDBs(now);
+
     if (!SrvAddrMgr().getValidTimeout()) {
         SrvAddrMgr().doDuties(addrLst, tempAddrLst, prefixLst);
         removeExpired(addrLst, tempAddrLst, prefixLst);
@@ -556,7 +600,11 @@ void TSrvTransMgr::removeExpired(std::vector<TSrvAddrMgr::TExpiredInfo>& addrLst
         if (dnsAddr && fqdn) {
 	    SrvIfaceMgr().delFQDN(addr->ia->getIfindex(), dnsAddr,
 				  addr->addr, fqdn->getName());
-	    /// @todo: remove this FQDN from the list of used names
+        }
+        if (fqdn) {
+            SPtr<TSrvCfgIface> cfgIface = SrvCfgMgr().getIfaceByID(addr->ia->getIfindex());
+            if (cfgIface)
+                cfgIface->getFQDNRegistry().release(fqdn);
         }
 
         SrvAddrMgr().delClntAddr(addr->client->getDUID(),
@@ -608,12 +656,14 @@ void TSrvTransMgr::removeExpired(std::vector<TSrvAddrMgr::TExpiredInfo>& addrLst
         SrvIfaceMgr().notifyScript(SrvCfgMgr().getScriptName(), "expire", params);
     }
 
-    SrvAddrMgr().dump();
-    SrvCfgMgr().dump();
+    if (!GroupCommit_) {
+        commitLeases(true);
+    }
 }
 
 void TSrvTransMgr::shutdown()
 {
+    commitLeases(true);
     SrvAddrMgr().dump();
     IsDone = true;
 }
@@ -684,6 +734,22 @@ bool TSrvTransMgr::sanitizeAddrDB() {
                                              currentIndexToName);
 }
 
+/// @brief reconciles loaded database with the configuration
+///
+/// Every lease is checked once (see TSrvLeaseReconciler): interface
+/// names/indexes are updated, pool usage counters are set, reserved
+/// entries are removed from the cache and clients with leases outside of
+/// the configured pools are reconfigured (if enabled).
+///
+/// @return false if the database can't be used
+bool TSrvTransMgr::reconcileLeases() {
+    TSrvLeaseReconciler reconciler;
+    TSrvReconfCampaign* campaign = 0;
+    if (SrvCfgMgr().getReconfigureSupport())
+        campaign = &Reconfigures_;
+    return reconciler.run(campaign, (unsigned long)time(NULL));
+}
+
 ostream & operator<<(ostream &s, TSrvTransMgr &x)
 {
     s << "<TSrvTransMgr>" << endl;
@@ -702,36 +768,6 @@ ostream & operator<<(ostream &s, TSrvTransMgr &x)
 /// @param PD is this PD?
 ///
 /// @return 
-bool TSrvTransMgr::ClientInPool1(SPtr<TIPv6Addr> addr, int iface, bool PD) {
-
-    SPtr<TSrvCfgIface> ptrIface = SrvCfgMgr().getIfaceByID(iface);
-    if (!ptrIface)
-	return false;
-    
-    if(PD) {
-        // checking prefix delegation
-        ptrIface->firstPD();
-        SPtr<TSrvCfgPD> PDClass;
-        while (PDClass = ptrIface->getPD()) {
-            if (PDClass->prefixInPool(addr)){
-                return true;
-            }
-        }
-        return false;
-    }
-    else {
-        // checking addresses
-    	ptrIface->firstAddrClass();
-    	SPtr<TSrvCfgAddrClass> addrClass;
-    	while (addrClass = ptrIface->getAddrClass()) {
-            if (addrClass->addrInPool(addr)){
-                return true;
-            }
-    	}
-    	return false;
-   }
-}
-
 bool TSrvTransMgr::sendReconfigure(SPtr<TIPv6Addr> addr, int iface,
                                    int msgType, SPtr<TDUID> ptrDUID)
 {
@@ -21,6 +21,10 @@
 #include "SrvIfaceMgr.h"
 #include "SrvCfgIface.h"
 #include "SrvAddrMgr.h"
+#include "SrvReplyCache.h"
+#include "SrvReplyTemplates.h"
+#include "SrvAdmission.h"
+#include "SrvReconfCampaign.h"
 
 #define SrvTransMgr() (TSrvTransMgr::instance())
 
@@ -57,6 +61,7 @@ class TSrvTransMgr
 #endif
 
     bool sanitizeAddrDB();
+    bool reconcileLeases();
 
     void removeExpired(std::vector<TSrvAddrMgr::TExpiredInfo>& addrLst,
                        std::vector<TSrvAddrMgr::TExpiredInfo>& tempAddrLst,
@@ -68,18 +73,31 @@ class TSrvTransMgr
     char * getCtrlAddr();
     int    getCtrlIface();
 
-    int checkReconfigures();
-
     bool sendReconfigure(SPtr<TIPv6Addr> addr, int iface,
                          int msgType, SPtr<TDUID> ptrDUID);
 
-    bool ClientInPool1(SPtr<TIPv6Addr> addr, int iface,bool PD);
-
     /// @brief sends specified packet
     ///
     /// @param msg message to be sent
     virtual void sendPacket(SPtr<TSrvMsg> msg);
 
+    // lease persistence (group commit)
+    void setGroupCommit(bool enabled);
+    bool hasPendingReplies() const;
+    void commitLeases(bool force = false);
+
+    /// returns cache of answers used for retransmitted messages
+    TSrvReplyCache& getReplyCache() { return ReplyCache_; }
+
+    /// returns pre-encoded answers to INFORMATION-REQUEST
+    TSrvReplyTemplates& getReplyTemplates() { return Templates_; }
+
+    /// returns admission control of received messages
+    TSrvAdmission& getAdmission() { return Admission_; }
+
+    /// returns RECONFIGURE campaign (progress can be checked there)
+    TSrvReconfCampaign& getReconfigures() { return Reconfigures_; }
+
     // not private, as we need to instantiate derived SrvTransMgr in tests
   protected:
     TSrvTransMgr(std::string xmlFile, int port);
@@ -94,6 +112,27 @@ class TSrvTransMgr
     static TSrvTransMgr * Instance;
 
     int port_;
+
+    /// replies held until lease changes they confirm are on disk
+    std::vector<SPtr<TSrvMsg> > Replies_;
+
+    /// if true, commits are driven by the server loop (see commitLeases())
+    bool GroupCommit_;
+
+    /// answers for retransmitted messages
+    TSrvReplyCache ReplyCache_;
+
+    /// pre-encoded answers to INFORMATION-REQUEST
+    TSrvReplyTemplates Templates_;
+
+    /// received messages waiting to be processed (see TDHCPServer::run())
+    TSrvAdmission Admission_;
+
+    /// clients with outdated leases being reconfigured
+    TSrvReconfCampaign Reconfigures_;
+
+    bool resendReply(SPtr<TSrvMsg> msg, TSrvReplyCache::TEntry& cached);
+    bool answerFromTemplate(SPtr<TSrvMsg> msg, const std::string& key);
 };
 
 
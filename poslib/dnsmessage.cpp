@@ -313,7 +313,7 @@ class PTruncatedException {
   PTruncatedException() { }
 };
 
-void DnsMessage::write_rr(DnsRR &rr, stl_string &message, stl_slist(dom_compr_info) *comprinfo,
+void DnsMessage::write_rr(DnsRR &rr, stl_string &message, dom_compr_table *comprinfo,
   int flags) {
   dom_write(message, rr.NAME.c_str(), comprinfo);
   message.append((char*)uint16_buff(rr.TYPE), 2);
@@ -328,7 +328,7 @@ void DnsMessage::write_rr(DnsRR &rr, stl_string &message, stl_slist(dom_compr_in
   message[p - 1] = (x - p);
 }
 
-void DnsMessage::write_section(stl_list(DnsRR)& section, int lenpos, stl_string& message, stl_slist(dom_compr_info) &comprinfo, int maxlen, bool is_additional) {
+void DnsMessage::write_section(stl_list(DnsRR)& section, int lenpos, stl_string& message, dom_compr_table &comprinfo, int maxlen, bool is_additional) {
     stl_list(DnsRR)::iterator it = section.begin();
 
     int n = 0, x;
@@ -358,7 +358,7 @@ void DnsMessage::write_section(stl_list(DnsRR)& section, int lenpos, stl_string&
 message_buff DnsMessage::compile(int maxlen) {
   stl_string msg;
   unsigned char ch;
-  stl_slist(dom_compr_info) comprinfo;
+  dom_compr_table comprinfo;
 
   try {
     msg.append((char*)uint16_buff(ID), 2);
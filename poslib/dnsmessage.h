@@ -24,6 +24,7 @@ class DnsRR;
 #define __POSLIB_DNSMESSAGE_H
 
 class message_buff;
+class dom_compr_table;
 
 #include <time.h>
 #include "dnsdefs.h"
@@ -508,9 +509,9 @@ class DnsMessage {
    */
   message_buff compile(int maxlen);
 
-  static void write_rr(DnsRR &rr, stl_string &message, stl_slist(dom_compr_info) *comprinfo,
+  static void write_rr(DnsRR &rr, stl_string &message, dom_compr_table *comprinfo,
   int flags = 0);
-  void write_section(stl_list(DnsRR)& section, int lenpos, stl_string& message, stl_slist(dom_compr_info) &comprinfo, int maxlen, bool is_additional = false);
+  void write_section(stl_list(DnsRR)& section, int lenpos, stl_string& message, dom_compr_table &comprinfo, int maxlen, bool is_additional = false);
   void read_section(stl_list(DnsRR)& section, int count, message_buff &buff, int &pos, unsigned int *tsig_pos = NULL);
   static DnsRR read_rr(message_buff &buff, int &pos, int flags = 0);
   
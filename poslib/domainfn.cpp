@@ -59,9 +59,14 @@ int dom_comprlen(message_buff &buff, int ix) {
 }
 
 _domain dom_uncompress(message_buff &buff, int ix) {
+  unsigned char dbuff[DOM_LEN];
+  dom_uncompress(buff, ix, dbuff);
+  return domdup(dbuff);
+}
+
+int dom_uncompress(message_buff &buff, int ix, _domain dbuff) {
   int reclevel = 0, len = 0, val;
   unsigned char *ptr = buff.msg + ix, *end = buff.msg + buff.len;
-  unsigned char dbuff[255];
 
   while (true) {
     if (ptr >= end) throw PException("Domain name exceeds message borders");
@@ -69,7 +74,7 @@ _domain dom_uncompress(message_buff &buff, int ix) {
     if (*ptr == 0) {
       /* we're at the end! */
       dbuff[len] = '\0';
-      return domdup(dbuff);
+      return len + 1;
     }
 
     if ((*ptr & 192) == 192) {
@@ -88,66 +93,90 @@ _domain dom_uncompress(message_buff &buff, int ix) {
     len += *ptr + 1;
     ptr += *ptr + 1;
   }
+}
 
-//  return domdup(dbuff);
+dom_compr_table::dom_compr_table() {
+  buckets.resize(64, -1);
 }
 
-dom_compr_info::dom_compr_info(_cdomain _dom, int _ix, int _nl, int _nul) {
-  dom = _dom;
-  ix = _ix;
-  nl = _nl;
-  nul = _nul;
+u_int32 dom_compr_table::hash(_cdomain label, u_int32 suffix_hash) {
+  /* FNV-1a over the (lowercase) label, continued from the suffix hash */
+  u_int32 h = (suffix_hash ^ 2166136261u) * 16777619u;
+  h = (h ^ *label) * 16777619u;
+  for (int t = 1; t <= *label; t++)
+    h = (h ^ (unsigned char)tolower(label[t])) * 16777619u;
+  return h;
 }
 
-int dom_partiallength(_cdomain _dom, int n) {
-  _domain dom = (_domain) _dom;
-  int len = 0;
-  while (--n >= 0) {
-    len += *dom + 1;
-    dom += *dom + 1;
+int dom_compr_table::find(_cdomain dom, u_int32 hash) const {
+  for (int e = buckets[hash & (buckets.size() - 1)]; e != -1; e = entries[e].next) {
+    if (entries[e].hash == hash && domcmp(entries[e].dom, dom))
+      return entries[e].ix;
+  }
+  return -1;
+}
+
+void dom_compr_table::add(_cdomain dom, u_int32 hash, int ix) {
+  if (entries.size() >= buckets.size())
+    rehash(buckets.size() * 2);
+  entry en;
+  en.dom = dom;
+  en.hash = hash;
+  en.ix = ix;
+  int &bucket = buckets[hash & (buckets.size() - 1)];
+  en.next = bucket;
+  bucket = entries.size();
+  entries.push_back(en);
+}
+
+void dom_compr_table::rehash(int nbuckets) {
+  buckets.assign(nbuckets, -1);
+  for (unsigned int e = 0; e < entries.size(); e++) {
+    int &bucket = buckets[entries[e].hash & (nbuckets - 1)];
+    entries[e].next = bucket;
+    bucket = e;
   }
-  return len;
 }
 
-void dom_write(stl_string &ret, _cdomain dom, stl_slist(dom_compr_info) *comprinfo) {
+void dom_write(stl_string &ret, _cdomain dom, dom_compr_table *comprinfo) {
   if (!comprinfo) {
     ret.append((char *)dom, domlen(dom));
     return;
   }
-  
-  stl_slist(dom_compr_info)::iterator it = comprinfo->begin(), best = comprinfo->end();
-  int nlabels = dom_nlabels(dom) - 1, x;
-  int ix = ret.size();
-
-  while (it != comprinfo->end()) {
-    if (nlabels >= it->nl && (best == comprinfo->end() || best->nul < it->nul)) {
-      if (domcmp(domfrom(dom, nlabels - it->nl), it->dom)) {
-        /* the same! */
-        best = it;
-        if (nlabels == best->nl) break; /* perfect match */
-      }
-    }
-    ++it;
+
+  /* labels and hashes of all suffixes (computed from the root) */
+  _cdomain labels[DOM_LEN / 2];
+  u_int32 hashes[DOM_LEN / 2];
+  int nlabels = 0, x;
+  for (_cdomain pdom = dom; *pdom; pdom += *pdom + 1) {
+    if (*pdom > DOMLABEL_LEN) throw PException(true, "Unknown domain nibble %d", *pdom);
+    if (nlabels == DOM_LEN / 2) throw PException("Length too long");
+    labels[nlabels++] = pdom;
+  }
+  u_int32 h = 0;
+  for (x = nlabels - 1; x >= 0; x--)
+    hashes[x] = h = dom_compr_table::hash(labels[x], h);
+
+  /* the longest suffix written earlier */
+  int ix = ret.size(), ptr = -1;
+  for (x = 0; x < nlabels; x++) {
+    if ((ptr = comprinfo->find(labels[x], hashes[x])) != -1) break;
   }
 
-  /* let's go! */
-  if (best == comprinfo->end()) {
+  /* let's go! x is the number of stored labels */
+  if (ptr == -1) {
     ret.append((char *)dom, domlen(dom));
-    x = nlabels; /* number of stored labels */
   } else {
     unsigned char val;
-    ret.append((char *)dom, dom_partiallength(dom, nlabels - best->nl));
-    val = (best->ix / 256) | 192; ret.append((char *)&val, 1);
-    val = best->ix; ret.append((char*)&val, 1);
-    x = nlabels - best->nl; /* number of stored labels */
+    ret.append((char *)dom, labels[x] - dom);
+    val = (ptr / 256) | 192; ret.append((char *)&val, 1);
+    val = ptr; ret.append((char*)&val, 1);
   }
 
-  /* add our information to the list */
-  _cdomain pdom = dom;
+  /* add our information to the table */
   for (int z = 0; z < x; z++) {
-    if (ix + (pdom - dom) >= 16384) break;
-    comprinfo->push_front(dom_compr_info(pdom, ix + (pdom - dom), nlabels - z, x - z));
-    pdom += *pdom + 1;
+    if (ix + (labels[z] - dom) >= 16384) break;
+    comprinfo->add(labels[z], hashes[z], ix + (labels[z] - dom));
   }
 }
 
@@ -209,45 +238,60 @@ bool domcmp(_cdomain _dom1, _cdomain _dom2) {
 }
 
 domainname::domainname() {
-  domain = (unsigned char *)strdup("");
+  domain = inline_buf;
+  domain[0] = '\0';
 }
 
 domainname::domainname(const char *string, const domainname& origin) {
   unsigned char tmp[DOM_LEN];
 
+  domain = inline_buf;
   txt_to_email(tmp, string, origin.domain);
-  domain = domdup(tmp);
+  assign(tmp, domlen(tmp));
 }
 
 domainname::domainname(const char *string, _cdomain origin) {
   unsigned char tmp[DOM_LEN];
 
+  domain = inline_buf;
   txt_to_email(tmp, string, origin);
-  domain = domdup(tmp);
+  assign(tmp, domlen(tmp));
 }
 
 domainname::domainname(message_buff &buff, int ix) {
-  domain = dom_uncompress(buff, ix);
+  unsigned char tmp[DOM_LEN];
+
+  domain = inline_buf;
+  assign(tmp, dom_uncompress(buff, ix, tmp));
 }
 
 
 domainname::domainname(bool val, const unsigned char* dom) {
-  domain = domdup(dom);
+  domain = inline_buf;
+  assign(dom, domlen(dom));
 }
 
 domainname::domainname(const domainname& nam) {
-  domain = domdup(nam.domain);
+  domain = inline_buf;
+  assign(nam.domain, domlen(nam.domain));
 }
 
 domainname::~domainname() {
-  free(domain);
+  if (domain != inline_buf) free(domain);
+}
+
+/* stores binary domain name (of specified length), short names are not
+   allocated on the heap */
+void domainname::assign(_cdomain dom, int len) {
+  unsigned char *old = domain;
+  unsigned char *dst = (len <= DOM_INLINE_LEN) ? inline_buf : (unsigned char *)malloc(len);
+  memmove(dst, dom, len);
+  if (old != inline_buf && old != dst) free(old);
+  domain = dst;
 }
 
 domainname& domainname::operator=(const domainname& nam) {
-  if (this != &nam) {
-    if (domain) free(domain);
-    domain = domdup(nam.domain);
-  }
+  if (this != &nam) assign(nam.domain, domlen(nam.domain));
   return *this;
 }
 
@@ -255,13 +299,8 @@ domainname& domainname::operator=(const domainname& nam) {
 domainname& domainname::operator=(const char *buff) {
   unsigned char tmp[DOM_LEN];
 
-  if (domain) {
-    free(domain);
-    domain = NULL;
-  }
-  
   txt_to_dname(tmp, buff, (unsigned char *)"");
-  domain = domdup(tmp);
+  assign(tmp, domlen(tmp));
   return *this;
 }
 
@@ -275,15 +314,14 @@ bool domainname::operator!=(const domainname& nam) const {
 }
 
 domainname& domainname::operator+=(const domainname& nam) {
+  unsigned char tmp[DOM_LEN];
   int lenres = domlen(domain),
       lensrc = domlen(nam.domain);
 
   if (lenres + lensrc - 1 > DOM_LEN) throw PException("Domain name too long");
-  unsigned char * tmp = (unsigned char *)realloc(domain, lenres + lensrc - 1);
-  if (tmp != NULL) {
-      domain = tmp;
-  }
-  memcpy(domain + lenres - 1, nam.domain, lensrc);
+  memcpy(tmp, domain, lenres - 1);
+  memcpy(tmp + lenres - 1, nam.domain, lensrc);
+  assign(tmp, lenres + lensrc - 1);
   return *this;
 }
 
@@ -23,6 +23,7 @@
 
 class domainname;
 
+#include <vector>
 #include "sysstl.h"
 #include "dnsmessage.h"
 
@@ -54,6 +55,14 @@ class domainname;
  */
 #define DOMLABEL_LEN 63
 
+/*!
+ * \brief Length of domain names stored within the domainname object
+ *
+ * Longer domain names are allocated on the heap. This is enough for reverse
+ * (ip6.arpa) names of IPv6 addresses.
+ */
+#define DOM_INLINE_LEN 96
+
 /*!
  * \brief class representing a domain name
  *
@@ -333,7 +342,10 @@ class domainname {
   int ncommon(const domainname &dom) const;
    
   private:
-  unsigned char *domain;
+  void assign(_cdomain dom, int len);
+
+  unsigned char *domain;                 /**< inline_buf or heap (long names) */
+  unsigned char inline_buf[DOM_INLINE_LEN];
 };
 
 /*!
@@ -377,17 +389,76 @@ int dom_comprlen(message_buff &buff, int ix);
 _domain dom_uncompress(message_buff &buff, int ix);
 
 /*!
- * \brief internal domain name compression structure
+ * \brief uncompress domain name into a buffer
+ *
+ * Same as dom_uncompress(message_buff&, int), but the domain name is stored
+ * in the buffer provided, nothing is allocated.
+ * \param buff A DNS message
+ * \param ix Index of the domain name
+ * \param dom Buffer for the domain name (at least DOM_LEN bytes)
+ * \return Length of the uncompressed domain name
+ */
+int dom_uncompress(message_buff &buff, int ix, _domain dom);
+
+/*!
+ * \brief domain name compression table
  *
- * Internal structure for domain name compression
+ * Remembers where domain names (and all their suffixes) were written in a
+ * DNS message, so that names written later can point to them. Suffixes are
+ * kept in a hash table, keyed by a case-insensitive hash of their labels, so
+ * the longest suffix already written is found without comparing the name
+ * with every name in the message.
+ *
+ * Suffixes are not copied, the table points to the domain names being
+ * written, so they must not be changed or freed while the table is in use.
  */
-struct dom_compr_info {
+class dom_compr_table {
  public:
-  dom_compr_info(_cdomain _dom, int _ix, int _nl, int _nul); /**< Constructor. */
-  _cdomain dom;                     /**< Pointer to binary domain. */
-  int ix;                                /**< Index in message. */
-  int nl;                                /**< Total number of labels. */
-  int nul;                               /**< Number of uncompressed labels. */
+  dom_compr_table(); /**< Constructor. */
+
+  /*!
+   * \brief hash of a domain name suffix
+   *
+   * \param label First label of the suffix
+   * \param suffix_hash Hash of the rest of the suffix (0 for the root)
+   * \return Hash of the suffix
+   */
+  static u_int32 hash(_cdomain label, u_int32 suffix_hash);
+
+  /*!
+   * \brief find a suffix written earlier
+   *
+   * \param dom Domain name suffix
+   * \param hash Hash of the suffix
+   * \return Index of the suffix in the message, or -1 if it was not written
+   */
+  int find(_cdomain dom, u_int32 hash) const;
+
+  /*!
+   * \brief remember a written suffix
+   *
+   * \param dom Domain name suffix
+   * \param hash Hash of the suffix
+   * \param ix Index of the suffix in the message
+   */
+  void add(_cdomain dom, u_int32 hash, int ix);
+
+  /*!
+   * \brief number of suffixes remembered
+   */
+  int size() const { return entries.size(); }
+
+ private:
+  struct entry {
+    _cdomain dom;   /**< Pointer to binary domain suffix. */
+    u_int32 hash;   /**< Hash of the suffix. */
+    int ix;         /**< Index in message. */
+    int next;       /**< Next entry in the same bucket (-1 if none). */
+  };
+  void rehash(int nbuckets);
+
+  std::vector<entry> entries;
+  std::vector<int> buckets;
 };
 
 /*!
@@ -397,9 +468,9 @@ struct dom_compr_info {
  * it if possible.
  * \param ret A (partial) DNS message
  * \param dom Domain name to write
- * \param compr List of earlier compressed domain names, or NULL if no compression
+ * \param compr Table of earlier written domain names, or NULL if no compression
  */
-void dom_write(stl_string &ret, _cdomain dom, stl_slist(dom_compr_info)* compr);
+void dom_write(stl_string &ret, _cdomain dom, dom_compr_table *compr);
 
 /* traditional domain-name functions */
 
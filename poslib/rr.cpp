@@ -202,7 +202,7 @@ void rr_read(u_int16 RRTYPE, unsigned char*& RDATA, uint16_t &RDLEN, message_buf
   RDATA = (unsigned char *)memdup((void *)res.c_str(), res.length());
 }
 
-void rr_write(u_int16 RRTYPE, unsigned char *RDATA, uint16_t RDLEN, stl_string &dnsmessage, stl_slist(dom_compr_info) *comprinfo) {
+void rr_write(u_int16 RRTYPE, unsigned char *RDATA, uint16_t RDLEN, stl_string &dnsmessage, dom_compr_table *comprinfo) {
   rr_type *info = rrtype_getinfo(RRTYPE);
   char *ptr;
   int len, ix = 0;
@@ -218,7 +218,7 @@ void rr_read(u_int16 RRTYPE, unsigned char*& RDATA, uint16_t &RDLEN, message_buf
  * \param dnsmessage The message to write to
  * \param comprinfo List of compressed domain names in DNS message, or NULL for no compression
  */
-void rr_write(u_int16 RRTYPE, unsigned char *RDATA, uint16_t RDLEN, stl_string &dnsmessage, stl_slist(dom_compr_info) *comprinfo);
+void rr_write(u_int16 RRTYPE, unsigned char *RDATA, uint16_t RDLEN, stl_string &dnsmessage, dom_compr_table *comprinfo);
 
 /*!
  * \brief convert a binary RR to string
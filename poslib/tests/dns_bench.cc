@@ -0,0 +1,117 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+/*
+ * DNS message building benchmark. This is not a unit test and it is not
+ * run by 'make check'. It builds UPDATE messages similar to those sent by
+ * the server (AAAA, DHCID and PTR records for every host), compiles them
+ * to wire format and parses them back. For every message size it reports
+ * CPU time and the number of heap allocations per message.
+ *
+ * Usage: ./poslib_bench [--gtest_filter=...]
+ */
+
+#include <stdlib.h>
+#include <sstream>
+#include <iomanip>
+#include "poslib.h"
+#include "bench_utils.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace test;
+
+namespace {
+
+/// DHCID RR type (RFC 4701), not known to qtype_getcode()
+const u_int16 BenchTypeDHCID = 49;
+
+class DnsBench : public ::testing::Test {
+public:
+    DnsBench() {
+        benchCnt_ = getenv("DIBBLER_BENCH_MSGS") ? atoi(getenv("DIBBLER_BENCH_MSGS")) : 200;
+    }
+
+    /// @brief adds RR with specified wire-format RDATA
+    void addRR(DnsMessage& msg, const domainname& name, u_int16 type, const stl_string& data) {
+        DnsRR rr(name, type, CLASS_IN, 7200);
+        rr.RDLENGTH = data.size();
+        rr.RDATA = (unsigned char*)memdup(data.c_str(), rr.RDLENGTH);
+        msg.authority.push_back(rr);
+    }
+
+    /// @brief creates UPDATE with AAAA, DHCID and PTR records for hosts
+    DnsMessage* createUpdate(int hosts) {
+        domainname zone("example.org");
+        DnsMessage* msg = new DnsMessage();
+        msg->OPCODE = OPCODE_UPDATE;
+        msg->questions.push_back(DnsQuestion(zone, DNS_TYPE_SOA));
+
+        for (int i = 0; i < hosts; i++) {
+            ostringstream host, addr, rev;
+            host << "host-" << i;
+            addr << "2001:db8:1::" << hex << i + 1;
+            domainname fqdn(host.str().c_str(), zone);
+
+            addRR(*msg, fqdn, DNS_TYPE_AAAA, rr_fromstring(DNS_TYPE_AAAA, addr.str().c_str()));
+            addRR(*msg, fqdn, BenchTypeDHCID, stl_string(35, (char)i));
+
+            // 2001:db8:1::<i+1> in ip6.arpa
+            for (int n = 0; n < 8; n++)
+                rev << hex << (((i + 1) >> (4 * n)) & 0xf) << ".";
+            rev << "0.0.0.0.0.0.0.0.0.0.0.0.0.0.0.0.0.0.0.0.1.0.0.0.8.b.d.0.1.0.0.2.ip6.arpa";
+            addRR(*msg, domainname(rev.str().c_str()), DNS_TYPE_PTR,
+                  rr_fromstring(DNS_TYPE_PTR, fqdn.tocstr()));
+        }
+        return msg;
+    }
+
+    /// @brief compiles and parses UPDATE, reports time and allocations
+    void run(int hosts) {
+        DnsMessage* msg = createUpdate(hosts);
+        int len = 0;
+
+        unsigned long long allocs = benchAllocs();
+        unsigned long long start = benchCpuNs();
+        for (int i = 0; i < benchCnt_; i++) {
+            message_buff buff = msg->compile(65535);
+            len = buff.len;
+        }
+        unsigned long long compileNs = benchCpuNs() - start;
+        unsigned long long compileAllocs = benchAllocs() - allocs;
+
+        message_buff wire = msg->compile(65535);
+        ASSERT_FALSE(msg->TC);
+        allocs = benchAllocs();
+        start = benchCpuNs();
+        for (int i = 0; i < benchCnt_; i++) {
+            DnsMessage parsed;
+            parsed.read_from_data(wire.msg, wire.len);
+            ASSERT_EQ(msg->authority.size(), parsed.authority.size());
+        }
+        unsigned long long parseNs = benchCpuNs() - start;
+        unsigned long long parseAllocs = benchAllocs() - allocs;
+        delete msg;
+
+        cout << "UPDATE " << setw(4) << 3 * hosts << " RRs, " << setw(5) << len << " bytes: "
+             << "compile " << fixed << setprecision(1) << compileNs / 1000.0 / benchCnt_
+             << "us " << compileAllocs / benchCnt_ << " allocs, "
+             << "parse " << parseNs / 1000.0 / benchCnt_
+             << "us " << parseAllocs / benchCnt_ << " allocs (per message)" << endl;
+    }
+
+protected:
+    int benchCnt_;
+};
+
+TEST_F(DnsBench, update) {
+    run(10);
+    run(100);
+    run(300);
+}
+
+}
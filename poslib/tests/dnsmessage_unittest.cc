@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "poslib.h"
+
+using namespace std;
+
+namespace {
+
+// checks that names are compressed against the longest suffix written
+// earlier, regardless of letter case
+TEST(DomainCompressionTest, suffixes) {
+    stl_string msg(12, '\0'); // message header
+    dom_compr_table table;
+
+    domainname www("www.example.org");
+    dom_write(msg, www.c_str(), &table);
+    EXPECT_EQ(12u + www.len(), msg.size());
+    EXPECT_EQ(3, table.size());
+
+    // mail + pointer to example.org (offset 16)
+    domainname mail("mail.EXAMPLE.org");
+    dom_write(msg, mail.c_str(), &table);
+    ASSERT_EQ(29u + 5 + 2, msg.size());
+    EXPECT_EQ(0xc0, (unsigned char)msg[34]);
+    EXPECT_EQ(16, msg[35]);
+
+    // the whole name was written already
+    domainname org("Org");
+    dom_write(msg, org.c_str(), &table);
+    ASSERT_EQ(38u, msg.size());
+    EXPECT_EQ(0xc0, (unsigned char)msg[36]);
+    EXPECT_EQ(24, msg[37]);
+
+    // nothing in common
+    domainname net("example.net");
+    dom_write(msg, net.c_str(), &table);
+    EXPECT_EQ(38u + net.len(), msg.size());
+
+    message_buff buff((unsigned char*)msg.c_str(), msg.size());
+    EXPECT_TRUE(domainname(buff, 29) == mail);
+    EXPECT_TRUE(domainname(buff, 36) == org);
+    EXPECT_EQ(2, dom_comprlen(buff, 36));
+}
+
+// checks that short names are kept within the object and long names on
+// the heap, and that both can be copied and concatenated
+TEST(DomainNameTest, storage) {
+    string label(40, 'a');
+    domainname shortName("host.example.org");
+    domainname longName((label + "." + label + "." + label + ".example.org").c_str());
+    EXPECT_EQ(3 * 41 + 13, longName.len());
+    EXPECT_EQ("host.example.org.", shortName.tostring());
+
+    domainname copy(longName);
+    EXPECT_TRUE(copy == longName);
+    copy = shortName;
+    EXPECT_TRUE(copy == shortName);
+    EXPECT_TRUE(longName.from(3) == domainname("example.org"));
+
+    // grows from the inline buffer to the heap
+    domainname name(label.c_str());
+    name += domainname((label + "." + label).c_str());
+    EXPECT_EQ(3 * 41 + 1, name.len());
+    EXPECT_TRUE(name.from(1) == domainname((label + "." + label).c_str()));
+    name = name.from(2);
+    EXPECT_EQ(41 + 1, name.len());
+}
+
+// checks that UPDATE with many names in the same zone is compressed and
+// parsed back
+TEST(DnsMessageTest, updateCompression) {
+    DnsMessage msg;
+    msg.OPCODE = OPCODE_UPDATE;
+    msg.questions.push_back(DnsQuestion(domainname("example.org"), DNS_TYPE_SOA));
+
+    for (int i = 0; i < 100; i++) {
+        ostringstream host, addr;
+        host << "host" << i;
+        addr << "2001:db8::" << hex << i + 1;
+        DnsRR rr(domainname(host.str().c_str(), domainname("example.org")), DNS_TYPE_AAAA,
+                 CLASS_IN, 3600);
+        stl_string data = rr_fromstring(rr.TYPE, addr.str().c_str());
+        rr.RDLENGTH = data.size();
+        rr.RDATA = (unsigned char*)memdup(data.c_str(), rr.RDLENGTH);
+        msg.authority.push_back(rr);
+    }
+
+    message_buff buff = msg.compile(65535);
+    // header, question, every RR: host label, pointer, type, class, TTL, rdlength, rdata
+    EXPECT_EQ(12 + 13 + 4 + 10 * (6 + 2 + 10 + 16) + 90 * (7 + 2 + 10 + 16),
+              buff.len);
+
+    DnsMessage parsed;
+    parsed.read_from_data(buff.msg, buff.len);
+    ASSERT_EQ(100u, parsed.authority.size());
+    EXPECT_TRUE(parsed.authority.back().NAME == domainname("host99.example.org"));
+}
+
+}
@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 #include "Key.h"
 #include "ClntIfaceMgr/ClntIfaceMgr.h"
+#include "IfaceMgr/IfaceMonitor.h"
 
 using namespace std;
 
@@ -105,4 +106,103 @@ TEST(ClntIfaceMgr, calculateSubprefixMidByte) {
 }
 
 
+
+addr_event_t makeAddrEvent(int type, int ifindex, const char* addr, int flags) {
+    addr_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.ifindex = ifindex;
+    TIPv6Addr tmp(addr, true);
+    memcpy(event.addr, tmp.getAddr(), 16);
+    event.prefix_len = 128;
+    event.flags = flags;
+    return event;
+}
+
+// This test verifies that DAD progress is tracked and reported only
+// once DAD is finished (successfully or not).
+TEST(IfaceMonitor, dad) {
+    TIfaceMonitor monitor;
+    std::vector<TIfaceMonitor::TEvent> events;
+    TIPv6AddrValue addr1 = TIPv6Addr("2001:db8::1", true).getValue();
+    TIPv6AddrValue addr2 = TIPv6Addr("2001:db8::2", true).getValue();
+
+    EXPECT_EQ(TIfaceMonitor::DAD_UNKNOWN, monitor.getDadState(5, addr1));
+
+    // tentative address appears, nothing to report yet
+    monitor.handle(makeAddrEvent(ADDR_EVENT_NEW_ADDR, 5, "2001:db8::1", ADDR_EVENT_FLAG_TENTATIVE));
+    monitor.handle(makeAddrEvent(ADDR_EVENT_NEW_ADDR, 5, "2001:db8::2", ADDR_EVENT_FLAG_TENTATIVE));
+    EXPECT_FALSE(monitor.getEvents(events));
+    EXPECT_EQ(TIfaceMonitor::DAD_IN_PROGRESS, monitor.getDadState(5, addr1));
+    EXPECT_EQ(TIfaceMonitor::DAD_UNKNOWN, monitor.getDadState(6, addr1));
+    EXPECT_EQ(2u, monitor.countAddrs());
+
+    // DAD finished for the first address and failed for the second one
+    monitor.handle(makeAddrEvent(ADDR_EVENT_NEW_ADDR, 5, "2001:db8::1", 0));
+    monitor.handle(makeAddrEvent(ADDR_EVENT_NEW_ADDR, 5, "2001:db8::2",
+                                 ADDR_EVENT_FLAG_TENTATIVE | ADDR_EVENT_FLAG_DADFAILED));
+    ASSERT_TRUE(monitor.getEvents(events));
+    ASSERT_EQ(2u, events.size());
+    EXPECT_EQ(TIfaceMonitor::EVENT_DAD_DONE, events[0].type);
+    EXPECT_EQ(5, events[0].ifindex);
+    EXPECT_TRUE(addr1 == events[0].addr);
+    EXPECT_EQ(TIfaceMonitor::EVENT_DAD_FAILED, events[1].type);
+    EXPECT_TRUE(addr2 == events[1].addr);
+    EXPECT_EQ(TIfaceMonitor::DAD_DONE, monitor.getDadState(5, addr1));
+    EXPECT_EQ(TIfaceMonitor::DAD_FAILED, monitor.getDadState(5, addr2));
+
+    // events are retrieved only once, repeated notification is not reported
+    monitor.handle(makeAddrEvent(ADDR_EVENT_NEW_ADDR, 5, "2001:db8::1", 0));
+    EXPECT_FALSE(monitor.getEvents(events));
+    EXPECT_TRUE(events.empty());
+
+    // address removed
+    monitor.handle(makeAddrEvent(ADDR_EVENT_DEL_ADDR, 5, "2001:db8::1", 0));
+    monitor.handle(makeAddrEvent(ADDR_EVENT_DEL_ADDR, 5, "2001:db8::3", 0));
+    ASSERT_TRUE(monitor.getEvents(events));
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(TIfaceMonitor::EVENT_ADDR_REMOVED, events[0].type);
+    EXPECT_EQ(TIfaceMonitor::DAD_UNKNOWN, monitor.getDadState(5, addr1));
+    EXPECT_EQ(1u, monitor.countAddrs());
+}
+
+// This test verifies that link transitions are reported.
+TEST(IfaceMonitor, links) {
+    TIfaceMonitor monitor;
+    std::vector<TIfaceMonitor::TEvent> events;
+    addr_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.ifindex = 7;
+
+    EXPECT_EQ(-1, monitor.getLinkState(7));
+
+    // link appears down, no transition
+    event.type = ADDR_EVENT_NEW_LINK;
+    monitor.handle(event);
+    EXPECT_FALSE(monitor.getEvents(events));
+    EXPECT_EQ(0, monitor.getLinkState(7));
+
+    event.flags = ADDR_EVENT_FLAG_RUNNING;
+    monitor.handle(event);
+    monitor.handle(event); // no change
+    ASSERT_TRUE(monitor.getEvents(events));
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(TIfaceMonitor::EVENT_LINK_UP, events[0].type);
+    EXPECT_EQ(7, events[0].ifindex);
+    EXPECT_EQ(1, monitor.getLinkState(7));
+
+    event.flags = 0;
+    monitor.handle(event);
+    event.flags = ADDR_EVENT_FLAG_RUNNING;
+    monitor.handle(event);
+    event.type = ADDR_EVENT_DEL_LINK;
+    monitor.handle(event);
+    ASSERT_TRUE(monitor.getEvents(events));
+    ASSERT_EQ(3u, events.size());
+    EXPECT_EQ(TIfaceMonitor::EVENT_LINK_DOWN, events[0].type);
+    EXPECT_EQ(TIfaceMonitor::EVENT_LINK_UP, events[1].type);
+    EXPECT_EQ(TIfaceMonitor::EVENT_LINK_DOWN, events[2].type);
+    EXPECT_EQ(-1, monitor.getLinkState(7));
+}
+
 }
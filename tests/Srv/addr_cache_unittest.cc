@@ -0,0 +1,152 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * author: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <stdio.h>
+#include "IPv6Addr.h"
+#include "DUID.h"
+#include "SrvAddrCache.h"
+#include "SrvAddrMgr.h"
+#include "assign_utils.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace test {
+
+// checks that the least recently used entry is removed when cache is full
+TEST(SrvAddrCacheTest, lru) {
+    TSrvAddrCache cache;
+    cache.setMaxSize(2);
+
+    SPtr<TDUID> duid1 = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TDUID> duid2 = new TDUID("00:01:00:00:00:00:00:02");
+    SPtr<TDUID> duid3 = new TDUID("00:01:00:00:00:00:00:03");
+    SPtr<TIPv6Addr> addr1 = new TIPv6Addr("2001:db8::1", true);
+    SPtr<TIPv6Addr> addr2 = new TIPv6Addr("2001:db8::2", true);
+    SPtr<TIPv6Addr> addr3 = new TIPv6Addr("2001:db8::3", true);
+
+    cache.add(duid1, addr1, IATYPE_IA);
+    cache.add(duid2, addr2, IATYPE_IA);
+    EXPECT_EQ(2u, cache.count());
+
+    // duid1 is used, so duid2 becomes the oldest one
+    ASSERT_TRUE(cache.get(duid1, IATYPE_IA));
+    EXPECT_TRUE(*cache.get(duid1, IATYPE_IA) == *addr1);
+    EXPECT_FALSE(cache.get(duid1, IATYPE_PD));
+
+    cache.add(duid3, addr3, IATYPE_IA);
+    EXPECT_EQ(2u, cache.count());
+    EXPECT_FALSE(cache.get(duid2, IATYPE_IA));
+    EXPECT_TRUE(cache.get(duid1, IATYPE_IA));
+    EXPECT_TRUE(cache.get(duid3, IATYPE_IA));
+
+    // delete by address
+    EXPECT_TRUE(cache.del(addr3, IATYPE_IA));
+    EXPECT_FALSE(cache.del(addr3, IATYPE_IA));
+    EXPECT_FALSE(cache.get(duid3, IATYPE_IA));
+    EXPECT_EQ(1u, cache.count());
+
+    // disabled cache does not store anything
+    cache.setMaxSize(0);
+    EXPECT_EQ(0u, cache.count());
+    cache.add(duid2, addr2, IATYPE_IA);
+    EXPECT_EQ(0u, cache.count());
+}
+
+// checks that there is at most one entry per client and per address
+TEST(SrvAddrCacheTest, replace) {
+    TSrvAddrCache cache;
+    cache.setMaxSize(10);
+
+    SPtr<TDUID> duid1 = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TDUID> duid2 = new TDUID("00:01:00:00:00:00:00:02");
+    SPtr<TIPv6Addr> addr1 = new TIPv6Addr("2001:db8::1", true);
+    SPtr<TIPv6Addr> addr2 = new TIPv6Addr("2001:db8::2", true);
+
+    cache.add(duid1, addr1, IATYPE_IA);
+    cache.add(duid1, addr2, IATYPE_IA);
+    EXPECT_EQ(1u, cache.count());
+    EXPECT_TRUE(*cache.get(duid1, IATYPE_IA) == *addr2);
+
+    // address and prefix entries are separate
+    cache.add(duid1, addr1, IATYPE_PD);
+    EXPECT_EQ(2u, cache.count());
+
+    // address cached for another client is taken over
+    cache.add(duid2, addr2, IATYPE_IA);
+    EXPECT_EQ(2u, cache.count());
+    EXPECT_FALSE(cache.get(duid1, IATYPE_IA));
+    EXPECT_TRUE(*cache.get(duid2, IATYPE_IA) == *addr2);
+}
+
+// checks that changes written to journal can be replayed
+TEST(SrvAddrCacheTest, journal) {
+    const char* file = "cache-test.journal";
+    unlink(file);
+
+    SPtr<TDUID> duid1 = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TDUID> duid2 = new TDUID("00:01:00:00:00:00:00:02");
+    SPtr<TDUID> duid3 = new TDUID("00:01:00:00:00:00:00:03");
+
+    TSrvAddrCache cache;
+    cache.setMaxSize(10);
+    cache.add(duid1, new TIPv6Addr("2001:db8::1", true), IATYPE_IA);
+    cache.add(duid2, new TIPv6Addr("2001:db8::2", true), IATYPE_IA);
+    EXPECT_TRUE(cache.flush(file));
+    cache.add(duid3, new TIPv6Addr("2001:db8:1::", true), IATYPE_PD);
+    EXPECT_TRUE(cache.del(duid1, IATYPE_IA));
+    EXPECT_TRUE(cache.flush(file));
+    EXPECT_EQ(4u, cache.getJournalSize());
+
+    TSrvAddrCache loaded;
+    loaded.setMaxSize(10);
+    EXPECT_EQ(4, loaded.replay(file));
+    EXPECT_EQ(2u, loaded.count());
+    EXPECT_FALSE(loaded.get(duid1, IATYPE_IA));
+    ASSERT_TRUE(loaded.get(duid2, IATYPE_IA));
+    EXPECT_EQ(string("2001:db8::2"), string(loaded.get(duid2, IATYPE_IA)->getPlain()));
+    ASSERT_TRUE(loaded.get(duid3, IATYPE_PD));
+    EXPECT_EQ(string("2001:db8:1::"), string(loaded.get(duid3, IATYPE_PD)->getPlain()));
+
+    // replayed changes are not recorded again
+    EXPECT_TRUE(loaded.flush(file));
+    TSrvAddrCache again;
+    again.setMaxSize(10);
+    EXPECT_EQ(4, again.replay(file));
+
+    // after snapshot, journal is empty
+    cache.resetJournal(file);
+    EXPECT_EQ(0u, cache.getJournalSize());
+    EXPECT_EQ(0, again.replay(file));
+
+    unlink(file);
+}
+
+// checks that server appends cache changes to the journal
+TEST_F(ServerTest, SrvAddrMgr_cacheJournal) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    SPtr<TDUID> duid = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TIPv6Addr> addr = new TIPv6Addr("2001:db8:123::1", true);
+
+    SrvAddrMgr().addCachedEntry(duid, addr, IATYPE_IA);
+    ASSERT_TRUE(SrvAddrMgr().getCachedEntry(duid, IATYPE_IA));
+    SrvAddrMgr().dump();
+
+    TSrvAddrCache cache;
+    cache.setMaxSize(10);
+    EXPECT_EQ(1, cache.replay(SRVCACHE_JOURNAL_FILE));
+    ASSERT_TRUE(cache.get(duid, IATYPE_IA));
+    EXPECT_TRUE(*cache.get(duid, IATYPE_IA) == *addr);
+}
+
+}
@@ -0,0 +1,169 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * author: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "SrvAdmission.h"
+#include "SrvMsgSolicit.h"
+#include "SrvMsgRequest.h"
+#include "SrvMsgRenew.h"
+#include "assign_utils.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace test {
+
+class AdmissionTest : public ServerTest {
+public:
+    AdmissionTest() {
+        string cfg = "iface REPLACE_ME {\n"
+                     "  class { pool 2001:db8:123::/64 }\n"
+                     "}\n";
+        EXPECT_TRUE(createMgrs(cfg));
+    }
+
+    /// creates message of specified type, sent by specified client
+    SPtr<TSrvMsg> createMsg(int type, int client) {
+        char buf[] = { (char)type, 0, 0, (char)client };
+        SPtr<TSrvMsg> msg;
+        switch (type) {
+        case SOLICIT_MSG:
+            msg = new TSrvMsgSolicit(iface_->getID(), clntAddr_, buf, sizeof(buf));
+            break;
+        case REQUEST_MSG:
+            msg = new TSrvMsgRequest(iface_->getID(), clntAddr_, buf, sizeof(buf));
+            break;
+        default:
+            msg = new TSrvMsgRenew(iface_->getID(), clntAddr_, buf, sizeof(buf));
+        }
+        char duid[] = { 0, 1, 0, 0, 0, 0, 0, 0, (char)client };
+        msg->addOption(new TOptDUID(OPTION_CLIENTID, new TDUID(duid, sizeof(duid)), &(*msg)));
+        return msg;
+    }
+};
+
+// checks that the most important messages are processed first
+TEST_F(AdmissionTest, priority) {
+    TSrvAdmission admission;
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 1), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(REQUEST_MSG, 2), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(RENEW_MSG, 3), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 4), 0));
+    EXPECT_EQ(4u, admission.count());
+
+    SPtr<TSrvMsg> msg = admission.dequeue(0);
+    ASSERT_TRUE(msg);
+    EXPECT_EQ(RENEW_MSG, msg->getType());
+    ASSERT_TRUE(msg = admission.dequeue(0));
+    EXPECT_EQ(REQUEST_MSG, msg->getType());
+    ASSERT_TRUE(msg = admission.dequeue(0));
+    EXPECT_EQ(1u, msg->getTransID());
+    ASSERT_TRUE(msg = admission.dequeue(0));
+    EXPECT_EQ(4u, msg->getTransID());
+    EXPECT_FALSE(admission.dequeue(0));
+
+    EXPECT_EQ(2u, admission.getStats(TSrvAdmission::PRIO_SOLICIT).processed);
+    EXPECT_EQ(0u, admission.dropped(TSrvAdmission::PRIO_SOLICIT));
+}
+
+// checks that late SOLICITs are dropped, other messages are not
+TEST_F(AdmissionTest, delay) {
+    TSrvAdmission admission;
+    admission.setMaxDelay(500);
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 1), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(RENEW_MSG, 2), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 3), 400));
+
+    // the oldest SOLICIT is late already, new ones are not accepted
+    EXPECT_FALSE(admission.enqueue(createMsg(SOLICIT_MSG, 4), 600));
+    EXPECT_TRUE(admission.enqueue(createMsg(RENEW_MSG, 5), 600));
+
+    SPtr<TSrvMsg> msg = admission.dequeue(600);
+    ASSERT_TRUE(msg);
+    EXPECT_EQ(2u, msg->getTransID());
+    ASSERT_TRUE(msg = admission.dequeue(600));
+    EXPECT_EQ(5u, msg->getTransID());
+    ASSERT_TRUE(msg = admission.dequeue(600));
+    EXPECT_EQ(3u, msg->getTransID());
+    EXPECT_FALSE(admission.dequeue(600));
+
+    EXPECT_EQ(2u, admission.getStats(TSrvAdmission::PRIO_SOLICIT).delay);
+    EXPECT_EQ(0u, admission.dropped(TSrvAdmission::PRIO_BOUND));
+}
+
+// checks that less important messages are dropped when queues are full
+TEST_F(AdmissionTest, full) {
+    TSrvAdmission admission;
+    admission.setQueueLimit(2);
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 1), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 2), 0));
+    EXPECT_FALSE(admission.enqueue(createMsg(SOLICIT_MSG, 3), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(RENEW_MSG, 4), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(REQUEST_MSG, 5), 0));
+    EXPECT_FALSE(admission.enqueue(createMsg(REQUEST_MSG, 6), 0));
+    EXPECT_EQ(2u, admission.count());
+
+    EXPECT_EQ(3u, admission.getStats(TSrvAdmission::PRIO_SOLICIT).full);
+    EXPECT_EQ(1u, admission.getStats(TSrvAdmission::PRIO_REQUEST).full);
+    EXPECT_EQ(4u, admission.dequeue(0)->getTransID());
+    EXPECT_EQ(5u, admission.dequeue(0)->getTransID());
+}
+
+// checks per-client and per-relay rate limits
+TEST_F(AdmissionTest, rate) {
+    TSrvAdmission admission;
+    admission.setClientRate(1, 2);
+    admission.setRelayRate(2, 3);
+    admission.setMaxDelay(0);
+    admission.setOverload(0);
+
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 1), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 1), 0));
+    EXPECT_FALSE(admission.enqueue(createMsg(SOLICIT_MSG, 1), 500));
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 1), 1000));
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 2), 1000));
+    EXPECT_EQ(1u, admission.getStats(TSrvAdmission::PRIO_SOLICIT).client);
+
+    // relayed messages, each from a different client
+    TOptList echo;
+    for (int client = 10; client < 14; client++) {
+        SPtr<TSrvMsg> msg = createMsg(RENEW_MSG, client);
+        msg->addRelayInfo(new TIPv6Addr("2001:db8::1", true), new TIPv6Addr("fe80::1", true),
+                          0, echo);
+        EXPECT_EQ(client < 13, admission.enqueue(msg, 1000));
+    }
+    EXPECT_EQ(1u, admission.getStats(TSrvAdmission::PRIO_BOUND).relay);
+}
+
+// checks that rate limits apply only when the server is overloaded
+TEST_F(AdmissionTest, rateOverload) {
+    TSrvAdmission admission;
+    admission.setClientRate(1, 1);
+    admission.setOverload(3);
+
+    // nothing is charged while there are less than 3 messages queued
+    EXPECT_TRUE(admission.enqueue(createMsg(RENEW_MSG, 1), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(RENEW_MSG, 1), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(RENEW_MSG, 1), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(RENEW_MSG, 1), 0));
+    EXPECT_FALSE(admission.enqueue(createMsg(RENEW_MSG, 1), 0));
+    EXPECT_EQ(1u, admission.getStats(TSrvAdmission::PRIO_BOUND).client);
+
+    // queue drained, client is accepted again
+    while (admission.dequeue(0))
+        ;
+    EXPECT_TRUE(admission.enqueue(createMsg(RENEW_MSG, 1), 0));
+
+    // late SOLICIT means overload as well
+    admission.setOverload(100);
+    EXPECT_TRUE(admission.enqueue(createMsg(SOLICIT_MSG, 2), 0));
+    EXPECT_TRUE(admission.enqueue(createMsg(REQUEST_MSG, 3), 1000));
+    EXPECT_FALSE(admission.enqueue(createMsg(REQUEST_MSG, 3), 1000));
+}
+
+}
@@ -386,4 +386,139 @@ TEST_F(ServerTest, SARR_outpool_reservation) {
 }
 
 
+// checks that pool counters count allocations and report usage
+TEST(SrvPoolCounterTest, snapshot) {
+    TSrvPoolCounter counter;
+    counter.setTotal(200);
+
+    EXPECT_EQ(1u, counter.incr());
+    EXPECT_EQ(11u, counter.incr(10));
+    EXPECT_EQ(10u, counter.decr());
+
+    TSrvPoolCounter::TSnapshot s = counter.snapshot(1000);
+    EXPECT_EQ(200u, s.total);
+    EXPECT_EQ(10u, s.assigned);
+    EXPECT_EQ(190u, s.free);
+    EXPECT_EQ(5u, s.utilization);
+    EXPECT_EQ(11u, s.allocs);
+    EXPECT_EQ(1u, s.releases);
+    EXPECT_EQ(0.0, s.allocRate); // no previous snapshot
+
+    counter.incr(20);
+    s = counter.snapshot(1010);
+    EXPECT_EQ(30u, s.assigned);
+    EXPECT_EQ(15u, s.utilization);
+    EXPECT_DOUBLE_EQ(2.0, s.allocRate);
+
+    // recount does not count as allocations
+    counter.set(150);
+    s = counter.snapshot(1020);
+    EXPECT_EQ(150u, s.assigned);
+    EXPECT_EQ(75u, s.utilization);
+    EXPECT_EQ(0.0, s.allocRate);
+}
+
+// checks that pool usage is recounted from leases (without counting them
+// twice) and reported for every pool
+TEST_F(ServerTest, SrvCfgMgr_poolStats) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::1-2001:db8:123::64 }\n"
+                 "  pd-class {\n"
+                 "    pd-pool 2001:db8:456::/48\n"
+                 "    pd-length 56\n"
+                 "  }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    SPtr<TDUID> duid = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TIPv6Addr> clntAddr = new TIPv6Addr("fe80::1", true);
+    int ifindex = iface_->getID();
+    string ifname = iface_->getName();
+
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid, clntAddr, ifindex, 1, 10, 20,
+                                         new TIPv6Addr("2001:db8:123::1", true), 100, 200, true));
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid, clntAddr, ifindex, 1, 10, 20,
+                                         new TIPv6Addr("2001:db8:123::64", true), 100, 200, true));
+    // outside of the pool
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid, clntAddr, ifindex, 1, 10, 20,
+                                         new TIPv6Addr("2001:db8:123::65", true), 100, 200, true));
+    EXPECT_TRUE(SrvAddrMgr().addPrefix(duid, clntAddr, ifname, ifindex, 2, 10, 20,
+                                       new TIPv6Addr("2001:db8:456:100::", true), 100, 200,
+                                       56, true));
+
+    SrvCfgMgr().setCounters();
+    SrvCfgMgr().setCounters();
+
+    SPtr<TSrvCfgIface> cfgIface = SrvCfgMgr().getIfaceByID(ifindex);
+    ASSERT_TRUE(cfgIface);
+    cfgIface->firstAddrClass();
+    SPtr<TSrvCfgAddrClass> addrClass = cfgIface->getAddrClass();
+    ASSERT_TRUE(addrClass);
+    EXPECT_EQ(2u, addrClass->getAssignedCount());
+    cfgIface->firstPD();
+    SPtr<TSrvCfgPD> pd = cfgIface->getPD();
+    ASSERT_TRUE(pd);
+    EXPECT_EQ(1u, pd->getAssignedCount());
+    EXPECT_EQ(255u, pd->countFree());
+
+    addrClass->incrAssigned();
+
+    vector<TSrvCfgMgr::TPoolStats> stats;
+    SrvCfgMgr().getPoolStats(stats);
+    ASSERT_EQ(2u, stats.size());
+
+    EXPECT_EQ(ifindex, stats[0].ifindex);
+    EXPECT_EQ(IATYPE_IA, stats[0].type);
+    EXPECT_EQ(addrClass->getID(), stats[0].id);
+    EXPECT_EQ(100u, stats[0].usage.total);
+    EXPECT_EQ(3u, stats[0].usage.assigned);
+    EXPECT_EQ(97u, stats[0].usage.free);
+    EXPECT_EQ(3u, stats[0].usage.utilization);
+    EXPECT_EQ(1u, stats[0].usage.allocs);
+
+    EXPECT_EQ(IATYPE_PD, stats[1].type);
+    EXPECT_EQ(256u, stats[1].usage.total);
+    EXPECT_EQ(1u, stats[1].usage.assigned);
+    EXPECT_EQ(255u, stats[1].usage.free);
+}
+
+// checks that each lease is counted once, in the first matching class on
+// its own interface
+TEST_F(ServerTest, SrvCfgMgr_setCountersOverlap) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::1-2001:db8:123::64 }\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    SPtr<TDUID> duid = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TIPv6Addr> clntAddr = new TIPv6Addr("fe80::1", true);
+    int ifindex = iface_->getID();
+
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid, clntAddr, ifindex, 1, 10, 20,
+                                         new TIPv6Addr("2001:db8:123::1", true), 100, 200, true));
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid, clntAddr, ifindex, 1, 10, 20,
+                                         new TIPv6Addr("2001:db8:123::100", true), 100, 200, true));
+    // leased on another interface
+    SPtr<TDUID> duid2 = new TDUID("00:01:00:00:00:00:00:02");
+    SPtr<TAddrClient> client = new TAddrClient(duid2);
+    SPtr<TAddrIA> ia = new TAddrIA("eth9", ifindex + 1000, IATYPE_IA, SPtr<TIPv6Addr>(),
+                                   duid2, 10, 20, 2);
+    ia->addAddr(new TIPv6Addr("2001:db8:123::2", true), 100, 200);
+    client->addIA(ia);
+    SrvAddrMgr().addClient(client);
+
+    SrvCfgMgr().setCounters();
+
+    SPtr<TSrvCfgIface> cfgIface = SrvCfgMgr().getIfaceByID(ifindex);
+    ASSERT_TRUE(cfgIface);
+    cfgIface->firstAddrClass();
+    SPtr<TSrvCfgAddrClass> first = cfgIface->getAddrClass();
+    SPtr<TSrvCfgAddrClass> second = cfgIface->getAddrClass();
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    EXPECT_EQ(1u, first->getAssignedCount());
+    EXPECT_EQ(1u, second->getAssignedCount());
+}
+
 }
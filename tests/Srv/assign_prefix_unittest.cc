@@ -10,6 +10,7 @@
 #include "HostRange.h"
 #include "assign_utils.h"
 #include <gtest/gtest.h>
+#include <set>
 
 using namespace std;
 
@@ -363,6 +364,14 @@ TEST_F(ServerTest, SARR_prefix_inpool_reservation_negative2) {
     ASSERT_TRUE(rcvStatusCode);
 
     EXPECT_EQ(STATUSCODE_NOPREFIXAVAIL, rcvStatusCode->getCode());
+
+    // reserved prefix is not leased, so the pool still tracks it as free
+    SPtr<TSrvCfgIface> cfgIface = SrvCfgMgr().getIfaceByID(iface_->getID());
+    ASSERT_TRUE(cfgIface);
+    cfgIface->firstPD();
+    SPtr<TSrvCfgPD> cfgPD = cfgIface->getPD();
+    ASSERT_TRUE(cfgPD);
+    EXPECT_EQ(1u, cfgPD->countFree());
 }
 
 
@@ -487,4 +496,106 @@ TEST_F(ServerTest, SARR_prefix_hint_nonzero_host_part) {
                SERVER_DEFAULT_MIN_PREF, SERVER_DEFAULT_MIN_VALID);
 }
 
+// This test checks that PD class tracks free prefixes: every prefix from
+// the pool is handed out exactly once and released prefixes can be reused.
+TEST_F(ServerTest, SARR_prefix_allocator) {
+
+    string cfg = "iface REPLACE_ME {\n"
+        "  pd-class {\n"
+        "    pd-pool 2001:db8:123::/62\n"
+        "    pd-length 64\n"
+        "  }\n"
+        "}\n";
+
+    ASSERT_TRUE( createMgrs(cfg) );
+
+    SPtr<TSrvCfgIface> cfgIface = SrvCfgMgr().getIfaceByID(iface_->getID());
+    ASSERT_TRUE(cfgIface);
+    cfgIface->firstPD();
+    SPtr<TSrvCfgPD> cfgPD = cfgIface->getPD();
+    ASSERT_TRUE(cfgPD);
+
+    EXPECT_EQ(4u, cfgPD->countFree());
+
+    set<string> assigned;
+    uint64_t index;
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(cfgPD->getFreeIndex(index));
+        SPtr<TIPv6Addr> prefix = cfgPD->getPrefix(index);
+        ASSERT_TRUE(prefix);
+        EXPECT_TRUE(cfgPD->prefixInPool(prefix));
+        EXPECT_TRUE(assigned.insert(prefix->getPlain()).second);
+
+        // this is what the server does when a prefix is leased
+        EXPECT_TRUE(SrvCfgMgr().incrPrefixCount(iface_->getID(), prefix));
+    }
+    EXPECT_EQ(0u, cfgPD->countFree());
+    EXPECT_FALSE(cfgPD->getFreeIndex(index));
+
+    // prefixes that are not in the pool are not tracked
+    EXPECT_FALSE(cfgPD->markFree(new TIPv6Addr("2001:db8:124::", true)));
+    EXPECT_FALSE(cfgPD->markFree(new TIPv6Addr("2001:db8:123:1::1", true)));
+
+    // released prefix is the only one available
+    SPtr<TIPv6Addr> released = new TIPv6Addr("2001:db8:123:2::", true);
+    EXPECT_TRUE(SrvCfgMgr().decrPrefixCount(iface_->getID(), released));
+    EXPECT_EQ(1u, cfgPD->countFree());
+    ASSERT_TRUE(cfgPD->getFreeIndex(index));
+    EXPECT_EQ(string("2001:db8:123:2::"), string(cfgPD->getPrefix(index)->getPlain()));
+
+    // neighbouring free prefixes are merged
+    EXPECT_TRUE(cfgPD->markFree(new TIPv6Addr("2001:db8:123:3::", true)));
+    EXPECT_TRUE(cfgPD->markFree(new TIPv6Addr("2001:db8:123:1::", true)));
+    EXPECT_EQ(3u, cfgPD->countFree());
+    EXPECT_TRUE(cfgPD->markUsed(new TIPv6Addr("2001:db8:123:2::", true)));
+    EXPECT_EQ(2u, cfgPD->countFree());
+}
+
+// This test checks that the server gives up (instead of looping forever) when
+// the only prefix in the pool is already leased.
+TEST_F(ServerTest, SARR_prefix_pool_exhausted) {
+
+    string cfg = "iface REPLACE_ME {\n"
+        "  pd-class {\n"
+        "    pd-pool 2001:db8:123::/64\n"
+        "    pd-length 64\n"
+        "  }\n"
+        "}\n";
+
+    ASSERT_TRUE( createMgrs(cfg) );
+
+    // lease the only prefix to someone else, without updating the pool
+    SPtr<TDUID> otherDuid = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TIPv6Addr> leased = new TIPv6Addr("2001:db8:123::", true);
+    ASSERT_TRUE(SrvAddrMgr().addPrefix(otherDuid, new TIPv6Addr("fe80::1", true),
+                                       iface_->getName(), iface_->getID(), 1, 100, 200,
+                                       leased, 300, 400, 64, true));
+    EXPECT_FALSE(SrvAddrMgr().prefixIsFree(leased));
+
+    // client sends a hint for the used prefix
+    SPtr<TSrvMsg> sol = createSolicit(true, false, true);
+    pd_->setIAID(100);
+    pd_->addOption(new TSrvOptIAPrefix(leased, 64, 1000, 2000, &(*sol)));
+
+    SPtr<TSrvMsg> adv = sendAndReceive(sol, 1);
+    ASSERT_TRUE(adv);
+
+    SPtr<TSrvOptIA_PD> rcvPD = SPtr_cast<TSrvOptIA_PD>(adv->getOption(OPTION_IA_PD));
+    ASSERT_TRUE(rcvPD);
+    EXPECT_FALSE(rcvPD->getOption(OPTION_IAPREFIX));
+
+    SPtr<TOptStatusCode> rcvStatusCode =
+        SPtr_cast<TOptStatusCode>(rcvPD->getOption(OPTION_STATUS_CODE));
+    ASSERT_TRUE(rcvStatusCode);
+    EXPECT_EQ(STATUSCODE_NOPREFIXAVAIL, rcvStatusCode->getCode());
+
+    // the leased prefix is no longer considered free by the pool
+    SPtr<TSrvCfgIface> cfgIface = SrvCfgMgr().getIfaceByID(iface_->getID());
+    ASSERT_TRUE(cfgIface);
+    cfgIface->firstPD();
+    SPtr<TSrvCfgPD> cfgPD = cfgIface->getPD();
+    ASSERT_TRUE(cfgPD);
+    EXPECT_EQ(0u, cfgPD->countFree());
+}
+
 }
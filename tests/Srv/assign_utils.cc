@@ -28,6 +28,17 @@ bool NakedSrvIfaceMgr::send(int iface, char *msg, int size, SPtr<TIPv6Addr> addr
 int NakedSrvIfaceMgr::receive(unsigned long timeout, char* buf, int& bufsize,
                               SPtr<TIPv6Addr> peer, SPtr<TIPv6Addr> myaddr) {
 
+    if (!injected_.empty()) {
+        const Pkt6Info& pkt = injected_.front();
+        int sockid = pkt.Iface_;
+        if ((int)pkt.Data_.size() < bufsize)
+            bufsize = pkt.Data_.size();
+        memcpy(buf, &pkt.Data_[0], bufsize);
+        *peer = *pkt.Addr_;
+        injected_.pop_front();
+        return sockid;
+    }
+
     return TSrvIfaceMgr::receive(timeout, buf, bufsize, peer, myaddr);
 }
 
@@ -229,7 +240,8 @@ SPtr<TSrvMsg> ServerTest::sendAndReceive(SPtr<TSrvMsg> clntMsg,
 }
 
 void NakedSrvTransMgr::sendPacket(SPtr<TSrvMsg> msg) {
-    std::cout << "Pretending to send packet" << std::endl;
+    if (!Quiet_)
+        std::cout << "Pretending to send packet" << std::endl;
     MsgLst_.push_back(msg);
 }
 
@@ -255,6 +267,7 @@ bool ServerTest::createMgrs(std::string config) {
     cfgfile.close();
 
     unlink("server-cache.xml");
+    unlink("server-cache.journal");
 
     cfgmgr_ = new NakedSrvCfgMgr("testdata/server.conf", "testdata/server-CfgMgr.xml");
     addrmgr_ = new NakedSrvAddrMgr("testdata/server-AddrMgr.xml", false); // don't load db
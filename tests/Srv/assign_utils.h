@@ -12,6 +12,7 @@
 #include "SrvOptIA_NA.h"
 #include "SrvOptIA_PD.h"
 #include <string>
+#include <deque>
 #include <unistd.h>
 
 namespace test {
@@ -33,6 +34,12 @@ namespace test {
 
         Pkt6Collection sent_pkts_;
 
+        /// @brief packets returned by receive() before any socket is read
+        ///
+        /// Iface_ field holds the socket descriptor the packet is received on,
+        /// Addr_ is the sender.
+        std::deque<Pkt6Info> injected_;
+
         NakedSrvIfaceMgr(const std::string& xmlFile)
             : TSrvIfaceMgr(xmlFile) {
             TSrvIfaceMgr::Instance = this;
@@ -55,6 +62,11 @@ namespace test {
         ~NakedSrvAddrMgr() {
             TSrvAddrMgr::Instance = NULL;
         }
+        /// makes database snapshots and journal writes fail
+        void breakStorage() {
+            Journal_.close();
+            XmlFile = "testdata/nonexistent/server-AddrMgr.xml";
+        }
     };
 
     class NakedSrvCfgMgr : public TSrvCfgMgr {
@@ -71,7 +83,7 @@ namespace test {
     class NakedSrvTransMgr: public TSrvTransMgr {
     public:
         NakedSrvTransMgr(const std::string& xmlFile, int port)
-            :TSrvTransMgr(xmlFile, port) {
+            :TSrvTransMgr(xmlFile, port), Quiet_(false) {
             TSrvTransMgr::Instance = this;
         }
 
@@ -84,6 +96,9 @@ namespace test {
         }
 
         SrvMsgList MsgLst_;
+
+        /// @brief don't print anything when pretending to send (used by benchmarks)
+        bool Quiet_;
     };
 
     class ServerTest : public ::testing::Test {
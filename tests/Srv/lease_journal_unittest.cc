@@ -0,0 +1,286 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * author: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "IPv6Addr.h"
+#include "DUID.h"
+#include "SrvLeaseJournal.h"
+#include "SrvAddrMgr.h"
+#include "SrvCfgMgr.h"
+#include "assign_utils.h"
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace test {
+
+// checks that leases can be found and expire once added to address manager
+TEST_F(ServerTest, SrvAddrMgr_leases) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    SPtr<TDUID> duid = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TIPv6Addr> clntAddr = new TIPv6Addr("fe80::1", true);
+    SPtr<TIPv6Addr> addr1 = new TIPv6Addr("2001:db8:123::1", true);
+    SPtr<TIPv6Addr> addr2 = new TIPv6Addr("2001:db8:123::2", true);
+    int ifindex = iface_->getID();
+
+    EXPECT_TRUE(SrvAddrMgr().addrIsFree(addr1));
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid, clntAddr, ifindex, 1, 10, 20, addr1,
+                                         100, 200, true));
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid, clntAddr, ifindex, 1, 10, 20, addr2,
+                                         0, 0, true));
+    EXPECT_FALSE(SrvAddrMgr().addrIsFree(addr1));
+    EXPECT_FALSE(SrvAddrMgr().addrIsFree(addr2));
+    EXPECT_EQ(2u, SrvAddrMgr().getLeaseCount(duid));
+
+    SPtr<TAddrClient> client = SrvAddrMgr().getClient(addr1);
+    ASSERT_TRUE(client);
+    EXPECT_TRUE(*client->getDUID() == *duid);
+    EXPECT_TRUE(&(*SrvAddrMgr().getClient(duid)) == &(*client));
+
+    // only the address with zero lifetime has expired
+    vector<TSrvAddrMgr::TExpiredInfo> addrs, tas, prefixes;
+    SrvAddrMgr().doDuties(addrs, tas, prefixes);
+    ASSERT_EQ(1u, addrs.size());
+    EXPECT_TRUE(*addrs[0].addr == *addr2);
+    EXPECT_TRUE(&(*addrs[0].client) == &(*client));
+    ASSERT_TRUE(addrs[0].ia);
+    EXPECT_EQ(1u, addrs[0].ia->getIAID());
+    EXPECT_TRUE(tas.empty());
+    EXPECT_TRUE(prefixes.empty());
+
+    EXPECT_TRUE(SrvAddrMgr().delClntAddr(duid, 1, addr2, true));
+    EXPECT_TRUE(SrvAddrMgr().addrIsFree(addr2));
+    EXPECT_EQ(1u, SrvAddrMgr().getLeaseCount(duid));
+
+    // removing last address removes the client
+    EXPECT_TRUE(SrvAddrMgr().delClntAddr(duid, 1, addr1, true));
+    EXPECT_TRUE(SrvAddrMgr().addrIsFree(addr1));
+    EXPECT_FALSE(SrvAddrMgr().getClient(duid));
+    EXPECT_FALSE(SrvAddrMgr().getClient(addr1));
+    EXPECT_EQ(0, SrvAddrMgr().countClient());
+}
+
+// collects records replayed from the lease journal
+struct JournalRecord {
+    char type;
+    string duid;
+    string data;
+};
+
+void journalHandler(char type, SPtr<TDUID> duid, const char* data, size_t len, void* arg) {
+    JournalRecord rec;
+    rec.type = type;
+    rec.duid = duid->getPlain();
+    rec.data = string(data, len);
+    static_cast<vector<JournalRecord>*>(arg)->push_back(rec);
+}
+
+// checks that journal records are written on commit and replayed, and that
+// truncated (not committed completely) record at the end is ignored
+TEST(SrvLeaseJournalTest, replay) {
+    const char* file = "testdata/test-lease.journal";
+    SPtr<TDUID> duid1 = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TDUID> duid2 = new TDUID("00:01:00:00:00:00:00:02");
+    vector<char> data(3, 'x');
+
+    {
+        TSrvLeaseJournal journal;
+        ASSERT_TRUE(journal.open(file, true));
+        journal.add(TSrvLeaseJournal::JOURNAL_CLIENT, duid1, data);
+        journal.add(TSrvLeaseJournal::JOURNAL_DELETE, duid2, vector<char>());
+        EXPECT_EQ(2u, journal.pending());
+        EXPECT_EQ(0u, journal.getSize());
+        EXPECT_TRUE(journal.commit());
+        EXPECT_EQ(0u, journal.pending());
+        EXPECT_EQ(2u, journal.getSize());
+
+        // not committed, lost
+        journal.add(TSrvLeaseJournal::JOURNAL_DELETE, duid1, vector<char>());
+    }
+
+    // partially written record
+    FILE* f = fopen(file, "ab");
+    ASSERT_TRUE(f);
+    fwrite("\0\0\0\x20" "C", 1, 5, f);
+    fclose(f);
+
+    vector<JournalRecord> records;
+    TSrvLeaseJournal journal;
+    EXPECT_EQ(2, journal.replay(file, journalHandler, &records));
+    EXPECT_EQ(2u, journal.getSize());
+    ASSERT_EQ(2u, records.size());
+    EXPECT_EQ(TSrvLeaseJournal::JOURNAL_CLIENT, records[0].type);
+    EXPECT_EQ(duid1->getPlain(), records[0].duid);
+    EXPECT_EQ("xxx", records[0].data);
+    EXPECT_EQ(TSrvLeaseJournal::JOURNAL_DELETE, records[1].type);
+    EXPECT_EQ(duid2->getPlain(), records[1].duid);
+    EXPECT_EQ("", records[1].data);
+
+    // reset truncates the journal
+    ASSERT_TRUE(journal.open(file, false));
+    EXPECT_TRUE(journal.reset());
+    records.clear();
+    EXPECT_EQ(0, journal.replay(file, journalHandler, &records));
+    EXPECT_TRUE(records.empty());
+
+    remove(file);
+}
+
+// checks that committed lease changes are recovered from the journal
+TEST_F(ServerTest, SrvAddrMgr_journal) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    // separate database, so no snapshot is loaded
+    const string xml = "testdata/journal-AddrMgr.xml";
+    delete addrmgr_;
+    addrmgr_ = new NakedSrvAddrMgr(xml, false);
+
+    SPtr<TDUID> duid1 = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TDUID> duid2 = new TDUID("00:01:00:00:00:00:00:02");
+    SPtr<TIPv6Addr> clntAddr = new TIPv6Addr("fe80::1", true);
+    SPtr<TIPv6Addr> addr1 = new TIPv6Addr("2001:db8:123::1", true);
+    SPtr<TIPv6Addr> addr2 = new TIPv6Addr("2001:db8:123::2", true);
+    int ifindex = iface_->getID();
+
+    EXPECT_FALSE(SrvAddrMgr().commitPending());
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid1, clntAddr, ifindex, 1, 10, 20, addr1,
+                                         100, 200, true));
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid2, clntAddr, ifindex, 2, 10, 20, addr2,
+                                         100, 200, true));
+    EXPECT_TRUE(SrvAddrMgr().commitPending());
+    EXPECT_TRUE(SrvAddrMgr().commitDue(0));
+    EXPECT_TRUE(SrvAddrMgr().commit());
+    EXPECT_FALSE(SrvAddrMgr().commitPending());
+
+    EXPECT_TRUE(SrvAddrMgr().delClntAddr(duid2, 2, addr2, true));
+    EXPECT_TRUE(SrvAddrMgr().commit());
+
+    // not committed, lost
+    EXPECT_TRUE(SrvAddrMgr().delClntAddr(duid1, 1, addr1, true));
+
+    NakedSrvAddrMgr* restored = new NakedSrvAddrMgr(xml, true);
+    EXPECT_EQ(1, restored->countClient());
+    EXPECT_TRUE(restored->getClient(duid1));
+    EXPECT_FALSE(restored->getClient(duid2));
+    EXPECT_FALSE(restored->addrIsFree(addr1));
+    EXPECT_TRUE(restored->addrIsFree(addr2));
+    delete restored;
+
+    remove(TSrvAddrMgr::journalName(xml).c_str());
+}
+
+// checks that snapshots are written in binary format only and XML is
+// written on explicit export
+TEST_F(ServerTest, SrvAddrMgr_exportXml) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    const string xml = "testdata/export-AddrMgr.xml";
+    const string bin = TAddrMgr::binaryDbName(xml);
+    const string exported = "testdata/exported-AddrMgr.xml";
+    remove(xml.c_str());
+    remove(bin.c_str());
+    delete addrmgr_;
+    addrmgr_ = new NakedSrvAddrMgr(xml, false);
+
+    SPtr<TDUID> duid = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TIPv6Addr> addr = new TIPv6Addr("2001:db8:123::1", true);
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid, new TIPv6Addr("fe80::1", true), iface_->getID(),
+                                         1, 10, 20, addr, 100, 200, true));
+    SrvAddrMgr().dump();
+    EXPECT_EQ(0, access(bin.c_str(), F_OK));
+    EXPECT_NE(0, access(xml.c_str(), F_OK));
+
+    ASSERT_TRUE(SrvAddrMgr().exportXml(exported));
+    NakedSrvAddrMgr* restored = new NakedSrvAddrMgr(exported, true);
+    EXPECT_EQ(1, restored->countClient());
+    EXPECT_FALSE(restored->addrIsFree(addr));
+    delete restored;
+
+    remove(bin.c_str());
+    remove(exported.c_str());
+    remove(TSrvAddrMgr::journalName(xml).c_str());
+    remove(TSrvAddrMgr::journalName(exported).c_str());
+}
+
+// checks that replies are held until leases they confirm are committed
+TEST_F(ServerTest, SrvTransMgr_groupCommit) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+    transmgr_->setGroupCommit(true);
+
+    // ADVERTISE does not change any leases, sent immediately
+    SPtr<TSrvMsg> adv = sendAndReceive(createSolicit(true, true), 1);
+    ASSERT_TRUE(adv);
+    EXPECT_FALSE(transmgr_->hasPendingReplies());
+
+    SPtr<TSrvMsg> req = createRequest(true, true);
+    ASSERT_TRUE(adv->getOption(OPTION_SERVERID));
+    req->addOption(adv->getOption(OPTION_SERVERID));
+    transmgr_->relayMsg(req);
+    EXPECT_EQ(1u, transmgr_->getMsgLst().size());
+    EXPECT_TRUE(transmgr_->hasPendingReplies());
+    EXPECT_TRUE(SrvAddrMgr().commitPending());
+
+    transmgr_->commitLeases();
+    EXPECT_FALSE(transmgr_->hasPendingReplies());
+    EXPECT_FALSE(SrvAddrMgr().commitPending());
+    ASSERT_EQ(2u, transmgr_->getMsgLst().size());
+    EXPECT_EQ(REPLY_MSG, transmgr_->getMsgLst().back()->getType());
+}
+
+
+// checks that replies are not sent if leases they confirm can't be committed
+TEST_F(ServerTest, SrvTransMgr_groupCommitFailed) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+    transmgr_->setGroupCommit(true);
+
+    SPtr<TSrvMsg> adv = sendAndReceive(createSolicit(true, true), 1);
+    ASSERT_TRUE(adv);
+    SPtr<TSrvMsg> req = createRequest(true, true);
+    req->addOption(adv->getOption(OPTION_SERVERID));
+    transmgr_->relayMsg(req);
+    EXPECT_TRUE(transmgr_->hasPendingReplies());
+    size_t cached = transmgr_->getReplyCache().count();
+
+    addrmgr_->breakStorage();
+    transmgr_->commitLeases(true);
+    EXPECT_EQ(1u, transmgr_->getMsgLst().size());
+    EXPECT_FALSE(transmgr_->hasPendingReplies());
+    EXPECT_EQ(cached - 1, transmgr_->getReplyCache().count());
+
+    // client stays changed, but the commit is not retried immediately
+    EXPECT_TRUE(SrvAddrMgr().commitPending());
+    EXPECT_FALSE(SrvAddrMgr().commitDue((unsigned long)time(NULL)));
+    EXPECT_LT(0u, SrvAddrMgr().getCommitTimeout((unsigned long)time(NULL)));
+
+    // retransmission is processed again (not answered from the cache)
+    transmgr_->relayMsg(req);
+    EXPECT_TRUE(transmgr_->hasPendingReplies());
+    transmgr_->commitLeases();
+    EXPECT_TRUE(transmgr_->hasPendingReplies());
+    EXPECT_EQ(1u, transmgr_->getMsgLst().size());
+}
+
+}
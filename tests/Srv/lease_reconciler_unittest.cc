@@ -0,0 +1,122 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * author: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "SrvLeaseReconciler.h"
+#include "SrvTransMgr.h"
+#include "SrvAddrMgr.h"
+#include "assign_utils.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace test {
+
+// checks that every lease is checked once: pool counters are set, clients
+// with leases outside of pools are reconfigured and unknown interfaces are
+// reported
+TEST_F(ServerTest, SrvLeaseReconciler_run) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::1-2001:db8:123::64 }\n"
+                 "  pd-class {\n"
+                 "    pd-pool 2001:db8:456::/48\n"
+                 "    pd-length 56\n"
+                 "  }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    SPtr<TIPv6Addr> clntAddr = new TIPv6Addr("fe80::1", true);
+    int ifindex = iface_->getID();
+    string ifname = iface_->getName();
+
+    // client 1 has valid leases, clients 2 and 3 use old pools
+    SPtr<TDUID> duid1 = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TDUID> duid2 = new TDUID("00:01:00:00:00:00:00:02");
+    SPtr<TDUID> duid3 = new TDUID("00:01:00:00:00:00:00:03");
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid1, clntAddr, ifindex, 1, 10, 20,
+                                         new TIPv6Addr("2001:db8:123::1", true), 100, 200, true));
+    EXPECT_TRUE(SrvAddrMgr().addPrefix(duid1, clntAddr, ifname, ifindex, 2, 10, 20,
+                                       new TIPv6Addr("2001:db8:456:100::", true), 100, 200,
+                                       56, true));
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid2, clntAddr, ifindex, 1, 10, 20,
+                                         new TIPv6Addr("2001:db8:999::1", true), 100, 200, true));
+    EXPECT_TRUE(SrvAddrMgr().addPrefix(duid3, clntAddr, ifname, ifindex, 2, 10, 20,
+                                       new TIPv6Addr("2001:db8:999:100::", true), 100, 200,
+                                       56, true));
+
+    TSrvLeaseReconciler reconciler;
+    TSrvReconfCampaign& campaign = transmgr_->getReconfigures();
+    ASSERT_TRUE(reconciler.run(&campaign, 1000));
+    EXPECT_EQ(4u, reconciler.getLeaseCount());
+    EXPECT_TRUE(reconciler.getInvalid().empty());
+    EXPECT_EQ(5u, reconciler.getPhases().size());
+
+    EXPECT_TRUE(reconciler.inPool(ifindex, IATYPE_IA, TIPv6Addr("2001:db8:123::64", true).getValue()));
+    EXPECT_FALSE(reconciler.inPool(ifindex, IATYPE_IA, TIPv6Addr("2001:db8:123::65", true).getValue()));
+    EXPECT_FALSE(reconciler.inPool(ifindex + 1, IATYPE_IA, TIPv6Addr("2001:db8:123::1", true).getValue()));
+    EXPECT_TRUE(reconciler.inPool(ifindex, IATYPE_PD, TIPv6Addr("2001:db8:456:ff00::", true).getValue()));
+
+    SPtr<TSrvCfgIface> cfgIface = SrvCfgMgr().getIfaceByID(ifindex);
+    ASSERT_TRUE(cfgIface);
+    cfgIface->firstAddrClass();
+    EXPECT_EQ(1u, cfgIface->getAddrClass()->getAssignedCount());
+    cfgIface->firstPD();
+    EXPECT_EQ(1u, cfgIface->getPD()->getAssignedCount());
+
+    // only the affected clients are checked by the campaign
+    ASSERT_EQ(2u, reconciler.getReconfigure().size());
+    EXPECT_TRUE(*reconciler.getReconfigure()[0] == *duid2);
+    EXPECT_TRUE(*reconciler.getReconfigure()[1] == *duid3);
+    EXPECT_TRUE(campaign.isActive());
+    EXPECT_EQ(2u, campaign.getProgress().clients);
+    campaign.stop();
+
+    // interface not present in the system
+    SPtr<TAddrClient> client = SrvAddrMgr().getClient(duid2);
+    ASSERT_TRUE(client);
+    client->firstIA();
+    client->getIA()->setIfacename("nosuch0");
+    EXPECT_FALSE(reconciler.run(0, 1000));
+    ASSERT_EQ(1u, reconciler.getInvalid().size());
+    EXPECT_EQ("nosuch0", reconciler.getInvalid()[0].iface);
+    EXPECT_EQ(IATYPE_IA, reconciler.getInvalid()[0].type);
+}
+
+// checks that a lease in overlapping classes is counted once, in the class
+// that comes first in the configuration
+TEST_F(ServerTest, SrvLeaseReconciler_overlap) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::10-2001:db8:123::64 }\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    SPtr<TDUID> duid = new TDUID("00:01:00:00:00:00:00:01");
+    SPtr<TIPv6Addr> clntAddr = new TIPv6Addr("fe80::1", true);
+    int ifindex = iface_->getID();
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid, clntAddr, ifindex, 1, 10, 20,
+                                         new TIPv6Addr("2001:db8:123::20", true), 100, 200, true));
+    EXPECT_TRUE(SrvAddrMgr().addClntAddr(duid, clntAddr, ifindex, 1, 10, 20,
+                                         new TIPv6Addr("2001:db8:123::100", true), 100, 200, true));
+
+    TSrvLeaseReconciler reconciler;
+    ASSERT_TRUE(reconciler.run(0, 1000));
+    EXPECT_TRUE(reconciler.getReconfigure().empty());
+
+    SPtr<TSrvCfgIface> cfgIface = SrvCfgMgr().getIfaceByID(ifindex);
+    ASSERT_TRUE(cfgIface);
+    cfgIface->firstAddrClass();
+    SPtr<TSrvCfgAddrClass> first = cfgIface->getAddrClass();
+    SPtr<TSrvCfgAddrClass> second = cfgIface->getAddrClass();
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    EXPECT_EQ(1u, first->getAssignedCount());
+    EXPECT_EQ(1u, second->getAssignedCount());
+}
+
+}
@@ -1,6 +1,8 @@
 #include "assign_utils.h"
 #include <gtest/gtest.h>
 #include "OptAddrLst.h"
+#include "OptOptionRequest.h"
+#include "OptGeneric.h"
 
 using namespace std;
 
@@ -34,4 +36,93 @@ TEST_F(ServerTest, CfgMgr_options1) {
     EXPECT_FALSE(addrLst.get()); // no additional addresses
 }
 
+// Checks that static options are pre-encoded properly and that only options
+// requested in ORO are appended (once each) to the response.
+TEST_F(ServerTest, CfgMgr_encodedOptions) {
+
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:1111::/64 }\n"
+                 "  option nis-server 2000::400,2000::401\n"
+                 "  option nis-domain nis.example.com\n"
+                 "  option nis+-server 2000::501,2000::502\n"
+                 "}\n";
+
+    ASSERT_TRUE( createMgrs(cfg) );
+
+    // encoded form must be identical to what the original option stores
+    SPtr<TOpt> opt = cfgIface_->getExtraOption(OPTION_NIS_SERVERS);
+    ASSERT_TRUE(opt);
+    const TOptList& encodedLst = cfgIface_->getEncodedExtraOptions(OPTION_NIS_SERVERS);
+    ASSERT_EQ(1u, encodedLst.size());
+    SPtr<TOpt> encoded = encodedLst.front();
+    ASSERT_EQ(opt->getSize(), encoded->getSize());
+
+    vector<char> expected(opt->getSize()), actual(encoded->getSize());
+    opt->storeSelf(&expected[0]);
+    encoded->storeSelf(&actual[0]);
+    EXPECT_TRUE(expected == actual);
+
+    EXPECT_TRUE(cfgIface_->getEncodedExtraOptions(OPTION_NISP_DOMAIN_NAME).empty());
+
+    // now ask for NIS servers (twice) and NIS domain
+    SPtr<TSrvMsg> sol = createSolicit(true, true);
+    SPtr<TOptOptionRequest> oro = new TOptOptionRequest(OPTION_ORO, &(*sol));
+    oro->addOption(OPTION_NIS_SERVERS);
+    oro->addOption(OPTION_NIS_DOMAIN_NAME);
+    oro->addOption(OPTION_NIS_SERVERS);
+    sol->addOption(SPtr_cast<TOpt>(oro));
+
+    SPtr<TSrvMsg> adv = sendAndReceive(sol, 1);
+    ASSERT_TRUE(adv);
+
+    int nis = 0, nisDomain = 0, nisp = 0;
+    adv->firstOption();
+    while (SPtr<TOpt> x = adv->getOption()) {
+        switch (x->getOptType()) {
+        case OPTION_NIS_SERVERS:
+            nis++;
+            break;
+        case OPTION_NIS_DOMAIN_NAME:
+            nisDomain++;
+            break;
+        case OPTION_NISP_SERVERS:
+            nisp++;
+            break;
+        default:
+            break;
+        }
+    }
+    EXPECT_EQ(1, nis);
+    EXPECT_EQ(1, nisDomain);
+    EXPECT_EQ(0, nisp); // configured, but not requested
+}
+
+
+/// option that stores more bytes than it reports
+class OversizedOpt : public TOptGeneric {
+public:
+    OversizedOpt() :TOptGeneric(OPTION_PREFERENCE, "x", 1, NULL) {}
+    char* storeSelf(char* buf) {
+        return TOptGeneric::storeSelf(buf) + 1;
+    }
+};
+
+// checks that a message is not stored if it does not fit in the buffer or
+// if an option stores a different number of bytes than it reported
+TEST_F(ServerTest, Msg_storeBounded) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    SPtr<TSrvMsg> msg = createSolicit(true, false);
+    size_t len = msg->getSize();
+    vector<char> buf(len + 16);
+    EXPECT_EQ(static_cast<int>(len), msg->storeSelf(&buf[0], len));
+    EXPECT_EQ(-1, msg->storeSelf(&buf[0], len - 1));
+
+    msg->addOption(new OversizedOpt());
+    EXPECT_EQ(-1, msg->storeSelf(&buf[0], buf.size()));
+}
+
 }
@@ -0,0 +1,91 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * author: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "SrvReconfCampaign.h"
+#include "SrvTransMgr.h"
+#include "SrvAddrMgr.h"
+#include "assign_utils.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace std;
+
+namespace test {
+
+// checks that clients with leases outside of the configured pools are
+// reconfigured at the configured rate, retransmitted to and that their
+// outdated leases are removed
+TEST_F(ServerTest, SrvReconfCampaign_pacing) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+    int ifindex = iface_->getID();
+
+    // client 0 uses a valid address, clients 1-4 addresses from an old pool
+    vector<SPtr<TDUID> > duids;
+    for (int i = 0; i < 5; i++) {
+        ostringstream duid, addr;
+        duid << "00:01:00:00:00:00:00:0" << i;
+        addr << (i ? "2001:db8:999::" : "2001:db8:123::") << i + 1;
+        duids.push_back(new TDUID(duid.str().c_str()));
+        EXPECT_TRUE(SrvAddrMgr().addClntAddr(duids[i], new TIPv6Addr("fe80::1", true),
+                                             ifindex, 1, 100, 200,
+                                             new TIPv6Addr(addr.str().c_str(), true),
+                                             300, 400, true));
+    }
+
+    TSrvReconfCampaign& campaign = transmgr_->getReconfigures();
+    campaign.setRate(2);
+    campaign.start(1000);
+    EXPECT_TRUE(campaign.inPool(ifindex, IATYPE_IA, new TIPv6Addr("2001:db8:123::ffff", true)));
+    EXPECT_FALSE(campaign.inPool(ifindex, IATYPE_IA, new TIPv6Addr("2001:db8:999::1", true)));
+    EXPECT_FALSE(campaign.inPool(ifindex, IATYPE_PD, new TIPv6Addr("2001:db8:123::1", true)));
+    EXPECT_EQ(5u, campaign.getProgress().clients);
+
+    // only 2 RECONFIGUREs per second
+    size_t sent = ifacemgr_->sent_pkts_.size();
+    campaign.doDuties(1000);
+    EXPECT_EQ(5u, campaign.getProgress().checked);
+    EXPECT_EQ(4u, campaign.getProgress().affected);
+    EXPECT_EQ(2u, campaign.getProgress().sent);
+    ASSERT_EQ(sent + 2, ifacemgr_->sent_pkts_.size());
+    EXPECT_EQ(RECONFIGURE_MSG, ifacemgr_->sent_pkts_.back().Data_[0]);
+    EXPECT_EQ(1u, campaign.getTimeout(1000));
+
+    campaign.doDuties(1000);
+    EXPECT_EQ(2u, campaign.getProgress().sent);
+    campaign.doDuties(1001);
+    EXPECT_EQ(4u, campaign.getProgress().sent);
+    EXPECT_EQ(1u, campaign.getTimeout(1001)); // first retransmission
+
+    // client 1 responds, its outdated lease is removed
+    EXPECT_TRUE(campaign.clientResponded(duids[1]));
+    EXPECT_FALSE(campaign.clientResponded(duids[1]));
+    EXPECT_FALSE(campaign.clientResponded(duids[0]));
+    EXPECT_EQ(1u, campaign.getProgress().completed);
+    EXPECT_FALSE(SrvAddrMgr().getClient(duids[1]));
+
+    // client 2 is retransmitted to
+    campaign.doDuties(1002);
+    EXPECT_EQ(1u, campaign.getProgress().retransmitted);
+
+    // the others never respond
+    for (unsigned long now = 1003; now < 5000 && campaign.isActive(); now++)
+        campaign.doDuties(now);
+    EXPECT_FALSE(campaign.isActive());
+    EXPECT_EQ(1u, campaign.getProgress().completed);
+    EXPECT_EQ(3u, campaign.getProgress().failed);
+    EXPECT_EQ(3u * REC_MAX_RC, campaign.getProgress().retransmitted);
+    EXPECT_EQ(1, SrvAddrMgr().countClient());
+    EXPECT_TRUE(SrvAddrMgr().getClient(duids[0]));
+    EXPECT_EQ(DHCPV6_INFINITY, campaign.getTimeout(5000));
+}
+
+}
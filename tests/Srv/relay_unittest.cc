@@ -11,6 +11,8 @@
 #include "SrvCfgMgr.h"
 #include "SrvTransMgr.h"
 #include "assign_utils.h"
+#include "SrvRelayChain.h"
+#include "hex.h"
 #include <gtest/gtest.h>
 
 using namespace std;
@@ -55,7 +57,7 @@ TEST_F(ServerTest, decodeRelayForwGuessMode) {
 
     ASSERT_TRUE(received);
 
-    vector<TSrvMsg::RelayInfo> rcvRelay = received->RelayInfo_;
+    vector<TSrvMsg::RelayInfo> rcvRelay = received->getRelayInfo();
 
     // Check that there's info about exactly one relay
     ASSERT_EQ(rcvRelay.size(), 1u);
@@ -141,7 +143,7 @@ TEST_F(ServerTest, relaySelectInterfaceIdInteger) {
     received = SrvIfaceMgr().select(1);
     ASSERT_TRUE(received);
 
-    vector<TSrvMsg::RelayInfo> rcvRelay = received->RelayInfo_;
+    vector<TSrvMsg::RelayInfo> rcvRelay = received->getRelayInfo();
 
     // Check that there's info about 1 relay
     ASSERT_EQ(rcvRelay.size(), 1u);
@@ -227,7 +229,7 @@ TEST_F(ServerTest, relaySelectInterfaceIdString) {
     received = SrvIfaceMgr().select(1);
     ASSERT_TRUE(received);
 
-    vector<TSrvMsg::RelayInfo> &rcvRelay = received->RelayInfo_;
+    vector<TSrvMsg::RelayInfo> rcvRelay = received->getRelayInfo();
 
     // Check that there's info about 1 relay
     ASSERT_EQ(rcvRelay.size(), 1u);
@@ -316,7 +318,7 @@ TEST_F(ServerTest, relaySelectInterfaceIdHex) {
     received = SrvIfaceMgr().select(1);
     ASSERT_TRUE(received);
 
-    vector<TSrvMsg::RelayInfo> rcvRelay = received->RelayInfo_;
+    vector<TSrvMsg::RelayInfo> rcvRelay = received->getRelayInfo();
 
     // Check that there's info about 1 relay
     ASSERT_EQ(rcvRelay.size(), 1u);
@@ -368,6 +370,14 @@ TEST_F(ServerTest, relaySelectSubnet) {
 
     SrvIfaceMgr().dump();
 
+    // link-address is matched as received (16 bytes, network order)
+    SPtr<TSrvCfgIface> relay2 = SrvCfgMgr().getIfaceByName("relay2");
+    ASSERT_TRUE(relay2);
+    TIPv6Addr linkAddr("2001:db8:2::1", true);
+    EXPECT_EQ(relay2->getID(), SrvCfgMgr().getRelayByLinkAddr(linkAddr.getAddr()));
+    TIPv6Addr otherAddr("2001:db8:4::1", true);
+    EXPECT_EQ(-1, SrvCfgMgr().getRelayByLinkAddr(otherAddr.getAddr()));
+
     // now generate SOLICIT
     setIface("relay2");
     clntAddr_ = SPtr<TIPv6Addr>(new TIPv6Addr("ff05::1:3", true));
@@ -398,7 +408,7 @@ TEST_F(ServerTest, relaySelectSubnet) {
     received = SrvIfaceMgr().select(1);
     ASSERT_TRUE(received);
 
-    vector<TSrvMsg::RelayInfo> rcvRelay = received->RelayInfo_;
+    vector<TSrvMsg::RelayInfo> rcvRelay = received->getRelayInfo();
 
     // Check that there's info about 1 relay
     ASSERT_EQ(rcvRelay.size(), 1u);
@@ -423,4 +433,85 @@ TEST_F(ServerTest, relaySelectSubnet) {
 }
 
 
+// This test verifies that relay hops are stored as received and that
+// the answer is encapsulated with interface-id and echoed options copied back.
+TEST(RelayChainTest, encapsulate) {
+    string outer = "0c01" "20010db8000000000000000000000001" "fe800000000000000000000000000001"
+        "0025000800000de901020304" // remote-id
+        "0012000461626364" // interface-id
+        "002b00020025" // ERO (remote-id)
+        "00090035"; // relay-msg
+    string inner = "0c00" "00000000000000000000000000000000" "fe800000000000000000000000000002"
+        "0009000401aabbcc" // relay-msg (SOLICIT)
+        "001200027879" // interface-id
+        "006300017a"; // unknown option
+    vector<uint8_t> bin = textToHex(outer + inner);
+    const char* buf = (const char*)&bin[0];
+
+    TSrvRelayChain chain;
+    const char* msg;
+    int msgLen;
+    ASSERT_TRUE(chain.addHop(buf, bin.size(), msg, msgLen));
+    ASSERT_EQ(buf + 64, msg);
+    ASSERT_EQ(53, msgLen);
+    ASSERT_TRUE(chain.addHop(msg, msgLen, msg, msgLen));
+    ASSERT_EQ(4, msgLen);
+    EXPECT_EQ(textToHex("01aabbcc"), vector<uint8_t>(msg, msg + msgLen));
+
+    ASSERT_EQ(2, chain.size());
+    EXPECT_EQ(1, chain.getHopCount(0));
+    EXPECT_EQ(0, chain.getHopCount(1));
+    EXPECT_EQ(0, memcmp(buf + 2, chain.getLinkAddr(0), 16));
+    EXPECT_EQ(0, memcmp(buf + 18, chain.getPeerAddr(0), 16));
+    EXPECT_EQ(0, memcmp(buf + 82, chain.getPeerAddr(1), 16));
+
+    const char* data;
+    int len;
+    ASSERT_TRUE(chain.getInterfaceID(1, data, len));
+    EXPECT_EQ(string("xy"), string(data, len));
+    ASSERT_TRUE(chain.getOption(0, OPTION_REMOTE_ID, data, len));
+    EXPECT_EQ(8, len);
+    EXPECT_FALSE(chain.getOption(1, OPTION_REMOTE_ID, data, len));
+    EXPECT_EQ(3u, chain.getOptions(0).size());
+    EXPECT_EQ(2u, chain.getOptions(1).size());
+
+    // interface-id before relay-msg, remote-id echoed back (listed in ERO)
+    vector<char> reply(chain.getSize(msgLen, SRV_IFACE_ID_ORDER_BEFORE));
+    size_t offset;
+    EXPECT_EQ(106u, reply.size());
+    EXPECT_EQ(reply.size(), chain.storeSelf(&reply[0], msgLen, SRV_IFACE_ID_ORDER_BEFORE,
+                                            RELAY_REPL_MSG, offset));
+    memcpy(&reply[offset], msg, msgLen);
+    EXPECT_EQ(textToHex("0d01" "20010db8000000000000000000000001" "fe800000000000000000000000000001"
+                        "0012000461626364" "00090030"
+                        "0d00" "00000000000000000000000000000000" "fe800000000000000000000000000002"
+                        "001200027879" "00090004" "01aabbcc"
+                        "0025000800000de901020304"),
+              vector<uint8_t>(reply.begin(), reply.end()));
+
+    // interface-id after relay-msg
+    reply.resize(chain.getSize(msgLen, SRV_IFACE_ID_ORDER_AFTER));
+    EXPECT_EQ(reply.size(), chain.storeSelf(&reply[0], msgLen, SRV_IFACE_ID_ORDER_AFTER,
+                                            RELAY_REPL_MSG, offset));
+    memcpy(&reply[offset], msg, msgLen);
+    EXPECT_EQ(textToHex("0d01" "20010db8000000000000000000000001" "fe800000000000000000000000000001"
+                        "00090030"
+                        "0d00" "00000000000000000000000000000000" "fe800000000000000000000000000002"
+                        "00090004" "01aabbcc" "001200027879"
+                        "0012000461626364" "0025000800000de901020304"),
+              vector<uint8_t>(reply.begin(), reply.end()));
+
+    // no interface-id
+    reply.resize(chain.getSize(msgLen, SRV_IFACE_ID_ORDER_NONE));
+    EXPECT_EQ(92u, reply.size());
+    EXPECT_EQ(reply.size(), chain.storeSelf(&reply[0], msgLen, SRV_IFACE_ID_ORDER_NONE,
+                                            RELAY_REPL_MSG, offset));
+    EXPECT_EQ(textToHex("0009002a"), vector<uint8_t>(&reply[34], &reply[38]));
+
+    // relay-msg missing
+    TSrvRelayChain invalid;
+    EXPECT_FALSE(invalid.addHop(buf + 64, 34, msg, msgLen));
+    EXPECT_TRUE(invalid.empty());
+}
+
 }
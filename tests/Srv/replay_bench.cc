@@ -0,0 +1,705 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * author: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+/*
+ * Packet capture replay benchmark. This is not a unit test and it is not
+ * run by 'make check'. Client messages (UDP to port 547) are read from a
+ * pcap or pcapng file and replayed as if they were sent by many distinct
+ * clients: for client number N the last 4 bytes of client-id DUID, the
+ * transaction-id and the client's link-local address are XORed with N
+ * (client 0 sends the capture as it is), server-id is replaced with the DUID
+ * of the tested server. Packets are injected into the regular receive path
+ * (TSrvIfaceMgr::select() via NakedSrvIfaceMgr::receive()) and processed
+ * by TSrvTransMgr::relayMsg(). Every message is expected to be answered
+ * with the right message type and transaction-id. Throughput and latency
+ * (per message type) are reported.
+ *
+ * Usage: DIBBLER_REPLAY_PCAP=file.pcapng ./Srv_bench --gtest_filter=ServerReplay.*
+ *
+ * DIBBLER_REPLAY_CLIENTS - number of clients to synthesize (default 100)
+ * DIBBLER_REPLAY_RATE    - messages per second (default 0 - as fast as possible)
+ * DIBBLER_REPLAY_CONFIG  - server config (REPLACE_ME is replaced with the name
+ *                          of the interface packets are received on)
+ *
+ * Without DIBBLER_REPLAY_PCAP, a small capture is generated (in both formats)
+ * and replayed.
+ */
+
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include "IPv6Addr.h"
+#include "SrvIfaceMgr.h"
+#include "SrvCfgMgr.h"
+#include "SrvTransMgr.h"
+#include "OptDUID.h"
+#include "OptOptionRequest.h"
+#include "SrvOptInterfaceID.h"
+#include "Logger.h"
+#include "Portable.h"
+#include "assign_utils.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace test {
+
+/// @brief a client message read from capture
+struct ReplayPkt {
+    std::vector<char> Data_;
+    char Src_[16];
+};
+
+typedef std::vector<ReplayPkt> ReplayCapture;
+
+/// @brief reads DHCPv6 client messages from pcap and pcapng files
+///
+/// Supported link types: Ethernet (with VLAN tags), Linux cooked (v1 and v2),
+/// BSD loopback and raw IPv6. IPv6 extension headers are skipped, fragmented
+/// packets are ignored.
+class CaptureReader {
+public:
+    CaptureReader() :Big_(false), Frames_(0) {}
+
+    bool read(const std::string& file, ReplayCapture& pkts) {
+        ifstream f(file.c_str(), ios::in | ios::binary);
+        if (!f.is_open())
+            return false;
+        vector<uint8_t> buf((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
+        if (buf.size() < 24)
+            return false;
+        if (get32le(&buf[0]) == 0x0a0d0d0a)
+            return readPcapng(buf, pkts);
+        return readPcap(buf, pkts);
+    }
+
+    /// number of frames read (including ones that are not DHCPv6 client messages)
+    unsigned int frames() const { return Frames_; }
+
+private:
+    static uint32_t get32le(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    uint16_t get16(const uint8_t* p) const {
+        return Big_ ? (p[0] << 8) | p[1] : p[0] | (p[1] << 8);
+    }
+    uint32_t get32(const uint8_t* p) const {
+        return Big_ ? ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3] : get32le(p);
+    }
+
+    bool readPcap(const vector<uint8_t>& buf, ReplayCapture& pkts) {
+        uint32_t magic = get32le(&buf[0]);
+        if (magic == 0xa1b2c3d4 || magic == 0xa1b23c4d)
+            Big_ = false;
+        else if (magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1)
+            Big_ = true;
+        else
+            return false;
+        uint32_t linktype = get32(&buf[20]);
+        for (size_t off = 24; off + 16 <= buf.size(); ) {
+            uint32_t caplen = get32(&buf[off + 8]);
+            off += 16;
+            if (off + caplen > buf.size())
+                break;
+            frame(linktype, &buf[off], caplen, pkts);
+            off += caplen;
+        }
+        return true;
+    }
+
+    bool readPcapng(const vector<uint8_t>& buf, ReplayCapture& pkts) {
+        vector<uint16_t> linktypes; // of interfaces in current section
+        for (size_t off = 0; off + 12 <= buf.size(); ) {
+            uint32_t type = get32le(&buf[off]);
+            if (type == 0x0a0d0d0a) {
+                // section header, byte order magic decides endianness
+                uint32_t bom = get32le(&buf[off + 8]);
+                if (bom == 0x1a2b3c4d)
+                    Big_ = false;
+                else if (bom == 0x4d3c2b1a)
+                    Big_ = true;
+                else
+                    return false;
+                linktypes.clear();
+            } else {
+                type = get32(&buf[off]);
+            }
+            uint32_t len = get32(&buf[off + 4]);
+            if (len < 12 || len % 4 || off + len > buf.size())
+                return false;
+            const uint8_t* block = &buf[off];
+            switch (type) {
+            case 1: // interface description
+                linktypes.push_back(get16(block + 8));
+                break;
+            case 3: { // simple packet
+                uint32_t caplen = min<uint32_t>(get32(block + 8), len - 16);
+                if (!linktypes.empty())
+                    frame(linktypes[0], block + 12, caplen, pkts);
+                break;
+            }
+            case 6: { // enhanced packet
+                uint32_t iface = get32(block + 8);
+                uint32_t caplen = get32(block + 20);
+                if (iface < linktypes.size() && caplen <= len - 32)
+                    frame(linktypes[iface], block + 28, caplen, pkts);
+                break;
+            }
+            default:
+                break;
+            }
+            off += len;
+        }
+        return true;
+    }
+
+    /// extracts UDP payload sent to the server port
+    void frame(uint32_t linktype, const uint8_t* p, size_t len, ReplayCapture& pkts) {
+        Frames_++;
+        size_t off;
+        switch (linktype) {
+        case 1: { // Ethernet
+            off = 12;
+            while (off + 2 <= len && (p[off] << 8 | p[off + 1]) != 0x86dd) {
+                uint16_t ethertype = p[off] << 8 | p[off + 1];
+                if (ethertype != 0x8100 && ethertype != 0x88a8)
+                    return;
+                off += 4;
+            }
+            off += 2;
+            break;
+        }
+        case 0:   // BSD loopback
+        case 108: // OpenBSD loopback
+            off = 4;
+            break;
+        case 113: // Linux cooked
+            off = 16;
+            break;
+        case 276: // Linux cooked v2
+            off = 20;
+            break;
+        case 12:  // raw IP
+        case 101:
+        case 229: // raw IPv6
+            off = 0;
+            break;
+        default:
+            return;
+        }
+
+        if (off + 40 > len || (p[off] >> 4) != 6)
+            return;
+        const uint8_t* ip = p + off;
+        uint8_t nh = ip[6];
+        off += 40;
+        while (nh == 0 || nh == 43 || nh == 60) { // hop-by-hop, routing, destination
+            if (off + 8 > len)
+                return;
+            nh = p[off];
+            off += (p[off + 1] + 1) * 8;
+        }
+        if (nh != 17 || off + 8 > len) // not UDP (or fragmented)
+            return;
+        const uint8_t* udp = p + off;
+        if ((udp[2] << 8 | udp[3]) != DHCPSERVER_PORT)
+            return;
+        size_t payload = min<size_t>((udp[4] << 8 | udp[5]), len - off);
+        if (payload < 8 + 4)
+            return;
+
+        ReplayPkt pkt;
+        pkt.Data_.assign(udp + 8, udp + payload);
+        memcpy(pkt.Src_, ip + 8, 16);
+        pkts.push_back(pkt);
+    }
+
+    bool Big_;
+    unsigned int Frames_;
+};
+
+/// @brief statistics of replayed messages of one type
+struct ReplayStats {
+    ReplayStats() :Sent_(0), Answered_(0), Unanswered_(0), Mismatched_(0) {}
+    unsigned int Sent_;
+    unsigned int Answered_;   ///< expected response received
+    unsigned int Unanswered_; ///< no response (or not the expected one)
+    unsigned int Mismatched_; ///< responses with unexpected type or transaction-id
+    std::vector<uint32_t> LatencyNs_;
+};
+
+class ServerReplay : public ServerTest {
+public:
+    ServerReplay() {
+        clients_ = getenv("DIBBLER_REPLAY_CLIENTS") ? atoi(getenv("DIBBLER_REPLAY_CLIENTS")) : 100;
+        rate_ = getenv("DIBBLER_REPLAY_RATE") ? atoi(getenv("DIBBLER_REPLAY_RATE")) : 0;
+    }
+
+    /// @brief sets up the managers in a quiet, performance-mode setup
+    bool createReplayMgrs() {
+        string cfg = "experimental\n"
+                     "performance-mode 1\n"
+                     "iface REPLACE_ME {\n"
+                     "  option dns-server 2001:db8::53\n"
+                     "  class { pool 2001:db8:1::/64 }\n"
+                     "}\n"
+                     "iface relay1 {\n"
+                     "  relay REPLACE_ME\n"
+                     "  interface-id 1234\n"
+                     "  class { pool 2001:db8:ffff::/64 }\n"
+                     "}\n";
+        if (getenv("DIBBLER_REPLAY_CONFIG")) {
+            ifstream f(getenv("DIBBLER_REPLAY_CONFIG"));
+            if (!f.is_open()) {
+                ADD_FAILURE() << "Unable to open " << getenv("DIBBLER_REPLAY_CONFIG");
+                return false;
+            }
+            stringstream tmp;
+            tmp << f.rdbuf();
+            cfg = tmp.str();
+        }
+        if (!createMgrs(cfg))
+            return false;
+        transmgr_->Quiet_ = true;
+        logger::setLogLevel(2); // Alert and above only
+        return true;
+    }
+
+    static uint64_t monotonicNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    static void xor32(char* p, uint32_t value) {
+        p[0] ^= value >> 24;
+        p[1] ^= value >> 16;
+        p[2] ^= value >> 8;
+        p[3] ^= value;
+    }
+
+    /// @brief appends message as sent by specified client to out
+    ///
+    /// Relayed messages are rewritten recursively (lengths of relay-msg
+    /// options are updated, as server-id may change its length).
+    void rewrite(const char* buf, size_t len, uint32_t client, vector<char>& out) {
+        size_t start = out.size();
+        size_t off;
+        bool relay = len >= 34 && buf[0] == RELAY_FORW_MSG;
+        if (relay) {
+            out.insert(out.end(), buf, buf + 34);
+            if (!buf[1]) // hop-count 0, peer-addr is the client's address
+                xor32(&out[start + 30], client);
+            off = 34;
+        } else {
+            out.insert(out.end(), buf, buf + min<size_t>(len, 4));
+            if (len < 4)
+                return;
+            // transaction-id is 24 bits long
+            xor32(&out[start], client & 0xffffff);
+            off = 4;
+        }
+
+        while (off + 4 <= len) {
+            uint16_t code = readUint16(buf + off);
+            uint16_t optLen = readUint16(buf + off + 2);
+            if (off + 4 + optLen > len)
+                break;
+            const char* data = buf + off + 4;
+            if (relay && code == OPTION_RELAY_MSG) {
+                size_t hdr = out.size();
+                out.resize(hdr + 4);
+                rewrite(data, optLen, client, out);
+                writeUint16(&out[hdr], code);
+                writeUint16(&out[hdr + 2], out.size() - hdr - 4);
+            } else if (!relay && code == OPTION_SERVERID) {
+                SPtr<TDUID> duid = SrvCfgMgr().getDUID();
+                size_t hdr = out.size();
+                out.resize(hdr + 4 + duid->getLen());
+                writeUint16(&out[hdr], code);
+                writeUint16(&out[hdr + 2], duid->getLen());
+                memcpy(&out[hdr + 4], duid->get(), duid->getLen());
+            } else {
+                size_t opt = out.size();
+                out.insert(out.end(), buf + off, data + optLen);
+                if (!relay && code == OPTION_CLIENTID && optLen >= 4)
+                    xor32(&out[opt + 4 + optLen - 4], client);
+            }
+            off += 4 + optLen;
+        }
+        // trailing garbage is kept as it is
+        out.insert(out.end(), buf + off, buf + len);
+    }
+
+    /// @brief returns type and transaction-id of the message (relays are skipped)
+    static bool clientMsg(const char* buf, size_t len, uint8_t& type, uint32_t& transid) {
+        while (len >= 34 && (buf[0] == RELAY_FORW_MSG || buf[0] == RELAY_REPL_MSG)) {
+            size_t off = 34;
+            const char* inner = 0;
+            while (off + 4 <= len) {
+                uint16_t optLen = readUint16(buf + off + 2);
+                if (readUint16(buf + off) == OPTION_RELAY_MSG && off + 4 + optLen <= len) {
+                    inner = buf + off + 4;
+                    break;
+                }
+                off += 4 + optLen;
+            }
+            if (!inner)
+                return false;
+            len = readUint16(buf + off + 2);
+            buf = inner;
+        }
+        if (len < 4)
+            return false;
+        type = buf[0];
+        transid = readUint32(buf) & 0xffffff;
+        return true;
+    }
+
+    /// @brief returns type of the response server is expected to send (0 if none)
+    static int expectedResponse(uint8_t type) {
+        switch (type) {
+        case SOLICIT_MSG:
+            return ADVERTISE_MSG; // or REPLY with rapid-commit
+        case REQUEST_MSG:
+        case CONFIRM_MSG:
+        case RENEW_MSG:
+        case REBIND_MSG:
+        case RELEASE_MSG:
+        case DECLINE_MSG:
+        case INFORMATION_REQUEST_MSG:
+            return REPLY_MSG;
+        case LEASEQUERY_MSG:
+            return LEASEQUERY_REPLY_MSG;
+        default:
+            return 0;
+        }
+    }
+
+    /// @brief replays capture as sent by clients_ clients
+    ///
+    /// Packets are sent in capture order, every packet by all clients before
+    /// the next one, so exchanges of every client stay in order.
+    ///
+    /// @return statistics (by message type, 0 is total)
+    map<int, ReplayStats> replay(const ReplayCapture& capture, uint64_t& wallNs) {
+        map<int, ReplayStats> stats;
+        SrvMsgList& sent = transmgr_->getMsgLst();
+        sent.clear();
+
+        iface_->firstSocket();
+        SPtr<TIfaceSocket> sock = iface_->getSocket();
+        if (!sock) {
+            ADD_FAILURE() << "No socket open on " << iface_->getFullName();
+            return stats;
+        }
+
+        uint64_t start = monotonicNs();
+        uint64_t n = 0;
+        vector<char> data;
+        for (ReplayCapture::const_iterator pkt = capture.begin(); pkt != capture.end(); ++pkt) {
+            for (uint32_t client = 0; client < clients_; client++, n++) {
+                data.clear();
+                rewrite(&pkt->Data_[0], pkt->Data_.size(), client, data);
+                char src[16];
+                memcpy(src, pkt->Src_, 16);
+                if (pkt->Data_[0] != RELAY_FORW_MSG)
+                    xor32(src + 12, client);
+                uint8_t type = 0;
+                uint32_t transid = 0;
+                clientMsg(&data[0], data.size(), type, transid);
+
+                if (rate_) {
+                    uint64_t due = start + n * 1000000000ULL / rate_;
+                    for (uint64_t now = monotonicNs(); now < due; now = monotonicNs()) {
+                        struct timespec ts;
+                        ts.tv_sec = (due - now) / 1000000000ULL;
+                        ts.tv_nsec = (due - now) % 1000000000ULL;
+                        nanosleep(&ts, 0);
+                    }
+                }
+
+                uint64_t sentAt = monotonicNs();
+                ifacemgr_->injected_.push_back(Pkt6Info(sock->getFD(), &data[0], data.size(),
+                                                        new TIPv6Addr(src, false),
+                                                        DHCPCLIENT_PORT));
+                SPtr<TSrvMsg> msg = SrvIfaceMgr().select(0);
+                if (msg)
+                    transmgr_->relayMsg(msg);
+                uint32_t latency = monotonicNs() - sentAt;
+
+                // verify responses
+                int expected = expectedResponse(type);
+                bool answered = false;
+                unsigned int mismatched = 0;
+                for (SrvMsgList::const_iterator rsp = sent.begin(); rsp != sent.end(); ++rsp) {
+                    int rspType = (*rsp)->getType();
+                    bool typeOk = rspType == expected ||
+                        (expected == ADVERTISE_MSG && rspType == REPLY_MSG);
+                    if (typeOk && (*rsp)->getTransID() == transid)
+                        answered = true;
+                    else
+                        mismatched++;
+                }
+                sent.clear();
+
+                // answers sent in wire format (cached or pre-encoded)
+                for (Pkt6Collection::const_iterator rsp = ifacemgr_->sent_pkts_.begin();
+                     rsp != ifacemgr_->sent_pkts_.end(); ++rsp) {
+                    uint8_t rspType = 0;
+                    uint32_t rspTransid = 0;
+                    if (!rsp->Data_.empty())
+                        clientMsg((const char*)&rsp->Data_[0], rsp->Data_.size(),
+                                  rspType, rspTransid);
+                    if (rspType == expected && rspTransid == transid)
+                        answered = true;
+                    else
+                        mismatched++;
+                }
+                ifacemgr_->sent_pkts_.clear();
+
+                ReplayStats* s[] = { &stats[type], &stats[0] };
+                for (int i = 0; i < 2; i++) {
+                    s[i]->Sent_++;
+                    s[i]->Mismatched_ += mismatched;
+                    if (answered)
+                        s[i]->Answered_++;
+                    else if (expected)
+                        s[i]->Unanswered_++;
+                    s[i]->LatencyNs_.push_back(latency);
+                }
+            }
+        }
+        wallNs = monotonicNs() - start;
+        return stats;
+    }
+
+    static double percentileUs(vector<uint32_t>& ns, double p) {
+        if (ns.empty())
+            return 0;
+        size_t idx = min(ns.size() - 1, (size_t)(p * ns.size()));
+        nth_element(ns.begin(), ns.begin() + idx, ns.end());
+        return ns[idx] / 1000.0;
+    }
+
+    void report(map<int, ReplayStats>& stats, uint64_t wallNs) {
+        for (map<int, ReplayStats>::iterator it = stats.begin(); it != stats.end(); ++it) {
+            ReplayStats& s = it->second;
+            uint64_t busyNs = 0;
+            for (size_t i = 0; i < s.LatencyNs_.size(); i++)
+                busyNs += s.LatencyNs_[i];
+            string name = it->first ? MsgTypeToString(it->first) : "TOTAL";
+            cout << "REPLAY " << setw(14) << left << name << right
+                 << " sent=" << setw(7) << s.Sent_
+                 << " answered=" << setw(7) << s.Answered_
+                 << " unanswered=" << setw(6) << s.Unanswered_
+                 << " mismatched=" << setw(6) << s.Mismatched_
+                 << fixed << setprecision(1)
+                 << " capacity=" << setw(9) << (busyNs ? s.Sent_ * 1e9 / busyNs : 0) << "/s"
+                 << " p50=" << setw(7) << percentileUs(s.LatencyNs_, 0.50) << "us"
+                 << " p99=" << setw(7) << percentileUs(s.LatencyNs_, 0.99) << "us"
+                 << " max=" << setw(8) << percentileUs(s.LatencyNs_, 1.0) << "us" << endl;
+        }
+        cout << "REPLAY " << clients_ << " client(s), " << stats[0].Sent_ << " message(s) in "
+             << wallNs / 1000000 << "ms, " << fixed << setprecision(1)
+             << (wallNs ? stats[0].Sent_ * 1e9 / wallNs : 0) << " msgs/s (rate limit "
+             << rate_ << "/s)" << endl;
+    }
+
+    // --- synthetic capture ---
+
+    /// @brief Ethernet frame with IPv6/UDP packet sent from src to server port
+    static vector<char> ethFrame(const char* src, uint16_t dstPort, const vector<char>& payload) {
+        vector<char> frame(14 + 40 + 8, 0);
+        frame[12] = (char)0x86;
+        frame[13] = (char)0xdd;
+        char* ip = &frame[14];
+        ip[0] = 0x60;
+        writeUint16(ip + 4, 8 + payload.size());
+        ip[6] = 17; // UDP
+        ip[7] = 1;
+        memcpy(ip + 8, src, 16);
+        TIPv6Addr dst(ALL_DHCP_RELAY_AGENTS_AND_SERVERS, true);
+        memcpy(ip + 24, dst.getAddr(), 16);
+        char* udp = ip + 40;
+        writeUint16(udp, DHCPCLIENT_PORT);
+        writeUint16(udp + 2, dstPort);
+        writeUint16(udp + 4, 8 + payload.size());
+        frame.insert(frame.end(), payload.begin(), payload.end());
+        return frame;
+    }
+
+    static void put16(vector<char>& out, uint16_t v, bool big) {
+        char b[2] = { (char)(big ? v >> 8 : v), (char)(big ? v : v >> 8) };
+        out.insert(out.end(), b, b + 2);
+    }
+
+    static void put32(vector<char>& out, uint32_t v, bool big) {
+        put16(out, big ? v >> 16 : v, big);
+        put16(out, big ? v : v >> 16, big);
+    }
+
+    /// @brief stores frames as classic pcap (little endian)
+    static void writePcap(const string& file, const vector<vector<char> >& frames) {
+        vector<char> out;
+        put32(out, 0xa1b2c3d4, false);
+        put16(out, 2, false);
+        put16(out, 4, false);
+        put32(out, 0, false);
+        put32(out, 0, false);
+        put32(out, 65535, false);
+        put32(out, 1, false); // Ethernet
+        for (size_t i = 0; i < frames.size(); i++) {
+            put32(out, 1000 + i, false);
+            put32(out, 0, false);
+            put32(out, frames[i].size(), false);
+            put32(out, frames[i].size(), false);
+            out.insert(out.end(), frames[i].begin(), frames[i].end());
+        }
+        ofstream f(file.c_str(), ios::out | ios::binary);
+        f.write(&out[0], out.size());
+    }
+
+    /// @brief stores frames as pcapng (big endian, enhanced packet blocks)
+    static void writePcapng(const string& file, const vector<vector<char> >& frames) {
+        vector<char> out;
+        // section header
+        put32(out, 0x0a0d0d0a, true);
+        put32(out, 28, true);
+        put32(out, 0x1a2b3c4d, true);
+        put16(out, 1, true);
+        put16(out, 0, true);
+        put32(out, 0xffffffff, true);
+        put32(out, 0xffffffff, true);
+        put32(out, 28, true);
+        // interface description
+        put32(out, 1, true);
+        put32(out, 20, true);
+        put16(out, 1, true); // Ethernet
+        put16(out, 0, true);
+        put32(out, 65535, true);
+        put32(out, 20, true);
+        for (size_t i = 0; i < frames.size(); i++) {
+            size_t padded = (frames[i].size() + 3) & ~3;
+            put32(out, 6, true);
+            put32(out, 32 + padded, true);
+            put32(out, 0, true);
+            put32(out, 0, true);
+            put32(out, 1000 + i, true);
+            put32(out, frames[i].size(), true);
+            put32(out, frames[i].size(), true);
+            out.insert(out.end(), frames[i].begin(), frames[i].end());
+            out.resize(out.size() + padded - frames[i].size(), 0);
+            put32(out, 32 + padded, true);
+        }
+        ofstream f(file.c_str(), ios::out | ios::binary);
+        f.write(&out[0], out.size());
+    }
+
+    static vector<char> store(SPtr<TSrvMsg> msg) {
+        vector<char> buf(msg->getSize());
+        msg->storeSelf(&buf[0]);
+        return buf;
+    }
+
+    /// @brief generates frames: SOLICIT, REQUEST, RENEW, INF-REQUEST (server-id
+    ///        of a different server is used), relayed SOLICIT and a DNS query
+    vector<vector<char> > createFrames() {
+        SPtr<TOpt> srvId = new TOptDUID(OPTION_SERVERID, new TDUID("00:01:00:00:de:ad:be:ef"), 0);
+        vector<vector<char> > frames;
+        const char* src = clntAddr_->getAddr();
+
+        frames.push_back(ethFrame(src, DHCPSERVER_PORT, store(createSolicit(true, true))));
+        SPtr<TSrvMsg> msg = createRequest(true, true);
+        msg->addOption(srvId);
+        frames.push_back(ethFrame(src, DHCPSERVER_PORT, store(msg)));
+        msg = createRenew(true, true);
+        msg->addOption(srvId);
+        frames.push_back(ethFrame(src, DHCPSERVER_PORT, store(msg)));
+        msg = createInfRequest(true);
+        SPtr<TOptOptionRequest> oro = new TOptOptionRequest(OPTION_ORO, &(*msg));
+        oro->addOption(OPTION_DNS_SERVERS);
+        msg->addOption(SPtr_cast<TOpt>(oro));
+        frames.push_back(ethFrame(src, DHCPSERVER_PORT, store(msg)));
+
+        // SOLICIT relayed by relay1
+        vector<char> inner = store(createSolicit(true, true));
+        SPtr<TOpt> ifaceId = new TSrvOptInterfaceID(1234, NULL);
+        vector<char> relayed(34 + ifaceId->getSize() + 4);
+        relayed[0] = RELAY_FORW_MSG;
+        TIPv6Addr link("2001:db8:ffff::1", true);
+        link.storeSelf(&relayed[2]);
+        clntAddr_->storeSelf(&relayed[18]);
+        char* ptr = ifaceId->storeSelf(&relayed[34]);
+        ptr = writeUint16(ptr, OPTION_RELAY_MSG);
+        writeUint16(ptr, inner.size());
+        relayed.insert(relayed.end(), inner.begin(), inner.end());
+        TIPv6Addr relay("2001:db8:ffff::1", true);
+        frames.push_back(ethFrame(relay.getAddr(), DHCPSERVER_PORT, relayed));
+
+        // not a DHCPv6 message, ignored
+        frames.push_back(ethFrame(src, 53, vector<char>(20, 0)));
+        return frames;
+    }
+
+    uint32_t clients_;
+    unsigned int rate_;
+};
+
+TEST_F(ServerReplay, capture) {
+    ASSERT_TRUE(createReplayMgrs());
+
+    ReplayCapture capture;
+    CaptureReader reader;
+    if (getenv("DIBBLER_REPLAY_PCAP")) {
+        ASSERT_TRUE(reader.read(getenv("DIBBLER_REPLAY_PCAP"), capture))
+            << "Unable to read " << getenv("DIBBLER_REPLAY_PCAP");
+    } else {
+        vector<vector<char> > frames = createFrames();
+        writePcap("testdata/replay.pcap", frames);
+        writePcapng("testdata/replay.pcapng", frames);
+
+        ReplayCapture ng;
+        ASSERT_TRUE(reader.read("testdata/replay.pcap", capture));
+        CaptureReader ngReader;
+        ASSERT_TRUE(ngReader.read("testdata/replay.pcapng", ng));
+        unlink("testdata/replay.pcap");
+        unlink("testdata/replay.pcapng");
+
+        EXPECT_EQ(6u, reader.frames());
+        ASSERT_EQ(5u, capture.size());
+        ASSERT_EQ(capture.size(), ng.size());
+        for (size_t i = 0; i < capture.size(); i++) {
+            EXPECT_TRUE(capture[i].Data_ == ng[i].Data_);
+            EXPECT_FALSE(memcmp(capture[i].Src_, ng[i].Src_, 16));
+        }
+    }
+    cout << "REPLAY " << capture.size() << " client message(s) in " << reader.frames()
+         << " frame(s)" << endl;
+    ASSERT_FALSE(capture.empty());
+
+    uint64_t wallNs = 0;
+    map<int, ReplayStats> stats = replay(capture, wallNs);
+    report(stats, wallNs);
+
+    EXPECT_EQ(capture.size() * clients_, stats[0].Sent_);
+    if (!getenv("DIBBLER_REPLAY_PCAP")) {
+        // every client got its own answers
+        EXPECT_EQ(stats[0].Sent_, stats[0].Answered_);
+        EXPECT_EQ(0u, stats[0].Mismatched_);
+        EXPECT_EQ(2 * clients_, stats[SOLICIT_MSG].Answered_);
+    }
+}
+
+}
@@ -0,0 +1,111 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * author: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "SrvReplyCache.h"
+#include "SrvTransMgr.h"
+#include "SrvAddrMgr.h"
+#include "assign_utils.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace test {
+
+// checks that retransmissions are answered from the cache, with the same
+// data and without processing them again
+TEST_F(ServerTest, SrvReplyCache_retransmission) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    SPtr<TSrvMsg> sol = createSolicit(true, true);
+    SPtr<TSrvMsg> adv = sendAndReceive(sol, 1);
+    ASSERT_TRUE(adv);
+    EXPECT_EQ(1u, transmgr_->getReplyCache().count());
+
+    // retransmitted SOLICIT is not processed, cached ADVERTISE is sent
+    size_t sent = ifacemgr_->sent_pkts_.size();
+    transmgr_->relayMsg(sol);
+    EXPECT_EQ(1u, transmgr_->getMsgLst().size());
+    ASSERT_EQ(sent + 1, ifacemgr_->sent_pkts_.size());
+    Pkt6Info pkt = ifacemgr_->sent_pkts_.back();
+    ASSERT_LE(4u, pkt.Data_.size());
+    EXPECT_EQ(ADVERTISE_MSG, pkt.Data_[0]);
+    EXPECT_EQ(adv->getTransID(), (long)((pkt.Data_[1] << 16) | (pkt.Data_[2] << 8) | pkt.Data_[3]));
+
+    // the same data is sent again
+    transmgr_->relayMsg(sol);
+    ASSERT_EQ(sent + 2, ifacemgr_->sent_pkts_.size());
+    EXPECT_TRUE(pkt.Data_ == ifacemgr_->sent_pkts_.back().Data_);
+
+    // REQUEST is a different transaction
+    SPtr<TSrvMsg> req = createRequest(true, true);
+    ASSERT_TRUE(adv->getOption(OPTION_SERVERID));
+    req->addOption(adv->getOption(OPTION_SERVERID));
+    SPtr<TSrvMsg> reply = sendAndReceive(req, 2);
+    ASSERT_TRUE(reply);
+    EXPECT_EQ(1u, SrvAddrMgr().getLeaseCount(clntDuid_));
+
+    transmgr_->relayMsg(req);
+    EXPECT_EQ(2u, transmgr_->getMsgLst().size());
+    EXPECT_EQ(1u, SrvAddrMgr().getLeaseCount(clntDuid_));
+    EXPECT_EQ(2u, transmgr_->getReplyCache().count());
+}
+
+// checks that entries expire and that the oldest entry is dropped when the
+// cache is full
+TEST_F(ServerTest, SrvReplyCache_limits) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    TSrvReplyCache cache;
+    cache.setLimits(2, 10);
+
+    SPtr<TSrvMsg> sol = createSolicit(true, true);
+    SPtr<TSrvMsg> req = createRequest(true, true);
+    SPtr<TSrvMsg> renew = createRenew(true, true);
+    string key1, key2, key3;
+    ASSERT_TRUE(TSrvReplyCache::makeKey(sol, key1));
+    ASSERT_TRUE(TSrvReplyCache::makeKey(req, key2));
+    ASSERT_TRUE(TSrvReplyCache::makeKey(renew, key3));
+    EXPECT_NE(key1, key2);
+
+    // the same message received over a relay is a different message
+    string relayed;
+    TOptList echo;
+    sol->addRelayInfo(new TIPv6Addr("2001:db8::1", true), new TIPv6Addr("fe80::1", true), 0,
+                      echo);
+    ASSERT_TRUE(TSrvReplyCache::makeKey(sol, relayed));
+    EXPECT_NE(key1, relayed);
+
+    // messages without client-id are not cached
+    string key;
+    EXPECT_FALSE(TSrvReplyCache::makeKey(createSolicit(), key));
+
+    cache.add(key1, sol, 100);
+    cache.add(key2, req, 105);
+    EXPECT_TRUE(cache.find(key1, 105));
+    EXPECT_FALSE(cache.find(key1, 110));
+    EXPECT_TRUE(cache.find(key2, 110));
+
+    // key1 is dropped, the cache is full
+    cache.add(key3, renew, 106);
+    EXPECT_EQ(2u, cache.count());
+    EXPECT_FALSE(cache.find(key1, 106));
+    EXPECT_TRUE(cache.find(key2, 106));
+    EXPECT_TRUE(cache.find(key3, 106));
+
+    cache.expire(116);
+    EXPECT_EQ(0u, cache.count());
+}
+
+}
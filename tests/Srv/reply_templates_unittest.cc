@@ -0,0 +1,140 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * author: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include "SrvReplyTemplates.h"
+#include "SrvTransMgr.h"
+#include "SrvMsgInfRequest.h"
+#include "SrvOptInterfaceID.h"
+#include "OptOptionRequest.h"
+#include "assign_utils.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace test {
+
+class ReplyTemplatesTest : public ServerTest {
+public:
+    /// creates INF-REQUEST with specified transaction-id, asking for DNS servers
+    SPtr<TSrvMsg> infRequest(uint32_t transid, bool include_client_id = true) {
+        char buf[] = { INFORMATION_REQUEST_MSG, (char)(transid >> 16), (char)(transid >> 8),
+                       (char)transid };
+        SPtr<TSrvMsg> msg = new TSrvMsgInfRequest(iface_->getID(), clntAddr_, buf, sizeof(buf));
+        if (include_client_id)
+            msg->addOption(clntId_);
+        SPtr<TOptOptionRequest> oro = new TOptOptionRequest(OPTION_ORO, &(*msg));
+        oro->addOption(OPTION_DNS_SERVERS);
+        msg->addOption(SPtr_cast<TOpt>(oro));
+        return msg;
+    }
+
+    /// returns wire data of the answer built the usual way
+    vector<uint8_t> encode(SPtr<TSrvMsg> reply) {
+        vector<char> data;
+        int ifindex, port;
+        EXPECT_TRUE(reply->encode(data, ifindex, port));
+        return vector<uint8_t>(data.begin(), data.end());
+    }
+};
+
+// checks that INF-REQUESTs are answered with the same data as the usual
+// answer, without building it again
+TEST_F(ReplyTemplatesTest, answer) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  option dns-server 2001:db8::53\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+    transmgr_->getReplyCache().setLimits(0, 0);
+
+    SPtr<TSrvMsg> reply = sendAndReceive(infRequest(0x010203), 1);
+    ASSERT_TRUE(reply);
+    ASSERT_TRUE(reply->getOption(OPTION_DNS_SERVERS));
+    EXPECT_EQ(1u, transmgr_->getReplyTemplates().count());
+    vector<uint8_t> expected = encode(reply);
+
+    // the next one is answered from the template, only transaction-id differs
+    size_t sent = ifacemgr_->sent_pkts_.size();
+    transmgr_->relayMsg(infRequest(0x040506));
+    EXPECT_EQ(1u, transmgr_->getMsgLst().size());
+    ASSERT_EQ(sent + 1, ifacemgr_->sent_pkts_.size());
+    Pkt6Info pkt = ifacemgr_->sent_pkts_.back();
+    EXPECT_EQ(DHCPCLIENT_PORT, pkt.Port_);
+    expected[1] = 4;
+    expected[2] = 5;
+    expected[3] = 6;
+    EXPECT_TRUE(expected == pkt.Data_);
+
+    // anonymous INF-REQUEST, client-id is not included
+    transmgr_->relayMsg(infRequest(0x040506, false));
+    ASSERT_EQ(sent + 2, ifacemgr_->sent_pkts_.size());
+    EXPECT_EQ(expected.size() - clntId_->getSize(), ifacemgr_->sent_pkts_.back().Data_.size());
+    EXPECT_EQ(1u, transmgr_->getReplyTemplates().count());
+
+    // relay headers are added, interface-id is echoed back
+    SPtr<TSrvMsg> relayed = infRequest(0x040506);
+    TOptList echo;
+    echo.push_back(new TSrvOptInterfaceID(1234, NULL));
+    relayed->addRelayInfo(new TIPv6Addr("2001:db8::1", true), new TIPv6Addr("fe80::1", true),
+                          0, echo);
+    transmgr_->relayMsg(relayed);
+    ASSERT_EQ(sent + 3, ifacemgr_->sent_pkts_.size());
+    pkt = ifacemgr_->sent_pkts_.back();
+    EXPECT_EQ(DHCPSERVER_PORT, pkt.Port_);
+    ASSERT_EQ(expected.size() + 34 + 8 + 4, pkt.Data_.size());
+    EXPECT_EQ(RELAY_REPL_MSG, pkt.Data_[0]);
+    EXPECT_TRUE(vector<uint8_t>(pkt.Data_.end() - expected.size(), pkt.Data_.end()) == expected);
+
+    // different options requested
+    SPtr<TSrvMsg> other = infRequest(0x070809);
+    SPtr_cast<TOptOptionRequest>(other->getOption(OPTION_ORO))->addOption(OPTION_DOMAIN_LIST);
+    EXPECT_TRUE(sendAndReceive(other, 2));
+    EXPECT_EQ(2u, transmgr_->getReplyTemplates().count());
+
+    // nothing to answer with, no template is stored
+    SPtr<TSrvMsg> unanswered = infRequest(0x0a0b0c);
+    SPtr<TOptOptionRequest> oro = SPtr_cast<TOptOptionRequest>(unanswered->getOption(OPTION_ORO));
+    oro->delOption(OPTION_DNS_SERVERS);
+    oro->addOption(OPTION_NIS_SERVERS);
+    sent = ifacemgr_->sent_pkts_.size();
+    transmgr_->relayMsg(unanswered);
+    EXPECT_EQ(sent, ifacemgr_->sent_pkts_.size());
+    EXPECT_EQ(2u, transmgr_->getReplyTemplates().count());
+}
+
+// checks that clients with exceptions are not answered with templates
+TEST_F(ReplyTemplatesTest, exceptions) {
+    string cfg = "iface REPLACE_ME {\n"
+                 "  option dns-server 2001:db8::53\n"
+                 "  class { pool 2001:db8:123::/64 }\n"
+                 "  client duid 00:01:00:00:00:00:00:00:01 {\n"
+                 "    address 2001:db8:123::5\n"
+                 "  }\n"
+                 "}\n";
+    ASSERT_TRUE(createMgrs(cfg));
+
+    string key;
+    EXPECT_TRUE(TSrvReplyTemplates::makeKey(infRequest(0x010203), key));
+
+    SPtr<TSrvMsg> msg = infRequest(0x010203, false);
+    msg->addOption(new TOptDUID(OPTION_CLIENTID, new TDUID("00:01:00:00:00:00:00:00:01"), &(*msg)));
+    EXPECT_FALSE(TSrvReplyTemplates::makeKey(msg, key));
+
+    // other messages are not answered with templates
+    EXPECT_FALSE(TSrvReplyTemplates::makeKey(createSolicit(true, true), key));
+
+    // message that was not answered, nothing is stored
+    TSrvReplyTemplates templates;
+    ASSERT_TRUE(TSrvReplyTemplates::makeKey(infRequest(0x010203), key));
+    templates.add(key, SPtr<TSrvMsg>());
+    EXPECT_FALSE(templates.find(key));
+    EXPECT_EQ(0u, templates.count());
+}
+
+}
@@ -0,0 +1,344 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * author: Tomasz Mrugalski <thomson@klub.com.pl>
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+/*
+ * In-process throughput benchmark. This is not a unit test and it is not
+ * run by 'make check'. It reuses the naked managers from assign_utils.h to
+ * feed pre-generated wire-format packet corpora through the regular
+ * decode (TSrvIfaceMgr::decodeMsg/decodeRelayForw) and processing
+ * (TSrvTransMgr::relayMsg) paths, with the lease database pre-populated
+ * with a given number of leases. For every message type it reports CPU time
+ * and the number of heap allocations per message.
+ *
+ * Usage: ./Srv_bench [--gtest_filter=...] [--gtest_also_run_disabled_tests]
+ *
+ * The 1M leases variant takes a lot of memory and time, so it is disabled
+ * by default.
+ */
+
+#include <stdlib.h>
+#include <iomanip>
+#include "IPv6Addr.h"
+#include "SrvIfaceMgr.h"
+#include "SrvCfgMgr.h"
+#include "SrvTransMgr.h"
+#include "AddrClient.h"
+#include "AddrIA.h"
+#include "AddrAddr.h"
+#include "OptDUID.h"
+#include "OptStatusCode.h"
+#include "OptOptionRequest.h"
+#include "SrvOptIAAddress.h"
+#include "SrvOptInterfaceID.h"
+#include "Logger.h"
+#include "Portable.h"
+#include "assign_utils.h"
+#include "bench_utils.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace test {
+
+/// @brief a single pre-generated packet
+struct BenchPkt {
+    std::vector<char> Data_;
+    SPtr<TIPv6Addr> Peer_;
+};
+
+typedef std::vector<BenchPkt> BenchCorpus;
+
+/// @brief results of a single corpus run
+struct BenchResult {
+    BenchResult() :Msgs_(0), Replies_(0), Assigned_(0), NoAddrs_(0),
+                   CpuNs_(0), Allocs_(0) {}
+    unsigned int Msgs_;
+    unsigned int Replies_;
+    unsigned int Assigned_;  ///< responses with at least one IAADDR in IA_NA
+    unsigned int NoAddrs_;   ///< responses with NoAddrsAvail status in IA_NA
+    unsigned long long CpuNs_;
+    unsigned long long Allocs_;
+};
+
+class ServerBench : public ServerTest {
+public:
+    ServerBench() {
+        benchCnt_ = getenv("DIBBLER_BENCH_MSGS") ? atoi(getenv("DIBBLER_BENCH_MSGS")) : 200;
+    }
+
+    /// @brief sets up the managers in a quiet, performance-mode setup
+    bool createBenchMgrs(const std::string& pools) {
+        string cfg = "experimental\n"
+                     "performance-mode 1\n"
+                     "iface REPLACE_ME {\n"
+                     "  class { pool " + pools + " }\n"
+                     "}\n"
+                     "iface relay1 {\n"
+                     "  relay REPLACE_ME\n"
+                     "  interface-id 1234\n"
+                     "  class { pool 2001:db8:ffff::/64 }\n"
+                     "}\n";
+        if (!createMgrs(cfg))
+            return false;
+        transmgr_->Quiet_ = true;
+        logger::setLogLevel(2); // Alert and above only
+        return true;
+    }
+
+    /// @brief DUID number idx (00:01 type, 8 bytes)
+    SPtr<TDUID> benchDuid(uint32_t idx) {
+        char buf[8] = { 0x00, 0x01, 0x00, 0x00, 0, 0, 0, 0 };
+        writeUint32(buf + 4, idx);
+        return new TDUID(buf, sizeof(buf));
+    }
+
+    /// @brief address with host part equal to idx, within base /96
+    SPtr<TIPv6Addr> benchAddr(const char* base, uint32_t idx) {
+        TIPv6Addr tmp(base, true);
+        char buf[16];
+        memcpy(buf, tmp.getAddr(), 16);
+        writeUint32(buf + 12, idx);
+        return new TIPv6Addr(buf, false);
+    }
+
+    /// @brief populates the database with specified number of leases
+    ///
+    /// Leases are added directly (not via addClntAddr()), so populating
+    /// large databases does not take quadratic time. Class counters are
+    /// updated, so the pool exhaustion logic sees proper values.
+    void populate(uint32_t count, uint32_t firstHost = 1) {
+        int ifindex = iface_->getID();
+        for (uint32_t i = 0; i < count; i++) {
+            SPtr<TDUID> duid = benchDuid(i);
+            SPtr<TIPv6Addr> addr = benchAddr("2001:db8:1::", firstHost + i);
+            SPtr<TAddrClient> client = new TAddrClient(duid);
+            SPtr<TAddrIA> ia = new TAddrIA(iface_->getName(), ifindex, IATYPE_IA,
+                                           clntAddr_, duid, 1800, 2880, 1);
+            ia->addAddr(new TAddrAddr(addr, 3600, 7200));
+            client->addIA(ia);
+            addrmgr_->addClient(client);
+            cfgmgr_->addClntAddr(ifindex, addr);
+        }
+    }
+
+    /// @brief serializes message to wire format
+    BenchPkt store(SPtr<TSrvMsg> msg, SPtr<TIPv6Addr> peer) {
+        BenchPkt pkt;
+        pkt.Data_.resize(msg->getSize());
+        msg->storeSelf(&pkt.Data_[0]);
+        pkt.Peer_ = peer;
+        return pkt;
+    }
+
+    /// @brief creates client message with client-id, ORO and IA_NA
+    SPtr<TSrvMsg> benchMsg(int type, uint32_t duidIdx, uint32_t transid,
+                           SPtr<TIPv6Addr> hint, bool include_srvid) {
+        char hdr[4] = { (char)type, 0, 0, 0 };
+        hdr[1] = (transid >> 16) & 0xff;
+        hdr[2] = (transid >> 8) & 0xff;
+        hdr[3] = transid & 0xff;
+        SPtr<TSrvMsg> msg;
+        switch (type) {
+        case SOLICIT_MSG:
+            msg = new TSrvMsgSolicit(iface_->getID(), clntAddr_, hdr, sizeof(hdr));
+            break;
+        case REQUEST_MSG:
+            msg = new TSrvMsgRequest(iface_->getID(), clntAddr_, hdr, sizeof(hdr));
+            break;
+        case RENEW_MSG:
+        default:
+            msg = new TSrvMsgRenew(iface_->getID(), clntAddr_, hdr, sizeof(hdr));
+            break;
+        }
+        msg->addOption(new TOptDUID(OPTION_CLIENTID, benchDuid(duidIdx), &(*msg)));
+        if (include_srvid)
+            msg->addOption(new TOptDUID(OPTION_SERVERID, SrvCfgMgr().getDUID(), &(*msg)));
+        SPtr<TOptOptionRequest> oro = new TOptOptionRequest(OPTION_ORO, &(*msg));
+        oro->addOption(OPTION_DNS_SERVERS);
+        oro->addOption(OPTION_DOMAIN_LIST);
+        msg->addOption(SPtr_cast<TOpt>(oro));
+        SPtr<TSrvOptIA_NA> ia = new TSrvOptIA_NA(1, 1800, 2880, &(*msg));
+        if (hint)
+            ia->addOption(new TSrvOptIAAddress(hint, 3600, 7200, &(*msg)));
+        msg->addOption(SPtr_cast<TOpt>(ia));
+        return msg;
+    }
+
+    /// @brief generates corpus of count messages, for clients firstDuid...
+    BenchCorpus createCorpus(int type, uint32_t firstDuid, uint32_t count,
+                             bool relayed = false) {
+        BenchCorpus corpus;
+        for (uint32_t i = 0; i < count; i++) {
+            SPtr<TIPv6Addr> hint;
+            if (type == RENEW_MSG)
+                hint = benchAddr("2001:db8:1::", firstDuid + i + 1);
+            SPtr<TIPv6Addr> peer = benchAddr("fe80::", firstDuid + i + 1);
+            SPtr<TSrvMsg> msg = benchMsg(type, firstDuid + i, i + 1, hint,
+                                         type != SOLICIT_MSG);
+            BenchPkt pkt = store(msg, peer);
+            if (relayed)
+                pkt = encapsulate(pkt);
+            corpus.push_back(pkt);
+        }
+        return corpus;
+    }
+
+    /// @brief wraps packet in RELAY-FORW with interface-id 1234
+    BenchPkt encapsulate(const BenchPkt& inner) {
+        SPtr<TOpt> ifaceId = new TSrvOptInterfaceID(1234, NULL);
+        BenchPkt pkt;
+        pkt.Data_.resize(34 + ifaceId->getSize() + 4 + inner.Data_.size());
+        char* buf = &pkt.Data_[0];
+        buf[0] = RELAY_FORW_MSG;
+        buf[1] = 0; // hop count
+        TIPv6Addr link("2001:db8:ffff::1", true);
+        link.storeSelf(buf + 2);
+        inner.Peer_->storeSelf(buf + 18);
+        buf += 34;
+        ifaceId->storeSelf(buf);
+        buf += ifaceId->getSize();
+        buf = writeUint16(buf, OPTION_RELAY_MSG);
+        buf = writeUint16(buf, inner.Data_.size());
+        memcpy(buf, &inner.Data_[0], inner.Data_.size());
+        pkt.Peer_ = new TIPv6Addr("fe80::1", true);
+        return pkt;
+    }
+
+    /// @brief updates assigned/no-addrs counters based on the response
+    void classify(SPtr<TSrvMsg> rsp, BenchResult& result) {
+        SPtr<TOpt> opt = rsp->getOption(OPTION_IA_NA);
+        if (!opt)
+            return;
+        if (opt->getOption(OPTION_IAADDR))
+            result.Assigned_++;
+        SPtr<TOptStatusCode> code = SPtr_cast<TOptStatusCode>(opt->getOption(OPTION_STATUS_CODE));
+        if (code && code->getCode() == STATUSCODE_NOADDRSAVAIL)
+            result.NoAddrs_++;
+    }
+
+    /// @brief decodes and processes every packet in the corpus
+    BenchResult run(BenchCorpus& corpus, bool relayed = false) {
+        BenchResult result;
+        SrvMsgList& sent = transmgr_->getMsgLst();
+        sent.clear();
+
+        unsigned long long allocs = benchAllocs();
+        unsigned long long start = benchCpuNs();
+
+        for (BenchCorpus::iterator pkt = corpus.begin(); pkt != corpus.end(); ++pkt) {
+            SPtr<TSrvMsg> msg;
+            if (relayed)
+                msg = SrvIfaceMgr().decodeRelayForw(iface_, pkt->Peer_,
+                                                    &pkt->Data_[0], pkt->Data_.size());
+            else
+                msg = SrvIfaceMgr().decodeMsg(iface_->getID(), pkt->Peer_,
+                                              &pkt->Data_[0], pkt->Data_.size());
+            result.Msgs_++;
+            if (!msg)
+                continue;
+            transmgr_->relayMsg(msg);
+            for (SrvMsgList::const_iterator rsp = sent.begin(); rsp != sent.end(); ++rsp) {
+                result.Replies_++;
+                classify(*rsp, result);
+            }
+            sent.clear();
+        }
+
+        result.CpuNs_ = benchCpuNs() - start;
+        result.Allocs_ = benchAllocs() - allocs;
+        return result;
+    }
+
+    void report(const std::string& name, uint32_t leases, const BenchResult& r) {
+        unsigned int msgs = r.Msgs_ ? r.Msgs_ : 1;
+        cout << "BENCH " << setw(16) << left << name << right
+             << " leases=" << setw(8) << leases
+             << " msgs=" << setw(6) << r.Msgs_
+             << " replies=" << setw(6) << r.Replies_
+             << " assigned=" << setw(6) << r.Assigned_
+             << " noaddrs=" << setw(6) << r.NoAddrs_
+             << " cpu/msg=" << setw(10) << fixed << setprecision(1)
+             << (r.CpuNs_ / 1000.0 / msgs) << "us"
+             << " allocs/msg=" << setw(8) << (double)r.Allocs_ / msgs << endl;
+    }
+
+    /// @brief runs the whole SOLICIT, REQUEST, RENEW, relayed SOLICIT sequence
+    void throughput(uint32_t leases) {
+        ASSERT_TRUE(createBenchMgrs("2001:db8:1::/64"));
+
+        unsigned long long start = benchCpuNs();
+        populate(leases);
+        cout << "BENCH populated " << leases << " leases in "
+             << (benchCpuNs() - start) / 1000000 << "ms" << endl;
+
+        uint32_t cnt = benchCnt_;
+        uint32_t fresh = 0x80000000; // DUIDs of clients unknown to the server
+        BenchCorpus sol = createCorpus(SOLICIT_MSG, fresh, cnt);
+        BenchCorpus req = createCorpus(REQUEST_MSG, fresh, cnt);
+        BenchCorpus renew = createCorpus(RENEW_MSG, 0, cnt < leases ? cnt : leases);
+        BenchCorpus relayed = createCorpus(SOLICIT_MSG, fresh + cnt, cnt, true);
+
+        BenchResult r = run(sol);
+        report("SOLICIT", leases, r);
+        EXPECT_EQ(cnt, r.Replies_);
+
+        r = run(req);
+        report("REQUEST", leases, r);
+        EXPECT_EQ(cnt, r.Replies_);
+
+        r = run(renew);
+        report("RENEW", leases, r);
+        EXPECT_EQ(renew.size(), r.Replies_);
+
+        r = run(relayed, true);
+        report("RELAY-SOLICIT", leases, r);
+        EXPECT_EQ(cnt, r.Replies_);
+    }
+
+    uint32_t benchCnt_;
+};
+
+TEST_F(ServerBench, throughput_1k) {
+    throughput(1000);
+}
+
+TEST_F(ServerBench, throughput_100k) {
+    throughput(100000);
+}
+
+TEST_F(ServerBench, DISABLED_throughput_1M) {
+    throughput(1000000);
+}
+
+// Pool with 4096 addresses, 4064 of them already leased. The first REQUESTs
+// have to search a nearly full pool (random search is bounded, so some of
+// them may be refused even if there are still free addresses), the remaining
+// ones hit an exhausted pool.
+TEST_F(ServerBench, poolExhaustion) {
+    ASSERT_TRUE(createBenchMgrs("2001:db8:1::1-2001:db8:1::1000"));
+
+    populate(4064);
+
+    BenchCorpus req = createCorpus(REQUEST_MSG, 0x80000000, 128);
+    BenchResult first = run(req);
+    report("REQUEST-EXHAUST", 4064, first);
+    EXPECT_EQ(128u, first.Replies_);
+    EXPECT_EQ(first.Replies_, first.Assigned_ + first.NoAddrs_);
+
+    req = createCorpus(REQUEST_MSG, 0x90000000, 128);
+    BenchResult second = run(req);
+    report("REQUEST-FULL", 4064 + first.Assigned_, second);
+    EXPECT_EQ(128u, second.Replies_);
+    EXPECT_EQ(second.Replies_, second.Assigned_ + second.NoAddrs_);
+
+    // there were only 32 free addresses
+    EXPECT_LE(first.Assigned_ + second.Assigned_, 32u);
+}
+
+}
@@ -70,7 +70,7 @@ TEST_F(ServerTest, parseDoubleRelay) {
 
     ASSERT_TRUE(received);
 
-    vector<TSrvMsg::RelayInfo> &rcvRelay = received->RelayInfo_;
+    vector<TSrvMsg::RelayInfo> rcvRelay = received->getRelayInfo();
 
     // Check that there's info about exactly one relay
     ASSERT_EQ(rcvRelay.size(), 2u);
@@ -0,0 +1,68 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#include <time.h>
+#include <stdlib.h>
+#include <new>
+#include "bench_utils.h"
+
+static unsigned long long BenchAllocs = 0;
+
+// Allocations are counted by replacing the global operator new. Every
+// operator delete variant frees through the same single function, so
+// malloc() and free() are paired in one place. GCC does not know that
+// the replacements are paired and warns about each free() of memory
+// returned by operator new, so the warning is disabled here only.
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    BenchAllocs++;
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) throw() {
+    free(p);
+}
+
+void operator delete[](void* p) throw() {
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t) throw() {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) throw() {
+    operator delete(p);
+}
+
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace test {
+
+    unsigned long long benchAllocs() {
+        return BenchAllocs;
+    }
+
+    unsigned long long benchCpuNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+}
@@ -0,0 +1,22 @@
+/*
+ * Dibbler - a portable DHCPv6
+ *
+ * released under GNU GPL v2 only licence
+ *
+ */
+
+#ifndef TEST_BENCH_UTILS_H
+#define TEST_BENCH_UTILS_H
+
+// Linking libBenchUtils.a replaces the global operator new and delete, so
+// it is meant for benchmarks only, never for regular tests.
+
+namespace test {
+    /// number of heap allocations made so far (whole process)
+    unsigned long long benchAllocs();
+
+    /// CPU time used by the process so far (in nsec)
+    unsigned long long benchCpuNs();
+}
+
+#endif